@@ -6,6 +6,13 @@ execute_process(
   COMMAND tr -d '\n'
   OUTPUT_VARIABLE ARGOS_PROCESSOR_ARCH)
 
+#
+# Compile the vector math kernels on x86 processors
+#
+if(ARGOS_PROCESSOR_ARCH MATCHES "^(x86_64|amd64|i[3-6]86)$")
+  set(ARGOS_WITH_X86_SIMD ON)
+endif(ARGOS_PROCESSOR_ARCH MATCHES "^(x86_64|amd64|i[3-6]86)$")
+
 #
 # General compilation flags
 #
@@ -12,6 +12,7 @@ namespace argos {
 }
 
 #include <argos3/core/utility/configuration/base_configurable_resource.h>
+#include <argos3/core/utility/configuration/memento.h>
 #include <argos3/core/utility/datatypes/datatypes.h>
 #include <argos3/core/control_interface/ci_sensor.h>
 #include <argos3/core/control_interface/ci_actuator.h>
@@ -27,7 +28,8 @@ namespace argos {
    /**
     * The basic interface for a robot controller.
     */
-   class CCI_Controller : public CBaseConfigurableResource {
+   class CCI_Controller : public CBaseConfigurableResource,
+                          public CMemento {
 
    public:
 
@@ -71,6 +73,26 @@ namespace argos {
        */
       virtual void Destroy() {}
 
+      /**
+       * Saves the state of the controller to the given buffer.
+       * This method is used by simulation checkpoints.
+       * Override it to save the variables of your controller that change
+       * during an experiment, so that a run restored from a checkpoint
+       * continues exactly as the original one.
+       * The default implementation of this method does nothing.
+       * @param c_buffer The target buffer.
+       * @see LoadState()
+       */
+      virtual void SaveState(CByteArray& c_buffer) {}
+
+      /**
+       * Restores the state of the controller from the given buffer.
+       * The default implementation of this method does nothing.
+       * @param c_buffer The source buffer.
+       * @see SaveState()
+       */
+      virtual void LoadState(CByteArray& c_buffer) {}
+
       /**
        * Returns the id of the robot associated to this controller.
        * @return The id of the robot associated to this controller.
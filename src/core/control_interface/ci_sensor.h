@@ -16,6 +16,7 @@ namespace argos {
 #include <argos3/core/config.h>
 #include <argos3/core/utility/datatypes/datatypes.h>
 #include <argos3/core/utility/configuration/base_configurable_resource.h>
+#include <argos3/core/utility/configuration/memento.h>
 #include <map>
 
 #ifdef ARGOS_WITH_LUA
@@ -31,7 +32,8 @@ namespace argos {
    /**
     * The basic interface for all sensors.
     */
-   class CCI_Sensor : public CBaseConfigurableResource {
+   class CCI_Sensor : public CBaseConfigurableResource,
+                      public CMemento {
 
    public:
 
@@ -70,6 +72,24 @@ namespace argos {
        */
       virtual void Destroy() {}
 
+      /**
+       * Saves the state of the sensor to the given buffer.
+       * This method is used by simulation checkpoints.
+       * Override it if the sensor keeps data across control steps.
+       * The default implementation of this method does nothing.
+       * @param c_buffer The target buffer.
+       * @see LoadState()
+       */
+      virtual void SaveState(CByteArray& c_buffer) {}
+
+      /**
+       * Restores the state of the sensor from the given buffer.
+       * The default implementation of this method does nothing.
+       * @param c_buffer The source buffer.
+       * @see SaveState()
+       */
+      virtual void LoadState(CByteArray& c_buffer) {}
+
 #ifdef ARGOS_WITH_LUA
       /**
        * Creates the Lua state for this sensor.
@@ -14,6 +14,7 @@ namespace argos {
 
    CARGoSCommandLineArgParser::CARGoSCommandLineArgParser() :
       m_eAction(ACTION_UNKNOWN),
+      m_unForkWorkers(0),
       m_pcInitLogStream(NULL),
       m_pcInitLogErrStream(NULL) {
       AddFlag(
@@ -40,6 +41,18 @@ namespace argos {
          "the experiment XML configuration file",
          m_strExperimentConfigFile
          );
+      AddArgument<UInt32>(
+         'f',
+         "fork",
+         "run the experiment in N forked workers [OPTIONAL]",
+         m_unForkWorkers
+         );
+      AddArgument<std::string>(
+         'b',
+         "batch",
+         "run the jobs listed in FILE [OPTIONAL]",
+         m_strBatchFile
+         );
       AddArgument<std::string>(
          'q',
          "query",
@@ -122,6 +135,12 @@ namespace argos {
       if(m_strExperimentConfigFile != "") {
          m_eAction = ACTION_RUN_EXPERIMENT;
       }
+      else if(m_unForkWorkers > 0 || m_strBatchFile != "") {
+         THROW_ARGOSEXCEPTION("Options --fork and --batch require --config-file.");
+      }
+      if(m_unForkWorkers > 0 && m_strBatchFile != "") {
+         THROW_ARGOSEXCEPTION("Options --fork and --batch are mutually exclusive.");
+      }
 
       if(m_strQuery != "") {
          m_eAction = ACTION_QUERY;
@@ -150,12 +169,24 @@ namespace argos {
       c_log << "   -v       | --version               display ARGoS version and release" << std::endl;
       c_log << "   -c FILE  | --config-file FILE      the experiment XML configuration file" << std::endl;
       c_log << "   -q QUERY | --query QUERY           query the available plugins." << std::endl;
+      c_log << "   -f N     | --fork N                run the experiment in N forked workers [OPTIONAL]" << std::endl;
+      c_log << "   -b FILE  | --batch FILE            run the jobs listed in FILE [OPTIONAL]" << std::endl;
       c_log << "   -n       | --no-color              do not use colored output [OPTIONAL]" << std::endl;
       c_log << "   -l       | --log-file FILE         redirect LOG to FILE [OPTIONAL]" << std::endl;
       c_log << "   -e       | --logerr-file FILE      redirect LOGERR to FILE [OPTIONAL]" << std::endl << std::endl;
       c_log << "The options --config-file and --query are mutually exclusive. Either you use" << std::endl;
       c_log << "the first, and thus you run an experiment, or you use the second to query the" << std::endl;
       c_log << "plugins." << std::endl << std::endl;
+      c_log << "With --fork, the experiment is initialized once and then copied into N" << std::endl;
+      c_log << "worker processes. Worker i uses the experiment random seed plus i. At most" << std::endl;
+      c_log << "one worker per online processor runs at the same time." << std::endl << std::endl;
+      c_log << "With --batch, each line of FILE is a job made of a random seed, optionally" << std::endl;
+      c_log << "followed by overrides of the configuration such as" << std::endl << std::endl;
+      c_log << "   42 framework/experiment.length=600 loop_functions.items=20" << std::endl << std::endl;
+      c_log << "Each job is initialized from scratch in its own forked process, so it gives" << std::endl;
+      c_log << "the same result as a single run with its seed. At most one job per online" << std::endl;
+      c_log << "processor runs at the same time. The options --fork and --batch are mutually" << std::endl;
+      c_log << "exclusive." << std::endl << std::endl;
       c_log << "EXAMPLES" << std::endl << std::endl;
       c_log << "To run an experiment, type:" << std::endl << std::endl;
       c_log << "   argos3 -c /path/to/myconfig.argos" << std::endl << std::endl;
@@ -98,6 +98,30 @@ namespace argos {
          return m_strExperimentConfigFile;
       }
 
+      /**
+       * Returns the number of forked workers as parsed by Parse().
+       * The returned value is meaningful only if GetAction() returns ACTION_RUN_EXPERIMENT.
+       * A value of 0 means that the experiment runs in this process.
+       * @return The number of forked workers as parsed by Parse().
+       * @see Parse()
+       * @see CSimulator::ExecuteForked()
+       */
+      inline UInt32 GetForkWorkers() {
+         return m_unForkWorkers;
+      }
+
+      /**
+       * Returns the batch file as parsed by Parse().
+       * The returned value is meaningful only if GetAction() returns ACTION_RUN_EXPERIMENT.
+       * An empty string means that a single experiment must be run.
+       * @return The batch file as parsed by Parse().
+       * @see Parse()
+       * @see CSimulator::ExecuteBatch()
+       */
+      inline const std::string& GetBatchFile() {
+         return m_strBatchFile;
+      }
+
       /**
        * Returns the query on the plugins as parsed by Parse().
        * The returned value is meaningful only if GetAction() returns ACTION_QUERY.
@@ -133,6 +157,8 @@ namespace argos {
 
       EAction m_eAction;
       std::string m_strExperimentConfigFile;
+      UInt32 m_unForkWorkers;
+      std::string m_strBatchFile;
       std::string m_strQuery;
       std::string m_strLogFileName;
       std::ofstream m_cLogFile;
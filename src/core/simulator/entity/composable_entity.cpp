@@ -44,6 +44,32 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CComposableEntity::SaveState(CByteArray& c_buffer) {
+      CEntity::SaveState(c_buffer);
+      c_buffer << static_cast<UInt32>(m_vecComponents.size());
+      for(size_t i = 0; i < m_vecComponents.size(); ++i) {
+         m_vecComponents[i]->SaveState(c_buffer);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CComposableEntity::LoadState(CByteArray& c_buffer) {
+      CEntity::LoadState(c_buffer);
+      UInt32 unNumComponents;
+      c_buffer >> unNumComponents;
+      if(unNumComponents != m_vecComponents.size()) {
+         THROW_ARGOSEXCEPTION("Saved state of entity \"" << GetId() << "\" has " << unNumComponents << " components, but the entity has " << m_vecComponents.size());
+      }
+      for(size_t i = 0; i < m_vecComponents.size(); ++i) {
+         m_vecComponents[i]->LoadState(c_buffer);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CComposableEntity::SetEnabled(bool b_enabled) {
       CEntity::SetEnabled(b_enabled);
       for(CEntity::TMultiMap::iterator it = m_mapComponents.begin();
@@ -74,6 +74,20 @@ namespace argos {
        */
       virtual void Update();
 
+      /**
+       * Saves the state of the entity and of all its components.
+       * The components are saved in the order in which they were added.
+       * @param c_buffer The target buffer.
+       */
+      virtual void SaveState(CByteArray& c_buffer);
+
+      /**
+       * Restores the state of the entity and of all its components.
+       * @param c_buffer The source buffer.
+       * @throws CARGoSException if the number of components does not match
+       */
+      virtual void LoadState(CByteArray& c_buffer);
+
       virtual std::string GetTypeDescription() const {
          return "composite";
       }
@@ -10,6 +10,7 @@
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/entity/composable_entity.h>
 #include <argos3/core/simulator/space/space.h>
+#include <argos3/core/utility/profiler/profiler.h>
 
 namespace argos {
 
@@ -18,7 +19,10 @@ namespace argos {
 
    CControllableEntity::CControllableEntity(CComposableEntity* pc_parent) :
       CEntity(pc_parent),
-      m_pcController(NULL) {}
+      m_pcController(NULL),
+      m_bDeviceTiming(false),
+      m_unTimedActs(0),
+      m_unTimedSenses(0) {}
 
    /****************************************/
    /****************************************/
@@ -26,7 +30,10 @@ namespace argos {
    CControllableEntity::CControllableEntity(CComposableEntity* pc_parent,
                                             const std::string& str_id) :
       CEntity(pc_parent, str_id),
-      m_pcController(NULL) {
+      m_pcController(NULL),
+      m_bDeviceTiming(false),
+      m_unTimedActs(0),
+      m_unTimedSenses(0) {
    }
 
    /****************************************/
@@ -89,6 +96,58 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CControllableEntity::SaveState(CByteArray& c_buffer) {
+      CEntity::SaveState(c_buffer);
+      /* Save sensors */
+      c_buffer << static_cast<UInt32>(m_pcController->GetAllSensors().size());
+      for(CCI_Sensor::TMap::iterator it = m_pcController->GetAllSensors().begin();
+          it != m_pcController->GetAllSensors().end(); ++it) {
+         it->second->SaveState(c_buffer);
+      }
+      /* Save actuators */
+      c_buffer << static_cast<UInt32>(m_pcController->GetAllActuators().size());
+      for(CCI_Actuator::TMap::iterator it = m_pcController->GetAllActuators().begin();
+          it != m_pcController->GetAllActuators().end(); ++it) {
+         it->second->SaveState(c_buffer);
+      }
+      /* Save user-defined controller */
+      m_pcController->SaveState(c_buffer);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CControllableEntity::LoadState(CByteArray& c_buffer) {
+      CEntity::LoadState(c_buffer);
+      /* Clear rays */
+      m_vecCheckedRays.clear();
+      m_vecIntersectionPoints.clear();
+      /* Load sensors */
+      UInt32 unNum;
+      c_buffer >> unNum;
+      if(unNum != m_pcController->GetAllSensors().size()) {
+         THROW_ARGOSEXCEPTION("Saved state of controllable entity \"" << GetContext() << GetId() << "\" has " << unNum << " sensors, but the entity has " << m_pcController->GetAllSensors().size());
+      }
+      for(CCI_Sensor::TMap::iterator it = m_pcController->GetAllSensors().begin();
+          it != m_pcController->GetAllSensors().end(); ++it) {
+         it->second->LoadState(c_buffer);
+      }
+      /* Load actuators */
+      c_buffer >> unNum;
+      if(unNum != m_pcController->GetAllActuators().size()) {
+         THROW_ARGOSEXCEPTION("Saved state of controllable entity \"" << GetContext() << GetId() << "\" has " << unNum << " actuators, but the entity has " << m_pcController->GetAllActuators().size());
+      }
+      for(CCI_Actuator::TMap::iterator it = m_pcController->GetAllActuators().begin();
+          it != m_pcController->GetAllActuators().end(); ++it) {
+         it->second->LoadState(c_buffer);
+      }
+      /* Load user-defined controller */
+      m_pcController->LoadState(c_buffer);
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CControllableEntity::Destroy() {
       /* Clear rays */
       m_vecCheckedRays.clear();
@@ -107,6 +166,18 @@ namespace argos {
          /* Destroy user-defined controller */
          m_pcController->Destroy();
       }
+      /* Report the time spent in sensors and actuators */
+      if(m_bDeviceTiming) {
+         CProfiler& cProfiler = CSimulator::GetInstance().GetProfiler();
+         for(TDeviceTimeMap::iterator it = m_mapSensorTimes.begin();
+             it != m_mapSensorTimes.end(); ++it) {
+            cProfiler.AddSensorTime(it->second.Type, it->second.Time, m_unTimedSenses);
+         }
+         for(TDeviceTimeMap::iterator it = m_mapActuatorTimes.begin();
+             it != m_mapActuatorTimes.end(); ++it) {
+            cProfiler.AddActuatorTime(it->second.Type, it->second.Time, m_unTimedActs);
+         }
+      }
    }
 
    /****************************************/
@@ -152,6 +223,10 @@ namespace argos {
          TConfigurationNode& tConfig = CSimulator::GetInstance().GetConfigForController(str_controller_id);
          /* tConfig is the base of the XML section of the wanted controller */
          std::string strImpl;
+         /* Time sensors and actuators, if requested */
+         m_bDeviceTiming =
+            CSimulator::GetInstance().IsProfiling() &&
+            CSimulator::GetInstance().GetProfiler().IsDeviceTiming();
          /* Create the controller */
          m_pcController = CFactory<CCI_Controller>::New(tConfig.Value());
          m_pcController->SetId(GetParent().GetId());
@@ -171,6 +246,9 @@ namespace argos {
             pcAct->SetRobot(GetParent());
             pcCIAct->Init(*itAct);
             m_mapActuators[itAct->Value()] = pcAct;
+            if(m_bDeviceTiming) {
+               m_mapActuatorTimes[itAct->Value()] = SDeviceTime(itAct->Value() + "/" + strImpl);
+            }
             m_pcController->AddActuator(itAct->Value(), pcCIAct);
          }
          /* Go through sensors */
@@ -189,6 +267,9 @@ namespace argos {
             pcSens->SetRobot(GetParent());
             pcCISens->Init(*itSens);
             m_mapSensors[itSens->Value()] = pcSens;
+            if(m_bDeviceTiming) {
+               m_mapSensorTimes[itSens->Value()] = SDeviceTime(itSens->Value() + "/" + strImpl);
+            }
             m_pcController->AddSensor(itSens->Value(), pcCISens);
          }
          /* Configure the controller */
@@ -205,9 +286,22 @@ namespace argos {
    void CControllableEntity::Sense() {
       m_vecCheckedRays.clear();
       m_vecIntersectionPoints.clear();
-      for(std::map<std::string, CSimulatedSensor*>::iterator it = m_mapSensors.begin();
-          it != m_mapSensors.end(); ++it) {
-         it->second->Update();
+      if(m_bDeviceTiming) {
+         /* m_mapSensorTimes has the same keys as m_mapSensors */
+         TDeviceTimeMap::iterator itTime = m_mapSensorTimes.begin();
+         for(std::map<std::string, CSimulatedSensor*>::iterator it = m_mapSensors.begin();
+             it != m_mapSensors.end(); ++it, ++itTime) {
+            double fStart = CProfiler::GetTimeStamp();
+            it->second->Update();
+            itTime->second.Time += CProfiler::GetTimeStamp() - fStart;
+         }
+         ++m_unTimedSenses;
+      }
+      else {
+         for(std::map<std::string, CSimulatedSensor*>::iterator it = m_mapSensors.begin();
+             it != m_mapSensors.end(); ++it) {
+            it->second->Update();
+         }
       }
    }
 
@@ -227,9 +321,22 @@ namespace argos {
    /****************************************/
 
    void CControllableEntity::Act() {
-      for(std::map<std::string, CSimulatedActuator*>::iterator it = m_mapActuators.begin();
-          it != m_mapActuators.end(); ++it) {
-         it->second->Update();
+      if(m_bDeviceTiming) {
+         /* m_mapActuatorTimes has the same keys as m_mapActuators */
+         TDeviceTimeMap::iterator itTime = m_mapActuatorTimes.begin();
+         for(std::map<std::string, CSimulatedActuator*>::iterator it = m_mapActuators.begin();
+             it != m_mapActuators.end(); ++it, ++itTime) {
+            double fStart = CProfiler::GetTimeStamp();
+            it->second->Update();
+            itTime->second.Time += CProfiler::GetTimeStamp() - fStart;
+         }
+         ++m_unTimedActs;
+      }
+      else {
+         for(std::map<std::string, CSimulatedActuator*>::iterator it = m_mapActuators.begin();
+             it != m_mapActuators.end(); ++it) {
+            it->second->Update();
+         }
       }
    }
 
@@ -81,6 +81,21 @@ namespace argos {
        */
       virtual void Reset();
 
+      /**
+       * Saves the state of the sensors, of the actuators and of the controller.
+       * @param c_buffer The target buffer.
+       * @see CCI_Controller::SaveState()
+       */
+      virtual void SaveState(CByteArray& c_buffer);
+
+      /**
+       * Restores the state of the sensors, of the actuators and of the controller.
+       * @param c_buffer The source buffer.
+       * @throws CARGoSException if the number of sensors or actuators does not match
+       * @see CCI_Controller::LoadState()
+       */
+      virtual void LoadState(CByteArray& c_buffer);
+
       /**
        * Destroys the entity, undoing whatever was done by Init() or by the standalone constructor.
        */
@@ -215,6 +230,27 @@ namespace argos {
          return m_vecIntersectionPoints;
       }
 
+   protected:
+
+      /**
+       * The time spent updating a sensor or an actuator, when profiling.
+       */
+      struct SDeviceTime {
+         /** The device type and implementation, such as <tt>proximity/default</tt> */
+         std::string Type;
+         /** The time spent in the updates, in seconds */
+         double Time;
+
+         SDeviceTime() :
+            Time(0.0) {}
+
+         SDeviceTime(const std::string& str_type) :
+            Type(str_type),
+            Time(0.0) {}
+      };
+
+      typedef std::map<std::string, SDeviceTime> TDeviceTimeMap;
+
    protected:
 
       /** The pointer to the associated controller */
@@ -232,6 +268,21 @@ namespace argos {
       /** The list of intersection points */
       std::vector<CVector3> m_vecIntersectionPoints;
 
+      /** <tt>true</tt> when the sensor and actuator updates are timed */
+      bool m_bDeviceTiming;
+
+      /** The time spent in each actuator, indexed like m_mapActuators */
+      TDeviceTimeMap m_mapActuatorTimes;
+
+      /** The time spent in each sensor, indexed like m_mapSensors */
+      TDeviceTimeMap m_mapSensorTimes;
+
+      /** The number of timed Act() calls */
+      size_t m_unTimedActs;
+
+      /** The number of timed Sense() calls */
+      size_t m_unTimedSenses;
+
    };
 
 }
@@ -118,6 +118,63 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CEmbodiedEntity::SaveState(CByteArray& c_buffer) {
+      CEntity::SaveState(c_buffer);
+      c_buffer << static_cast<UInt32>(m_mapAnchors.size());
+      SAnchor* psAnchor;
+      for(std::map<std::string, SAnchor*>::iterator it = m_mapAnchors.begin();
+          it != m_mapAnchors.end(); ++it) {
+         psAnchor = it->second;
+         c_buffer << psAnchor->Position.GetX()
+                  << psAnchor->Position.GetY()
+                  << psAnchor->Position.GetZ()
+                  << psAnchor->Orientation.GetW()
+                  << psAnchor->Orientation.GetX()
+                  << psAnchor->Orientation.GetY()
+                  << psAnchor->Orientation.GetZ();
+      }
+      c_buffer << static_cast<UInt32>(m_tPhysicsModelMap.size());
+      for(CPhysicsModel::TMap::iterator it = m_tPhysicsModelMap.begin();
+          it != m_tPhysicsModelMap.end(); ++it) {
+         it->second->SaveState(c_buffer);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CEmbodiedEntity::LoadState(CByteArray& c_buffer) {
+      CEntity::LoadState(c_buffer);
+      UInt32 unNumAnchors;
+      c_buffer >> unNumAnchors;
+      if(unNumAnchors != m_mapAnchors.size()) {
+         THROW_ARGOSEXCEPTION("Saved state of embodied entity \"" << GetContext() << GetId() << "\" has " << unNumAnchors << " anchors, but the entity has " << m_mapAnchors.size());
+      }
+      SAnchor* psAnchor;
+      Real fX, fY, fZ, fW;
+      for(std::map<std::string, SAnchor*>::iterator it = m_mapAnchors.begin();
+          it != m_mapAnchors.end(); ++it) {
+         psAnchor = it->second;
+         c_buffer >> fX >> fY >> fZ;
+         psAnchor->Position.Set(fX, fY, fZ);
+         c_buffer >> fW >> fX >> fY >> fZ;
+         psAnchor->Orientation.Set(fW, fX, fY, fZ);
+      }
+      UInt32 unNumModels;
+      c_buffer >> unNumModels;
+      if(unNumModels != m_tPhysicsModelMap.size()) {
+         THROW_ARGOSEXCEPTION("Saved state of embodied entity \"" << GetContext() << GetId() << "\" has " << unNumModels << " physics models, but the entity has " << m_tPhysicsModelMap.size());
+      }
+      for(CPhysicsModel::TMap::iterator it = m_tPhysicsModelMap.begin();
+          it != m_tPhysicsModelMap.end(); ++it) {
+         it->second->LoadState(c_buffer);
+      }
+      CalculateBoundingBox();
+   }
+
+   /****************************************/
+   /****************************************/
+
    SAnchor& CEmbodiedEntity::AddAnchor(const std::string& str_id,
                                        const CVector3& c_offset_position,
                                        const CQuaternion& c_offset_orientation) {
@@ -445,6 +502,23 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   bool CEmbodiedEntity::CheckIntersectionWithRay(Real& f_t_on_ray,
+                                                  const CRay3& c_ray) const {
+      bool bFound = false;
+      Real fTOnRay;
+      for(size_t i = 0; i < m_tPhysicsModelVector.size(); ++i) {
+         if(m_tPhysicsModelVector[i]->CheckIntersectionWithRay(fTOnRay, c_ray) &&
+            (!bFound || fTOnRay < f_t_on_ray)) {
+            f_t_on_ray = fTOnRay;
+            bFound = true;
+         }
+      }
+      return bFound;
+   }
+
+   /****************************************/
+   /****************************************/
+
    bool operator==(const SAnchor* ps_anchor,
                    const std::string& str_id) {
       return (ps_anchor->Id == str_id);
@@ -476,13 +550,13 @@ namespace argos {
       m_cGrid(c_grid) {}
 
    bool CEmbodiedEntityGridUpdater::operator()(CEmbodiedEntity& c_entity) {
+      /* Entities not associated to any engine have no bounding box */
+      if(c_entity.GetPhysicsModelsNum() == 0) return true;
       try {
          /* Get cell of bb min corner, clamping it if is out of bounds */
-         m_cGrid.PositionToCell(m_nMinI, m_nMinJ, m_nMinK, c_entity.GetBoundingBox().MinCorner);
-         m_cGrid.ClampCoordinates(m_nMinI, m_nMinJ, m_nMinK);
+         m_cGrid.PositionToCellClamped(m_nMinI, m_nMinJ, m_nMinK, c_entity.GetBoundingBox().MinCorner);
          /* Get cell of bb max corner, clamping it if is out of bounds */
-         m_cGrid.PositionToCell(m_nMaxI, m_nMaxJ, m_nMaxK, c_entity.GetBoundingBox().MaxCorner);
-         m_cGrid.ClampCoordinates(m_nMaxI, m_nMaxJ, m_nMaxK);
+         m_cGrid.PositionToCellClamped(m_nMaxI, m_nMaxJ, m_nMaxK, c_entity.GetBoundingBox().MaxCorner);
          /* Go through cells */
          for(SInt32 m_nK = m_nMinK; m_nK <= m_nMaxK; ++m_nK) {
             for(SInt32 m_nJ = m_nMinJ; m_nJ <= m_nMaxJ; ++m_nJ) {
@@ -512,6 +586,8 @@ namespace argos {
          c_space.AddEntity(c_entity);
          /* Try to add entity to physics engine(s) */
          c_space.AddEntityToPhysicsEngine(c_entity);
+         /* Make the entity visible to the ray queries */
+         c_space.GetRayGrid().AddEntity(c_entity);
       }
    };
    REGISTER_SPACE_OPERATION(CSpaceOperationAddEntity, CSpaceOperationAddEmbodiedEntity, CEmbodiedEntity);
@@ -543,6 +619,8 @@ namespace argos {
              * removed.
              */
          }
+         /* Remove entity from the ray queries */
+         c_space.GetRayGrid().RemoveEntity(c_entity);
          /* Remove entity from space */
          c_space.RemoveEntity(c_entity);
       }
@@ -94,6 +94,22 @@ namespace argos {
 
       virtual void Reset();
 
+      /**
+       * Saves the position and orientation of all the anchors, followed
+       * by the state of the physics models of this entity.
+       * @param c_buffer The target buffer.
+       * @see CPhysicsModel::SaveState()
+       */
+      virtual void SaveState(CByteArray& c_buffer);
+
+      /**
+       * Restores the position and orientation of all the anchors and the
+       * state of the physics models of this entity.
+       * @param c_buffer The source buffer.
+       * @throws CARGoSException if the number of anchors or models does not match
+       */
+      virtual void LoadState(CByteArray& c_buffer);
+
       /**
        * Returns <tt>true</tt> if the entity is movable.
        * @return <tt>true</tt> if the entity is movable.
@@ -302,6 +318,18 @@ namespace argos {
        */
       virtual bool IsCollidingWithSomething() const;
 
+      /**
+       * Checks whether the given ray intersects this entity.
+       * The check is performed with the exact shapes of the physics models
+       * associated to this entity.
+       * @param f_t_on_ray Set to the t on the ray of the closest intersection.
+       * @param c_ray The ray to test.
+       * @return <tt>true</tt> if the ray intersects this entity.
+       * @see CPhysicsModel::CheckIntersectionWithRay()
+       */
+      bool CheckIntersectionWithRay(Real& f_t_on_ray,
+                                    const CRay3& c_ray) const;
+
       virtual std::string GetTypeDescription() const {
          return "body";
       }
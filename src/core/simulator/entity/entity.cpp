@@ -135,6 +135,22 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CEntity::SaveState(CByteArray& c_buffer) {
+      c_buffer << static_cast<UInt8>(m_bEnabled ? 1 : 0);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CEntity::LoadState(CByteArray& c_buffer) {
+      UInt8 unEnabled;
+      c_buffer >> unEnabled;
+      m_bEnabled = (unEnabled != 0);
+   }
+
+   /****************************************/
+   /****************************************/
+
    INIT_VTABLE_FOR(CEntity);
 
    REGISTER_STANDARD_SPACE_OPERATIONS_ON_ENTITY(CEntity);
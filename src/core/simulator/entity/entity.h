@@ -22,6 +22,7 @@ namespace argos {
 #include <argos3/core/utility/datatypes/datatypes.h>
 #include <argos3/core/utility/configuration/argos_configuration.h>
 #include <argos3/core/utility/configuration/base_configurable_resource.h>
+#include <argos3/core/utility/configuration/memento.h>
 #include <argos3/core/utility/plugins/factory.h>
 #include <argos3/core/utility/plugins/vtable.h>
 
@@ -87,6 +88,7 @@ namespace argos {
     * @see CSpaceHash
     */
    class CEntity : public CBaseConfigurableResource,
+                   public CMemento,
                    public EnableVTableFor<CEntity> {
 
    public:
@@ -150,6 +152,27 @@ namespace argos {
        */
       virtual void Destroy() {}
 
+      /**
+       * Saves the state of the entity to the given buffer.
+       * This method is used by simulation checkpoints. The default
+       * implementation saves the enabled flag. Entities that have state
+       * which changes during an experiment must extend this method and
+       * call the one of their parent class first.
+       * @param c_buffer The target buffer.
+       * @see CSimulator::SaveCheckpoint()
+       */
+      virtual void SaveState(CByteArray& c_buffer);
+
+      /**
+       * Restores the state of the entity from the given buffer.
+       * The data must have been written by SaveState() on an entity
+       * of the same type.
+       * @param c_buffer The source buffer.
+       * @throws CARGoSException if the data does not match this entity
+       * @see CSimulator::LoadCheckpoint()
+       */
+      virtual void LoadState(CByteArray& c_buffer);
+
       /**
        * Returns the id of this entity.
        * @return The id of this entity.
@@ -8,6 +8,7 @@
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/space/space.h>
 #include <argos3/core/simulator/loop_functions.h>
+#include <cstring>
 
 #ifdef ARGOS_WITH_FREEIMAGE
 #include <FreeImagePlus.h>
@@ -171,7 +172,15 @@ namespace argos {
       CEntity(NULL),
       m_eColorSource(UNSET),
       m_pcColorSource(NULL),
-      m_bHasChanged(true) {}
+      m_bHasChanged(true),
+      m_bRasterized(false),
+      m_bRasterChanged(true),
+      m_bRasterFullRebuild(true),
+      m_nRasterWidth(0),
+      m_nRasterHeight(0),
+      m_fRasterPixelsPerMeter(0.0f) {
+      InitRasterMutex();
+   }
 
    /****************************************/
    /****************************************/
@@ -182,7 +191,14 @@ namespace argos {
       CEntity(NULL, str_id),
       m_eColorSource(FROM_IMAGE),
       m_pcColorSource(NULL),
-      m_bHasChanged(true) {
+      m_bHasChanged(true),
+      m_bRasterized(false),
+      m_bRasterChanged(true),
+      m_bRasterFullRebuild(true),
+      m_nRasterWidth(0),
+      m_nRasterHeight(0),
+      m_fRasterPixelsPerMeter(0.0f) {
+      InitRasterMutex();
       std::string strFileName = str_file_name;
       ExpandEnvVariables(strFileName);
       m_pcColorSource = new CFloorColorFromImageFile(strFileName);
@@ -197,7 +213,15 @@ namespace argos {
       CEntity(NULL, str_id),
       m_eColorSource(FROM_LOOP_FUNCTIONS),
       m_pcColorSource(new CFloorColorFromLoopFunctions(un_pixels_per_meter)),
-      m_bHasChanged(true) {}
+      m_bHasChanged(true),
+      m_bRasterized(false),
+      m_bRasterChanged(true),
+      m_bRasterFullRebuild(true),
+      m_nRasterWidth(0),
+      m_nRasterHeight(0),
+      m_fRasterPixelsPerMeter(0.0f) {
+      InitRasterMutex();
+   }
 
    /****************************************/
    /****************************************/
@@ -206,6 +230,7 @@ namespace argos {
       if(m_pcColorSource != NULL) {
          delete m_pcColorSource;
       }
+      pthread_mutex_destroy(&m_tRasterMutex);
    }
 
    /****************************************/
@@ -217,11 +242,13 @@ namespace argos {
       /* Parse XML */
       std::string strColorSource;
       GetNodeAttribute(t_tree, "source", strColorSource);
+      GetNodeAttributeOrDefault(t_tree, "rasterize", m_bRasterized, m_bRasterized);
       if(strColorSource == "loop_functions") {
          m_eColorSource = FROM_LOOP_FUNCTIONS;
          UInt32 unPixelsPerMeter;
          GetNodeAttribute(t_tree, "pixels_per_meter", unPixelsPerMeter);
          m_pcColorSource = new CFloorColorFromLoopFunctions(unPixelsPerMeter);
+         m_fRasterPixelsPerMeter = unPixelsPerMeter;
       }
       else if(strColorSource == "image") {
 #ifdef ARGOS_WITH_FREEIMAGE
@@ -230,6 +257,11 @@ namespace argos {
          GetNodeAttribute(t_tree, "path", strPath);
          ExpandEnvVariables(strPath);
          m_pcColorSource = new CFloorColorFromImageFile(strPath);
+         if(m_bRasterized) {
+            UInt32 unPixelsPerMeter;
+            GetNodeAttribute(t_tree, "pixels_per_meter", unPixelsPerMeter);
+            m_fRasterPixelsPerMeter = unPixelsPerMeter;
+         }
 #else
          THROW_ARGOSEXCEPTION("ARGoS was compiled without FreeImage, this image source is unsupported for the floor entity \"" <<
                               GetId() <<
@@ -243,6 +275,11 @@ namespace argos {
                               GetId() <<
                               "\"");
       }
+      if(m_bRasterized && m_fRasterPixelsPerMeter <= 0.0f) {
+         THROW_ARGOSEXCEPTION("The floor entity \"" <<
+                              GetId() <<
+                              "\" needs a positive value of 'pixels_per_meter' to be rasterized");
+      }
    }
 
    /****************************************/
@@ -250,6 +287,108 @@ namespace argos {
 
    void CFloorEntity::Reset() {
       m_pcColorSource->Reset();
+      SetChanged();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFloorEntity::SetChanged() {
+      m_bHasChanged = true;
+      pthread_mutex_lock(&m_tRasterMutex);
+      m_bRasterFullRebuild = true;
+      __atomic_store_n(&m_bRasterChanged, true, __ATOMIC_RELEASE);
+      pthread_mutex_unlock(&m_tRasterMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFloorEntity::SetChanged(const CVector2& c_min_corner,
+                                 const CVector2& c_max_corner) {
+      m_bHasChanged = true;
+      pthread_mutex_lock(&m_tRasterMutex);
+      if(!m_bRasterFullRebuild) {
+         if(m_bRasterChanged) {
+            /* Merge with the rectangle still to fill */
+            m_cRasterChangedMin.Set(Min(m_cRasterChangedMin.GetX(), c_min_corner.GetX()),
+                                    Min(m_cRasterChangedMin.GetY(), c_min_corner.GetY()));
+            m_cRasterChangedMax.Set(Max(m_cRasterChangedMax.GetX(), c_max_corner.GetX()),
+                                    Max(m_cRasterChangedMax.GetY(), c_max_corner.GetY()));
+         }
+         else {
+            m_cRasterChangedMin = c_min_corner;
+            m_cRasterChangedMax = c_max_corner;
+         }
+      }
+      __atomic_store_n(&m_bRasterChanged, true, __ATOMIC_RELEASE);
+      pthread_mutex_unlock(&m_tRasterMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFloorEntity::InitRasterMutex() {
+      int nErrors;
+      if((nErrors = pthread_mutex_init(&m_tRasterMutex, NULL))) {
+         THROW_ARGOSEXCEPTION("Error creating the floor raster mutex: " << ::strerror(nErrors));
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFloorEntity::Rasterize() {
+      pthread_mutex_lock(&m_tRasterMutex);
+      /* Another thread might have done the work while we were waiting */
+      if(m_bRasterChanged) {
+         if(m_bRasterFullRebuild || m_vecRaster.empty()) {
+            /* Calculate the raster size */
+            const CVector3& cArenaSize = CSimulator::GetInstance().GetSpace().GetArenaSize();
+            const CVector3& cArenaCenter = CSimulator::GetInstance().GetSpace().GetArenaCenter();
+            m_cRasterOrigin.Set(cArenaCenter.GetX() - cArenaSize.GetX() * 0.5f,
+                                cArenaCenter.GetY() - cArenaSize.GetY() * 0.5f);
+            m_nRasterWidth  = Max<SInt32>(1, Ceil(cArenaSize.GetX() * m_fRasterPixelsPerMeter));
+            m_nRasterHeight = Max<SInt32>(1, Ceil(cArenaSize.GetY() * m_fRasterPixelsPerMeter));
+            m_vecRaster.resize(m_nRasterWidth * m_nRasterHeight);
+            RasterizePixels(0, 0, m_nRasterWidth - 1, m_nRasterHeight - 1);
+         }
+         else {
+            /* Fill only the pixels whose center may lie in the changed rectangle */
+            SInt32 nMinI = Floor((m_cRasterChangedMin.GetX() - m_cRasterOrigin.GetX()) * m_fRasterPixelsPerMeter);
+            SInt32 nMinJ = Floor((m_cRasterChangedMin.GetY() - m_cRasterOrigin.GetY()) * m_fRasterPixelsPerMeter);
+            SInt32 nMaxI = Floor((m_cRasterChangedMax.GetX() - m_cRasterOrigin.GetX()) * m_fRasterPixelsPerMeter);
+            SInt32 nMaxJ = Floor((m_cRasterChangedMax.GetY() - m_cRasterOrigin.GetY()) * m_fRasterPixelsPerMeter);
+            RasterizePixels(Max<SInt32>(nMinI, 0),
+                            Max<SInt32>(nMinJ, 0),
+                            Min<SInt32>(nMaxI, m_nRasterWidth - 1),
+                            Min<SInt32>(nMaxJ, m_nRasterHeight - 1));
+         }
+         m_bRasterFullRebuild = false;
+         /* Publish the result; the release store pairs with the acquire
+            load in GetColorAtPoint() */
+         __atomic_store_n(&m_bRasterChanged, false, __ATOMIC_RELEASE);
+      }
+      pthread_mutex_unlock(&m_tRasterMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFloorEntity::RasterizePixels(SInt32 n_min_i,
+                                      SInt32 n_min_j,
+                                      SInt32 n_max_i,
+                                      SInt32 n_max_j) {
+      /* Sample the color source at the center of each pixel */
+      Real fPixelSize = 1.0f / m_fRasterPixelsPerMeter;
+      for(SInt32 j = n_min_j; j <= n_max_j; ++j) {
+         Real fY = m_cRasterOrigin.GetY() + (j + 0.5f) * fPixelSize;
+         for(SInt32 i = n_min_i; i <= n_max_i; ++i) {
+            m_vecRaster[j * m_nRasterWidth + i] =
+               m_pcColorSource->GetColorAtPoint(m_cRasterOrigin.GetX() + (i + 0.5f) * fPixelSize,
+                                                fY);
+         }
+      }
    }
 
    /****************************************/
@@ -315,7 +454,24 @@ namespace argos {
                    "    ...\n"
                    "  </arena>\n\n"
                    "OPTIONAL XML CONFIGURATION\n\n"
-                   "None for the time being.\n",
+                   "By default, the ground sensors ask the color source for the color at each\n"
+                   "point they sense. With loop functions, this means calling GetFloorColor()\n"
+                   "for every sensor at every step. Setting the attribute 'rasterize' to 'true'\n"
+                   "makes the floor sample the color source once into an image with resolution\n"
+                   "'pixels_per_meter', and the sensors read the color from this image. The image\n"
+                   "is sampled again only when the floor is marked as changed with SetChanged(),\n"
+                   "for instance by the loop functions, and when the simulation is reset. If only\n"
+                   "a part of the floor changed, SetChanged() can be passed the corners of the\n"
+                   "changed rectangle, and only that part of the image is sampled again. When\n"
+                   "'source' is set to 'image', 'pixels_per_meter' is required too:\n\n"
+                   "  <arena ...>\n"
+                   "    ...\n"
+                   "    <floor id=\"floor\"\n"
+                   "           source=\"loop_functions\"\n"
+                   "           pixels_per_meter=\"100\"\n"
+                   "           rasterize=\"true\" />\n"
+                   "    ...\n"
+                   "  </arena>\n",
                    "Usable"
       );
 
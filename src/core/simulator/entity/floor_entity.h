@@ -15,6 +15,8 @@ namespace argos {
 #include <argos3/core/utility/math/vector2.h>
 #include <argos3/core/utility/math/vector3.h>
 #include <argos3/core/utility/datatypes/color.h>
+#include <vector>
+#include <pthread.h>
 
 namespace argos {
 
@@ -92,6 +94,7 @@ namespace argos {
 
       /**
        * Returns the color at the given point.
+       * If the floor is rasterized, the color is taken from the raster.
        * @param f_x The x coordinate on the floor
        * @param f_y The y coordinate on the floor
        * @returns the color at the given point
@@ -102,9 +105,28 @@ namespace argos {
                       "The floor entity \"" <<
                       GetId() <<
                       "\" has no associated color source.");
+         if(m_bRasterized) {
+            /* The acquire load pairs with the release store in Rasterize(),
+               so the raster is complete once the flag reads false */
+            if(__atomic_load_n(&m_bRasterChanged, __ATOMIC_ACQUIRE)) Rasterize();
+            /* Clamp the pixel coordinates to the raster */
+            SInt32 nI = static_cast<SInt32>((f_x - m_cRasterOrigin.GetX()) * m_fRasterPixelsPerMeter);
+            SInt32 nJ = static_cast<SInt32>((f_y - m_cRasterOrigin.GetY()) * m_fRasterPixelsPerMeter);
+            nI = Min<SInt32>(Max<SInt32>(nI, 0), m_nRasterWidth - 1);
+            nJ = Min<SInt32>(Max<SInt32>(nJ, 0), m_nRasterHeight - 1);
+            return m_vecRaster[nJ * m_nRasterWidth + nI];
+         }
          return m_pcColorSource->GetColorAtPoint(f_x, f_y);
       }
 
+      /**
+       * Returns <tt>true</tt> if the floor colors are sampled from a raster.
+       * @return <tt>true</tt> if the floor colors are sampled from a raster.
+       */
+      inline bool IsRasterized() const {
+         return m_bRasterized;
+      }
+
       /**
        * Returns <tt>true</tt> if the floor color has changed.
        * It is mainly used by the OpenGL visualization to know when to create a new texture.
@@ -116,11 +138,21 @@ namespace argos {
 
       /**
        * Marks the floor color as changed.
+       * If the floor is rasterized, the whole raster is sampled again.
        * @see HasChanged
        */
-      inline void SetChanged() {
-         m_bHasChanged = true;
-      }
+      void SetChanged();
+
+      /**
+       * Marks the floor color as changed in the given rectangle.
+       * If the floor is rasterized, only the pixels in the rectangle are
+       * sampled again. Rectangles marked before the next reading are merged.
+       * @param c_min_corner The corner of the rectangle with the smallest coordinates.
+       * @param c_max_corner The corner of the rectangle with the largest coordinates.
+       * @see HasChanged
+       */
+      void SetChanged(const CVector2& c_min_corner,
+                      const CVector2& c_max_corner);
 
       /**
        * Marks the floor color as not changed.
@@ -144,6 +176,24 @@ namespace argos {
          return "floor";
       }
 
+   private:
+
+      void InitRasterMutex();
+
+      /**
+       * Fills the changed part of the raster with the colors of the color source.
+       * This method is thread-safe.
+       */
+      void Rasterize();
+
+      /**
+       * Samples the color source into the given pixels of the raster.
+       */
+      void RasterizePixels(SInt32 n_min_i,
+                           SInt32 n_min_j,
+                           SInt32 n_max_i,
+                           SInt32 n_max_j);
+
    private:
 
       /**
@@ -160,6 +210,54 @@ namespace argos {
        * Set to <tt>true</tt> when the floor color has changed.
        */
       bool               m_bHasChanged;
+
+      /**
+       * Set to <tt>true</tt> when the floor colors are sampled from a raster.
+       */
+      bool               m_bRasterized;
+
+      /**
+       * Set to <tt>true</tt> when part of the raster must be filled again.
+       * It is written with release semantics and read with acquire semantics.
+       */
+      bool               m_bRasterChanged;
+
+      /**
+       * Set to <tt>true</tt> when the whole raster must be filled again.
+       */
+      bool               m_bRasterFullRebuild;
+
+      /**
+       * The rectangle to fill again, when not the whole raster changed.
+       */
+      CVector2           m_cRasterChangedMin;
+      CVector2           m_cRasterChangedMax;
+
+      /**
+       * The raster, stored row by row.
+       */
+      std::vector<CColor> m_vecRaster;
+
+      /**
+       * The size of the raster in pixels.
+       */
+      SInt32             m_nRasterWidth;
+      SInt32             m_nRasterHeight;
+
+      /**
+       * The resolution of the raster.
+       */
+      Real               m_fRasterPixelsPerMeter;
+
+      /**
+       * The position of the corner of the raster with the smallest coordinates.
+       */
+      CVector2           m_cRasterOrigin;
+
+      /**
+       * Makes sure that only one thread fills the raster.
+       */
+      pthread_mutex_t    m_tRasterMutex;
    };
 }
 
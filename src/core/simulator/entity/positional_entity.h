@@ -33,6 +33,9 @@ namespace argos {
       virtual void Init(TConfigurationNode& t_tree);
       virtual void Reset();
 
+      virtual void SaveState(CByteArray& c_buffer);
+      virtual void LoadState(CByteArray& c_buffer);
+
       inline const CVector3& GetPosition() const {
          return m_cPosition;
       }
@@ -41,7 +44,7 @@ namespace argos {
          return m_cInitPosition;
       }
 
-      inline void SetPosition(const CVector3& c_position) {
+      virtual void SetPosition(const CVector3& c_position) {
          m_cPosition = c_position;
       }
 
@@ -17,6 +17,7 @@ namespace argos {
 }
 
 #include <argos3/core/utility/configuration/base_configurable_resource.h>
+#include <argos3/core/utility/configuration/memento.h>
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/space/space.h>
 #include <argos3/core/utility/datatypes/color.h>
@@ -65,7 +66,8 @@ namespace argos {
     * they are promoted to the core ARGoS code.
     * </p>
     */
-   class CLoopFunctions : public CBaseConfigurableResource {
+   class CLoopFunctions : public CBaseConfigurableResource,
+                          public CMemento {
 
    public:
 
@@ -100,6 +102,24 @@ namespace argos {
        */
       virtual void Reset() {}
 
+      /**
+       * Saves the user-defined state of the loop functions.
+       * Override this method if the loop functions keep state across steps
+       * that must survive a checkpoint, such as accumulated statistics.
+       * The default implementation of this method does nothing.
+       * @param c_buffer The target buffer.
+       * @see CSimulator::SaveCheckpoint()
+       */
+      virtual void SaveState(CByteArray& c_buffer) {}
+
+      /**
+       * Restores the user-defined state of the loop functions.
+       * The default implementation of this method does nothing.
+       * @param c_buffer The source buffer.
+       * @see CSimulator::LoadCheckpoint()
+       */
+      virtual void LoadState(CByteArray& c_buffer) {}
+
       /**
        * Executes user-defined destruction logic.
        * This method should undo whatever is done in Init().
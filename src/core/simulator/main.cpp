@@ -34,8 +34,17 @@ int main(int n_argc, char** ppch_argv) {
          case CARGoSCommandLineArgParser::ACTION_RUN_EXPERIMENT:
             CDynamicLoading::LoadAllLibraries();
             cSimulator.SetExperimentFileName(cACLAP.GetExperimentConfigFile());
-            cSimulator.LoadExperiment();
-            cSimulator.Execute();
+            if(cACLAP.GetBatchFile() != "") {
+               cSimulator.ExecuteBatch(cACLAP.GetBatchFile());
+            }
+            else if(cACLAP.GetForkWorkers() > 0) {
+               cSimulator.LoadExperiment();
+               cSimulator.ExecuteForked(cACLAP.GetForkWorkers());
+            }
+            else {
+               cSimulator.LoadExperiment();
+               cSimulator.Execute();
+            }
             break;
          case CARGoSCommandLineArgParser::ACTION_QUERY:
             CDynamicLoading::LoadAllLibraries();
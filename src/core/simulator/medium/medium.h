@@ -65,9 +65,39 @@ namespace argos {
 
       /**
        * Updates the state of this medium.
+       * The update of a step is made of three parts, executed in this order:
+       * <ul>
+       * <li>Update(), executed for all the media in parallel
+       * <li>UpdateThread(), executed by every thread of the space
+       * <li>PostUpdate(), executed in the main thread
+       * </ul>
+       * A medium whose update can be split among the threads does the
+       * preparation here, its share of the work in UpdateThread(), and
+       * collects the results in PostUpdate().
+       * @see UpdateThread()
+       * @see PostUpdate()
        */
       virtual void Update() = 0;
 
+      /**
+       * Performs the share of the update assigned to a thread of the space.
+       * Each thread index is passed exactly once per step, and the calls with
+       * different indices may run concurrently.
+       * By default, this method does nothing.
+       * @param un_thread The index of the thread, in <tt>[0,un_threads)</tt>.
+       * @param un_threads The number of threads sharing the update.
+       * @see Update()
+       */
+      virtual void UpdateThread(UInt32 un_thread,
+                                UInt32 un_threads) {}
+
+      /**
+       * Completes the update after all the threads are done.
+       * By default, this method does nothing.
+       * @see Update()
+       */
+      virtual void PostUpdate() {}
+
       /**
        * Returns the id of this medium.
        * @return The id of this medium.
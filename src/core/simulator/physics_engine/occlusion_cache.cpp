@@ -0,0 +1,58 @@
+/**
+ * @file <argos3/core/simulator/physics_engine/occlusion_cache.cpp>
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#include "occlusion_cache.h"
+#include "physics_engine.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   COcclusionCache::COcclusionCache() :
+      m_fSquareTolerance(0.0f) {}
+
+   /****************************************/
+   /****************************************/
+
+   void COcclusionCache::Init(Real f_tolerance) {
+      m_fSquareTolerance = f_tolerance * f_tolerance;
+      CSimulator::GetInstance().GetSpace().GetMotionGrid().Enable(f_tolerance);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool COcclusionCache::IsSegmentOccluded(const void* pt_key,
+                                           const CRay3& c_ray,
+                                           const CEmbodiedEntity* pc_entity_1,
+                                           const CEmbodiedEntity* pc_entity_2) {
+      CMotionGrid& cMotionGrid = CSimulator::GetInstance().GetSpace().GetMotionGrid();
+      /* Make sure the motion grid is up to date */
+      cMotionGrid.Update();
+      /* Is there a valid stored result? */
+      TItemMap::iterator it = m_mapItems.find(pt_key);
+      if(it != m_mapItems.end() &&
+         it->second.Timestamp <= cMotionGrid.GetStamp() &&
+         SquareDistance(it->second.Segment.GetStart(), c_ray.GetStart()) <= m_fSquareTolerance &&
+         SquareDistance(it->second.Segment.GetEnd(), c_ray.GetEnd()) <= m_fSquareTolerance &&
+         !cMotionGrid.HasMotionAlong(c_ray, it->second.Timestamp)) {
+         return it->second.Occluded;
+      }
+      /* Perform the check and store the result */
+      SItem& sItem = m_mapItems[pt_key];
+      sItem.Segment = c_ray;
+      sItem.Timestamp = cMotionGrid.GetStamp();
+      sItem.Occluded = argos::IsSegmentOccluded(c_ray, pc_entity_1, pc_entity_2);
+      return sItem.Occluded;
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
@@ -0,0 +1,102 @@
+/**
+ * @file <argos3/core/simulator/physics_engine/occlusion_cache.h>
+ *
+ * @brief This file provides the definition of a cache for the results
+ * of occlusion checks.
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#ifndef OCCLUSION_CACHE_H
+#define OCCLUSION_CACHE_H
+
+namespace argos {
+   class COcclusionCache;
+   class CEmbodiedEntity;
+}
+
+#include <argos3/core/utility/math/ray3.h>
+#include <map>
+
+namespace argos {
+
+   /**
+    * A cache for the results of IsSegmentOccluded().
+    * <p>
+    * Media and sensors often check the same segments at every step, for
+    * instance between two robots that are not moving, or between a camera
+    * and an LED. This cache stores the result of each check under a key
+    * chosen by the user, typically the entity at the other end of the
+    * segment. The stored result is reused as long as:
+    * <ul>
+    * <li>both ends of the segment moved by less than the tolerance, and</li>
+    * <li>nothing moved in the cells of the motion grid crossed by the segment.</li>
+    * </ul>
+    * </p>
+    * <p>
+    * A cache instance is not thread-safe. Components that check segments in
+    * parallel should use one instance per thread or per entity.
+    * </p>
+    * @see CMotionGrid
+    */
+   class COcclusionCache {
+
+   public:
+
+      COcclusionCache();
+
+      /**
+       * Initializes the cache.
+       * This method also activates the motion grid of the space.
+       * @param f_tolerance How much the ends of a segment can move before a stored result is discarded.
+       */
+      void Init(Real f_tolerance);
+
+      /**
+       * Forgets all the stored results.
+       * Call this method when the simulation is reset.
+       */
+      inline void Clear() {
+         m_mapItems.clear();
+      }
+
+      /**
+       * Checks whether the given segment is occluded by an embodied entity.
+       * If a valid result is stored under the given key, it is returned.
+       * Otherwise, the check is performed and the result stored.
+       * @param pt_key The key to store the result under.
+       * @param c_ray The segment to test.
+       * @param pc_entity_1 An entity to exclude from the check, or <tt>NULL</tt>.
+       * @param pc_entity_2 Another entity to exclude from the check, or <tt>NULL</tt>.
+       * @return <tt>true</tt> if the segment is occluded
+       * @see argos::IsSegmentOccluded
+       */
+      bool IsSegmentOccluded(const void* pt_key,
+                             const CRay3& c_ray,
+                             const CEmbodiedEntity* pc_entity_1 = NULL,
+                             const CEmbodiedEntity* pc_entity_2 = NULL);
+
+   private:
+
+      /** A stored result */
+      struct SItem {
+         CRay3 Segment;
+         UInt32 Timestamp;
+         bool Occluded;
+      };
+
+      typedef std::map<const void*, SItem> TItemMap;
+
+   private:
+
+      /** The stored results */
+      TItemMap m_mapItems;
+
+      /** The square of the tolerance */
+      Real m_fSquareTolerance;
+
+   };
+
+}
+
+#endif
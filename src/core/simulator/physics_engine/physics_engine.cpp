@@ -5,6 +5,7 @@
  */
 
 #include <cstdlib>
+#include <pthread.h>
 #include "physics_engine.h"
 #include <argos3/core/utility/logging/argos_log.h>
 #include <argos3/core/utility/math/vector3.h>
@@ -24,6 +25,12 @@ namespace argos {
       static CSimulator& cSimulator = CSimulator::GetInstance();
       /* Clear data */
       t_data.clear();
+      /* Use the ray grid, if active */
+      CRayGrid& cRayGrid = cSimulator.GetSpace().GetRayGrid();
+      if(cRayGrid.IsEnabled()) {
+         cRayGrid.CheckIntersectionWithRay(t_data, c_ray);
+         return !t_data.empty();
+      }
       /* Create a reference to the vector of physics engines */
       CPhysicsEngine::TVector& vecEngines = cSimulator.GetPhysicsEngines();
       /* Ask each engine to perform the ray query */
@@ -38,18 +45,53 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * The ray queries are performed by the sensors, which may run in
+    * parallel threads. Each thread gets its own intersection buffer, which
+    * is created at the first query and kept until the thread exits. This
+    * way, no memory is allocated in the ray queries after the first step.
+    */
+   static pthread_key_t  tIntersectionBufferKey;
+   static pthread_once_t tIntersectionBufferKeyOnce = PTHREAD_ONCE_INIT;
+
+   static void DestroyIntersectionBuffer(void* p_buffer) {
+      delete reinterpret_cast<TEmbodiedEntityIntersectionData*>(p_buffer);
+   }
+
+   static void CreateIntersectionBufferKey() {
+      pthread_key_create(&tIntersectionBufferKey, DestroyIntersectionBuffer);
+   }
+
+   static TEmbodiedEntityIntersectionData& GetIntersectionBuffer() {
+      pthread_once(&tIntersectionBufferKeyOnce, CreateIntersectionBufferKey);
+      TEmbodiedEntityIntersectionData* ptBuffer =
+         reinterpret_cast<TEmbodiedEntityIntersectionData*>(pthread_getspecific(tIntersectionBufferKey));
+      if(ptBuffer == NULL) {
+         ptBuffer = new TEmbodiedEntityIntersectionData;
+         pthread_setspecific(tIntersectionBufferKey, ptBuffer);
+      }
+      return *ptBuffer;
+   }
+
+   /****************************************/
+   /****************************************/
+
    bool GetClosestEmbodiedEntityIntersectedByRay(SEmbodiedEntityIntersectionItem& s_item,
                                                  const CRay3& c_ray) {
+      /* This variable is instantiated at the first call of this function, once and forever */
+      static CSimulator& cSimulator = CSimulator::GetInstance();
       /* Initialize s_item */
       s_item.IntersectedEntity = NULL;
       s_item.TOnRay = 1.0f;
-      /* Perform full ray query */
-      TEmbodiedEntityIntersectionData tData;
-      GetEmbodiedEntitiesIntersectedByRay(tData, c_ray);
-      /* Go through intersections and find the closest */
-      for(size_t i = 0; i < tData.size(); ++i) {
-         if(s_item.TOnRay > tData[i].TOnRay)
-            s_item = tData[i];
+      /* Use the ray grid, if active */
+      CRayGrid& cRayGrid = cSimulator.GetSpace().GetRayGrid();
+      if(cRayGrid.IsEnabled()) {
+         return cRayGrid.CheckClosestIntersectionWithRay(s_item, c_ray, NULL);
+      }
+      /* Ask each engine for its closest intersection, passing the best one found so far */
+      CPhysicsEngine::TVector& vecEngines = cSimulator.GetPhysicsEngines();
+      for(size_t i = 0; i < vecEngines.size(); ++i) {
+         vecEngines[i]->CheckClosestIntersectionWithRay(s_item, c_ray, NULL);
       }
       /* Return true if an intersection was found */
       return (s_item.IntersectedEntity != NULL);
@@ -61,18 +103,20 @@ namespace argos {
    bool GetClosestEmbodiedEntityIntersectedByRay(SEmbodiedEntityIntersectionItem& s_item,
                                                  const CRay3& c_ray,
                                                  CEmbodiedEntity& c_entity) {
+      /* This variable is instantiated at the first call of this function, once and forever */
+      static CSimulator& cSimulator = CSimulator::GetInstance();
       /* Initialize s_item */
       s_item.IntersectedEntity = NULL;
       s_item.TOnRay = 1.0f;
-      /* Perform full ray query */
-      TEmbodiedEntityIntersectionData tData;
-      GetEmbodiedEntitiesIntersectedByRay(tData, c_ray);
-      /* Go through intersections and find the closest */
-      for(size_t i = 0; i < tData.size(); ++i) {
-         if(s_item.TOnRay > tData[i].TOnRay &&
-            s_item.IntersectedEntity != &c_entity) {
-            s_item = tData[i];
-         }
+      /* Use the ray grid, if active */
+      CRayGrid& cRayGrid = cSimulator.GetSpace().GetRayGrid();
+      if(cRayGrid.IsEnabled()) {
+         return cRayGrid.CheckClosestIntersectionWithRay(s_item, c_ray, &c_entity);
+      }
+      /* Ask each engine for its closest intersection, passing the best one found so far */
+      CPhysicsEngine::TVector& vecEngines = cSimulator.GetPhysicsEngines();
+      for(size_t i = 0; i < vecEngines.size(); ++i) {
+         vecEngines[i]->CheckClosestIntersectionWithRay(s_item, c_ray, &c_entity);
       }
       /* Return true if an intersection was found */
       return (s_item.IntersectedEntity != NULL);
@@ -81,6 +125,73 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   bool IsSegmentOccluded(const CRay3& c_ray,
+                          const CEmbodiedEntity* pc_entity) {
+      return IsSegmentOccluded(c_ray, pc_entity, NULL);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool IsSegmentOccluded(const CRay3& c_ray,
+                          const CEmbodiedEntity* pc_entity_1,
+                          const CEmbodiedEntity* pc_entity_2) {
+      /* This variable is instantiated at the first call of this function, once and forever */
+      static CSimulator& cSimulator = CSimulator::GetInstance();
+      /* Use the ray grid, if active */
+      CRayGrid& cRayGrid = cSimulator.GetSpace().GetRayGrid();
+      if(cRayGrid.IsEnabled()) {
+         return cRayGrid.IsSegmentOccluded(c_ray, pc_entity_1, pc_entity_2);
+      }
+      /* Stop at the first engine that finds an intersection */
+      CPhysicsEngine::TVector& vecEngines = cSimulator.GetPhysicsEngines();
+      for(size_t i = 0; i < vecEngines.size(); ++i) {
+         if(vecEngines[i]->IsSegmentOccluded(c_ray, pc_entity_1, pc_entity_2)) {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   size_t GetClosestEmbodiedEntitiesIntersectedByRays(SEmbodiedEntityIntersectionItem* ps_items,
+                                                      const CRay3* pc_rays,
+                                                      size_t un_num_rays,
+                                                      const CEmbodiedEntity* pc_entity) {
+      /* This variable is instantiated at the first call of this function, once and forever */
+      static CSimulator& cSimulator = CSimulator::GetInstance();
+      /* Initialize the items */
+      for(size_t i = 0; i < un_num_rays; ++i) {
+         ps_items[i].IntersectedEntity = NULL;
+         ps_items[i].TOnRay = 1.0f;
+      }
+      /* Use the ray grid, if active */
+      CRayGrid& cRayGrid = cSimulator.GetSpace().GetRayGrid();
+      if(cRayGrid.IsEnabled()) {
+         for(size_t i = 0; i < un_num_rays; ++i) {
+            cRayGrid.CheckClosestIntersectionWithRay(ps_items[i], pc_rays[i], pc_entity);
+         }
+      }
+      else {
+         /* Ask each engine to perform the batch query */
+         CPhysicsEngine::TVector& vecEngines = cSimulator.GetPhysicsEngines();
+         for(size_t i = 0; i < vecEngines.size(); ++i) {
+            vecEngines[i]->CheckClosestIntersectionWithRays(ps_items, pc_rays, un_num_rays, pc_entity);
+         }
+      }
+      /* Count the rays with an intersection */
+      size_t unHits = 0;
+      for(size_t i = 0; i < un_num_rays; ++i) {
+         if(ps_items[i].IntersectedEntity != NULL) ++unHits;
+      }
+      return unHits;
+   }
+
+   /****************************************/
+   /****************************************/
+
    /* The default value of the simulation clock tick */
    Real CPhysicsEngine::m_fSimulationClockTick = 0.1f;
    Real CPhysicsEngine::m_fInverseSimulationClockTick = 1.0f / CPhysicsEngine::m_fSimulationClockTick;
@@ -261,6 +372,57 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   bool CPhysicsEngine::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                        const CRay3& c_ray,
+                                                        const CEmbodiedEntity* pc_entity) const {
+      bool bFound = false;
+      TEmbodiedEntityIntersectionData& tData = GetIntersectionBuffer();
+      tData.clear();
+      CheckIntersectionWithRay(tData, c_ray);
+      for(size_t i = 0; i < tData.size(); ++i) {
+         if(s_item.TOnRay > tData[i].TOnRay &&
+            tData[i].IntersectedEntity != pc_entity) {
+            s_item = tData[i];
+            bFound = true;
+         }
+      }
+      return bFound;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CPhysicsEngine::IsSegmentOccluded(const CRay3& c_ray,
+                                          const CEmbodiedEntity* pc_entity_1,
+                                          const CEmbodiedEntity* pc_entity_2) const {
+      TEmbodiedEntityIntersectionData& tData = GetIntersectionBuffer();
+      tData.clear();
+      CheckIntersectionWithRay(tData, c_ray);
+      for(size_t i = 0; i < tData.size(); ++i) {
+         if(tData[i].TOnRay < 1.0f &&
+            tData[i].IntersectedEntity != pc_entity_1 &&
+            tData[i].IntersectedEntity != pc_entity_2) {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhysicsEngine::CheckClosestIntersectionWithRays(SEmbodiedEntityIntersectionItem* ps_items,
+                                                         const CRay3* pc_rays,
+                                                         size_t un_num_rays,
+                                                         const CEmbodiedEntity* pc_entity) const {
+      for(size_t i = 0; i < un_num_rays; ++i) {
+         CheckClosestIntersectionWithRay(ps_items[i], pc_rays[i], pc_entity);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    Real CPhysicsEngine::GetSimulationClockTick() {
       return m_fSimulationClockTick;
    }
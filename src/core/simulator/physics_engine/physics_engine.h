@@ -21,6 +21,7 @@ namespace argos {
 #include <argos3/core/utility/math/ray2.h>
 #include <argos3/core/utility/configuration/base_configurable_resource.h>
 #include <argos3/core/utility/configuration/argos_configuration.h>
+#include <argos3/core/utility/configuration/memento.h>
 #include <argos3/core/utility/datatypes/datatypes.h>
 #include <argos3/core/utility/plugins/factory.h>
 
@@ -84,10 +85,52 @@ namespace argos {
                                                         const CRay3& c_ray,
                                                         CEmbodiedEntity& c_entity);
 
+   /**
+    * Returns the closest intersection with an embodied entity for each ray in a batch.
+    * This function is meant for sensors that cast many rays at once, such as
+    * the proximity sensors. The physics engines are queried once for the whole
+    * batch, and no memory is allocated.
+    * For each ray with no intersection, <tt>ps_items[i].IntersectedEntity</tt>
+    * is set to <tt>NULL</tt> and <tt>ps_items[i].TOnRay</tt> is set to 1.
+    * @param ps_items The array of intersection data, one per ray.
+    * @param pc_rays The array of rays to test for intersections.
+    * @param un_num_rays The number of rays.
+    * @param pc_entity The entity to exclude from the intersection check, or <tt>NULL</tt>.
+    * @return The number of rays for which an intersection was found
+    */
+   extern size_t GetClosestEmbodiedEntitiesIntersectedByRays(SEmbodiedEntityIntersectionItem* ps_items,
+                                                             const CRay3* pc_rays,
+                                                             size_t un_num_rays,
+                                                             const CEmbodiedEntity* pc_entity = NULL);
+
+   /**
+    * Checks whether the given segment is occluded by an embodied entity.
+    * This is cheaper than GetClosestEmbodiedEntityIntersectedByRay(), because
+    * the search stops at the first intersection found.
+    * @param c_ray The segment to test.
+    * @param pc_entity The entity to exclude from the check, or <tt>NULL</tt>.
+    * @return <tt>true</tt> if at least one intersection is found
+    */
+   extern bool IsSegmentOccluded(const CRay3& c_ray,
+                                 const CEmbodiedEntity* pc_entity = NULL);
+
+   /**
+    * Checks whether the given segment is occluded by an embodied entity.
+    * This version allows you to exclude the entities at both ends of the segment.
+    * @param c_ray The segment to test.
+    * @param pc_entity_1 The first entity to exclude from the check, or <tt>NULL</tt>.
+    * @param pc_entity_2 The second entity to exclude from the check, or <tt>NULL</tt>.
+    * @return <tt>true</tt> if at least one intersection is found
+    */
+   extern bool IsSegmentOccluded(const CRay3& c_ray,
+                                 const CEmbodiedEntity* pc_entity_1,
+                                 const CEmbodiedEntity* pc_entity_2);
+
    /****************************************/
    /****************************************/
 
-   class CPhysicsEngine : public CBaseConfigurableResource {
+   class CPhysicsEngine : public CBaseConfigurableResource,
+                          public CMemento {
 
    public:
 
@@ -141,6 +184,28 @@ namespace argos {
 
       virtual void Update() = 0;
 
+      /**
+       * Saves the engine-wide state, such as internal step counters.
+       * The state of the models is saved with their entities. An engine
+       * that cannot save part of its state should drop it here as it does
+       * in LoadState(), so that the run that saves the checkpoint matches
+       * the runs restored from it.
+       * By default, this method does nothing.
+       * @param c_buffer The target buffer.
+       * @see CSimulator::SaveCheckpoint()
+       */
+      virtual void SaveState(CByteArray& c_buffer) {}
+
+      /**
+       * Restores the engine-wide state.
+       * This method is called after the entities and their models have
+       * been restored, so it can also drop caches that refer to the old state.
+       * By default, this method does nothing.
+       * @param c_buffer The source buffer.
+       * @see CSimulator::LoadCheckpoint()
+       */
+      virtual void LoadState(CByteArray& c_buffer) {}
+
       /**
        * Executes extra initialization activities after the space has been initialized.
        * By default, this method does nothing.
@@ -227,6 +292,57 @@ namespace argos {
       virtual void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
                                             const CRay3& c_ray) const = 0;
 
+      /**
+       * Check the closest intersection in this engine with the given ray.
+       * The value of <tt>s_item.TOnRay</tt> on entry is the maximum t to consider:
+       * <tt>s_item</tt> is updated only if this engine finds an intersection closer
+       * than that. This way, the results of several engines can be accumulated in
+       * the same item, and each engine can discard early whatever lies beyond the
+       * closest intersection found so far.
+       * The default implementation calls CheckIntersectionWithRay() and scans
+       * the result, reusing a per-thread buffer for the intersection data.
+       * Engines should override this method to stop the search early.
+       * @param s_item The closest intersection found so far.
+       * @param c_ray The test ray.
+       * @param pc_entity The entity to exclude from the intersection check, or <tt>NULL</tt>.
+       * @return <tt>true</tt> if this engine updated <tt>s_item</tt>
+       */
+      virtual bool CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                   const CRay3& c_ray,
+                                                   const CEmbodiedEntity* pc_entity) const;
+
+      /**
+       * Checks whether any object in this engine intersects the given segment.
+       * Intersections at the very end of the segment (t = 1) do not count.
+       * Implementations should return as soon as an intersection is found.
+       * The default implementation calls CheckIntersectionWithRay(), reusing
+       * a per-thread buffer for the intersection data.
+       * @param c_ray The test segment.
+       * @param pc_entity_1 An entity to exclude from the check, or <tt>NULL</tt>.
+       * @param pc_entity_2 Another entity to exclude from the check, or <tt>NULL</tt>.
+       * @return <tt>true</tt> if an intersection is found
+       */
+      virtual bool IsSegmentOccluded(const CRay3& c_ray,
+                                     const CEmbodiedEntity* pc_entity_1,
+                                     const CEmbodiedEntity* pc_entity_2) const;
+
+      /**
+       * Check the closest intersection in this engine for each ray in a batch.
+       * For each ray, <tt>ps_items[i]</tt> is updated only if this engine
+       * finds an intersection closer than <tt>ps_items[i].TOnRay</tt>; this
+       * way, the results of several engines can be accumulated in the same array.
+       * The default implementation calls CheckClosestIntersectionWithRay() for each
+       * ray.
+       * @param ps_items The array of intersection data, one per ray.
+       * @param pc_rays The array of test rays.
+       * @param un_num_rays The number of rays.
+       * @param pc_entity The entity to exclude from the intersection check, or <tt>NULL</tt>.
+       */
+      virtual void CheckClosestIntersectionWithRays(SEmbodiedEntityIntersectionItem* ps_items,
+                                                    const CRay3* pc_rays,
+                                                    size_t un_num_rays,
+                                                    const CEmbodiedEntity* pc_entity) const;
+
       /**
        * Returns the simulation clock tick.
        * The clock tick is the time elapsed between two control steps
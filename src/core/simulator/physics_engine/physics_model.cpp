@@ -1,12 +1,62 @@
 #include "physics_model.h"
 #include <argos3/core/simulator/entity/embodied_entity.h>
 #include <argos3/core/simulator/entity/composable_entity.h>
+#include <argos3/core/utility/math/ray3.h>
 
 namespace argos {
 
    /****************************************/
    /****************************************/
 
+   /*
+    * Intersects the range [f_t_min,f_t_max] with the range of t in which
+    * the ray is between f_min and f_max along an axis.
+    * Returns false if the resulting range is empty.
+    */
+   static inline bool ClipRayRangeToSlab(Real& f_t_min,
+                                         Real& f_t_max,
+                                         Real f_start,
+                                         Real f_end,
+                                         Real f_min,
+                                         Real f_max) {
+      Real fDelta = f_end - f_start;
+      if(fDelta == 0.0f) {
+         /* The ray is parallel to the slab */
+         return (f_start >= f_min && f_start <= f_max);
+      }
+      Real fT1 = (f_min - f_start) / fDelta;
+      Real fT2 = (f_max - f_start) / fDelta;
+      if(fT1 > fT2) {
+         Real fTmp = fT1;
+         fT1 = fT2;
+         fT2 = fTmp;
+      }
+      if(fT1 > f_t_min) f_t_min = fT1;
+      if(fT2 < f_t_max) f_t_max = fT2;
+      return f_t_min <= f_t_max;
+   }
+
+   bool SBoundingBox::Intersects(Real& f_t_on_ray,
+                                 const CRay3& c_ray) const {
+      Real fTMin = 0.0f, fTMax = 1.0f;
+      if(ClipRayRangeToSlab(fTMin, fTMax,
+                            c_ray.GetStart().GetX(), c_ray.GetEnd().GetX(),
+                            MinCorner.GetX(), MaxCorner.GetX()) &&
+         ClipRayRangeToSlab(fTMin, fTMax,
+                            c_ray.GetStart().GetY(), c_ray.GetEnd().GetY(),
+                            MinCorner.GetY(), MaxCorner.GetY()) &&
+         ClipRayRangeToSlab(fTMin, fTMax,
+                            c_ray.GetStart().GetZ(), c_ray.GetEnd().GetZ(),
+                            MinCorner.GetZ(), MaxCorner.GetZ())) {
+         f_t_on_ray = fTMin;
+         return true;
+      }
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
    SAnchor::SAnchor(CEmbodiedEntity& c_body,
                     const std::string& str_id,
                     UInt32 un_index,
@@ -87,4 +137,12 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   bool CPhysicsModel::CheckIntersectionWithRay(Real& f_t_on_ray,
+                                                const CRay3& c_ray) const {
+      return m_sBoundingBox.Intersects(f_t_on_ray, c_ray);
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
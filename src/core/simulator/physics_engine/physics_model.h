@@ -19,6 +19,7 @@ namespace argos {
 #include <argos3/core/utility/datatypes/datatypes.h>
 #include <argos3/core/utility/math/vector3.h>
 #include <argos3/core/utility/math/quaternion.h>
+#include <argos3/core/utility/configuration/memento.h>
 #include <map>
 #include <vector>
 #include <string>
@@ -94,12 +95,21 @@ namespace argos {
             (MinCorner.GetY() < s_bb.MaxCorner.GetY()) && (MaxCorner.GetY() > s_bb.MinCorner.GetY()) &&
             (MinCorner.GetZ() < s_bb.MaxCorner.GetZ()) && (MaxCorner.GetZ() > s_bb.MinCorner.GetZ());
       }
+
+      /**
+       * Checks whether the given ray intersects this bounding box.
+       * @param f_t_on_ray Set to the t at which the ray enters the box (0 if the ray starts inside).
+       * @param c_ray The ray to test.
+       * @return <tt>true</tt> if the ray intersects this bounding box.
+       */
+      bool Intersects(Real& f_t_on_ray,
+                      const CRay3& c_ray) const;
    };
 
    /****************************************/
    /****************************************/
 
-   class CPhysicsModel {
+   class CPhysicsModel : public CMemento {
 
    public:
 
@@ -167,6 +177,26 @@ namespace argos {
        */
       virtual void UpdateFromEntityStatus() = 0;
 
+      /**
+       * Saves the state of this model that is not stored in the entity.
+       * This is the state the engine integrates over time, such as
+       * velocities and accumulated control errors.
+       * By default, this method does nothing.
+       * @param c_buffer The target buffer.
+       * @see CEmbodiedEntity::SaveState()
+       */
+      virtual void SaveState(CByteArray& c_buffer) {}
+
+      /**
+       * Restores the state of this model.
+       * The anchors of the entity have already been restored when this
+       * method is called. Implementations must recalculate the bounding box.
+       * By default, this method does nothing.
+       * @param c_buffer The source buffer.
+       * @see CEmbodiedEntity::LoadState()
+       */
+      virtual void LoadState(CByteArray& c_buffer) {}
+
       /**
        * <p>
        * Moves the entity to the wanted position and orientation within this engine.
@@ -218,6 +248,20 @@ namespace argos {
        */
       virtual bool IsCollidingWithSomething() const = 0;
 
+      /**
+       * Checks whether the given ray intersects this model.
+       * This method is used by the ray queries that find their candidates
+       * without asking the physics engines, such as the ray grid of the space.
+       * The default implementation tests the bounding box of the model, which
+       * is conservative: models should override it with an exact test.
+       * @param f_t_on_ray Set to the t on the ray of the closest intersection.
+       * @param c_ray The ray to test.
+       * @return <tt>true</tt> if the ray intersects this model.
+       * @see CRayGrid
+       */
+      virtual bool CheckIntersectionWithRay(Real& f_t_on_ray,
+                                            const CRay3& c_ray) const;
+
       /**
        * Returns an axis-aligned box that contains the physics model.
        * The bounding box is often called AABB.
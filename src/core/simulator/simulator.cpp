@@ -8,7 +8,14 @@
 
 #include <iostream>
 #include <string>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
 #include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <argos3/core/utility/logging/argos_log.h>
 #include <argos3/core/utility/profiler/profiler.h>
 #include <argos3/core/utility/string_utilities.h>
@@ -17,6 +24,7 @@
 #include <argos3/core/simulator/space/space_no_threads.h>
 #include <argos3/core/simulator/space/space_multi_thread_balance_quantity.h>
 #include <argos3/core/simulator/space/space_multi_thread_balance_length.h>
+#include <argos3/core/simulator/space/space_multi_thread_work_stealing.h>
 #include <argos3/core/simulator/visualization/default_visualization.h>
 #include <argos3/core/simulator/physics_engine/physics_engine.h>
 #include <argos3/core/simulator/loop_functions.h>
@@ -45,10 +53,13 @@ namespace argos {
       m_unMaxSimulationClock(0),
       m_bWasRandomSeedSet(false),
       m_unThreads(0),
+      m_ePhaseSyncMethod(CPhaseSyncCounter::METHOD_CONDITION),
+      m_unPhaseSyncSpinIterations(10000),
       m_pcProfiler(NULL),
       m_bHumanReadableProfile(true),
       m_bRealTimeClock(false),
-      m_bTerminated(false) {}
+      m_bTerminated(false),
+      m_bForkedParent(false) {}
 
    /****************************************/
    /****************************************/
@@ -151,6 +162,8 @@ namespace argos {
       }
       /* Physics engines */
       InitPhysics2();
+      /* Bin the entities in the ray grid, as the media may cast rays already */
+      m_pcSpace->GetRayGrid().Update();
       /* Media */
       InitMedia2();
       /* Initialise visualization */
@@ -188,6 +201,7 @@ namespace argos {
          m_unRandomSeed = unSeed;
          LOG << "[INFO] Using random seed = " << m_unRandomSeed << std::endl;
       }
+      CRandom::GetCategory("argos").SetStep(0);
       CRandom::GetCategory("argos").ResetRNGs();
       /* Reset the space */
       m_pcSpace->Reset();
@@ -201,6 +215,8 @@ namespace argos {
           it != m_mapPhysicsEngines.end(); ++it) {
          it->second->Reset();
       }
+      /* Bin the entities in the ray grid at their initial positions */
+      m_pcSpace->GetRayGrid().Reset();
       /* Reset the loop functions */
       m_pcLoopFunctions->Reset();
       LOG.Flush();
@@ -210,10 +226,158 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * Checkpoint file layout: the magic string, the format version, then a
+    * list of sections, each made of its size as a UInt32 followed by its
+    * contents
+    */
+   static const char   CHECKPOINT_MAGIC[]   = "ARGOSCKP";
+   static const size_t CHECKPOINT_MAGIC_LEN = sizeof(CHECKPOINT_MAGIC) - 1;
+   static const UInt32 CHECKPOINT_VERSION   = 1;
+
+   static void AppendCheckpointSection(CByteArray& c_file,
+                                       const CByteArray& c_section) {
+      c_file << static_cast<UInt32>(c_section.Size());
+      c_file.AddBuffer(c_section.ToCArray(), c_section.Size());
+   }
+
+   static void ExtractCheckpointSection(CByteArray& c_section,
+                                        const CByteArray& c_file,
+                                        size_t& un_offset,
+                                        const std::string& str_path) {
+      if(un_offset + sizeof(UInt32) > c_file.Size()) {
+         THROW_ARGOSEXCEPTION("Checkpoint file \"" << str_path << "\" is truncated");
+      }
+      UInt32 unSize;
+      CByteArray cSize(c_file.ToCArray() + un_offset, sizeof(UInt32));
+      cSize >> unSize;
+      un_offset += sizeof(UInt32);
+      if(un_offset + unSize > c_file.Size()) {
+         THROW_ARGOSEXCEPTION("Checkpoint file \"" << str_path << "\" is truncated");
+      }
+      CByteArray cSection(c_file.ToCArray() + un_offset, unSize);
+      c_section.Swap(cSection);
+      un_offset += unSize;
+   }
+
+   static void CheckSectionConsumed(const CByteArray& c_section,
+                                    const std::string& str_what,
+                                    const std::string& str_path) {
+      if(!c_section.Empty()) {
+         THROW_ARGOSEXCEPTION("Checkpoint file \"" << str_path << "\": the state of " << str_what << " does not match the experiment");
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSimulator::SaveCheckpoint(const std::string& str_path) {
+      CByteArray cFile, cSection;
+      cFile.AddBuffer(reinterpret_cast<const UInt8*>(CHECKPOINT_MAGIC), CHECKPOINT_MAGIC_LEN);
+      cFile << CHECKPOINT_VERSION;
+      /* Random number generators */
+      CRandom::SaveState(cSection);
+      AppendCheckpointSection(cFile, cSection);
+      /* Space, entities and physics models */
+      cSection.Clear();
+      m_pcSpace->SaveState(cSection);
+      AppendCheckpointSection(cFile, cSection);
+      /* Physics engines */
+      for(CPhysicsEngine::TMap::iterator it = m_mapPhysicsEngines.begin();
+          it != m_mapPhysicsEngines.end(); ++it) {
+         cSection.Clear();
+         cSection << it->first;
+         it->second->SaveState(cSection);
+         AppendCheckpointSection(cFile, cSection);
+      }
+      /* Loop functions */
+      cSection.Clear();
+      m_pcLoopFunctions->SaveState(cSection);
+      AppendCheckpointSection(cFile, cSection);
+      /* Write the file */
+      std::ofstream cOut(str_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      if(!cOut) {
+         THROW_ARGOSEXCEPTION("Cannot open checkpoint file \"" << str_path << "\" for writing");
+      }
+      cOut.write(reinterpret_cast<const char*>(cFile.ToCArray()), cFile.Size());
+      if(!cOut) {
+         THROW_ARGOSEXCEPTION("Error writing checkpoint file \"" << str_path << "\"");
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSimulator::LoadCheckpoint(const std::string& str_path) {
+      /* Read the whole file */
+      std::ifstream cIn(str_path.c_str(), std::ios::in | std::ios::binary);
+      if(!cIn) {
+         THROW_ARGOSEXCEPTION("Cannot open checkpoint file \"" << str_path << "\" for reading");
+      }
+      cIn.seekg(0, std::ios::end);
+      CByteArray cFile(static_cast<size_t>(cIn.tellg()));
+      cIn.seekg(0, std::ios::beg);
+      cIn.read(reinterpret_cast<char*>(cFile.ToCArray()), cFile.Size());
+      if(!cIn) {
+         THROW_ARGOSEXCEPTION("Error reading checkpoint file \"" << str_path << "\"");
+      }
+      /* Check the header */
+      size_t unOffset = CHECKPOINT_MAGIC_LEN + sizeof(UInt32);
+      if(cFile.Size() < unOffset ||
+         ::memcmp(cFile.ToCArray(), CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LEN) != 0) {
+         THROW_ARGOSEXCEPTION("File \"" << str_path << "\" is not an ARGoS checkpoint");
+      }
+      UInt32 unVersion;
+      CByteArray cVersion(cFile.ToCArray() + CHECKPOINT_MAGIC_LEN, sizeof(UInt32));
+      cVersion >> unVersion;
+      if(unVersion != CHECKPOINT_VERSION) {
+         THROW_ARGOSEXCEPTION("Checkpoint file \"" << str_path << "\" has version " << unVersion << ", but only version " << CHECKPOINT_VERSION << " is supported");
+      }
+      CByteArray cSection;
+      /* Random number generators */
+      ExtractCheckpointSection(cSection, cFile, unOffset, str_path);
+      CRandom::LoadState(cSection);
+      CheckSectionConsumed(cSection, "the random number generators", str_path);
+      /* Space, entities and physics models */
+      ExtractCheckpointSection(cSection, cFile, unOffset, str_path);
+      m_pcSpace->LoadState(cSection);
+      CheckSectionConsumed(cSection, "the space", str_path);
+      /* Physics engines */
+      std::string strEngineId;
+      for(CPhysicsEngine::TMap::iterator it = m_mapPhysicsEngines.begin();
+          it != m_mapPhysicsEngines.end(); ++it) {
+         ExtractCheckpointSection(cSection, cFile, unOffset, str_path);
+         cSection >> strEngineId;
+         if(strEngineId != it->first) {
+            THROW_ARGOSEXCEPTION("Checkpoint file \"" << str_path << "\" contains physics engine \"" << strEngineId << "\", but \"" << it->first << "\" was expected");
+         }
+         it->second->LoadState(cSection);
+         CheckSectionConsumed(cSection, "physics engine \"" + strEngineId + "\"", str_path);
+      }
+      /* Loop functions */
+      ExtractCheckpointSection(cSection, cFile, unOffset, str_path);
+      m_pcLoopFunctions->LoadState(cSection);
+      CheckSectionConsumed(cSection, "the loop functions", str_path);
+      if(unOffset != cFile.Size()) {
+         THROW_ARGOSEXCEPTION("Checkpoint file \"" << str_path << "\" contains more data than the experiment");
+      }
+      /* The media rebuild their indices and caches from the restored entities */
+      for(CMedium::TMap::iterator it = m_mapMedia.begin();
+          it != m_mapMedia.end(); ++it) {
+         it->second->Reset();
+      }
+      m_bTerminated = false;
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CSimulator::Destroy() {
-      /* Call user destroy function */
+      /* Call user destroy function, unless the experiment ran in forked workers */
       if (m_pcLoopFunctions != NULL) {
-         m_pcLoopFunctions->Destroy();
+         if(!m_bForkedParent) {
+            m_pcLoopFunctions->Destroy();
+         }
          delete m_pcLoopFunctions;
          m_pcLoopFunctions = NULL;
       }
@@ -254,11 +418,12 @@ namespace argos {
       CFactory<CCI_Controller>::Destroy();
       CFactory<CEntity>::Destroy();
       CFactory<CLoopFunctions>::Destroy();
-      /* Stop profiling and flush the data */
-      if(IsProfiling()) {
+      /* Stop profiling and flush the data; forked workers flush their own */
+      if(IsProfiling() && !m_bForkedParent) {
          m_pcProfiler->Stop();
          m_pcProfiler->Flush(m_bHumanReadableProfile);
       }
+      m_bForkedParent = false;
       LOG.Flush();
       LOGERR.Flush();
    }
@@ -273,6 +438,245 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * A piece of work run in a forked worker process
+    */
+   class CForkedTask {
+   public:
+      virtual ~CForkedTask() {}
+      virtual void Run(UInt32 un_task) = 0;
+   };
+
+   /*
+    * Runs tasks 0 to un_tasks-1 in forked worker processes, keeping at most
+    * un_max_running workers alive at the same time (0 means one per online
+    * processor). A new worker is forked as soon as another one exits.
+    * If fork() fails, the workers already started are waited for before
+    * throwing.
+    * Returns the number of failed workers.
+    */
+   static UInt32 RunForkedTasks(CForkedTask& c_task,
+                                UInt32 un_tasks,
+                                UInt32 un_max_running) {
+      if(un_max_running == 0) {
+         long nProcessors = ::sysconf(_SC_NPROCESSORS_ONLN);
+         un_max_running = (nProcessors > 0) ? static_cast<UInt32>(nProcessors) : 1;
+      }
+      UInt32 unNext = 0, unRunning = 0, unFailed = 0;
+      int nStatus;
+      while(unNext < un_tasks || unRunning > 0) {
+         if(unNext < un_tasks && unRunning < un_max_running) {
+            /* Flush now, or the workers would print the buffered output again */
+            LOG.Flush();
+            LOGERR.Flush();
+            pid_t tPid = ::fork();
+            if(tPid < 0) {
+               int nError = errno;
+               /* Do not leave the workers already started behind */
+               while(unRunning > 0) {
+                  if(::waitpid(-1, &nStatus, 0) < 0) {
+                     if(errno == EINTR) continue;
+                     break;
+                  }
+                  --unRunning;
+               }
+               THROW_ARGOSEXCEPTION("Error forking worker #" << unNext << ": " << ::strerror(nError) << ".");
+            }
+            if(tPid == 0) {
+               /* Worker process */
+               nStatus = 0;
+               try {
+                  c_task.Run(unNext);
+               }
+               catch(std::exception& ex) {
+                  LOGERR << "[FATAL] Worker #" << unNext << ": " << ex.what() << std::endl;
+                  nStatus = 1;
+               }
+               LOG.Flush();
+               LOGERR.Flush();
+               /* Leave without running the exit handlers inherited from the parent */
+               ::_exit(nStatus);
+            }
+            ++unNext;
+            ++unRunning;
+         }
+         else {
+            /* Wait for a worker to finish */
+            if(::waitpid(-1, &nStatus, 0) < 0) {
+               if(errno == EINTR) continue;
+               THROW_ARGOSEXCEPTION("Error waiting for the workers: " << ::strerror(errno));
+            }
+            --unRunning;
+            if(!WIFEXITED(nStatus) || WEXITSTATUS(nStatus) != 0) {
+               ++unFailed;
+            }
+         }
+      }
+      return unFailed;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Runs a replica of the initialized experiment with its own seed
+    */
+   class CForkedReplica : public CForkedTask {
+   public:
+      CForkedReplica(CSimulator& c_simulator) :
+         m_cSimulator(c_simulator),
+         m_unBaseSeed(c_simulator.GetRandomSeed()) {}
+      virtual void Run(UInt32 un_task) {
+         m_cSimulator.SetRandomSeed(m_unBaseSeed + un_task);
+         CRandom::SetSeedOf("argos", m_cSimulator.GetRandomSeed());
+         CRandom::GetCategory("argos").ResetRNGs();
+         LOG << "[INFO] Worker #" << un_task << " using random seed = " << m_cSimulator.GetRandomSeed() << std::endl;
+         m_cSimulator.Execute();
+         m_cSimulator.Destroy();
+      }
+   private:
+      CSimulator& m_cSimulator;
+      UInt32 m_unBaseSeed;
+   };
+
+   /****************************************/
+   /****************************************/
+
+   void CSimulator::ExecuteForked(UInt32 un_replicas,
+                                  UInt32 un_max_running) {
+      /* Threads do not survive fork(), and a GUI cannot be shared */
+      if(m_unThreads > 0) {
+         THROW_ARGOSEXCEPTION("Forked execution requires threads=\"0\" in the <system> tag.");
+      }
+      if(dynamic_cast<CDefaultVisualization*>(m_pcVisualization) == NULL) {
+         THROW_ARGOSEXCEPTION("Forked execution cannot be used with a visualization.");
+      }
+      CForkedReplica cReplica(*this);
+      UInt32 unFailed;
+      try {
+         unFailed = RunForkedTasks(cReplica, un_replicas, un_max_running);
+      }
+      catch(CARGoSException& ex) {
+         m_bForkedParent = true;
+         throw;
+      }
+      /* The experiment ran in the workers, not in this process */
+      m_bForkedParent = true;
+      if(unFailed > 0) {
+         THROW_ARGOSEXCEPTION(unFailed << " of " << un_replicas << " workers failed.");
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Applies an override in the form path/to/node.attribute=value to the
+    * configuration tree
+    */
+   static void ApplyConfigurationOverride(TConfigurationNode& t_root,
+                                          const std::string& str_override) {
+      size_t unEqual = str_override.find('=');
+      size_t unDot = (unEqual == std::string::npos) ?
+         std::string::npos :
+         str_override.rfind('.', unEqual);
+      if(unDot == std::string::npos || unDot == 0 || unDot + 1 == unEqual) {
+         THROW_ARGOSEXCEPTION("Malformed override \"" << str_override << "\", the format is path/to/node.attribute=value");
+      }
+      std::vector<std::string> vecPath;
+      Tokenize(str_override.substr(0, unDot), vecPath, "/");
+      TConfigurationNode* ptNode = &t_root;
+      for(size_t i = 0; i < vecPath.size(); ++i) {
+         ptNode = &GetNode(*ptNode, vecPath[i]);
+      }
+      ptNode->SetAttribute(str_override.substr(unDot + 1, unEqual - unDot - 1),
+                           str_override.substr(unEqual + 1));
+   }
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Runs a batch job from scratch with its own seed and overrides
+    */
+   class CBatchJob : public CForkedTask {
+   public:
+      CBatchJob(CSimulator& c_simulator,
+                const std::vector<UInt32>& vec_seeds,
+                const std::vector<std::vector<std::string> >& vec_overrides) :
+         m_cSimulator(c_simulator),
+         m_vecSeeds(vec_seeds),
+         m_vecOverrides(vec_overrides) {}
+      virtual void Run(UInt32 un_task) {
+         for(size_t i = 0; i < m_vecOverrides[un_task].size(); ++i) {
+            ApplyConfigurationOverride(m_cSimulator.GetConfigurationRoot(), m_vecOverrides[un_task][i]);
+         }
+         /* The seed is set before Init(), so that the initialization draws
+            from it too, as in a single run */
+         m_cSimulator.SetRandomSeed(m_vecSeeds[un_task]);
+         LOG << "[INFO] Running batch job #" << un_task << " with random seed = " << m_vecSeeds[un_task] << std::endl;
+         m_cSimulator.Init();
+         m_cSimulator.Execute();
+         m_cSimulator.Destroy();
+      }
+   private:
+      CSimulator& m_cSimulator;
+      const std::vector<UInt32>& m_vecSeeds;
+      const std::vector<std::vector<std::string> >& m_vecOverrides;
+   };
+
+   /****************************************/
+   /****************************************/
+
+   void CSimulator::ExecuteBatch(const std::string& str_batch_file,
+                                 UInt32 un_max_running) {
+      /* Parse the batch file */
+      std::ifstream cIn(str_batch_file.c_str());
+      if(!cIn) {
+         THROW_ARGOSEXCEPTION("Cannot open batch file \"" << str_batch_file << "\"");
+      }
+      std::vector<UInt32> vecSeeds;
+      std::vector<std::vector<std::string> > vecOverrides;
+      std::string strLine;
+      std::vector<std::string> vecTokens;
+      UInt32 unSeed, unLine = 0;
+      while(std::getline(cIn, strLine)) {
+         ++unLine;
+         /* Strip comments and split the line */
+         vecTokens.clear();
+         Tokenize(strLine.substr(0, strLine.find('#')), vecTokens, " \t\r");
+         if(vecTokens.empty()) continue;
+         /* Parse the seed */
+         std::istringstream issSeed(vecTokens[0]);
+         if(!(issSeed >> unSeed) || !issSeed.eof() || unSeed == 0) {
+            THROW_ARGOSEXCEPTION("Batch file \"" << str_batch_file << "\", line " << unLine << ": invalid random seed \"" << vecTokens[0] << "\"");
+         }
+         vecSeeds.push_back(unSeed);
+         vecOverrides.push_back(std::vector<std::string>(vecTokens.begin() + 1, vecTokens.end()));
+      }
+      if(vecSeeds.empty()) {
+         THROW_ARGOSEXCEPTION("Batch file \"" << str_batch_file << "\" contains no jobs");
+      }
+      LOG << "[INFO] Running " << vecSeeds.size() << " batch jobs" << std::endl;
+      /* Parse the configuration file once, the workers inherit it */
+      m_tConfiguration.LoadFile(m_strExperimentConfigFileName);
+      m_tConfigurationRoot = *m_tConfiguration.FirstChildElement();
+      /* Check here rather than in every job; the overrides cannot add nodes */
+      TConfigurationNodeIterator itVisualization;
+      if(NodeExists(m_tConfigurationRoot, "visualization") &&
+         ((itVisualization = itVisualization.begin(&GetNode(m_tConfigurationRoot, "visualization"))) != itVisualization.end())) {
+         THROW_ARGOSEXCEPTION("Batch execution cannot be used with a visualization.");
+      }
+      CBatchJob cJob(*this, vecSeeds, vecOverrides);
+      UInt32 unFailed = RunForkedTasks(cJob, vecSeeds.size(), un_max_running);
+      if(unFailed > 0) {
+         THROW_ARGOSEXCEPTION(unFailed << " of " << vecSeeds.size() << " batch jobs failed.");
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CSimulator::UpdateSpace() {
       /* Update the space */
       m_pcSpace->Update();
@@ -327,8 +731,30 @@ namespace argos {
                       << std::endl;
                   m_pcSpace = new CSpaceMultiThreadBalanceLength();
                }
+               else if(strThreadingMethod == "work_stealing") {
+                  LOG << "[INFO]   Chosen method \"work_stealing\": threads will be assigned the same"
+                      << std::endl
+                      << "[INFO]   number of tasks, and idle threads will steal tasks from busy ones."
+                      << std::endl;
+                  m_pcSpace = new CSpaceMultiThreadWorkStealing();
+               }
                else {
-                  THROW_ARGOSEXCEPTION("Error parsing the <system> tag. Unknown threading method \"" << strThreadingMethod << "\". Available methods: \"balance_quantity\" and \"balance_length\".");
+                  THROW_ARGOSEXCEPTION("Error parsing the <system> tag. Unknown threading method \"" << strThreadingMethod << "\". Available methods: \"balance_quantity\", \"balance_length\" and \"work_stealing\".");
+               }
+               std::string strPhaseSync = "condition";
+               GetNodeAttributeOrDefault(tSystem, "phase_sync", strPhaseSync, strPhaseSync);
+               if(strPhaseSync == "condition") {
+                  m_ePhaseSyncMethod = CPhaseSyncCounter::METHOD_CONDITION;
+               }
+               else if(strPhaseSync == "hybrid") {
+                  m_ePhaseSyncMethod = CPhaseSyncCounter::METHOD_HYBRID;
+                  GetNodeAttributeOrDefault(tSystem, "phase_sync_spins", m_unPhaseSyncSpinIterations, m_unPhaseSyncSpinIterations);
+                  LOG << "[INFO]   Threads will spin for up to " << m_unPhaseSyncSpinIterations
+                      << " iterations before sleeping at the end of each phase."
+                      << std::endl;
+               }
+               else {
+                  THROW_ARGOSEXCEPTION("Error parsing the <system> tag. Unknown phase synchronization method \"" << strPhaseSync << "\". Available methods: \"condition\" and \"hybrid\".");
                }
             }
          }
@@ -362,7 +788,17 @@ namespace argos {
             CRandom::CreateCategory("argos", unSeed);
             LOG << "[INFO] Using random seed = " << unSeed << std::endl;
          }
-         m_pcRNG = CRandom::CreateRNG("argos");
+         /* Parse the type of the RNGs */
+         std::string strRNGType = "mersenne_twister";
+         GetNodeAttributeOrDefault(tExperiment, "rng_type", strRNGType, strRNGType);
+         if(strRNGType == "counter_based") {
+            CRandom::GetCategory("argos").SetType(CRandom::RNG_COUNTER_BASED);
+            LOG << "[INFO] Using counter-based random number generators" << std::endl;
+         }
+         else if(strRNGType != "mersenne_twister") {
+            THROW_ARGOSEXCEPTION("Error parsing the <experiment> tag. Unknown RNG type \"" << strRNGType << "\". Available types: \"mersenne_twister\" and \"counter_based\".");
+         }
+         m_pcRNG = CRandom::CreateRNG("argos", "simulator");
          /* Set the simulation clock tick length */
          UInt32 unTicksPerSec;
          GetNodeAttribute(tExperiment,
@@ -403,6 +839,9 @@ namespace argos {
             bool bTrunc = true;
             GetNodeAttributeOrDefault(tProfiling, "truncate_file", bTrunc, bTrunc);
             m_pcProfiler = new CProfiler(strFile, bTrunc);
+            bool bDeviceTiming = false;
+            GetNodeAttributeOrDefault(tProfiling, "device_timing", bDeviceTiming, bDeviceTiming);
+            m_pcProfiler->SetDeviceTiming(bDeviceTiming);
          }
       }
       catch(CARGoSException& ex) {
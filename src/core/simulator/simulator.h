@@ -39,6 +39,7 @@ namespace argos {
 #include <argos3/core/utility/datatypes/datatypes.h>
 #include <argos3/core/simulator/physics_engine/physics_engine.h>
 #include <argos3/core/simulator/medium/medium.h>
+#include <argos3/core/simulator/space/phase_sync_counter.h>
 #include <string>
 #include <map>
 
@@ -261,6 +262,25 @@ namespace argos {
          return m_unThreads;
       }
 
+      /**
+       * Returns the method used to synchronize the threads at every phase.
+       * @return The method used to synchronize the threads at every phase.
+       * @see CPhaseSyncCounter
+       */
+      inline CPhaseSyncCounter::EMethod GetPhaseSyncMethod() const {
+         return m_ePhaseSyncMethod;
+      }
+
+      /**
+       * Returns how many times a thread spins before sleeping at the end of a phase.
+       * This value is used only by the hybrid phase synchronization method.
+       * @return How many times a thread spins before sleeping at the end of a phase.
+       * @see CPhaseSyncCounter
+       */
+      inline UInt32 GetPhaseSyncSpinIterations() const {
+         return m_unPhaseSyncSpinIterations;
+      }
+
       /**
        * Returns <tt>true</tt> if the clock tick follows the real time.
        * By default, this flag is <tt>false</tt>.
@@ -336,11 +356,99 @@ namespace argos {
        */
       void Destroy();
 
+      /**
+       * Saves the state of the running experiment to a checkpoint file.
+       * The checkpoint contains the random number generators, the space with
+       * all its entities, sensors, actuators, controllers and physics models,
+       * the physics engines and the loop functions. It can be loaded only by
+       * the same build of ARGoS running the same experiment configuration.
+       * The physics engines drop the state they do not save, such as the
+       * contact impulses cached by the dynamics2d engine, so that this run
+       * continues exactly like the runs restored from the checkpoint. For
+       * the same reason, a run that saves a checkpoint is not bit-identical
+       * to the same run without it.
+       * @param str_path The path of the checkpoint file.
+       * @throws CARGoSException if the file cannot be written
+       * @see LoadCheckpoint()
+       */
+      void SaveCheckpoint(const std::string& str_path);
+
+      /**
+       * Restores the state of the experiment from a checkpoint file.
+       * The experiment must have been initialized with the same configuration
+       * used to save the checkpoint. Every run restored from the same
+       * checkpoint evolves identically to the others and to the run that
+       * saved it.
+       * @param str_path The path of the checkpoint file.
+       * @throws CARGoSException if the file cannot be read or does not match the experiment
+       * @see SaveCheckpoint()
+       */
+      void LoadCheckpoint(const std::string& str_path);
+
       /**
        * Executes the simulation loop.
        */
       void Execute();
 
+      /**
+       * Executes the initialized experiment in several forked worker processes.
+       * <p>
+       * The experiment is loaded and initialized once; then, this method forks
+       * one worker per replica, which shares the initialized memory
+       * copy-on-write. Worker <tt>i</tt> reseeds the <tt>argos</tt> random
+       * number category with the experiment seed plus <tt>i</tt>, runs the
+       * experiment to completion, calls Destroy() and exits. At most
+       * <tt>un_max_running</tt> workers run at the same time; a new one is
+       * forked as soon as another one exits. The calling process waits for all
+       * the workers to finish, also when forking fails. Afterwards, Destroy()
+       * in the calling process neither calls the Destroy() method of the loop
+       * functions nor writes a profile, since the workers did both.
+       * </p>
+       * <p>
+       * The initial placement of the entities is shared by all workers, since it
+       * is decided during Init(). Workers inherit the open files of the calling
+       * process, so the loop functions should name their result files after
+       * GetRandomSeed(). This method requires <tt>threads="0"</tt> and no
+       * visualization.
+       * </p>
+       * @param un_replicas The number of replicas to run.
+       * @param un_max_running The maximum number of workers running at the same time; 0 means one per online processor.
+       * @throws CARGoSException if the experiment cannot be forked or if a worker fails
+       */
+      void ExecuteForked(UInt32 un_replicas,
+                         UInt32 un_max_running = 0);
+
+      /**
+       * Executes a batch of jobs listed in a file.
+       * <p>
+       * Each line of the file describes a job as a random seed, optionally
+       * followed by configuration overrides in the form
+       * <tt>path/to/node.attribute=value</tt>, where the path starts below
+       * the root of the XML configuration and each element selects the first
+       * child with that tag. Text after a <tt>#</tt> is a comment.
+       * </p>
+       * <p>
+       * The configuration file is parsed once, and the plugins are loaded
+       * once by the caller. Each job runs in its own forked process, which
+       * applies the overrides, sets the seed of the job, calls Init(), runs
+       * the experiment and calls Destroy(). Since the initialization draws
+       * from the seed of the job, each job gives the same result as a single
+       * run with that seed. Jobs do not reuse an initialized experiment
+       * through Reset(), since Reset() cannot redraw what Init() drew. At
+       * most <tt>un_max_running</tt> jobs run at the same time. Loop
+       * functions should name their result files after GetRandomSeed().
+       * The configuration must not select a visualization.
+       * </p>
+       * <p>
+       * Do not call LoadExperiment() before this method.
+       * </p>
+       * @param str_batch_file The path of the batch file.
+       * @param un_max_running The maximum number of jobs running at the same time; 0 means one per online processor.
+       * @throws CARGoSException if the batch file is invalid or a job fails
+       */
+      void ExecuteBatch(const std::string& str_batch_file,
+                        UInt32 un_max_running = 0);
+
       /**
        * Performs an update step of the space.
        */
@@ -462,6 +570,16 @@ namespace argos {
        */
       UInt32 m_unThreads;
 
+      /**
+       * The method used to synchronize the threads at every phase.
+       */
+      CPhaseSyncCounter::EMethod m_ePhaseSyncMethod;
+
+      /**
+       * How many times a thread spins before sleeping (hybrid phase synchronization only).
+       */
+      UInt32 m_unPhaseSyncSpinIterations;
+
       /**
        * Pointer to the profiler class (NULL when profiling is off).
        */
@@ -482,6 +600,11 @@ namespace argos {
        */
       bool m_bTerminated;
 
+      /**
+       * <tt>true</tt> in the process that forked the workers of ExecuteForked().
+       */
+      bool m_bForkedParent;
+
    };
 
 }
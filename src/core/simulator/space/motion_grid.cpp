@@ -0,0 +1,251 @@
+/**
+ * @file <argos3/core/simulator/space/motion_grid.cpp>
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#include "motion_grid.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/simulator/entity/embodied_entity.h>
+#include <argos3/core/utility/math/ray3.h>
+#include <cstring>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /* The side of a cell, in meters */
+   static const Real MOTION_GRID_CELL_SIZE = 0.25f;
+
+   /* The maximum number of cells along each axis */
+   static const SInt32 MOTION_GRID_MAX_CELLS = 1024;
+
+   /****************************************/
+   /****************************************/
+
+   static bool HasMoved(const SBoundingBox& s_old,
+                        const SBoundingBox& s_new,
+                        Real f_tolerance) {
+      return
+         Abs(s_old.MinCorner.GetX() - s_new.MinCorner.GetX()) > f_tolerance ||
+         Abs(s_old.MinCorner.GetY() - s_new.MinCorner.GetY()) > f_tolerance ||
+         Abs(s_old.MinCorner.GetZ() - s_new.MinCorner.GetZ()) > f_tolerance ||
+         Abs(s_old.MaxCorner.GetX() - s_new.MaxCorner.GetX()) > f_tolerance ||
+         Abs(s_old.MaxCorner.GetY() - s_new.MaxCorner.GetY()) > f_tolerance ||
+         Abs(s_old.MaxCorner.GetZ() - s_new.MaxCorner.GetZ()) > f_tolerance;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CMotionGrid::CMotionGrid() :
+      m_bEnabled(false),
+      m_fTolerance(0.0f),
+      m_nSizeI(0),
+      m_nSizeJ(0),
+      m_fInvCellSize(1.0f / MOTION_GRID_CELL_SIZE),
+      m_unStamp(0),
+      m_bUpdated(false),
+      m_unLastUpdate(0) {
+      int nErrors;
+      if((nErrors = pthread_mutex_init(&m_tUpdateMutex, NULL))) {
+         THROW_ARGOSEXCEPTION("Error creating the motion grid mutex: " << ::strerror(nErrors));
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CMotionGrid::~CMotionGrid() {
+      pthread_mutex_destroy(&m_tUpdateMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CMotionGrid::Enable(Real f_tolerance) {
+      if(!m_bEnabled) {
+         m_bEnabled = true;
+         m_fTolerance = f_tolerance;
+      }
+      else {
+         m_fTolerance = Min(m_fTolerance, f_tolerance);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CMotionGrid::Reset() {
+      m_vecCells.clear();
+      m_mapEntityStates.clear();
+      m_bUpdated = false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CMotionGrid::Setup() {
+      CSpace& cSpace = CSimulator::GetInstance().GetSpace();
+      CVector3 cMinCorner = cSpace.GetArenaCenter() - cSpace.GetArenaSize() * 0.5f;
+      m_cMinCorner.Set(cMinCorner.GetX(), cMinCorner.GetY());
+      /* Use the default cell size, unless the arena is so large that the grid would be too big */
+      Real fCellSize = Max(MOTION_GRID_CELL_SIZE,
+                           Max(cSpace.GetArenaSize().GetX(),
+                               cSpace.GetArenaSize().GetY()) / MOTION_GRID_MAX_CELLS);
+      m_fInvCellSize = 1.0f / fCellSize;
+      m_nSizeI = Max<SInt32>(1, Ceil(cSpace.GetArenaSize().GetX() * m_fInvCellSize));
+      m_nSizeJ = Max<SInt32>(1, Ceil(cSpace.GetArenaSize().GetY() * m_fInvCellSize));
+      m_vecCells.assign(m_nSizeI * m_nSizeJ, 0);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CMotionGrid::Update() {
+      CSpace& cSpace = CSimulator::GetInstance().GetSpace();
+      UInt32 unClock = cSpace.GetSimulationClock();
+      /* Already updated in this step? */
+      if(IsUpToDate(unClock)) return;
+      pthread_mutex_lock(&m_tUpdateMutex);
+      /* Another thread might have done the work while we were waiting */
+      if(!IsUpToDate(unClock)) {
+         DoUpdate(unClock);
+      }
+      pthread_mutex_unlock(&m_tUpdateMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CMotionGrid::Refresh() {
+      if(!m_bEnabled) return;
+      pthread_mutex_lock(&m_tUpdateMutex);
+      DoUpdate(CSimulator::GetInstance().GetSpace().GetSimulationClock());
+      pthread_mutex_unlock(&m_tUpdateMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CMotionGrid::DoUpdate(UInt32 un_clock) {
+      CSpace& cSpace = CSimulator::GetInstance().GetSpace();
+      if(m_vecCells.empty()) Setup();
+      ++m_unStamp;
+      /* Go through the embodied entities */
+      CSpace::TMapPerTypePerId::iterator itBodies = cSpace.GetEntityMapPerTypePerId().find("body");
+      if(itBodies != cSpace.GetEntityMapPerTypePerId().end()) {
+         for(CSpace::TMapPerType::iterator it = itBodies->second.begin();
+             it != itBodies->second.end();
+             ++it) {
+            CEmbodiedEntity& cBody = *any_cast<CEmbodiedEntity*>(it->second);
+            if(cBody.GetPhysicsModelsNum() == 0) continue;
+            const SBoundingBox& sBoundingBox = cBody.GetBoundingBox();
+            TEntityStateMap::iterator itState = m_mapEntityStates.find(&cBody);
+            if(itState == m_mapEntityStates.end()) {
+               /* New entity */
+               SEntityState& sState = m_mapEntityStates[&cBody];
+               sState.BoundingBox = sBoundingBox;
+               sState.SeenAt = m_unStamp;
+               MarkCells(sBoundingBox, m_unStamp);
+            }
+            else {
+               itState->second.SeenAt = m_unStamp;
+               if(HasMoved(itState->second.BoundingBox, sBoundingBox, m_fTolerance)) {
+                  /* The entity moved */
+                  MarkCells(itState->second.BoundingBox, m_unStamp);
+                  MarkCells(sBoundingBox, m_unStamp);
+                  itState->second.BoundingBox = sBoundingBox;
+               }
+            }
+         }
+      }
+      /* Forget about the entities that disappeared */
+      TEntityStateMap::iterator itState = m_mapEntityStates.begin();
+      while(itState != m_mapEntityStates.end()) {
+         if(itState->second.SeenAt != m_unStamp) {
+            MarkCells(itState->second.BoundingBox, m_unStamp);
+            m_mapEntityStates.erase(itState++);
+         }
+         else {
+            ++itState;
+         }
+      }
+      /* Publish the result; the release store makes the cells visible
+         to the threads that see the new clock */
+      m_bUpdated = true;
+      __atomic_store_n(&m_unLastUpdate, un_clock, __ATOMIC_RELEASE);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CMotionGrid::PositionToCell(Real& f_i,
+                                    Real& f_j,
+                                    const CVector3& c_position) const {
+      /* Keep the position inside the grid */
+      f_i = (c_position.GetX() - m_cMinCorner.GetX()) * m_fInvCellSize;
+      f_j = (c_position.GetY() - m_cMinCorner.GetY()) * m_fInvCellSize;
+      f_i = Min<Real>(Max<Real>(f_i, 0.0f), m_nSizeI - 0.001f);
+      f_j = Min<Real>(Max<Real>(f_j, 0.0f), m_nSizeJ - 0.001f);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CMotionGrid::MarkCells(const SBoundingBox& s_bounding_box,
+                               UInt32 un_clock) {
+      Real fMinI, fMinJ, fMaxI, fMaxJ;
+      PositionToCell(fMinI, fMinJ, s_bounding_box.MinCorner);
+      PositionToCell(fMaxI, fMaxJ, s_bounding_box.MaxCorner);
+      for(SInt32 j = Floor(fMinJ); j <= Floor(fMaxJ); ++j) {
+         for(SInt32 i = Floor(fMinI); i <= Floor(fMaxI); ++i) {
+            m_vecCells[j * m_nSizeI + i] = un_clock;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CMotionGrid::HasMotionAlong(const CRay3& c_segment,
+                                    UInt32 un_since) const {
+      /* Nothing recorded yet */
+      if(m_vecCells.empty()) return true;
+      /* Walk the cells crossed by the segment, as in a 2D DDA */
+      Real fStartI, fStartJ, fEndI, fEndJ;
+      PositionToCell(fStartI, fStartJ, c_segment.GetStart());
+      PositionToCell(fEndI, fEndJ, c_segment.GetEnd());
+      SInt32 nI = Floor(fStartI), nJ = Floor(fStartJ);
+      SInt32 nEndI = Floor(fEndI), nEndJ = Floor(fEndJ);
+      Real fDI = fEndI - fStartI, fDJ = fEndJ - fStartJ;
+      SInt32 nStepI = (fDI > 0.0f) ? 1 : -1;
+      SInt32 nStepJ = (fDJ > 0.0f) ? 1 : -1;
+      /* Ray parameter at which the next cell boundary is crossed, and between two boundaries */
+      Real fTMaxI = (fDI > 0.0f) ? (nI + 1 - fStartI) / fDI : (fDI < 0.0f) ? (fStartI - nI) / -fDI : 2.0f;
+      Real fTMaxJ = (fDJ > 0.0f) ? (nJ + 1 - fStartJ) / fDJ : (fDJ < 0.0f) ? (fStartJ - nJ) / -fDJ : 2.0f;
+      Real fTDeltaI = (fDI != 0.0f) ? 1.0f / Abs(fDI) : 2.0f;
+      Real fTDeltaJ = (fDJ != 0.0f) ? 1.0f / Abs(fDJ) : 2.0f;
+      /* The number of steps is known in advance */
+      SInt32 nSteps = Abs(nEndI - nI) + Abs(nEndJ - nJ);
+      if(GetCell(nI, nJ) > un_since) return true;
+      for(SInt32 s = 0; s < nSteps; ++s) {
+         if(nJ == nEndJ || (nI != nEndI && fTMaxI < fTMaxJ)) {
+            nI += nStepI;
+            fTMaxI += fTDeltaI;
+         }
+         else {
+            nJ += nStepJ;
+            fTMaxJ += fTDeltaJ;
+         }
+         if(GetCell(nI, nJ) > un_since) return true;
+      }
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
@@ -0,0 +1,197 @@
+/**
+ * @file <argos3/core/simulator/space/motion_grid.h>
+ *
+ * @brief This file provides the definition of the motion grid, which records
+ * where the embodied entities moved.
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#ifndef MOTION_GRID_H
+#define MOTION_GRID_H
+
+namespace argos {
+   class CMotionGrid;
+   class CEmbodiedEntity;
+   class CRay3;
+   class CSpace;
+}
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <argos3/core/utility/math/vector2.h>
+#include <argos3/core/simulator/physics_engine/physics_model.h>
+#include <map>
+#include <vector>
+#include <pthread.h>
+
+namespace argos {
+
+   /**
+    * A 2D grid over the arena that records when something last moved in each cell.
+    * <p>
+    * At each update, the grid compares the bounding box of every embodied entity
+    * with the one it stored the last time the entity moved. If a corner of the
+    * bounding box moved by more than the tolerance, the cells covered by the old
+    * and by the new bounding box are marked with the stamp of the update.
+    * Entities that appear or disappear mark their cells too. The stamp grows at
+    * every update, also across resets.
+    * </p>
+    * <p>
+    * The grid is owned by the space, and it is inactive until some component
+    * calls Enable(). Users call Update() before querying the grid. The first call
+    * in a step does the work; the other calls return immediately. The space also
+    * calls Refresh() after the loop functions' PreStep(), so the entities they
+    * move are noticed in the sense phase of the same step.
+    * </p>
+    * @see COcclusionCache
+    */
+   class CMotionGrid {
+
+   public:
+
+      CMotionGrid();
+      ~CMotionGrid();
+
+      /**
+       * Activates the grid.
+       * When several components ask for the grid, the smallest tolerance is used.
+       * @param f_tolerance How much an entity must move to be considered moving.
+       */
+      void Enable(Real f_tolerance);
+
+      /**
+       * Returns <tt>true</tt> if the grid is active.
+       * @return <tt>true</tt> if the grid is active.
+       */
+      inline bool IsEnabled() const {
+         return m_bEnabled;
+      }
+
+      /**
+       * Returns the tolerance used to decide whether an entity moved.
+       * @return The tolerance used to decide whether an entity moved.
+       */
+      inline Real GetTolerance() const {
+         return m_fTolerance;
+      }
+
+      /**
+       * Forgets all the recorded motion.
+       */
+      void Reset();
+
+      /**
+       * Records the motion happened since the last update.
+       * Only the first call in a simulation step does the work.
+       * This method is thread-safe.
+       */
+      void Update();
+
+      /**
+       * Records the motion happened since the last update, even if the grid was already updated in this step.
+       * The space calls this method when the loop functions may have moved
+       * some entities. This method does nothing if the grid is not active.
+       */
+      void Refresh();
+
+      /**
+       * Returns the stamp of the last update.
+       * @return The stamp of the last update.
+       */
+      inline UInt32 GetStamp() const {
+         return m_unStamp;
+      }
+
+      /**
+       * Returns <tt>true</tt> if something moved after the given stamp in the cells crossed by the segment.
+       * @param c_segment The segment.
+       * @param un_since The stamp to check from.
+       * @return <tt>true</tt> if something moved after the given stamp in the cells crossed by the segment.
+       */
+      bool HasMotionAlong(const CRay3& c_segment,
+                          UInt32 un_since) const;
+
+   private:
+
+      void Setup();
+
+      /**
+       * Records the motion happened since the last update.
+       * The caller must hold the update mutex.
+       */
+      void DoUpdate(UInt32 un_clock);
+
+      /**
+       * Returns <tt>true</tt> if Update() has already done the work for the given clock.
+       * The clock of the last update is read with acquire semantics, and it
+       * is written with release semantics after the cells. Thus, a thread
+       * that sees the update done also sees the cells it wrote.
+       */
+      inline bool IsUpToDate(UInt32 un_clock) const {
+         return
+            __atomic_load_n(&m_unLastUpdate, __ATOMIC_ACQUIRE) == un_clock &&
+            m_bUpdated;
+      }
+
+      void MarkCells(const SBoundingBox& s_bounding_box,
+                     UInt32 un_clock);
+
+      inline UInt32 GetCell(SInt32 n_i,
+                            SInt32 n_j) const {
+         return m_vecCells[n_j * m_nSizeI + n_i];
+      }
+
+      void PositionToCell(Real& f_i,
+                          Real& f_j,
+                          const CVector3& c_position) const;
+
+   private:
+
+      /** The state of an entity when it was last seen moving */
+      struct SEntityState {
+         SBoundingBox BoundingBox;
+         UInt32 SeenAt;
+      };
+
+      typedef std::map<const CEmbodiedEntity*, SEntityState> TEntityStateMap;
+
+   private:
+
+      /** True when some component asked for the grid */
+      bool m_bEnabled;
+
+      /** How much an entity must move to be considered moving */
+      Real m_fTolerance;
+
+      /** The stamp of the last update that saw some motion in each cell */
+      std::vector<UInt32> m_vecCells;
+
+      /** The size of the grid */
+      SInt32 m_nSizeI, m_nSizeJ;
+
+      /** The corner of the grid with the smallest coordinates */
+      CVector2 m_cMinCorner;
+
+      /** The inverse of the cell size */
+      Real m_fInvCellSize;
+
+      /** The entities and their bounding boxes when they last moved */
+      TEntityStateMap m_mapEntityStates;
+
+      /** The stamp of the last update */
+      UInt32 m_unStamp;
+
+      /** True if Update() has been called since the last Reset() */
+      bool m_bUpdated;
+
+      /** The simulation clock at the last Update(), published with release semantics */
+      UInt32 m_unLastUpdate;
+
+      /** Makes sure only one thread at a time performs Update() */
+      pthread_mutex_t m_tUpdateMutex;
+
+   };
+
+}
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * @file <argos3/core/simulator/space/phase_sync_counter.cpp>
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#include "phase_sync_counter.h"
+#include <argos3/core/utility/configuration/argos_exception.h>
+#include <cstring>
+#include <climits>
+#ifndef __APPLE__
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#  include <linux/futex.h>
+#endif
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Hint to the processor that we are in a spin loop
+    */
+   static inline void CPURelax() {
+#if defined(__i386__) || defined(__x86_64__)
+      __asm__ __volatile__("pause" ::: "memory");
+#else
+      __sync_synchronize();
+#endif
+   }
+
+   /*
+    * Cleanup handler for the threads canceled while waiting on the conditional
+    */
+   static void CleanupPhaseSyncCounterWait(void* p_data) {
+      pthread_mutex_unlock(reinterpret_cast<pthread_mutex_t*>(p_data));
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CPhaseSyncCounter::CPhaseSyncCounter() :
+      m_unValue(0),
+      m_unSleepers(0),
+      m_eMethod(METHOD_CONDITION),
+      m_unSpinIterations(0) {
+      ::memset(&m_tMutex, 0, sizeof(m_tMutex));
+      ::memset(&m_tCond, 0, sizeof(m_tCond));
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CPhaseSyncCounter::~CPhaseSyncCounter() {
+      pthread_mutex_destroy(&m_tMutex);
+      pthread_cond_destroy(&m_tCond);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhaseSyncCounter::Init(EMethod e_method,
+                                UInt32 un_spin_iterations,
+                                UInt32 un_value) {
+      m_eMethod = e_method;
+      m_unSpinIterations = un_spin_iterations;
+      m_unValue = un_value;
+      m_unSleepers = 0;
+      int nErrors;
+      if((nErrors = pthread_mutex_init(&m_tMutex, NULL))) {
+         THROW_ARGOSEXCEPTION("Error creating thread mutex " << ::strerror(nErrors));
+      }
+      if((nErrors = pthread_cond_init(&m_tCond, NULL))) {
+         THROW_ARGOSEXCEPTION("Error creating thread conditional " << ::strerror(nErrors));
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhaseSyncCounter::Set(UInt32 un_value) {
+      /* Nothing to do if the value does not change */
+      if(m_unValue == un_value) return;
+      if(m_eMethod == METHOD_CONDITION) {
+         pthread_mutex_lock(&m_tMutex);
+         m_unValue = un_value;
+         pthread_cond_broadcast(&m_tCond);
+         pthread_mutex_unlock(&m_tMutex);
+      }
+      else {
+         __sync_synchronize();
+         m_unValue = un_value;
+         __sync_synchronize();
+         Wake();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhaseSyncCounter::Increase() {
+      if(m_eMethod == METHOD_CONDITION) {
+         pthread_mutex_lock(&m_tMutex);
+         ++m_unValue;
+         pthread_cond_broadcast(&m_tCond);
+         pthread_mutex_unlock(&m_tMutex);
+      }
+      else {
+         __sync_add_and_fetch(&m_unValue, 1);
+         Wake();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhaseSyncCounter::Decrease() {
+      if(m_eMethod == METHOD_CONDITION) {
+         pthread_mutex_lock(&m_tMutex);
+         --m_unValue;
+         pthread_cond_broadcast(&m_tCond);
+         pthread_mutex_unlock(&m_tMutex);
+      }
+      else {
+         __sync_sub_and_fetch(&m_unValue, 1);
+         Wake();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhaseSyncCounter::WaitWhileEqual(UInt32 un_value) {
+      if(m_eMethod == METHOD_CONDITION) {
+         pthread_mutex_lock(&m_tMutex);
+         pthread_cleanup_push(CleanupPhaseSyncCounterWait, &m_tMutex);
+         while(m_unValue == un_value) {
+            pthread_cond_wait(&m_tCond, &m_tMutex);
+         }
+         pthread_cleanup_pop(1);
+      }
+      else {
+         /* Spin for a while */
+         for(UInt32 i = 0; i < m_unSpinIterations; ++i) {
+            if(m_unValue != un_value) {
+               __sync_synchronize();
+               return;
+            }
+            CPURelax();
+         }
+         /* Then sleep */
+         while(m_unValue == un_value) {
+            Sleep(un_value);
+         }
+         __sync_synchronize();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhaseSyncCounter::WaitUntilEqual(UInt32 un_value) {
+      if(m_eMethod == METHOD_CONDITION) {
+         pthread_mutex_lock(&m_tMutex);
+         pthread_cleanup_push(CleanupPhaseSyncCounterWait, &m_tMutex);
+         while(m_unValue != un_value) {
+            pthread_cond_wait(&m_tCond, &m_tMutex);
+         }
+         pthread_cleanup_pop(1);
+      }
+      else {
+         /* Spin for a while */
+         for(UInt32 i = 0; i < m_unSpinIterations; ++i) {
+            if(m_unValue == un_value) {
+               __sync_synchronize();
+               return;
+            }
+            CPURelax();
+         }
+         /* Then sleep */
+         UInt32 unCurValue;
+         while((unCurValue = m_unValue) != un_value) {
+            Sleep(unCurValue);
+         }
+         __sync_synchronize();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhaseSyncCounter::Wake() {
+      /* Make the syscall only if somebody is actually sleeping */
+      if(m_unSleepers > 0) {
+#ifndef __APPLE__
+         ::syscall(SYS_futex,
+                   const_cast<UInt32*>(&m_unValue),
+                   FUTEX_WAKE_PRIVATE,
+                   INT_MAX,
+                   NULL, NULL, 0);
+#else
+         pthread_mutex_lock(&m_tMutex);
+         pthread_cond_broadcast(&m_tCond);
+         pthread_mutex_unlock(&m_tMutex);
+#endif
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhaseSyncCounter::Sleep(UInt32 un_value) {
+      /* This full barrier pairs with the one in the waking thread:
+         either the waker sees the sleeper, or the sleeper sees the new value */
+      __sync_add_and_fetch(&m_unSleepers, 1);
+#ifndef __APPLE__
+      /* Sleep only if the value is still un_value. The timeout makes
+         sure that cancellation requests are honored in reasonable time. */
+      ::timespec tTimeout;
+      tTimeout.tv_sec = 0;
+      tTimeout.tv_nsec = 100000000;
+      ::syscall(SYS_futex,
+                const_cast<UInt32*>(&m_unValue),
+                FUTEX_WAIT_PRIVATE,
+                un_value,
+                &tTimeout, NULL, 0);
+#else
+      pthread_mutex_lock(&m_tMutex);
+      pthread_cleanup_push(CleanupPhaseSyncCounterWait, &m_tMutex);
+      if(m_unValue == un_value) {
+         pthread_cond_wait(&m_tCond, &m_tMutex);
+      }
+      pthread_cleanup_pop(1);
+#endif
+      __sync_sub_and_fetch(&m_unSleepers, 1);
+      pthread_testcancel();
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
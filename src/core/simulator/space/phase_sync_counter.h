@@ -0,0 +1,129 @@
+/**
+ * @file <argos3/core/simulator/space/phase_sync_counter.h>
+ *
+ * @brief This file provides the definition of the counter used by the
+ * multi-thread spaces to synchronize the threads at every phase.
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#ifndef PHASE_SYNC_COUNTER_H
+#define PHASE_SYNC_COUNTER_H
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <pthread.h>
+
+namespace argos {
+
+   /**
+    * A counter that threads can wait on.
+    * <p>
+    * The multi-thread spaces use one of these counters for each phase of
+    * a simulation step. The main thread resets the counter to start the
+    * phase, and the threads increase it when they are done.
+    * </p>
+    * <p>
+    * Two waiting methods are available. With METHOD_CONDITION, waiting
+    * threads sleep on a pthread conditional. With METHOD_HYBRID, waiting
+    * threads first spin for a bounded number of iterations, and then
+    * sleep on a futex (on Mac OSX, on a pthread conditional). The hybrid
+    * method avoids the sleep and wake-up costs when the phases are short,
+    * at the price of burning CPU while spinning. For this reason, it
+    * pays off only when the threads do not outnumber the CPU cores.
+    * </p>
+    */
+   class CPhaseSyncCounter {
+
+   public:
+
+      enum EMethod {
+         METHOD_CONDITION = 0,
+         METHOD_HYBRID
+      };
+
+   public:
+
+      CPhaseSyncCounter();
+      ~CPhaseSyncCounter();
+
+      /**
+       * Initializes the counter.
+       * @param e_method The waiting method.
+       * @param un_spin_iterations How many times to spin before sleeping (METHOD_HYBRID only).
+       * @param un_value The initial value of the counter.
+       * @throws CARGoSException if the pthread structures can't be created.
+       */
+      void Init(EMethod e_method,
+                UInt32 un_spin_iterations,
+                UInt32 un_value);
+
+      /**
+       * Returns the current value of the counter.
+       * @return The current value of the counter.
+       */
+      inline UInt32 Get() const {
+         return m_unValue;
+      }
+
+      /**
+       * Sets the value of the counter and wakes up the waiting threads.
+       * If the value does not change, the waiting threads are not woken up.
+       * Only one thread at a time is allowed to call this method.
+       * @param un_value The new value.
+       */
+      void Set(UInt32 un_value);
+
+      /**
+       * Increases the counter by one and wakes up the waiting threads.
+       */
+      void Increase();
+
+      /**
+       * Decreases the counter by one and wakes up the waiting threads.
+       */
+      void Decrease();
+
+      /**
+       * Waits as long as the counter is equal to the given value.
+       * This is a cancellation point.
+       * @param un_value The value to wait on.
+       */
+      void WaitWhileEqual(UInt32 un_value);
+
+      /**
+       * Waits until the counter is equal to the given value.
+       * This is a cancellation point.
+       * @param un_value The value to wait for.
+       */
+      void WaitUntilEqual(UInt32 un_value);
+
+   private:
+
+      void Wake();
+      void Sleep(UInt32 un_value);
+
+   private:
+
+      /** The counter value */
+      volatile UInt32 m_unValue;
+
+      /** How many threads are sleeping (METHOD_HYBRID only) */
+      volatile UInt32 m_unSleepers;
+
+      /** The waiting method */
+      EMethod m_eMethod;
+
+      /** How many times to spin before sleeping */
+      UInt32 m_unSpinIterations;
+
+      /** Mutex protecting the counter (METHOD_CONDITION) */
+      pthread_mutex_t m_tMutex;
+
+      /** Conditional to sleep on (METHOD_CONDITION) */
+      pthread_cond_t m_tCond;
+
+   };
+
+}
+
+#endif
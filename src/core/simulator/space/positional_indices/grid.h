@@ -5,9 +5,52 @@
 #include <argos3/core/utility/math/range.h>
 #include <argos3/core/utility/math/ray3.h>
 #include <argos3/core/simulator/space/positional_indices/positional_index.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <pthread.h>
 
 namespace argos {
 
+   /**
+    * A positional index that bins the entities in a regular grid of cells.
+    * <p>
+    * The cells an entity occupies are calculated by the update operation set
+    * with SetUpdateEntityOperation(), which calls UpdateCell() for each of them.
+    * The grid remembers the cells of each entity. At each Update(), the
+    * operation is run again, and the entity is moved only if its cells changed.
+    * Thus, the cost of the set insertions and removals is proportional to the
+    * number of entities that crossed a cell boundary, not to the number of
+    * entities.
+    * </p>
+    * <p>
+    * With EnableDirtyTracking(), Update() runs the update operation only for
+    * the entities marked with MarkDirty() since the last update, so its cost
+    * is proportional to the number of entities that moved. The users of the
+    * grid are then responsible for marking every entity that moves.
+    * </p>
+    * <p>
+    * Each cell has a timestamp. The cells with a timestamp older than the
+    * current one are considered empty and cleared when an entity is inserted
+    * again.
+    * </p>
+    * <p>
+    * TakeSnapshot() records the cells of every entity. From then on, the grid
+    * keeps a list of the entities that are not in their recorded cells, and
+    * Reset() works on those only: it moves them back one by one or, when
+    * many moved, copies all the recorded cells back at once. The entities
+    * added after the snapshot are re-binned with the update operation.
+    * Without a snapshot, Reset() re-bins all the entities.
+    * </p>
+    * <p>
+    * By default, the grid allocates all its cells. For large arenas with small
+    * cells, the grid can be sparse: only the cells that contain entities are
+    * stored, in an open-addressing hash table. In a sparse grid, GetCellAt()
+    * returns a shared, read-only empty cell for the cells that contain no
+    * entity. The cell operations receive a scratch cell for those cells
+    * instead; it is cleared before each call and changes to it are lost.
+    * </p>
+    */
    template<class ENTITY>
    class CGrid : public CPositionalIndex<ENTITY> {
 
@@ -24,6 +67,10 @@ namespace argos {
             Entities.clear();
             Timestamp = 0;
          }
+         inline void Swap(SCell& s_other) {
+            Entities.swap(s_other.Entities);
+            std::swap(Timestamp, s_other.Timestamp);
+         }
       };
 
       class CCellOperation {
@@ -35,13 +82,40 @@ namespace argos {
                                  SCell& s_cell) = 0;
       };
 
+      /**
+       * An operation on the cells crossed by a ray.
+       * @see WalkAlongRay
+       */
+      class CRayCellOperation {
+      public:
+         virtual ~CRayCellOperation() {}
+         /**
+          * Called for each cell crossed by the ray, in order.
+          * @param s_cell The cell. Cells with no entity may be passed as a shared empty cell.
+          * @param f_t_exit The t on the ray at which the ray leaves the cell.
+          * @return <tt>false</tt> to stop the walk.
+          */
+         virtual bool operator()(const SCell& s_cell,
+                                 Real f_t_exit) = 0;
+      };
+
    public:
 
+      /**
+       * Class constructor.
+       * @param c_area_min_corner The corner of the area with the smallest coordinates.
+       * @param c_area_max_corner The corner of the area with the largest coordinates.
+       * @param n_size_i The number of cells along X.
+       * @param n_size_j The number of cells along Y.
+       * @param n_size_k The number of cells along Z.
+       * @param b_sparse <tt>true</tt> to store only the cells that contain entities.
+       */
       CGrid(const CVector3& c_area_min_corner,
             const CVector3& c_area_max_corner,
             SInt32 n_size_i,
             SInt32 n_size_j,
-            SInt32 n_size_k);
+            SInt32 n_size_k,
+            bool b_sparse = false);
 
       virtual ~CGrid();
 
@@ -55,6 +129,43 @@ namespace argos {
 
       virtual void Update();
 
+      /**
+       * Marks the given entity to be re-binned at the next Update().
+       * It has an effect only when dirty tracking is enabled. Marking an
+       * entity more than once before an update is harmless.
+       * This method is thread-safe, as long as no entity is added or removed
+       * at the same time.
+       * @param c_entity The entity.
+       * @see EnableDirtyTracking
+       */
+      virtual void MarkDirty(ENTITY& c_entity);
+
+      /**
+       * Makes Update() re-bin only the entities marked with MarkDirty().
+       * Added entities are marked automatically. After TakeSnapshot(), Reset()
+       * keeps the marks, so the entities marked before it are checked at the
+       * next Update(); otherwise, Reset() re-bins all the entities.
+       */
+      inline void EnableDirtyTracking() {
+         m_bDirtyTracking = true;
+      }
+
+      /**
+       * Records the cells of every entity as the ones to restore on Reset().
+       * Call it when the entities are where a reset puts them back, typically
+       * right after the first Update(). An entity that is elsewhere after a
+       * reset is binned correctly only at the next Update() that checks it.
+       */
+      virtual void TakeSnapshot();
+
+      /**
+       * Returns <tt>true</tt> if Update() re-bins only the entities marked with MarkDirty().
+       * @return <tt>true</tt> if Update() re-bins only the entities marked with MarkDirty().
+       */
+      inline bool IsDirtyTracking() const {
+         return m_bDirtyTracking;
+      }
+
       virtual void GetEntitiesAt(CSet<ENTITY*>& c_entities,
                                  const CVector3& c_position) const;
 
@@ -101,6 +212,21 @@ namespace argos {
       virtual void ForCellsAlongRay(const CRay3& c_ray,
                                     CCellOperation& c_operation);
 
+      /**
+       * Visits the cells crossed by the given ray, from start to end.
+       * Unlike ForCellsAlongRay(), the cells are found with an exact 3D-DDA
+       * walk: every cell the ray crosses is visited once, in order, and the
+       * operation is told where the ray leaves each cell. This way, a search
+       * for the closest hit can stop as soon as it has found a hit that
+       * comes before the end of the current cell.
+       * The part of the ray out of the grid is ignored.
+       * This method is thread-safe as long as the grid is not modified.
+       * @param c_ray The ray.
+       * @param c_operation The operation to perform on each cell.
+       */
+      void WalkAlongRay(const CRay3& c_ray,
+                        CRayCellOperation& c_operation) const;
+
       inline SInt32 GetSizeI() const {
          return m_nSizeI;
       }
@@ -113,18 +239,57 @@ namespace argos {
          return m_nSizeK;
       }
 
+      /**
+       * Returns <tt>true</tt> if only the cells that contain entities are stored.
+       * @return <tt>true</tt> if only the cells that contain entities are stored.
+       */
+      inline bool IsSparse() const {
+         return m_bSparse;
+      }
+
+      /**
+       * Returns the number of cells currently stored in memory.
+       * @return The number of cells currently stored in memory.
+       */
+      inline size_t GetNumStoredCells() const {
+         return m_bSparse ? m_unSparseSize : m_unNumCells;
+      }
+
       inline void SetUpdateEntityOperation(CEntityOperation* pc_operation);
 
+      /**
+       * Marks the given cell as occupied by the given entity.
+       * When called by the update operation during Update(), the cell is
+       * recorded and the entity is re-binned only if its cells have changed.
+       * @throws CARGoSException if the cell is out of bounds.
+       */
       void UpdateCell(SInt32 n_i,
                       SInt32 n_j,
                       SInt32 n_k,
                       ENTITY& c_entity);
 
+      /**
+       * Calculates the cell that contains the given position.
+       * Positions on the faces of the area with the largest coordinates
+       * belong to the last cells.
+       * @throws CARGoSException if the position is out of the area.
+       * @see PositionToCellClamped
+       */
       inline void PositionToCell(SInt32& n_i,
                                  SInt32& n_j,
                                  SInt32& n_k,
                                  const CVector3& c_position) const;
 
+      /**
+       * Calculates the cell that contains the given position, without throwing.
+       * If the position is out of the area, the closest cell is returned.
+       * @return <tt>true</tt> if the position is in the area.
+       */
+      inline bool PositionToCellClamped(SInt32& n_i,
+                                        SInt32& n_j,
+                                        SInt32& n_k,
+                                        const CVector3& c_position) const;
+
       inline void PositionToCellUnsafe(SInt32& n_i,
                                        SInt32& n_j,
                                        SInt32& n_k,
@@ -136,14 +301,145 @@ namespace argos {
 
       inline void ClampCoordinates(CVector3& c_pos) const;
 
-      inline SCell& GetCellAt(SInt32 n_i,
-                              SInt32 n_j,
-                              SInt32 n_k);
+      /**
+       * Returns <tt>true</tt> if the given cell is in the grid.
+       */
+      inline bool IsCellInside(SInt32 n_i,
+                               SInt32 n_j,
+                               SInt32 n_k) const {
+         return
+            (n_i >= 0) && (n_i < m_nSizeI) &&
+            (n_j >= 0) && (n_j < m_nSizeJ) &&
+            (n_k >= 0) && (n_k < m_nSizeK);
+      }
 
+      /**
+       * Returns <tt>true</tt> if all the cells within the given distance
+       * (in cells) from the given center cell are in the grid.
+       */
+      inline bool IsCellRangeInside(SInt32 n_i,
+                                    SInt32 n_j,
+                                    SInt32 n_k,
+                                    SInt32 n_range_i,
+                                    SInt32 n_range_j,
+                                    SInt32 n_range_k) const {
+         return
+            IsCellInside(n_i - n_range_i, n_j - n_range_j, n_k - n_range_k) &&
+            IsCellInside(n_i + n_range_i, n_j + n_range_j, n_k + n_range_k);
+      }
+
+      /**
+       * Returns the given cell.
+       * In a sparse grid, the cells that are not stored are returned as a
+       * shared empty cell. Cells are modified only through the update
+       * operation, so no mutable access is given.
+       */
       inline const SCell& GetCellAt(SInt32 n_i,
                                     SInt32 n_j,
                                     SInt32 n_k) const;
 
+   protected:
+
+      /** What the grid remembers about an entity */
+      struct SEntityData {
+         /** The indices of the cells that contain the entity */
+         std::vector<size_t> Cells;
+         /** The cells recorded by TakeSnapshot() */
+         std::vector<size_t> SnapshotCells;
+         /** True if TakeSnapshot() recorded the cells of the entity */
+         bool HasSnapshot;
+         /** True if the entity is in the list of the entities away from the snapshot */
+         bool Away;
+         /** Non-zero if the entity is in the dirty list */
+         volatile SInt32 Dirty;
+
+         SEntityData() : HasSnapshot(false), Away(false), Dirty(0) {}
+      };
+
+      typedef std::map<ENTITY*, SEntityData> TEntityDataMap;
+
+      /** A cell recorded by TakeSnapshot(): its index and its entities */
+      typedef std::pair<size_t, CSet<ENTITY*> > TSnapshotCell;
+
+      /** Orders the recorded cells by index */
+      static bool SnapshotCellLess(const TSnapshotCell& t_a,
+                                   const TSnapshotCell& t_b) {
+         return t_a.first < t_b.first;
+      }
+
+      /** A slot of the hash table of a sparse grid */
+      struct SSparseSlot {
+         size_t Key;
+         SCell Cell;
+      };
+
+      /**
+       * Runs the update operation for the given entity and re-bins it if its
+       * cells have changed.
+       */
+      void UpdateEntity(typename TEntityDataMap::iterator t_it);
+
+      /**
+       * Moves the entity to the cells in m_vecUpdateCells, if they differ
+       * from the current ones.
+       */
+      void RebinEntity(typename TEntityDataMap::iterator t_it);
+
+      /**
+       * Adds the entity to the list of the entities away from the snapshot,
+       * if it is not in its recorded cells.
+       */
+      void MarkAway(typename TEntityDataMap::iterator t_it);
+
+      /**
+       * Returns the index of the given cell.
+       */
+      inline size_t CellIndex(SInt32 n_i,
+                              SInt32 n_j,
+                              SInt32 n_k) const;
+
+      /**
+       * Returns the cell passed to a cell operation.
+       * In a sparse grid, a cell that is not stored is returned as a
+       * cleared scratch cell.
+       */
+      inline SCell& GetOperationCell(SInt32 n_i,
+                                     SInt32 n_j,
+                                     SInt32 n_k);
+
+      /**
+       * Returns the cell with the given index, creating it in a sparse grid.
+       */
+      SCell& GetOrCreateCell(size_t un_index);
+
+      /**
+       * Erases the given entity from the cell with the given index.
+       * In a sparse grid, the cell is deleted when it becomes empty.
+       */
+      void EraseFromCell(size_t un_index,
+                         ENTITY* pc_entity);
+
+      /**
+       * Returns the slot of the given key in the hash table, or the
+       * empty slot where the key would be inserted.
+       */
+      size_t FindSparseSlot(size_t un_key) const;
+
+      /**
+       * Deletes the given slot from the hash table.
+       */
+      void DeleteSparseSlot(size_t un_slot);
+
+      /**
+       * Doubles the capacity of the hash table.
+       */
+      void GrowSparseTable();
+
+      /**
+       * Empties the hash table.
+       */
+      void ClearSparseTable();
+
    protected:
 
       CVector3 m_cAreaMinCorner;
@@ -161,6 +457,51 @@ namespace argos {
       CSet<ENTITY*> m_cEntities;
       CEntityOperation* m_pcUpdateEntityOperation;
 
+      /** For each entity, the cells that contain it */
+      TEntityDataMap m_mapEntityData;
+
+      /** The cells recorded by UpdateCell() for the entity being updated */
+      std::vector<size_t> m_vecUpdateCells;
+
+      /** True while Update() runs the update operation */
+      bool m_bRecordingCells;
+
+      /** True if Update() re-bins only the entities in the dirty list */
+      bool m_bDirtyTracking;
+
+      /** True once TakeSnapshot() has been called */
+      bool m_bSnapshot;
+
+      /** The cells that contained entities at TakeSnapshot(), ordered by index */
+      std::vector<TSnapshotCell> m_vecSnapshotCells;
+
+      /** The entities that are not in the cells recorded by TakeSnapshot() */
+      std::vector<typename TEntityDataMap::iterator> m_vecAwayEntities;
+
+      /** The entities marked with MarkDirty() since the last Update() */
+      std::vector<ENTITY*> m_vecDirtyEntities;
+
+      /** Protects the dirty list */
+      pthread_mutex_t m_tDirtyMutex;
+
+      /** The total number of cells */
+      size_t m_unNumCells;
+
+      /** True if only the cells that contain entities are stored */
+      bool m_bSparse;
+
+      /** The hash table of a sparse grid; its size is a power of two */
+      std::vector<SSparseSlot> m_vecSparseSlots;
+
+      /** The number of used slots in the hash table */
+      size_t m_unSparseSize;
+
+      /** The cell returned for the cells not stored in a sparse grid */
+      SCell m_sEmptyCell;
+
+      /** The cell passed to cell operations for the cells not stored in a sparse grid */
+      SCell m_sScratchCell;
+
    };
 
 }
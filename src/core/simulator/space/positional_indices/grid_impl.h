@@ -5,12 +5,24 @@ namespace argos {
 
    static const Real EPSILON = 1e-6;
 
+   /* The key of the empty slots in the hash table of a sparse grid */
+   static const size_t SPARSE_GRID_EMPTY_KEY = ~static_cast<size_t>(0);
+
+   /* The initial capacity of the hash table of a sparse grid */
+   static const size_t SPARSE_GRID_INITIAL_CAPACITY = 64;
+
+   /* Mixes the bits of a cell index for the hash table of a sparse grid */
+   static inline size_t SparseGridHash(size_t un_key) {
+      UInt64 unHash = static_cast<UInt64>(un_key) * 0x9E3779B97F4A7C15ULL;
+      return static_cast<size_t>(unHash ^ (unHash >> 32));
+   }
+
    /****************************************/
    /****************************************/
 
 #define APPLY_ENTITY_OPERATION_TO_CELL(nI,nJ,nK)                        \
    {                                                                    \
-      SCell& sCell = GetCellAt((nI), (nJ), (nK));                       \
+      const SCell& sCell = GetCellAt((nI), (nJ), (nK));                 \
       if((sCell.Timestamp == m_unCurTimestamp) &&                       \
          (! sCell.Entities.empty())) {                                  \
          for(typename CSet<ENTITY*>::iterator it = sCell.Entities.begin(); \
@@ -23,7 +35,7 @@ namespace argos {
 
 #define APPLY_ENTITY_OPERATION_TO_CELL_ALONG_RAY(nI,nJ,nK)              \
    {                                                                    \
-      SCell& sCell = GetCellAt(nI, nJ, nK);                             \
+      const SCell& sCell = GetCellAt(nI, nJ, nK);                       \
       if((sCell.Timestamp == m_unCurTimestamp) &&                       \
          (! sCell.Entities.empty())) {                                  \
          for(typename CSet<ENTITY*>::iterator it = sCell.Entities.begin(); \
@@ -37,10 +49,23 @@ namespace argos {
 
 #define APPLY_CELL_OPERATION_TO_CELL(nI,nJ,nK)          \
    {                                                    \
-      SCell& sCell = GetCellAt((nI), (nJ), (nK));       \
+      SCell& sCell = GetOperationCell((nI), (nJ), (nK)); \
       if(!c_operation((nI), (nJ), (nK), sCell)) return; \
    }
 
+/*
+ * The clipped variants skip the cells out of the grid. They expect a
+ * local flag bInside that is true when the whole query lies in the
+ * grid, in which case no bounds check is made.
+ */
+#define APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI,nJ,nK)                \
+   if(bInside || IsCellInside((nI), (nJ), (nK)))                       \
+      APPLY_ENTITY_OPERATION_TO_CELL(nI, nJ, nK)
+
+#define APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI,nJ,nK)                  \
+   if(bInside || IsCellInside((nI), (nJ), (nK)))                       \
+      APPLY_CELL_OPERATION_TO_CELL(nI, nJ, nK)
+
 /****************************************/
 /****************************************/
 
@@ -49,7 +74,8 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
                      const CVector3& c_area_max_corner,
                      SInt32 n_size_i,
                      SInt32 n_size_j,
-                     SInt32 n_size_k) :
+                     SInt32 n_size_k,
+                     bool b_sparse) :
    m_cAreaMinCorner(c_area_min_corner),
    m_cAreaMaxCorner(c_area_max_corner),
    m_nSizeI(n_size_i),
@@ -59,14 +85,27 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
    m_cRangeY(m_cAreaMinCorner.GetY(), m_cAreaMaxCorner.GetY()),
    m_cRangeZ(m_cAreaMinCorner.GetZ(), m_cAreaMaxCorner.GetZ()),
    m_unCurTimestamp(0),
-   m_pcUpdateEntityOperation(NULL) {
+   m_pcUpdateEntityOperation(NULL),
+   m_bRecordingCells(false),
+   m_bDirtyTracking(false),
+   m_bSnapshot(false),
+   m_unNumCells(static_cast<size_t>(n_size_i) * n_size_j * n_size_k),
+   m_bSparse(b_sparse),
+   m_unSparseSize(0) {
    m_cCellSize.Set(m_cRangeX.GetSpan() / m_nSizeI,
                    m_cRangeY.GetSpan() / m_nSizeJ,
                    m_cRangeZ.GetSpan() / m_nSizeK);
    m_cInvCellSize.Set(1.0f / m_cCellSize.GetX(),
                       1.0f / m_cCellSize.GetY(),
                       1.0f / m_cCellSize.GetZ());
-   m_psCells = new SCell[m_nSizeI * m_nSizeJ * m_nSizeK];
+   if(m_bSparse) {
+      m_psCells = NULL;
+      ClearSparseTable();
+   }
+   else {
+      m_psCells = new SCell[m_unNumCells];
+   }
+   pthread_mutex_init(&m_tDirtyMutex, NULL);
 }
 
    /****************************************/
@@ -75,6 +114,7 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
    template<class ENTITY>
    CGrid<ENTITY>::~CGrid() {
       delete[] m_psCells;
+      pthread_mutex_destroy(&m_tDirtyMutex);
    }
 
    /****************************************/
@@ -89,15 +129,101 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
 
    template<class ENTITY>
    void CGrid<ENTITY>::Reset() {
-      m_unCurTimestamp = 0;
-      for(SInt32 i = 0; i < m_nSizeI; ++i) {
-         for(SInt32 j = 0; j < m_nSizeJ; ++j) {
-            for(SInt32 k = 0; k < m_nSizeK; ++k) {
-               GetCellAt(i,j,k).Reset();
+      if(!m_bSnapshot) {
+         /* Invalidate all the cells at once, they are cleared when used again */
+         ++m_unCurTimestamp;
+         /* A sparse grid can simply forget its cells */
+         if(m_bSparse) ClearSparseTable();
+         /* Re-bin all the entities, the dirty list is not needed */
+         m_vecDirtyEntities.clear();
+         m_bRecordingCells = true;
+         try {
+            for(typename TEntityDataMap::iterator it = m_mapEntityData.begin();
+                it != m_mapEntityData.end();
+                ++it) {
+               it->second.Cells.clear();
+               it->second.Dirty = 0;
+               UpdateEntity(it);
+            }
+         }
+         catch(CARGoSException&) {
+            m_bRecordingCells = false;
+            throw;
+         }
+         m_bRecordingCells = false;
+         return;
+      }
+      /*
+       * Only the entities away from their recorded cells need work. The dirty
+       * list is kept: the entities marked since the last update are checked
+       * again at the next one, in case they are not where the snapshot says.
+       */
+      std::vector<typename TEntityDataMap::iterator> vecAway;
+      vecAway.swap(m_vecAwayEntities);
+      /*
+       * Moving an entity costs a removal and an insertion for each of its
+       * cells. When many entities moved, it is cheaper to invalidate all the
+       * cells at once and copy the recorded cells back.
+       */
+      bool bRefill = (2 * vecAway.size() > m_mapEntityData.size());
+      if(bRefill) {
+         ++m_unCurTimestamp;
+         if(m_bSparse) ClearSparseTable();
+         for(size_t i = 0; i < m_vecSnapshotCells.size(); ++i) {
+            SCell& sCell = GetOrCreateCell(m_vecSnapshotCells[i].first);
+            sCell.Entities = m_vecSnapshotCells[i].second;
+            sCell.Timestamp = m_unCurTimestamp;
+         }
+      }
+      m_bRecordingCells = true;
+      try {
+         for(size_t i = 0; i < vecAway.size(); ++i) {
+            typename TEntityDataMap::iterator it = vecAway[i];
+            it->second.Away = false;
+            if(it->second.HasSnapshot) {
+               /* Go back to the recorded cells */
+               if(bRefill) {
+                  it->second.Cells = it->second.SnapshotCells;
+               }
+               else {
+                  m_vecUpdateCells = it->second.SnapshotCells;
+                  RebinEntity(it);
+               }
+            }
+            else {
+               /* Added after the snapshot, bin it where it is */
+               if(bRefill) it->second.Cells.clear();
+               UpdateEntity(it);
             }
+            MarkAway(it);
          }
       }
-      Update();
+      catch(CARGoSException&) {
+         m_bRecordingCells = false;
+         throw;
+      }
+      m_bRecordingCells = false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CGrid<ENTITY>::TakeSnapshot() {
+      std::map<size_t, CSet<ENTITY*> > mapCells;
+      m_vecAwayEntities.clear();
+      for(typename TEntityDataMap::iterator it = m_mapEntityData.begin();
+          it != m_mapEntityData.end();
+          ++it) {
+         it->second.SnapshotCells = it->second.Cells;
+         it->second.HasSnapshot = true;
+         it->second.Away = false;
+         for(size_t i = 0; i < it->second.Cells.size(); ++i) {
+            mapCells[it->second.Cells[i]].insert(it->first);
+         }
+      }
+      m_vecSnapshotCells.assign(mapCells.begin(), mapCells.end());
+      m_bSnapshot = true;
    }
 
    /****************************************/
@@ -113,6 +239,8 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
    template<class ENTITY>
    void CGrid<ENTITY>::AddEntity(ENTITY& c_entity) {
       m_cEntities.insert(&c_entity);
+      m_mapEntityData[&c_entity];
+      MarkDirty(c_entity);
    }
 
    /****************************************/
@@ -121,6 +249,34 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
    template<class ENTITY>
    void CGrid<ENTITY>::RemoveEntity(ENTITY& c_entity) {
       m_cEntities.erase(&c_entity);
+      typename TEntityDataMap::iterator it = m_mapEntityData.find(&c_entity);
+      if(it != m_mapEntityData.end()) {
+         /* Take the entity out of its cells */
+         for(size_t i = 0; i < it->second.Cells.size(); ++i) {
+            EraseFromCell(it->second.Cells[i], &c_entity);
+         }
+         /* Take the entity out of the snapshot */
+         for(size_t i = 0; i < it->second.SnapshotCells.size(); ++i) {
+            typename std::vector<TSnapshotCell>::iterator itCell =
+               std::lower_bound(m_vecSnapshotCells.begin(),
+                                m_vecSnapshotCells.end(),
+                                TSnapshotCell(it->second.SnapshotCells[i], CSet<ENTITY*>()),
+                                SnapshotCellLess);
+            itCell->second.erase(&c_entity);
+            if(itCell->second.empty()) m_vecSnapshotCells.erase(itCell);
+         }
+         /* Take the entity out of the list of the entities away from the snapshot */
+         if(it->second.Away) {
+            m_vecAwayEntities.erase(
+               std::find(m_vecAwayEntities.begin(), m_vecAwayEntities.end(), it));
+         }
+         /* Take the entity out of the dirty list */
+         if(it->second.Dirty) {
+            m_vecDirtyEntities.erase(
+               std::find(m_vecDirtyEntities.begin(), m_vecDirtyEntities.end(), &c_entity));
+         }
+         m_mapEntityData.erase(it);
+      }
    }
 
    /****************************************/
@@ -128,8 +284,96 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
 
    template<class ENTITY>
    void CGrid<ENTITY>::Update() {
-      ++m_unCurTimestamp;
-      ForAllEntities(*m_pcUpdateEntityOperation);
+      m_bRecordingCells = true;
+      try {
+         if(m_bDirtyTracking) {
+            /* Re-bin only the entities that have been marked */
+            for(size_t i = 0; i < m_vecDirtyEntities.size(); ++i) {
+               typename TEntityDataMap::iterator it = m_mapEntityData.find(m_vecDirtyEntities[i]);
+               it->second.Dirty = 0;
+               UpdateEntity(it);
+            }
+            m_vecDirtyEntities.clear();
+         }
+         else {
+            for(typename TEntityDataMap::iterator it = m_mapEntityData.begin();
+                it != m_mapEntityData.end();
+                ++it) {
+               UpdateEntity(it);
+            }
+         }
+      }
+      catch(CARGoSException&) {
+         m_bRecordingCells = false;
+         throw;
+      }
+      m_bRecordingCells = false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CGrid<ENTITY>::MarkDirty(ENTITY& c_entity) {
+      if(!m_bDirtyTracking) return;
+      typename TEntityDataMap::iterator it = m_mapEntityData.find(&c_entity);
+      /* Only the first thread that marks the entity adds it to the list */
+      if(it != m_mapEntityData.end() &&
+         __sync_lock_test_and_set(&it->second.Dirty, 1) == 0) {
+         pthread_mutex_lock(&m_tDirtyMutex);
+         m_vecDirtyEntities.push_back(&c_entity);
+         pthread_mutex_unlock(&m_tDirtyMutex);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CGrid<ENTITY>::UpdateEntity(typename TEntityDataMap::iterator t_it) {
+      /* Record the cells the entity occupies now */
+      m_vecUpdateCells.clear();
+      (*m_pcUpdateEntityOperation)(*t_it->first);
+      RebinEntity(t_it);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CGrid<ENTITY>::RebinEntity(typename TEntityDataMap::iterator t_it) {
+      /* Re-bin the entity only if its cells have changed */
+      std::vector<size_t>& vecCells = t_it->second.Cells;
+      if(vecCells != m_vecUpdateCells) {
+         for(size_t i = 0; i < vecCells.size(); ++i) {
+            EraseFromCell(vecCells[i], t_it->first);
+         }
+         for(size_t i = 0; i < m_vecUpdateCells.size(); ++i) {
+            SCell& sCell = GetOrCreateCell(m_vecUpdateCells[i]);
+            if(sCell.Timestamp < m_unCurTimestamp) {
+               sCell.Entities.clear();
+               sCell.Timestamp = m_unCurTimestamp;
+            }
+            sCell.Entities.insert(t_it->first);
+         }
+         vecCells.swap(m_vecUpdateCells);
+         MarkAway(t_it);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CGrid<ENTITY>::MarkAway(typename TEntityDataMap::iterator t_it) {
+      if(!m_bSnapshot || t_it->second.Away) return;
+      /* An entity added after the snapshot is away as long as it occupies cells */
+      if(t_it->second.HasSnapshot ?
+         (t_it->second.Cells != t_it->second.SnapshotCells) :
+         !t_it->second.Cells.empty()) {
+         t_it->second.Away = true;
+         m_vecAwayEntities.push_back(t_it);
+      }
    }
 
    /****************************************/
@@ -138,9 +382,8 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
    template<class ENTITY>
    void CGrid<ENTITY>::GetEntitiesAt(CSet<ENTITY*>& c_entities,
                                      const CVector3& c_position) const {
-      try {
-         SInt32 i, j, k;
-         PositionToCell(i, j, k, c_position);
+      SInt32 i, j, k;
+      if(PositionToCellClamped(i, j, k, c_position)) {
          const SCell& sCell = GetCellAt(i, j, k);
          if(sCell.Timestamp < m_unCurTimestamp) {
             c_entities.clear();
@@ -149,8 +392,9 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
             c_entities = sCell.Entities;
          }
       }
-      catch(CARGoSException& ex) {
-         THROW_ARGOSEXCEPTION_NESTED("CGrid<ENTITY>::GetEntitiesAt() : Position <" << c_position << "> out of bounds X -> " << m_cRangeX << " Y -> " << m_cRangeY << " Z -> " << m_cRangeZ, ex);
+      else {
+         /* No entity is indexed out of the area */
+         c_entities.clear();
       }
    }
 
@@ -174,34 +418,39 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
       /* Calculate cells for center */
       SInt32 nIC, nJC, nKC, nIR, nJR, nKR;
       PositionToCellUnsafe(nIC, nJC, nKC, c_center);
+      /* Skip the bounds checks when the whole sphere is in the grid */
+      bool bInside = IsCellRangeInside(nIC, nJC, nKC,
+                                       Floor(f_radius * m_cInvCellSize.GetX() + 0.5f),
+                                       Floor(f_radius * m_cInvCellSize.GetY() + 0.5f),
+                                       Floor(f_radius * m_cInvCellSize.GetZ() + 0.5f));
       if(nKC >= 0 && nKC < m_nSizeK) {
          /* Check circle center */
-         if((nIC >= 0 && nIC < m_nSizeI) && (nJC >= 0 && nJC < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nIC, nJC, nKC);
+         APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC, nJC, nKC);
          /* Calculate radia of circle */
          nIR = Floor(f_radius * m_cInvCellSize.GetX() + 0.5f);
          nJR = Floor(f_radius * m_cInvCellSize.GetY() + 0.5f);
          /* Go through diameter on j at i = 0 */
          if(nIC >= 0 && nIC < m_nSizeI) {
             for(SInt32 j = nJR; j > 0; --j) {
-               if(nJC + j >= 0 && nJC + j < m_nSizeJ) APPLY_ENTITY_OPERATION_TO_CELL(nIC, nJC + j, nKC);
-               if(nJC - j >= 0 && nJC - j < m_nSizeJ) APPLY_ENTITY_OPERATION_TO_CELL(nIC, nJC - j, nKC);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC, nJC + j, nKC);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC, nJC - j, nKC);
             }
          }
          /* Go through diameter on i at j = 0 */
          if(nJC >= 0 && nJC < m_nSizeJ) {
             for(SInt32 i = nIR; i > 0; --i) {
-               if(nIC + i >= 0 && nIC + i < m_nSizeI) APPLY_ENTITY_OPERATION_TO_CELL(nIC + i, nJC, nKC);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI) APPLY_ENTITY_OPERATION_TO_CELL(nIC - i, nJC, nKC);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC, nKC);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC, nKC);
             }
          }
          /* Go through cells with k = nKC */
          for(SInt32 j = nJR; j > 0; --j) {
             nIR = Floor(Sqrt(Max<Real>(0.0f, f_radius * f_radius - j * m_cCellSize.GetY() * j * m_cCellSize.GetY())) * m_cInvCellSize.GetX() + 0.5f);
             for(SInt32 i = nIR; i > 0; --i) {
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ) APPLY_ENTITY_OPERATION_TO_CELL(nIC + i, nJC + j, nKC);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ) APPLY_ENTITY_OPERATION_TO_CELL(nIC + i, nJC - j, nKC);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ) APPLY_ENTITY_OPERATION_TO_CELL(nIC - i, nJC + j, nKC);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ) APPLY_ENTITY_OPERATION_TO_CELL(nIC - i, nJC - j, nKC);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC + j, nKC);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC - j, nKC);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC + j, nKC);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC - j, nKC);
             }
          }
       }
@@ -211,8 +460,8 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
       for(SInt32 k = nKR; k > 0; --k) {
          /* Check center of circle at k and -k */
          if((nIC >= 0 && nIC < m_nSizeI) && (nJC >= 0 && nJC < m_nSizeJ)) {
-            if(nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC, nJC, nKC + k);
-            if(nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC, nJC, nKC - k);
+            APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC, nJC, nKC + k);
+            APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC, nJC, nKC - k);
          }
          /* Calculate radius of circle at k and -k */
          fCircleRadius2 = Max<Real>(0.0f, f_radius * f_radius - k * m_cCellSize.GetZ() * k * m_cCellSize.GetZ());
@@ -221,10 +470,10 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
          /* Go through diameter on i at j = 0 */
          if(nJC >= 0 && nJC < m_nSizeJ) {
             for(SInt32 i = nIR; i > 0; --i) {
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC + i, nJC, nKC + k);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC + i, nJC, nKC - k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC - i, nJC, nKC + k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC - i, nJC, nKC - k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC, nKC + k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC, nKC - k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC, nKC + k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC, nKC - k);
             }
          }
          /* Calculate circle radius in cells on j */
@@ -232,22 +481,22 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
          for(SInt32 j = nJR; j > 0; --j) {
             /* Go through diameter on j at i = 0 */
             if(nIC >= 0 && nIC < m_nSizeI) {
-               if(nJC + j >= 0 && nJC + j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC, nJC + j, nKC + k);
-               if(nJC + j >= 0 && nJC + j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC, nJC + j, nKC - k);
-               if(nJC - j >= 0 && nJC - j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC, nJC - j, nKC + k);
-               if(nJC - j >= 0 && nJC - j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC, nJC - j, nKC - k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC, nJC + j, nKC + k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC, nJC + j, nKC - k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC, nJC - j, nKC + k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC, nJC - j, nKC - k);
             }
             /* Calculate radius of circle at j,k */
             nIR = Floor(Sqrt(Max<Real>(0.0f, fCircleRadius2 - j * m_cCellSize.GetY() * j * m_cCellSize.GetY())) * m_cInvCellSize.GetX() + 0.5f);
             for(SInt32 i = nIR; i > 0; --i) {
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC + i, nJC + j, nKC + k);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC + i, nJC + j, nKC - k);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC + i, nJC - j, nKC + k);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC + i, nJC - j, nKC - k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC - i, nJC + j, nKC + k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC - i, nJC + j, nKC - k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC - i, nJC - j, nKC + k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_ENTITY_OPERATION_TO_CELL(nIC - i, nJC - j, nKC - k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC + j, nKC + k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC + j, nKC - k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC - j, nKC + k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC - j, nKC - k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC + j, nKC + k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC + j, nKC - k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC - j, nKC + k);
+               APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC - j, nKC - k);
             }
          }
       }
@@ -285,31 +534,34 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
                                                 CEntityOperation& c_operation) {
       /* Make sure the Z coordinate is inside the range */
       if(! m_cRangeZ.WithinMinBoundIncludedMaxBoundIncluded(c_center.GetZ())) return;
-      /* Calculate cells for center */
+      /* Calculate cells for center; a center on the top face belongs to the top cells */
       SInt32 nI, nJ, nK;
       PositionToCellUnsafe(nI, nJ, nK, c_center);
+      if(nK >= m_nSizeK) nK = m_nSizeK - 1;
+      /* Skip the bounds checks when the whole circle is in the grid */
+      SInt32 nID = Floor(f_radius * m_cInvCellSize.GetX() + 0.5f);
+      SInt32 nJD = Floor(f_radius * m_cInvCellSize.GetY() + 0.5f);
+      bool bInside = IsCellRangeInside(nI, nJ, nK, nID, nJD, 0);
       /* Check circle center */
-      if((nI >= 0 && nI < m_nSizeI) && (nJ >= 0 && nJ < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nI, nJ, nK);
+      APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI, nJ, nK);
       /* Check circle diameter on I */
-      SInt32 nID = Floor(f_radius * m_cInvCellSize.GetX() + 0.5f);
       for(SInt32 h = nID; h > 0; --h) {
-         if((nI + h >= 0 && nI + h < m_nSizeI) && (nJ >= 0 && nJ < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nI + h, nJ, nK);
-         if((nI - h >= 0 && nI - h < m_nSizeI) && (nJ >= 0 && nJ < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nI - h, nJ, nK);
+         APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI + h, nJ, nK);
+         APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI - h, nJ, nK);
       }
       /* Check circle diameter on J */
-      SInt32 nJD = Floor(f_radius * m_cInvCellSize.GetY() + 0.5f);
       for(SInt32 h = nJD; h > 0; --h) {
-         if((nI >= 0 && nI < m_nSizeI) && (nJ + h >= 0 && nJ + h < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nI, nJ + h, nK);
-         if((nI >= 0 && nI < m_nSizeI) && (nJ - h >= 0 && nJ - h < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nI, nJ - h, nK);
+         APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI, nJ + h, nK);
+         APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI, nJ - h, nK);
       }
       /* Check rest of the circle */
       for(SInt32 i = nID; i > 0; --i) {
-         nJD = Floor(Sqrt(f_radius * f_radius - i * m_cCellSize.GetX() * i * m_cCellSize.GetX()) * m_cInvCellSize.GetY() + 0.5f);
+         nJD = Floor(Sqrt(Max<Real>(0.0f, f_radius * f_radius - i * m_cCellSize.GetX() * i * m_cCellSize.GetX())) * m_cInvCellSize.GetY() + 0.5f);
          for(SInt32 j = nJD; j > 0; --j) {
-            if((nI + i >= 0 && nI + i < m_nSizeI) && (nJ + j >= 0 && nJ + j < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nI + i, nJ + j, nK);
-            if((nI + i >= 0 && nI + i < m_nSizeI) && (nJ - j >= 0 && nJ - j < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nI + i, nJ - j, nK);
-            if((nI - i >= 0 && nI - i < m_nSizeI) && (nJ + j >= 0 && nJ + j < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nI - i, nJ + j, nK);
-            if((nI - i >= 0 && nI - i < m_nSizeI) && (nJ - j >= 0 && nJ - j < m_nSizeJ)) APPLY_ENTITY_OPERATION_TO_CELL(nI - i, nJ - j, nK);
+            APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI + i, nJ + j, nK);
+            APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI + i, nJ - j, nK);
+            APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI - i, nJ + j, nK);
+            APPLY_ENTITY_OPERATION_TO_CELL_CLIPPED(nI - i, nJ - j, nK);
          }
       }
    }
@@ -538,34 +790,39 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
       /* Calculate cells for center */
       SInt32 nIC, nJC, nKC, nIR, nJR, nKR;
       PositionToCellUnsafe(nIC, nJC, nKC, c_center);
+      /* Skip the bounds checks when the whole sphere is in the grid */
+      bool bInside = IsCellRangeInside(nIC, nJC, nKC,
+                                       Floor(f_radius * m_cInvCellSize.GetX() + 0.5f),
+                                       Floor(f_radius * m_cInvCellSize.GetY() + 0.5f),
+                                       Floor(f_radius * m_cInvCellSize.GetZ() + 0.5f));
       if(nKC >= 0 && nKC < m_nSizeK) {
          /* Check circle center */
-         if((nIC >= 0 && nIC < m_nSizeI) && (nJC >= 0 && nJC < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nIC, nJC, nKC);
+         APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC, nJC, nKC);
          /* Calculate radia of circle */
          nIR = Floor(f_radius * m_cInvCellSize.GetX() + 0.5f);
          nJR = Floor(f_radius * m_cInvCellSize.GetY() + 0.5f);
          /* Go through diameter on j at i = 0 */
          if(nIC >= 0 && nIC < m_nSizeI) {
             for(SInt32 j = nJR; j > 0; --j) {
-               if(nJC + j >= 0 && nJC + j < m_nSizeJ) APPLY_CELL_OPERATION_TO_CELL(nIC, nJC + j, nKC);
-               if(nJC - j >= 0 && nJC - j < m_nSizeJ) APPLY_CELL_OPERATION_TO_CELL(nIC, nJC - j, nKC);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC, nJC + j, nKC);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC, nJC - j, nKC);
             }
          }
          /* Go through diameter on i at j = 0 */
          if(nJC >= 0 && nJC < m_nSizeJ) {
             for(SInt32 i = nIR; i > 0; --i) {
-               if(nIC + i >= 0 && nIC + i < m_nSizeI) APPLY_CELL_OPERATION_TO_CELL(nIC + i, nJC, nKC);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI) APPLY_CELL_OPERATION_TO_CELL(nIC - i, nJC, nKC);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC, nKC);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC, nKC);
             }
          }
          /* Go through cells with k = nKC */
          for(SInt32 j = nJR; j > 0; --j) {
             nIR = Floor(Sqrt(Max<Real>(0.0f, f_radius * f_radius - j * m_cCellSize.GetY() * j * m_cCellSize.GetY())) * m_cInvCellSize.GetX() + 0.5f);
             for(SInt32 i = nIR; i > 0; --i) {
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ) APPLY_CELL_OPERATION_TO_CELL(nIC + i, nJC + j, nKC);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ) APPLY_CELL_OPERATION_TO_CELL(nIC + i, nJC - j, nKC);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ) APPLY_CELL_OPERATION_TO_CELL(nIC - i, nJC + j, nKC);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ) APPLY_CELL_OPERATION_TO_CELL(nIC - i, nJC - j, nKC);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC + j, nKC);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC - j, nKC);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC + j, nKC);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC - j, nKC);
             }
          }
       }
@@ -575,8 +832,8 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
       for(SInt32 k = nKR; k > 0; --k) {
          /* Check center of circle at k and -k */
          if((nIC >= 0 && nIC < m_nSizeI) && (nJC >= 0 && nJC < m_nSizeJ)) {
-            if(nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC, nJC, nKC + k);
-            if(nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC, nJC, nKC - k);
+            APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC, nJC, nKC + k);
+            APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC, nJC, nKC - k);
          }
          /* Calculate radius of circle at k and -k */
          fCircleRadius2 = Max<Real>(0.0f, f_radius * f_radius - k * m_cCellSize.GetZ() * k * m_cCellSize.GetZ());
@@ -585,10 +842,10 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
          /* Go through diameter on i at j = 0 */
          if(nJC >= 0 && nJC < m_nSizeJ) {
             for(SInt32 i = nIR; i > 0; --i) {
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC + i, nJC, nKC + k);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC + i, nJC, nKC - k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC - i, nJC, nKC + k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC - i, nJC, nKC - k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC, nKC + k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC, nKC - k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC, nKC + k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC, nKC - k);
             }
          }
          /* Calculate circle radius in cells on j */
@@ -596,22 +853,22 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
          for(SInt32 j = nJR; j > 0; --j) {
             /* Go through diameter on j at i = 0 */
             if(nIC >= 0 && nIC < m_nSizeI) {
-               if(nJC + j >= 0 && nJC + j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC, nJC + j, nKC + k);
-               if(nJC + j >= 0 && nJC + j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC, nJC + j, nKC - k);
-               if(nJC - j >= 0 && nJC - j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC, nJC - j, nKC + k);
-               if(nJC - j >= 0 && nJC - j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC, nJC - j, nKC - k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC, nJC + j, nKC + k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC, nJC + j, nKC - k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC, nJC - j, nKC + k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC, nJC - j, nKC - k);
             }
             /* Calculate radius of circle at j,k */
             nIR = Floor(Sqrt(Max<Real>(0.0f, fCircleRadius2 - j * m_cCellSize.GetY() * j * m_cCellSize.GetY())) * m_cInvCellSize.GetX() + 0.5f);
             for(SInt32 i = nIR; i > 0; --i) {
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC + i, nJC + j, nKC + k);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC + i, nJC + j, nKC - k);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC + i, nJC - j, nKC + k);
-               if(nIC + i >= 0 && nIC + i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC + i, nJC - j, nKC - k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC - i, nJC + j, nKC + k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC + j >= 0 && nJC + j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC - i, nJC + j, nKC - k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ && nKC + k >= 0 && nKC + k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC - i, nJC - j, nKC + k);
-               if(nIC - i >= 0 && nIC - i < m_nSizeI && nJC - j >= 0 && nJC - j < m_nSizeJ && nKC - k >= 0 && nKC - k < m_nSizeK) APPLY_CELL_OPERATION_TO_CELL(nIC - i, nJC - j, nKC - k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC + j, nKC + k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC + j, nKC - k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC - j, nKC + k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC + i, nJC - j, nKC - k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC + j, nKC + k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC + j, nKC - k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC - j, nKC + k);
+               APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nIC - i, nJC - j, nKC - k);
             }
          }
       }
@@ -649,31 +906,34 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
                                              CCellOperation& c_operation) {
       /* Make sure the Z coordinate is inside the range */
       if(! m_cRangeZ.WithinMinBoundIncludedMaxBoundIncluded(c_center.GetZ())) return;
-      /* Calculate cells for center */
+      /* Calculate cells for center; a center on the top face belongs to the top cells */
       SInt32 nI, nJ, nK;
       PositionToCellUnsafe(nI, nJ, nK, c_center);
+      if(nK >= m_nSizeK) nK = m_nSizeK - 1;
+      /* Skip the bounds checks when the whole circle is in the grid */
+      SInt32 nID = Floor(f_radius * m_cInvCellSize.GetX() + 0.5f);
+      SInt32 nJD = Floor(f_radius * m_cInvCellSize.GetY() + 0.5f);
+      bool bInside = IsCellRangeInside(nI, nJ, nK, nID, nJD, 0);
       /* Check circle center */
-      if((nI >= 0 && nI < m_nSizeI) && (nJ >= 0 && nJ < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nI, nJ, nK);
+      APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI, nJ, nK);
       /* Check circle diameter on I */
-      SInt32 nID = Floor(f_radius * m_cInvCellSize.GetX() + 0.5f);
       for(SInt32 h = nID; h > 0; --h) {
-         if((nI + h >= 0 && nI + h < m_nSizeI) && (nJ >= 0 && nJ < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nI + h, nJ, nK);
-         if((nI - h >= 0 && nI - h < m_nSizeI) && (nJ >= 0 && nJ < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nI - h, nJ, nK);
+         APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI + h, nJ, nK);
+         APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI - h, nJ, nK);
       }
       /* Check circle diameter on J */
-      SInt32 nJD = Floor(f_radius * m_cInvCellSize.GetY() + 0.5f);
       for(SInt32 h = nJD; h > 0; --h) {
-         if((nI >= 0 && nI < m_nSizeI) && (nJ + h >= 0 && nJ + h < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nI, nJ + h, nK);
-         if((nI >= 0 && nI < m_nSizeI) && (nJ - h >= 0 && nJ - h < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nI, nJ - h, nK);
+         APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI, nJ + h, nK);
+         APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI, nJ - h, nK);
       }
       /* Check rest of the circle */
       for(SInt32 i = nID; i > 0; --i) {
-         nJD = Floor(Sqrt(f_radius * f_radius - i * m_cCellSize.GetX() * i * m_cCellSize.GetX()) * m_cInvCellSize.GetY() + 0.5f);
+         nJD = Floor(Sqrt(Max<Real>(0.0f, f_radius * f_radius - i * m_cCellSize.GetX() * i * m_cCellSize.GetX())) * m_cInvCellSize.GetY() + 0.5f);
          for(SInt32 j = nJD; j > 0; --j) {
-            if((nI + i >= 0 && nI + i < m_nSizeI) && (nJ + j >= 0 && nJ + j < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nI + i, nJ + j, nK);
-            if((nI + i >= 0 && nI + i < m_nSizeI) && (nJ - j >= 0 && nJ - j < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nI + i, nJ - j, nK);
-            if((nI - i >= 0 && nI - i < m_nSizeI) && (nJ + j >= 0 && nJ + j < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nI - i, nJ + j, nK);
-            if((nI - i >= 0 && nI - i < m_nSizeI) && (nJ - j >= 0 && nJ - j < m_nSizeJ)) APPLY_CELL_OPERATION_TO_CELL(nI - i, nJ - j, nK);
+            APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI + i, nJ + j, nK);
+            APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI + i, nJ - j, nK);
+            APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI - i, nJ + j, nK);
+            APPLY_CELL_OPERATION_TO_CELL_CLIPPED(nI - i, nJ - j, nK);
          }
       }
    }
@@ -880,15 +1140,92 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
    /****************************************/
    /****************************************/
 
+   template<class ENTITY>
+   void CGrid<ENTITY>::WalkAlongRay(const CRay3& c_ray,
+                                    CRayCellOperation& c_operation) const {
+      const CVector3& cStart = c_ray.GetStart();
+      CVector3 cDelta = c_ray.GetEnd() - cStart;
+      /* Clip the ray to the grid area */
+      Real fTMin = 0.0f, fTMax = 1.0f;
+      const CRange<Real>* pcRanges[3] = { &m_cRangeX, &m_cRangeY, &m_cRangeZ };
+      for(UInt32 a = 0; a < 3; ++a) {
+         if(cDelta[a] == 0.0f) {
+            if(!pcRanges[a]->WithinMinBoundIncludedMaxBoundIncluded(cStart[a])) return;
+         }
+         else {
+            Real fT1 = (pcRanges[a]->GetMin() - cStart[a]) / cDelta[a];
+            Real fT2 = (pcRanges[a]->GetMax() - cStart[a]) / cDelta[a];
+            if(fT1 > fT2) std::swap(fT1, fT2);
+            if(fT1 > fTMin) fTMin = fT1;
+            if(fT2 < fTMax) fTMax = fT2;
+            if(fTMin > fTMax) return;
+         }
+      }
+      /* Find the cell where the walk starts */
+      SInt32 pnCell[3];
+      PositionToCellUnsafe(pnCell[0], pnCell[1], pnCell[2], cStart + cDelta * fTMin);
+      ClampCoordinates(pnCell[0], pnCell[1], pnCell[2]);
+      /*
+       * For each axis, calculate the direction of the steps, the t at which
+       * the ray crosses the next cell boundary and the t between boundaries
+       */
+      SInt32 pnSize[3] = { m_nSizeI, m_nSizeJ, m_nSizeK };
+      SInt32 pnStep[3];
+      Real pfTNext[3], pfTDelta[3];
+      for(UInt32 a = 0; a < 3; ++a) {
+         if(cDelta[a] > 0.0f) {
+            pnStep[a] = 1;
+            pfTNext[a] = (m_cAreaMinCorner[a] + (pnCell[a] + 1) * m_cCellSize[a] - cStart[a]) / cDelta[a];
+            pfTDelta[a] = m_cCellSize[a] / cDelta[a];
+         }
+         else if(cDelta[a] < 0.0f) {
+            pnStep[a] = -1;
+            pfTNext[a] = (m_cAreaMinCorner[a] + pnCell[a] * m_cCellSize[a] - cStart[a]) / cDelta[a];
+            pfTDelta[a] = -m_cCellSize[a] / cDelta[a];
+         }
+         else {
+            pnStep[a] = 0;
+            pfTNext[a] = fTMax;
+            pfTDelta[a] = 0.0f;
+         }
+      }
+      /* Walk */
+      while(true) {
+         /* The axis whose boundary is crossed first */
+         UInt32 unAxis = 0;
+         if(pfTNext[1] < pfTNext[unAxis]) unAxis = 1;
+         if(pfTNext[2] < pfTNext[unAxis]) unAxis = 2;
+         Real fTExit = Min(pfTNext[unAxis], fTMax);
+         const SCell& sCell = GetCellAt(pnCell[0], pnCell[1], pnCell[2]);
+         if(sCell.Timestamp < m_unCurTimestamp) {
+            if(!c_operation(m_sEmptyCell, fTExit)) return;
+         }
+         else {
+            if(!c_operation(sCell, fTExit)) return;
+         }
+         /* Move to the next cell */
+         if(fTExit >= fTMax) return;
+         pnCell[unAxis] += pnStep[unAxis];
+         if(pnCell[unAxis] < 0 || pnCell[unAxis] >= pnSize[unAxis]) return;
+         pfTNext[unAxis] += pfTDelta[unAxis];
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    template<class ENTITY>
    void CGrid<ENTITY>::UpdateCell(SInt32 n_i,
                                   SInt32 n_j,
                                   SInt32 n_k,
                                   ENTITY& c_entity) {
-      if((n_i >= 0) && (n_i < m_nSizeI) &&
-         (n_j >= 0) && (n_j < m_nSizeJ) &&
-         (n_k >= 0) && (n_k < m_nSizeK)) {
-         SCell& sCell = GetCellAt(n_i, n_j, n_k);
+      if(IsCellInside(n_i, n_j, n_k)) {
+         if(m_bRecordingCells) {
+            /* Called by Update(), which takes care of the cell contents */
+            m_vecUpdateCells.push_back(CellIndex(n_i, n_j, n_k));
+            return;
+         }
+         SCell& sCell = GetOrCreateCell(CellIndex(n_i, n_j, n_k));
          if(sCell.Timestamp < m_unCurTimestamp) {
             sCell.Entities.clear();
             sCell.Timestamp = m_unCurTimestamp;
@@ -916,14 +1253,7 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
                                       SInt32& n_j,
                                       SInt32& n_k,
                                       const CVector3& c_position) const {
-      if(m_cRangeX.WithinMinBoundIncludedMaxBoundIncluded(c_position.GetX()) &&
-         m_cRangeY.WithinMinBoundIncludedMaxBoundIncluded(c_position.GetY()) &&
-         m_cRangeZ.WithinMinBoundIncludedMaxBoundIncluded(c_position.GetZ())) {
-         n_i = Floor((c_position.GetX() - m_cAreaMinCorner.GetX()) * m_cInvCellSize.GetX());
-         n_j = Floor((c_position.GetY() - m_cAreaMinCorner.GetY()) * m_cInvCellSize.GetY());
-         n_k = Floor((c_position.GetZ() - m_cAreaMinCorner.GetZ()) * m_cInvCellSize.GetZ());
-      }
-      else {
+      if(!PositionToCellClamped(n_i, n_j, n_k, c_position)) {
          THROW_ARGOSEXCEPTION("CGrid<ENTITY>::PositionToCell() : Position <" << c_position << "> out of bounds X -> " << m_cRangeX << " Y -> " << m_cRangeY << " Z -> " << m_cRangeZ);
       }
    }
@@ -931,6 +1261,22 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
    /****************************************/
    /****************************************/
 
+   template<class ENTITY>
+   bool CGrid<ENTITY>::PositionToCellClamped(SInt32& n_i,
+                                             SInt32& n_j,
+                                             SInt32& n_k,
+                                             const CVector3& c_position) const {
+      PositionToCellUnsafe(n_i, n_j, n_k, c_position);
+      ClampCoordinates(n_i, n_j, n_k);
+      return
+         m_cRangeX.WithinMinBoundIncludedMaxBoundIncluded(c_position.GetX()) &&
+         m_cRangeY.WithinMinBoundIncludedMaxBoundIncluded(c_position.GetY()) &&
+         m_cRangeZ.WithinMinBoundIncludedMaxBoundIncluded(c_position.GetZ());
+   }
+
+   /****************************************/
+   /****************************************/
+
    template<class ENTITY>
    void CGrid<ENTITY>::PositionToCellUnsafe(SInt32& n_i,
                                             SInt32& n_j,
@@ -973,12 +1319,20 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
    /****************************************/
    
    template<class ENTITY>
-   typename CGrid<ENTITY>::SCell& CGrid<ENTITY>::GetCellAt(SInt32 n_i,
-                                                           SInt32 n_j,
-                                                           SInt32 n_k) {
-      return m_psCells[m_nSizeI * m_nSizeJ * n_k +
-                       m_nSizeI * n_j +
-                       n_i];
+   typename CGrid<ENTITY>::SCell& CGrid<ENTITY>::GetOperationCell(SInt32 n_i,
+                                                                  SInt32 n_j,
+                                                                  SInt32 n_k) {
+      if(m_bSparse) {
+         size_t unSlot = FindSparseSlot(CellIndex(n_i, n_j, n_k));
+         if(m_vecSparseSlots[unSlot].Key == SPARSE_GRID_EMPTY_KEY) {
+            /* Hand out a cleared scratch cell, so changes to it are lost
+               instead of leaking into the shared empty cell */
+            m_sScratchCell.Reset();
+            return m_sScratchCell;
+         }
+         return m_vecSparseSlots[unSlot].Cell;
+      }
+      return m_psCells[CellIndex(n_i, n_j, n_k)];
    }
 
    /****************************************/
@@ -988,12 +1342,141 @@ CGrid<ENTITY>::CGrid(const CVector3& c_area_min_corner,
    const typename CGrid<ENTITY>::SCell& CGrid<ENTITY>::GetCellAt(SInt32 n_i,
                                                                  SInt32 n_j,
                                                                  SInt32 n_k) const {
-      return m_psCells[m_nSizeI * m_nSizeJ * n_k +
-                       m_nSizeI * n_j +
-                       n_i];
+      if(m_bSparse) {
+         size_t unSlot = FindSparseSlot(CellIndex(n_i, n_j, n_k));
+         if(m_vecSparseSlots[unSlot].Key == SPARSE_GRID_EMPTY_KEY) return m_sEmptyCell;
+         return m_vecSparseSlots[unSlot].Cell;
+      }
+      return m_psCells[CellIndex(n_i, n_j, n_k)];
    }
 
    /****************************************/
    /****************************************/
-   
+
+   template<class ENTITY>
+   size_t CGrid<ENTITY>::CellIndex(SInt32 n_i,
+                                   SInt32 n_j,
+                                   SInt32 n_k) const {
+      return
+         static_cast<size_t>(m_nSizeI) * m_nSizeJ * n_k +
+         static_cast<size_t>(m_nSizeI) * n_j +
+         n_i;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   typename CGrid<ENTITY>::SCell& CGrid<ENTITY>::GetOrCreateCell(size_t un_index) {
+      if(!m_bSparse) return m_psCells[un_index];
+      size_t unSlot = FindSparseSlot(un_index);
+      if(m_vecSparseSlots[unSlot].Key == SPARSE_GRID_EMPTY_KEY) {
+         /* Keep the load factor below 1/2 */
+         if(2 * (m_unSparseSize + 1) > m_vecSparseSlots.size()) {
+            GrowSparseTable();
+            unSlot = FindSparseSlot(un_index);
+         }
+         m_vecSparseSlots[unSlot].Key = un_index;
+         m_vecSparseSlots[unSlot].Cell.Timestamp = m_unCurTimestamp;
+         ++m_unSparseSize;
+      }
+      return m_vecSparseSlots[unSlot].Cell;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CGrid<ENTITY>::EraseFromCell(size_t un_index,
+                                     ENTITY* pc_entity) {
+      if(!m_bSparse) {
+         m_psCells[un_index].Entities.erase(pc_entity);
+         return;
+      }
+      size_t unSlot = FindSparseSlot(un_index);
+      if(m_vecSparseSlots[unSlot].Key == SPARSE_GRID_EMPTY_KEY) return;
+      m_vecSparseSlots[unSlot].Cell.Entities.erase(pc_entity);
+      if(m_vecSparseSlots[unSlot].Cell.Entities.empty()) {
+         DeleteSparseSlot(unSlot);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   size_t CGrid<ENTITY>::FindSparseSlot(size_t un_key) const {
+      size_t unMask = m_vecSparseSlots.size() - 1;
+      size_t unSlot = SparseGridHash(un_key) & unMask;
+      /* Linear probing; the table is never full */
+      while(m_vecSparseSlots[unSlot].Key != SPARSE_GRID_EMPTY_KEY &&
+            m_vecSparseSlots[unSlot].Key != un_key) {
+         unSlot = (unSlot + 1) & unMask;
+      }
+      return unSlot;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CGrid<ENTITY>::DeleteSparseSlot(size_t un_slot) {
+      /*
+       * Backward-shift deletion: move back the following slots of the
+       * probe sequence, so no tombstones are needed
+       */
+      size_t unMask = m_vecSparseSlots.size() - 1;
+      size_t unHole = un_slot;
+      size_t unNext = (un_slot + 1) & unMask;
+      while(m_vecSparseSlots[unNext].Key != SPARSE_GRID_EMPTY_KEY) {
+         size_t unHome = SparseGridHash(m_vecSparseSlots[unNext].Key) & unMask;
+         /* Can the slot be moved to the hole? Only if its home is not in (hole,next] */
+         if(((unNext - unHome) & unMask) >= ((unNext - unHole) & unMask)) {
+            m_vecSparseSlots[unHole].Key = m_vecSparseSlots[unNext].Key;
+            m_vecSparseSlots[unHole].Cell.Swap(m_vecSparseSlots[unNext].Cell);
+            unHole = unNext;
+         }
+         unNext = (unNext + 1) & unMask;
+      }
+      m_vecSparseSlots[unHole].Key = SPARSE_GRID_EMPTY_KEY;
+      m_vecSparseSlots[unHole].Cell.Reset();
+      --m_unSparseSize;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CGrid<ENTITY>::GrowSparseTable() {
+      std::vector<SSparseSlot> vecOldSlots(2 * m_vecSparseSlots.size());
+      for(size_t i = 0; i < vecOldSlots.size(); ++i) {
+         vecOldSlots[i].Key = SPARSE_GRID_EMPTY_KEY;
+      }
+      m_vecSparseSlots.swap(vecOldSlots);
+      /* Move the cells to the new table */
+      for(size_t i = 0; i < vecOldSlots.size(); ++i) {
+         if(vecOldSlots[i].Key != SPARSE_GRID_EMPTY_KEY) {
+            size_t unSlot = FindSparseSlot(vecOldSlots[i].Key);
+            m_vecSparseSlots[unSlot].Key = vecOldSlots[i].Key;
+            m_vecSparseSlots[unSlot].Cell.Swap(vecOldSlots[i].Cell);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CGrid<ENTITY>::ClearSparseTable() {
+      std::vector<SSparseSlot> vecSlots(SPARSE_GRID_INITIAL_CAPACITY);
+      for(size_t i = 0; i < vecSlots.size(); ++i) {
+         vecSlots[i].Key = SPARSE_GRID_EMPTY_KEY;
+      }
+      m_vecSparseSlots.swap(vecSlots);
+      m_unSparseSize = 0;
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
@@ -88,6 +88,19 @@ namespace argos {
        */
       virtual void Update() = 0;
 
+      /**
+       * Tells the index that the given entity moved or changed since the last update.
+       * Indices that check all the entities at each update ignore this call.
+       * @param c_entity The entity.
+       */
+      virtual void MarkDirty(ENTITY& c_entity) {}
+
+      /**
+       * Records the current content of the index as the one to restore on Reset().
+       * Indices that rebuild their content on Reset() ignore this call.
+       */
+      virtual void TakeSnapshot() {}
+
       /**
        * Puts the entities located at the given point in the passed buffer.
        * @param c_entities The entity set to use as buffer.
@@ -0,0 +1,238 @@
+/**
+ * @file <argos3/core/simulator/space/ray_grid.cpp>
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#include "ray_grid.h"
+#include <argos3/core/simulator/entity/embodied_entity.h>
+#include <argos3/core/utility/math/ray3.h>
+#include <set>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * The operations performed on the cells crossed by a ray.
+    * An entity that spans several cells may be tested more than once, but
+    * the entities of a cell are tested only if the search has not ended yet.
+    */
+
+   class CRayGridAllHits : public CGrid<CEmbodiedEntity>::CRayCellOperation {
+
+   public:
+
+      CRayGridAllHits(TEmbodiedEntityIntersectionData& t_data,
+                      const CRay3& c_ray) :
+         m_tData(t_data),
+         m_cRay(c_ray) {}
+
+      virtual bool operator()(const CGrid<CEmbodiedEntity>::SCell& s_cell,
+                              Real f_t_exit) {
+         Real fTOnRay;
+         for(CSet<CEmbodiedEntity*>::iterator it = s_cell.Entities.begin();
+             it != s_cell.Entities.end();
+             ++it) {
+            /* The intersection test does not depend on the cell, so each
+               entity is tested only the first time it is met */
+            if(m_setTested.insert(*it).second &&
+               (*it)->CheckIntersectionWithRay(fTOnRay, m_cRay)) {
+               m_tData.push_back(SEmbodiedEntityIntersectionItem(*it, fTOnRay));
+            }
+         }
+         return true;
+      }
+
+   private:
+
+      TEmbodiedEntityIntersectionData& m_tData;
+      const CRay3& m_cRay;
+      std::set<const CEmbodiedEntity*> m_setTested;
+   };
+
+   /****************************************/
+   /****************************************/
+
+   class CRayGridClosestHit : public CGrid<CEmbodiedEntity>::CRayCellOperation {
+
+   public:
+
+      CRayGridClosestHit(SEmbodiedEntityIntersectionItem& s_item,
+                         const CRay3& c_ray,
+                         const CEmbodiedEntity* pc_entity) :
+         Found(false),
+         m_sItem(s_item),
+         m_cRay(c_ray),
+         m_pcIgnoredEntity(pc_entity) {}
+
+      virtual bool operator()(const CGrid<CEmbodiedEntity>::SCell& s_cell,
+                              Real f_t_exit) {
+         Real fTOnRay;
+         for(CSet<CEmbodiedEntity*>::iterator it = s_cell.Entities.begin();
+             it != s_cell.Entities.end();
+             ++it) {
+            if(*it != m_pcIgnoredEntity &&
+               (*it)->CheckIntersectionWithRay(fTOnRay, m_cRay) &&
+               fTOnRay < m_sItem.TOnRay) {
+               m_sItem.IntersectedEntity = *it;
+               m_sItem.TOnRay = fTOnRay;
+               Found = true;
+            }
+         }
+         /* No entity in the next cells can be closer than a hit within this cell */
+         return m_sItem.TOnRay > f_t_exit;
+      }
+
+   public:
+
+      bool Found;
+
+   private:
+
+      SEmbodiedEntityIntersectionItem& m_sItem;
+      const CRay3& m_cRay;
+      const CEmbodiedEntity* m_pcIgnoredEntity;
+   };
+
+   /****************************************/
+   /****************************************/
+
+   class CRayGridAnyHit : public CGrid<CEmbodiedEntity>::CRayCellOperation {
+
+   public:
+
+      CRayGridAnyHit(const CRay3& c_ray,
+                     const CEmbodiedEntity* pc_entity_1,
+                     const CEmbodiedEntity* pc_entity_2) :
+         Occluded(false),
+         m_cRay(c_ray),
+         m_pcIgnoredEntity1(pc_entity_1),
+         m_pcIgnoredEntity2(pc_entity_2) {}
+
+      virtual bool operator()(const CGrid<CEmbodiedEntity>::SCell& s_cell,
+                              Real f_t_exit) {
+         Real fTOnRay;
+         for(CSet<CEmbodiedEntity*>::iterator it = s_cell.Entities.begin();
+             it != s_cell.Entities.end();
+             ++it) {
+            if(*it != m_pcIgnoredEntity1 &&
+               *it != m_pcIgnoredEntity2 &&
+               (*it)->CheckIntersectionWithRay(fTOnRay, m_cRay) &&
+               fTOnRay < 1.0f) {
+               Occluded = true;
+               return false;
+            }
+         }
+         return true;
+      }
+
+   public:
+
+      bool Occluded;
+
+   private:
+
+      const CRay3& m_cRay;
+      const CEmbodiedEntity* m_pcIgnoredEntity1;
+      const CEmbodiedEntity* m_pcIgnoredEntity2;
+   };
+
+   /****************************************/
+   /****************************************/
+
+   CRayGrid::CRayGrid() :
+      m_pcGrid(NULL),
+      m_pcUpdater(NULL) {}
+
+   /****************************************/
+   /****************************************/
+
+   CRayGrid::~CRayGrid() {
+      delete m_pcUpdater;
+      delete m_pcGrid;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRayGrid::Enable(const CVector3& c_area_min_corner,
+                         const CVector3& c_area_max_corner,
+                         SInt32 n_size_i,
+                         SInt32 n_size_j,
+                         SInt32 n_size_k) {
+      delete m_pcUpdater;
+      delete m_pcGrid;
+      m_pcGrid = new CGrid<CEmbodiedEntity>(c_area_min_corner,
+                                            c_area_max_corner,
+                                            n_size_i,
+                                            n_size_j,
+                                            n_size_k);
+      m_pcUpdater = new CEmbodiedEntityGridUpdater(*m_pcGrid);
+      m_pcGrid->SetUpdateEntityOperation(m_pcUpdater);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRayGrid::AddEntity(CEmbodiedEntity& c_entity) {
+      if(m_pcGrid != NULL) m_pcGrid->AddEntity(c_entity);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRayGrid::RemoveEntity(CEmbodiedEntity& c_entity) {
+      if(m_pcGrid != NULL) m_pcGrid->RemoveEntity(c_entity);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRayGrid::Update() {
+      if(m_pcGrid != NULL) m_pcGrid->Update();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRayGrid::Reset() {
+      if(m_pcGrid != NULL) m_pcGrid->Reset();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRayGrid::CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
+                                           const CRay3& c_ray) const {
+      CRayGridAllHits cOperation(t_data, c_ray);
+      m_pcGrid->WalkAlongRay(c_ray, cOperation);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CRayGrid::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                  const CRay3& c_ray,
+                                                  const CEmbodiedEntity* pc_entity) const {
+      CRayGridClosestHit cOperation(s_item, c_ray, pc_entity);
+      m_pcGrid->WalkAlongRay(c_ray, cOperation);
+      return cOperation.Found;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CRayGrid::IsSegmentOccluded(const CRay3& c_ray,
+                                    const CEmbodiedEntity* pc_entity_1,
+                                    const CEmbodiedEntity* pc_entity_2) const {
+      CRayGridAnyHit cOperation(c_ray, pc_entity_1, pc_entity_2);
+      m_pcGrid->WalkAlongRay(c_ray, cOperation);
+      return cOperation.Occluded;
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
@@ -0,0 +1,145 @@
+/**
+ * @file <argos3/core/simulator/space/ray_grid.h>
+ *
+ * @brief This file provides the definition of the ray grid, which indexes the
+ * embodied entities to answer ray queries without the physics engines.
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#ifndef RAY_GRID_H
+#define RAY_GRID_H
+
+namespace argos {
+   class CRayGrid;
+   class CEmbodiedEntity;
+   class CEmbodiedEntityGridUpdater;
+   class CRay3;
+}
+
+#include <argos3/core/simulator/physics_engine/physics_engine.h>
+#include <argos3/core/simulator/space/positional_indices/grid.h>
+
+namespace argos {
+
+   /**
+    * A grid of embodied entities that answers the ray queries of the sensors and media.
+    * <p>
+    * By default, each ray query asks every physics engine in turn. When the
+    * grid is active, the ray queries in physics_engine.h use it instead: the
+    * cells crossed by the ray are visited in order with a 3D-DDA walk, and
+    * only the entities in those cells are tested, with the exact shape of
+    * their physics models. The search for the closest hit stops as soon as a
+    * hit is found before the end of the current cell. This way, the cost of a
+    * query does not depend on the number of engines, and rays in empty areas
+    * are cheap.
+    * </p>
+    * <p>
+    * The grid is owned by the space, and it is inactive unless the
+    * <tt>&lt;arena&gt;</tt> section sets <tt>ray_index="grid"</tt>. The space
+    * updates it after the physics engines and after the PreStep() of the loop
+    * functions.
+    * </p>
+    * @see CGrid::WalkAlongRay
+    * @see CPhysicsModel::CheckIntersectionWithRay
+    */
+   class CRayGrid {
+
+   public:
+
+      CRayGrid();
+      ~CRayGrid();
+
+      /**
+       * Activates the grid.
+       * @param c_area_min_corner The corner of the area with the smallest coordinates.
+       * @param c_area_max_corner The corner of the area with the largest coordinates.
+       * @param n_size_i The number of cells along X.
+       * @param n_size_j The number of cells along Y.
+       * @param n_size_k The number of cells along Z.
+       */
+      void Enable(const CVector3& c_area_min_corner,
+                  const CVector3& c_area_max_corner,
+                  SInt32 n_size_i,
+                  SInt32 n_size_j,
+                  SInt32 n_size_k);
+
+      /**
+       * Returns <tt>true</tt> if the grid is active.
+       * @return <tt>true</tt> if the grid is active.
+       */
+      inline bool IsEnabled() const {
+         return m_pcGrid != NULL;
+      }
+
+      /**
+       * Adds an entity to the grid, if the grid is active.
+       * The entity is binned at the next Update().
+       */
+      void AddEntity(CEmbodiedEntity& c_entity);
+
+      /**
+       * Removes an entity from the grid, if the grid is active.
+       */
+      void RemoveEntity(CEmbodiedEntity& c_entity);
+
+      /**
+       * Bins the entities again, following their bounding boxes.
+       */
+      void Update();
+
+      /**
+       * Bins all the entities from scratch.
+       */
+      void Reset();
+
+      /**
+       * Finds all the entities intersected by the given ray.
+       * Each entity appears once, with its closest intersection.
+       * @param t_data The list of intersections found.
+       * @param c_ray The ray to test for intersections.
+       * @see GetEmbodiedEntitiesIntersectedByRay
+       */
+      void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
+                                    const CRay3& c_ray) const;
+
+      /**
+       * Finds the closest intersection with the given ray.
+       * <tt>s_item</tt> is updated only if an intersection closer than
+       * <tt>s_item.TOnRay</tt> is found.
+       * @param s_item The closest intersection found so far.
+       * @param c_ray The ray to test for intersections.
+       * @param pc_entity The entity to exclude from the check, or <tt>NULL</tt>.
+       * @return <tt>true</tt> if <tt>s_item</tt> was updated
+       * @see GetClosestEmbodiedEntityIntersectedByRay
+       */
+      bool CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                           const CRay3& c_ray,
+                                           const CEmbodiedEntity* pc_entity) const;
+
+      /**
+       * Checks whether the given segment is occluded by an entity.
+       * Intersections at the very end of the segment (t = 1) do not count.
+       * @param c_ray The segment to test.
+       * @param pc_entity_1 An entity to exclude from the check, or <tt>NULL</tt>.
+       * @param pc_entity_2 Another entity to exclude from the check, or <tt>NULL</tt>.
+       * @return <tt>true</tt> if an intersection is found
+       * @see IsSegmentOccluded
+       */
+      bool IsSegmentOccluded(const CRay3& c_ray,
+                             const CEmbodiedEntity* pc_entity_1,
+                             const CEmbodiedEntity* pc_entity_2) const;
+
+   private:
+
+      /** The grid, or NULL if the ray grid is not active */
+      CGrid<CEmbodiedEntity>* m_pcGrid;
+
+      /** The operation that bins an entity in the grid */
+      CEmbodiedEntityGridUpdater* m_pcUpdater;
+
+   };
+
+}
+
+#endif
@@ -12,6 +12,7 @@
 #include <argos3/core/utility/math/range.h>
 #include <argos3/core/utility/logging/argos_log.h>
 #include <argos3/core/utility/math/rng.h>
+#include <argos3/core/utility/profiler/profiler.h>
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/entity/composable_entity.h>
 #include <argos3/core/simulator/entity/positional_entity.h>
@@ -29,7 +30,10 @@ namespace argos {
       m_unSimulationClock(0),
       m_pcFloorEntity(NULL),
       m_ptPhysicsEngines(NULL),
-      m_ptMedia(NULL) {}
+      m_ptMedia(NULL),
+      m_pcDistributeRNG(NULL),
+      m_pcProfiler(NULL),
+      m_fStepPhaseStart(0.0) {}
    
    /****************************************/
    /****************************************/
@@ -38,11 +42,53 @@ namespace argos {
       /* Get reference to physics engine and media vectors */
       m_ptPhysicsEngines = &(m_cSimulator.GetPhysicsEngines());
       m_ptMedia = &(m_cSimulator.GetMedia());
+      /* Register the step phases to time */
+      if(m_cSimulator.IsProfiling()) {
+         m_pcProfiler = &(m_cSimulator.GetProfiler());
+         m_punStepPhases[STEP_PHASE_ACT] = m_pcProfiler->AddPhase("act");
+         m_punStepPhases[STEP_PHASE_PHYSICS] = m_pcProfiler->AddPhase("physics");
+         for(size_t i = 0; i < m_ptPhysicsEngines->size(); ++i) {
+            m_vecPhysicsEnginePhases.push_back(
+               m_pcProfiler->AddPhase("physics_" + (*m_ptPhysicsEngines)[i]->GetId()));
+         }
+         m_punStepPhases[STEP_PHASE_MEDIA] = m_pcProfiler->AddPhase("media");
+         for(size_t i = 0; i < m_ptMedia->size(); ++i) {
+            m_vecMediumPhases.push_back(
+               m_pcProfiler->AddPhase("media_" + (*m_ptMedia)[i]->GetId()));
+         }
+         m_vecMediumStarts.resize(m_ptMedia->size());
+         m_punStepPhases[STEP_PHASE_PRE_STEP] = m_pcProfiler->AddPhase("pre_step");
+         m_punStepPhases[STEP_PHASE_SENSE_CONTROL] = m_pcProfiler->AddPhase("sense_control");
+         m_punStepPhases[STEP_PHASE_POST_STEP] = m_pcProfiler->AddPhase("post_step");
+      }
       /* Get the arena center and size */
       GetNodeAttributeOrDefault(t_tree, "center", m_cArenaCenter, m_cArenaCenter);
       GetNodeAttribute(t_tree, "size", m_cArenaSize);
       m_cArenaLimits.Set(m_cArenaCenter - m_cArenaSize / 2.0f,
                          m_cArenaCenter + m_cArenaSize / 2.0f);
+      /* Set up the ray grid, if requested */
+      std::string strRayIndex = "none";
+      GetNodeAttributeOrDefault(t_tree, "ray_index", strRayIndex, strRayIndex);
+      if(strRayIndex == "grid") {
+         SInt32 pnGridSize[3] = {
+            static_cast<SInt32>(Ceil(m_cArenaSize.GetX())),
+            static_cast<SInt32>(Ceil(m_cArenaSize.GetY())),
+            static_cast<SInt32>(Ceil(m_cArenaSize.GetZ()))
+         };
+         if(NodeAttributeExists(t_tree, "ray_index_grid_size")) {
+            std::string strGridSize;
+            GetNodeAttribute(t_tree, "ray_index_grid_size", strGridSize);
+            ParseValues<SInt32>(strGridSize, 3, pnGridSize, ',');
+         }
+         m_cRayGrid.Enable(m_cArenaLimits.GetMin(),
+                           m_cArenaLimits.GetMax(),
+                           pnGridSize[0],
+                           pnGridSize[1],
+                           pnGridSize[2]);
+      }
+      else if(strRayIndex != "none") {
+         THROW_ARGOSEXCEPTION("Unknown ray index \"" << strRayIndex << "\" in the arena, allowed values are \"none\" and \"grid\".");
+      }
       /*
        * Add and initialize all entities in XML
        */
@@ -73,20 +119,96 @@ namespace argos {
    void CSpace::Reset() {
       /* Reset the simulation clock */
       m_unSimulationClock = 0;
-      /* Reset the entities */
-      for(UInt32 i = 0; i < m_vecEntities.size(); ++i) {
-         m_vecEntities[i]->Reset();
+      /* Forget the recorded motion */
+      m_cMotionGrid.Reset();
+      /* Reset the entities; the root entities reset their components */
+      for(UInt32 i = 0; i < m_vecRootEntities.size(); ++i) {
+         m_vecRootEntities[i]->Reset();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_unSimulationClock
+               << static_cast<UInt32>(m_vecRootEntities.size());
+      CByteArray cEntityState;
+      for(size_t i = 0; i < m_vecRootEntities.size(); ++i) {
+         cEntityState.Clear();
+         m_vecRootEntities[i]->SaveState(cEntityState);
+         c_buffer << m_vecRootEntities[i]->GetId()
+                  << static_cast<UInt32>(cEntityState.Size());
+         c_buffer.AddBuffer(cEntityState.ToCArray(), cEntityState.Size());
       }
    }
 
    /****************************************/
    /****************************************/
 
+   void CSpace::LoadState(CByteArray& c_buffer) {
+      UInt32 unNumEntities;
+      c_buffer >> m_unSimulationClock
+               >> unNumEntities;
+      if(unNumEntities != m_vecRootEntities.size()) {
+         THROW_ARGOSEXCEPTION("The saved state contains " << unNumEntities << " root entities, but the space has " << m_vecRootEntities.size());
+      }
+      /*
+       * The entity records are parsed by offset: extracting them one by one
+       * from the front of c_buffer would shift the rest of the buffer each time
+       */
+      const UInt8* punData = c_buffer.ToCArray();
+      size_t unOffset = 0;
+      std::string strId;
+      UInt32 unStateSize;
+      for(UInt32 i = 0; i < unNumEntities; ++i) {
+         /* Get the id */
+         const UInt8* punIdEnd = static_cast<const UInt8*>(
+            ::memchr(punData + unOffset, '\0', c_buffer.Size() - unOffset));
+         if(punIdEnd == NULL ||
+            punIdEnd - punData + 1 + sizeof(UInt32) > c_buffer.Size()) {
+            THROW_ARGOSEXCEPTION("The saved state of the space is truncated");
+         }
+         strId.assign(reinterpret_cast<const char*>(punData + unOffset),
+                      punIdEnd - punData - unOffset);
+         unOffset = punIdEnd - punData + 1;
+         /* Get the size of the entity state */
+         CByteArray cSize(punData + unOffset, sizeof(UInt32));
+         cSize >> unStateSize;
+         unOffset += sizeof(UInt32);
+         if(unOffset + unStateSize > c_buffer.Size()) {
+            THROW_ARGOSEXCEPTION("The saved state of entity \"" << strId << "\" is truncated");
+         }
+         /* Restore the entity */
+         CEntity& cEntity = GetEntity(strId);
+         if(cEntity.HasParent()) {
+            THROW_ARGOSEXCEPTION("The saved state refers to \"" << strId << "\", which is not a root entity");
+         }
+         CByteArray cEntityState(punData + unOffset, unStateSize);
+         cEntity.LoadState(cEntityState);
+         if(!cEntityState.Empty()) {
+            THROW_ARGOSEXCEPTION("The saved state of entity \"" << strId << "\" does not match the entity: " << cEntityState.Size() << " bytes were not used");
+         }
+         unOffset += unStateSize;
+      }
+      /* Leave the rest of the data in the buffer */
+      CByteArray cRest(punData + unOffset, c_buffer.Size() - unOffset);
+      c_buffer.Swap(cRest);
+      /* The recorded motion refers to the old positions */
+      m_cMotionGrid.Reset();
+      m_cRayGrid.Reset();
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CSpace::Destroy() {
       /* Remove all entities */
       while(!m_vecRootEntities.empty()) {
          CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(*this, *m_vecRootEntities.back());
       }
+      /* The RNG is deleted with its category */
+      m_pcDistributeRNG = NULL;
    }
 
    /****************************************/
@@ -121,18 +243,37 @@ namespace argos {
    void CSpace::Update() {
       /* Increase the simulation clock */
       IncreaseSimulationClock();
+      /* Counter-based RNGs start the sequence of the new step */
+      CRandom::GetCategory("argos").SetStep(m_unSimulationClock);
       /* Perform the 'act' phase for controllable entities */
+      StartStepPhase();
       UpdateControllableEntitiesAct();
+      EndStepPhase(STEP_PHASE_ACT);
       /* Update the physics engines */
+      StartStepPhase();
       UpdatePhysics();
+      /* Follow the moved entities in the ray grid */
+      m_cRayGrid.Update();
+      EndStepPhase(STEP_PHASE_PHYSICS);
       /* Update media */
+      StartStepPhase();
       UpdateMedia();
+      EndStepPhase(STEP_PHASE_MEDIA);
       /* Call loop functions */
+      StartStepPhase();
       m_cSimulator.GetLoopFunctions().PreStep();
+      /* The loop functions may have moved some entities */
+      m_cRayGrid.Update();
+      m_cMotionGrid.Refresh();
+      EndStepPhase(STEP_PHASE_PRE_STEP);
       /* Perform the 'sense+step' phase for controllable entities */
+      StartStepPhase();
       UpdateControllableEntitiesSenseStep();
+      EndStepPhase(STEP_PHASE_SENSE_CONTROL);
       /* Call loop functions */
+      StartStepPhase();
       m_cSimulator.GetLoopFunctions().PostStep();
+      EndStepPhase(STEP_PHASE_POST_STEP);
       /* Flush logs */
       LOG.Flush();
       LOGERR.Flush();
@@ -141,6 +282,76 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CSpace::UpdatePhysicsEngine(size_t un_index) {
+      if(m_pcProfiler == NULL) {
+         (*m_ptPhysicsEngines)[un_index]->Update();
+      }
+      else {
+         double fStart = CProfiler::GetTimeStamp();
+         (*m_ptPhysicsEngines)[un_index]->Update();
+         m_pcProfiler->AddPhaseSample(m_vecPhysicsEnginePhases[un_index],
+                                      CProfiler::GetTimeStamp() - fStart);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::UpdateMedium(size_t un_index) {
+      if(m_pcProfiler == NULL) {
+         (*m_ptMedia)[un_index]->Update();
+      }
+      else {
+         m_vecMediumStarts[un_index] = CProfiler::GetTimeStamp();
+         (*m_ptMedia)[un_index]->Update();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::UpdateMediaThread(UInt32 un_thread,
+                                  UInt32 un_threads) {
+      for(size_t i = 0; i < m_ptMedia->size(); ++i) {
+         (*m_ptMedia)[i]->UpdateThread(un_thread, un_threads);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::PostUpdateMedia() {
+      for(size_t i = 0; i < m_ptMedia->size(); ++i) {
+         (*m_ptMedia)[i]->PostUpdate();
+         if(m_pcProfiler != NULL) {
+            m_pcProfiler->AddPhaseSample(m_vecMediumPhases[i],
+                                         CProfiler::GetTimeStamp() - m_vecMediumStarts[i]);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::StartStepPhase() {
+      if(m_pcProfiler != NULL) {
+         m_fStepPhaseStart = CProfiler::GetTimeStamp();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::EndStepPhase(EStepPhase e_phase) {
+      if(m_pcProfiler != NULL) {
+         m_pcProfiler->AddPhaseSample(m_punStepPhases[e_phase],
+                                      CProfiler::GetTimeStamp() - m_fStepPhaseStart);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CSpace::AddControllableEntity(CControllableEntity& c_entity) {
       m_vecControllableEntities.push_back(&c_entity);
    }
@@ -228,43 +439,49 @@ namespace argos {
    class UniformGenerator : public RealNumberGenerator {
    public:
       UniformGenerator(const CVector3& c_min,
-                       const CVector3& c_max) :
+                       const CVector3& c_max,
+                       CRandom::CRNG* pc_rng) :
          m_cMin(c_min),
-         m_cMax(c_max) {}
+         m_cMax(c_max),
+         m_pcRNG(pc_rng) {}
       inline virtual CVector3 operator()(bool b_is_retry) {
          Real fRandX =
             m_cMax.GetX() > m_cMin.GetX() ?
-            CSimulator::GetInstance().GetRNG()->Uniform(CRange<Real>(m_cMin.GetX(), m_cMax.GetX())) :
+            m_pcRNG->Uniform(CRange<Real>(m_cMin.GetX(), m_cMax.GetX())) :
             m_cMax.GetX();
          Real fRandY =
             m_cMax.GetY() > m_cMin.GetY() ?
-            CSimulator::GetInstance().GetRNG()->Uniform(CRange<Real>(m_cMin.GetY(), m_cMax.GetY())) :
+            m_pcRNG->Uniform(CRange<Real>(m_cMin.GetY(), m_cMax.GetY())) :
             m_cMax.GetY();
          Real fRandZ =
             m_cMax.GetZ() > m_cMin.GetZ() ?
-            CSimulator::GetInstance().GetRNG()->Uniform(CRange<Real>(m_cMin.GetZ(), m_cMax.GetZ())) :
+            m_pcRNG->Uniform(CRange<Real>(m_cMin.GetZ(), m_cMax.GetZ())) :
             m_cMax.GetZ();
          return CVector3(fRandX, fRandY, fRandZ);
       }
    private:
       CVector3 m_cMin;
       CVector3 m_cMax;
+      CRandom::CRNG* m_pcRNG;
    };
 
    class GaussianGenerator : public RealNumberGenerator {
    public:
       GaussianGenerator(const CVector3& c_mean,
-                        const CVector3& c_std_dev) :
+                        const CVector3& c_std_dev,
+                        CRandom::CRNG* pc_rng) :
          m_cMean(c_mean),
-         m_cStdDev(c_std_dev) {}
+         m_cStdDev(c_std_dev),
+         m_pcRNG(pc_rng) {}
       inline virtual CVector3 operator()(bool b_is_retry) {
-         return CVector3(CSimulator::GetInstance().GetRNG()->Gaussian(m_cStdDev.GetX(), m_cMean.GetX()),
-                         CSimulator::GetInstance().GetRNG()->Gaussian(m_cStdDev.GetY(), m_cMean.GetY()),
-                         CSimulator::GetInstance().GetRNG()->Gaussian(m_cStdDev.GetZ(), m_cMean.GetZ()));
+         return CVector3(m_pcRNG->Gaussian(m_cStdDev.GetX(), m_cMean.GetX()),
+                         m_pcRNG->Gaussian(m_cStdDev.GetY(), m_cMean.GetY()),
+                         m_pcRNG->Gaussian(m_cStdDev.GetZ(), m_cMean.GetZ()));
       }
    private:
       CVector3 m_cMean;
       CVector3 m_cStdDev;
+      CRandom::CRNG* m_pcRNG;
    };
 
    class GridGenerator : public RealNumberGenerator {
@@ -312,7 +529,8 @@ namespace argos {
    /****************************************/
    /****************************************/
 
-   RealNumberGenerator* CreateGenerator(TConfigurationNode& t_tree) {
+   RealNumberGenerator* CreateGenerator(TConfigurationNode& t_tree,
+                                        CRandom::CRNG* pc_rng) {
       std::string strMethod;
       GetNodeAttribute(t_tree, "method", strMethod);
       if(strMethod == "uniform") {
@@ -322,13 +540,13 @@ namespace argos {
          if(! (cMin <= cMax)) {
             THROW_ARGOSEXCEPTION("Uniform generator: the min is not less than or equal to max: " << cMin << " / " << cMax);
          }
-         return new UniformGenerator(cMin, cMax);
+         return new UniformGenerator(cMin, cMax, pc_rng);
       }
       else if(strMethod == "gaussian") {
          CVector3 cMean, cStdDev;
          GetNodeAttribute(t_tree, "mean", cMean);
          GetNodeAttribute(t_tree, "std_dev", cStdDev);
-         return new GaussianGenerator(cMean, cStdDev);
+         return new GaussianGenerator(cMean, cStdDev, pc_rng);
       }
       else if(strMethod == "constant") {
          CVector3 cValues;
@@ -402,9 +620,22 @@ namespace argos {
          cOrientationNode = GetNode(t_tree, "orientation");
          TConfigurationNode cEntityNode;
          cEntityNode = GetNode(t_tree, "entity");
+         /* With counter-based RNGs, distribution draws from its own stream,
+            so that it does not shift the numbers drawn by the simulator RNG.
+            A new Mersenne Twister would instead take a seed from the category
+            seeder and shift the seeds of all the RNGs created after it, so in
+            that case distribution keeps using the simulator RNG */
+         if(m_pcDistributeRNG == NULL) {
+            if(CRandom::GetCategory("argos").GetType() == CRandom::RNG_COUNTER_BASED) {
+               m_pcDistributeRNG = CRandom::CreateRNG("argos", "distribute");
+            }
+            else {
+               m_pcDistributeRNG = CSimulator::GetInstance().GetRNG();
+            }
+         }
          /* Create the real number generators */
-         RealNumberGenerator* pcPositionGenerator = CreateGenerator(cPositionNode);
-         RealNumberGenerator* pcOrientationGenerator = CreateGenerator(cOrientationNode);
+         RealNumberGenerator* pcPositionGenerator = CreateGenerator(cPositionNode, m_pcDistributeRNG);
+         RealNumberGenerator* pcOrientationGenerator = CreateGenerator(cOrientationNode, m_pcDistributeRNG);
          /* How many entities? */
          UInt32 unQuantity;
          GetNodeAttribute(cEntityNode, "quantity", unQuantity);
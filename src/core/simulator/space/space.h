@@ -14,11 +14,15 @@ namespace argos {
    class CRay3;
    class CFloorEntity;
    class CSimulator;
+   class CProfiler;
 }
 
 #include <argos3/core/utility/datatypes/any.h>
+#include <argos3/core/utility/math/rng.h>
 #include <argos3/core/simulator/medium/medium.h>
 #include <argos3/core/simulator/space/positional_indices/positional_index.h>
+#include <argos3/core/simulator/space/motion_grid.h>
+#include <argos3/core/simulator/space/ray_grid.h>
 #include <argos3/core/simulator/entity/embodied_entity.h>
 #include <argos3/core/simulator/entity/controllable_entity.h>
 
@@ -27,7 +31,8 @@ namespace argos {
    /****************************************/
    /****************************************/
 
-   class CSpace : public CBaseConfigurableResource {
+   class CSpace : public CBaseConfigurableResource,
+                  public CMemento {
 
    public:
 
@@ -93,7 +98,13 @@ namespace argos {
 
       /**
        * Initializes the space using the <tt>&lt;arena&gt;</tt> section of the XML configuration file.
+       * The optional attribute <tt>ray_index</tt> selects how the ray queries
+       * are answered: <tt>"none"</tt> (the default) asks the physics engines,
+       * while <tt>"grid"</tt> uses the ray grid. The number of cells of the
+       * ray grid is set with <tt>ray_index_grid_size="i,j,k"</tt>, and by
+       * default there is one cell per meter of arena.
        * @param t_tree the <tt>&lt;arena&gt;</tt> section of the XML configuration file.
+       * @see CRayGrid
        */
       virtual void Init(TConfigurationNode& t_tree);
 
@@ -102,6 +113,25 @@ namespace argos {
        */
       virtual void Reset();
 
+      /**
+       * Saves the simulation clock and the state of all the root entities.
+       * Each entity is stored as its id, followed by the size and the
+       * contents of its state.
+       * @param c_buffer The target buffer.
+       * @see CSimulator::SaveCheckpoint()
+       */
+      virtual void SaveState(CByteArray& c_buffer);
+
+      /**
+       * Restores the simulation clock and the state of all the root entities.
+       * The saved entities are matched to the current ones by id. The motion
+       * grid and the ray grid are rebuilt from the restored positions.
+       * @param c_buffer The source buffer.
+       * @throws CARGoSException if the saved entities do not match the current ones
+       * @see CSimulator::LoadCheckpoint()
+       */
+      virtual void LoadState(CByteArray& c_buffer);
+
       /**
        * Destroys the space and all its entities.
        */
@@ -382,10 +412,44 @@ namespace argos {
          return m_cArenaLimits;
       }
 
+      /**
+       * Returns the grid that records where the embodied entities moved.
+       * @return The grid that records where the embodied entities moved.
+       * @see CMotionGrid
+       */
+      inline CMotionGrid& GetMotionGrid() {
+         return m_cMotionGrid;
+      }
+
+      /**
+       * Returns the grid that answers the ray queries.
+       * The grid is active only if requested in the <tt>&lt;arena&gt;</tt> section.
+       * @return The grid that answers the ray queries.
+       * @see CRayGrid
+       */
+      inline CRayGrid& GetRayGrid() {
+         return m_cRayGrid;
+      }
+
       virtual void AddControllableEntity(CControllableEntity& c_entity);
       virtual void RemoveControllableEntity(CControllableEntity& c_entity);
       virtual void AddEntityToPhysicsEngine(CEmbodiedEntity& c_entity);
       
+   protected:
+
+      /**
+       * The phases of a step timed when profiling.
+       */
+      enum EStepPhase {
+         STEP_PHASE_ACT = 0,
+         STEP_PHASE_PHYSICS,
+         STEP_PHASE_MEDIA,
+         STEP_PHASE_PRE_STEP,
+         STEP_PHASE_SENSE_CONTROL,
+         STEP_PHASE_POST_STEP,
+         STEP_PHASE_NUM
+      };
+
    protected:
 
       virtual void UpdateControllableEntitiesAct() = 0;
@@ -393,6 +457,49 @@ namespace argos {
       virtual void UpdateMedia() = 0;
       virtual void UpdateControllableEntitiesSenseStep() = 0;
 
+      /**
+       * Updates the physics engine with the given index.
+       * When profiling, the update is timed.
+       * @param un_index The index of the physics engine.
+       */
+      void UpdatePhysicsEngine(size_t un_index);
+
+      /**
+       * Updates the medium with the given index.
+       * When profiling, the update is timed.
+       * @param un_index The index of the medium.
+       */
+      void UpdateMedium(size_t un_index);
+
+      /**
+       * Executes the share of the media update assigned to a thread.
+       * Called once per thread index after all the media have been updated.
+       * @param un_thread The index of the thread, in <tt>[0,un_threads)</tt>.
+       * @param un_threads The number of threads sharing the update.
+       * @see CMedium::UpdateThread()
+       */
+      void UpdateMediaThread(UInt32 un_thread,
+                             UInt32 un_threads);
+
+      /**
+       * Completes the media update, after all the threads are done.
+       * When profiling, the time of each medium from the start of its
+       * update to the end of this call is recorded.
+       * @see CMedium::PostUpdate()
+       */
+      void PostUpdateMedia();
+
+      /**
+       * Starts timing a step phase, if profiling.
+       */
+      void StartStepPhase();
+
+      /**
+       * Stops timing a step phase and records its duration, if profiling.
+       * @param e_phase The phase being timed.
+       */
+      void EndStepPhase(EStepPhase e_phase);
+
       void Distribute(TConfigurationNode& t_tree);
 
       void AddBoxStrip(TConfigurationNode& t_tree);
@@ -445,6 +552,33 @@ namespace argos {
 
       /** A pointer to the list of media */
       CMedium::TVector* m_ptMedia;
+
+      /** Records where the embodied entities moved */
+      CMotionGrid m_cMotionGrid;
+
+      /** Answers the ray queries, if active */
+      CRayGrid m_cRayGrid;
+
+      /** The RNG used to distribute entities */
+      CRandom::CRNG* m_pcDistributeRNG;
+
+      /** The profiler that records the step phases, or NULL */
+      CProfiler* m_pcProfiler;
+
+      /** The profiler phase indices of the step phases */
+      size_t m_punStepPhases[STEP_PHASE_NUM];
+
+      /** The profiler phase indices of the physics engines */
+      std::vector<size_t> m_vecPhysicsEnginePhases;
+
+      /** The profiler phase indices of the media */
+      std::vector<size_t> m_vecMediumPhases;
+
+      /** When the update of each medium started */
+      std::vector<double> m_vecMediumStarts;
+
+      /** When the step phase being timed started */
+      double m_fStepPhaseStart;
    };
 
    /****************************************/
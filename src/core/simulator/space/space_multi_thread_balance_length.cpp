@@ -14,10 +14,6 @@ namespace argos {
    /****************************************/
 
    struct SCleanupThreadData {
-      pthread_mutex_t* StartSenseControlPhaseMutex;
-      pthread_mutex_t* StartActPhaseMutex;
-      pthread_mutex_t* StartPhysicsPhaseMutex;
-      pthread_mutex_t* StartMediaPhaseMutex;
       pthread_mutex_t* FetchTaskMutex;
    };
 
@@ -29,10 +25,6 @@ namespace argos {
       SCleanupThreadData& sData =
          *reinterpret_cast<SCleanupThreadData*>(p_data);
       pthread_mutex_unlock(sData.FetchTaskMutex);
-      pthread_mutex_unlock(sData.StartSenseControlPhaseMutex);
-      pthread_mutex_unlock(sData.StartActPhaseMutex);
-      pthread_mutex_unlock(sData.StartPhysicsPhaseMutex);
-      pthread_mutex_unlock(sData.StartMediaPhaseMutex);
    }
 
    void* LaunchThreadBalanceLength(void* p_data) {
@@ -46,13 +38,9 @@ namespace argos {
       CSpaceMultiThreadBalanceLength::SThreadLaunchData* psData = reinterpret_cast<CSpaceMultiThreadBalanceLength::SThreadLaunchData*>(p_data);
       /* Create cancellation data */
       SCleanupThreadData sCancelData;
-      sCancelData.StartSenseControlPhaseMutex = &(psData->Space->m_tStartSenseControlPhaseMutex);
-      sCancelData.StartActPhaseMutex = &(psData->Space->m_tStartActPhaseMutex);
-      sCancelData.StartPhysicsPhaseMutex = &(psData->Space->m_tStartPhysicsPhaseMutex);
-      sCancelData.StartMediaPhaseMutex = &(psData->Space->m_tStartMediaPhaseMutex);
       sCancelData.FetchTaskMutex = &(psData->Space->m_tFetchTaskMutex);
       pthread_cleanup_push(CleanupThread, &sCancelData);
-      psData->Space->SlaveThread();
+      psData->Space->SlaveThread(psData->ThreadId);
       /* Dispose of cancellation data */
       pthread_cleanup_pop(1);
       return NULL;
@@ -67,26 +55,26 @@ namespace argos {
       /* Initialize thread related structures */
       int nErrors;
       /* Init mutexes */
-      if((nErrors = pthread_mutex_init(&m_tStartSenseControlPhaseMutex, NULL)) ||
-         (nErrors = pthread_mutex_init(&m_tStartActPhaseMutex, NULL)) ||
-         (nErrors = pthread_mutex_init(&m_tStartPhysicsPhaseMutex, NULL)) ||
-         (nErrors = pthread_mutex_init(&m_tStartMediaPhaseMutex, NULL)) ||
-         (nErrors = pthread_mutex_init(&m_tFetchTaskMutex, NULL))) {
+      if((nErrors = pthread_mutex_init(&m_tFetchTaskMutex, NULL))) {
          THROW_ARGOSEXCEPTION("Error creating thread mutexes " << ::strerror(nErrors));
       }
-      /* Init conditionals */
-      if((nErrors = pthread_cond_init(&m_tStartSenseControlPhaseCond, NULL)) ||
-         (nErrors = pthread_cond_init(&m_tStartActPhaseCond, NULL)) ||
-         (nErrors = pthread_cond_init(&m_tStartPhysicsPhaseCond, NULL)) ||
-         (nErrors = pthread_cond_init(&m_tStartMediaPhaseCond, NULL)) ||
-         (nErrors = pthread_cond_init(&m_tFetchTaskCond, NULL))) {
-         THROW_ARGOSEXCEPTION("Error creating thread conditionals " << ::strerror(nErrors));
-      }
-      /* Reset the idle thread count */
-      m_unSenseControlPhaseIdleCounter = CSimulator::GetInstance().GetNumThreads();
-      m_unActPhaseIdleCounter = CSimulator::GetInstance().GetNumThreads();
-      m_unPhysicsPhaseIdleCounter = CSimulator::GetInstance().GetNumThreads();
-      m_unMediaPhaseIdleCounter = CSimulator::GetInstance().GetNumThreads();
+      /* Init the idle thread counters */
+      CSimulator& cSimulator = CSimulator::GetInstance();
+      m_cSenseControlPhaseIdleCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                           cSimulator.GetPhaseSyncSpinIterations(),
+                                           cSimulator.GetNumThreads());
+      m_cActPhaseIdleCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                  cSimulator.GetPhaseSyncSpinIterations(),
+                                  cSimulator.GetNumThreads());
+      m_cPhysicsPhaseIdleCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                      cSimulator.GetPhaseSyncSpinIterations(),
+                                      cSimulator.GetNumThreads());
+      m_cMediaPhaseIdleCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                    cSimulator.GetPhaseSyncSpinIterations(),
+                                    cSimulator.GetNumThreads());
+      m_cMediaThreadsPhaseIdleCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                           cSimulator.GetPhaseSyncSpinIterations(),
+                                           cSimulator.GetNumThreads());
       /* Start threads */
       StartThreads();
    }
@@ -122,16 +110,7 @@ namespace argos {
          }
       }
       delete[] m_psThreadData;
-      pthread_mutex_destroy(&m_tStartSenseControlPhaseMutex);
-      pthread_mutex_destroy(&m_tStartActPhaseMutex);
-      pthread_mutex_destroy(&m_tStartPhysicsPhaseMutex);
-      pthread_mutex_destroy(&m_tStartMediaPhaseMutex);
       pthread_mutex_destroy(&m_tFetchTaskMutex);
-      pthread_cond_destroy(&m_tStartSenseControlPhaseCond);
-      pthread_cond_destroy(&m_tStartActPhaseCond);
-      pthread_cond_destroy(&m_tStartPhysicsPhaseCond);
-      pthread_cond_destroy(&m_tStartMediaPhaseCond);
-      pthread_cond_destroy(&m_tFetchTaskCond);
 
       /* Destroy the base space */
       CSpace::Destroy();
@@ -142,10 +121,11 @@ namespace argos {
 
    void CSpaceMultiThreadBalanceLength::Update() {
       /* Reset the idle thread count */
-      m_unSenseControlPhaseIdleCounter = CSimulator::GetInstance().GetNumThreads();
-      m_unActPhaseIdleCounter = CSimulator::GetInstance().GetNumThreads();
-      m_unPhysicsPhaseIdleCounter = CSimulator::GetInstance().GetNumThreads();
-      m_unMediaPhaseIdleCounter = CSimulator::GetInstance().GetNumThreads();
+      m_cSenseControlPhaseIdleCounter.Set(CSimulator::GetInstance().GetNumThreads());
+      m_cActPhaseIdleCounter.Set(CSimulator::GetInstance().GetNumThreads());
+      m_cPhysicsPhaseIdleCounter.Set(CSimulator::GetInstance().GetNumThreads());
+      m_cMediaPhaseIdleCounter.Set(CSimulator::GetInstance().GetNumThreads());
+      m_cMediaThreadsPhaseIdleCounter.Set(CSimulator::GetInstance().GetNumThreads());
       /* Update the space */
       CSpace::Update();
    }
@@ -153,19 +133,12 @@ namespace argos {
    /****************************************/
    /****************************************/
 
-#define MAIN_START_PHASE(PHASE)                             \
-   pthread_mutex_lock(&m_tStart ## PHASE ## PhaseMutex);    \
-   m_un ## PHASE ## PhaseIdleCounter = 0;                   \
-   m_unTaskIndex = 0;                                       \
-   pthread_cond_broadcast(&m_tStart ## PHASE ## PhaseCond); \
-   pthread_mutex_unlock(&m_tStart ## PHASE ## PhaseMutex);
+#define MAIN_START_PHASE(PHASE)                 \
+   m_unTaskIndex = 0;                           \
+   m_c ## PHASE ## PhaseIdleCounter.Set(0);
 
-#define MAIN_WAIT_FOR_END_OF(PHASE)                                                         \
-   pthread_mutex_lock(&m_tStart ## PHASE ## PhaseMutex);                                    \
-   while(m_un ## PHASE ## PhaseIdleCounter < CSimulator::GetInstance().GetNumThreads()) {   \
-      pthread_cond_wait(&m_tStart ## PHASE ## PhaseCond, &m_tStart ## PHASE ## PhaseMutex); \
-   }                                                                                        \
-   pthread_mutex_unlock(&m_tStart ## PHASE ## PhaseMutex);
+#define MAIN_WAIT_FOR_END_OF(PHASE)                                                          \
+   m_c ## PHASE ## PhaseIdleCounter.WaitUntilEqual(CSimulator::GetInstance().GetNumThreads());
 
    void CSpaceMultiThreadBalanceLength::UpdateControllableEntitiesAct() {
       /* Act phase */
@@ -195,6 +168,10 @@ namespace argos {
       /* Media phase */
       MAIN_START_PHASE(Media);
       MAIN_WAIT_FOR_END_OF(Media);
+      /* Let each thread do its share of the media update */
+      MAIN_START_PHASE(MediaThreads);
+      MAIN_WAIT_FOR_END_OF(MediaThreads);
+      PostUpdateMedia();
    }
 
    /****************************************/
@@ -230,12 +207,8 @@ namespace argos {
    /****************************************/
    /****************************************/
 
-#define THREAD_WAIT_FOR_START_OF(PHASE)                                                     \
-   pthread_mutex_lock(&m_tStart ## PHASE ## PhaseMutex);                                    \
-   while(m_un ## PHASE ## PhaseIdleCounter == CSimulator::GetInstance().GetNumThreads()) {  \
-      pthread_cond_wait(&m_tStart ## PHASE ## PhaseCond, &m_tStart ## PHASE ## PhaseMutex); \
-   }                                                                                        \
-   pthread_mutex_unlock(&m_tStart ## PHASE ## PhaseMutex);                                  \
+#define THREAD_WAIT_FOR_START_OF(PHASE)                                                      \
+   m_c ## PHASE ## PhaseIdleCounter.WaitWhileEqual(CSimulator::GetInstance().GetNumThreads()); \
    pthread_testcancel();
 
 #define THREAD_PERFORM_TASK(PHASE, TASKVEC, SNIPPET)                \
@@ -254,17 +227,14 @@ namespace argos {
       else {                                                        \
          pthread_mutex_unlock(&m_tFetchTaskMutex);                  \
          pthread_testcancel();                                      \
-         pthread_mutex_lock(&m_tStart ## PHASE ## PhaseMutex);      \
-         ++m_un ## PHASE ## PhaseIdleCounter;                       \
-         pthread_cond_broadcast(&m_tStart ## PHASE ## PhaseCond);   \
-         pthread_mutex_unlock(&m_tStart ## PHASE ## PhaseMutex);    \
+         m_c ## PHASE ## PhaseIdleCounter.Increase();               \
          pthread_testcancel();                                      \
          break;                                                     \
       }                                                             \
    }                                                                \
    pthread_testcancel();
 
-   void CSpaceMultiThreadBalanceLength::SlaveThread() {
+   void CSpaceMultiThreadBalanceLength::SlaveThread(UInt32 un_id) {
       /* Task index */
       size_t unTaskIndex;
       while(1) {
@@ -278,14 +248,20 @@ namespace argos {
          THREAD_PERFORM_TASK(
             Physics,
             *m_ptPhysicsEngines,
-            (*m_ptPhysicsEngines)[unTaskIndex]->Update();
+            UpdatePhysicsEngine(unTaskIndex);
             );
          THREAD_WAIT_FOR_START_OF(Media);
          THREAD_PERFORM_TASK(
             Media,
             *m_ptMedia,
-            (*m_ptMedia)[unTaskIndex]->Update();
+            UpdateMedium(unTaskIndex);
             );
+         /* Every thread does its own share of the media update */
+         THREAD_WAIT_FOR_START_OF(MediaThreads);
+         UpdateMediaThread(un_id, CSimulator::GetInstance().GetNumThreads());
+         pthread_testcancel();
+         m_cMediaThreadsPhaseIdleCounter.Increase();
+         pthread_testcancel();
          THREAD_WAIT_FOR_START_OF(SenseControl);
          THREAD_PERFORM_TASK(
             SenseControl,
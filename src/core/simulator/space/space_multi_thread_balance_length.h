@@ -16,6 +16,7 @@ namespace argos {
 }
 
 #include <argos3/core/simulator/space/space.h>
+#include <argos3/core/simulator/space/phase_sync_counter.h>
 
 namespace argos {
 
@@ -38,7 +39,7 @@ namespace argos {
    private:
 
       void StartThreads();
-      void SlaveThread();
+      void SlaveThread(UInt32 un_id);
       friend void* LaunchThreadBalanceLength(void* p_data);
 
    private:
@@ -63,36 +64,19 @@ namespace argos {
       /** All tasks in arrays. This is the current array index. */
       size_t m_unTaskIndex;
 
-      /** Mutex for the start of the sense/control phase */
-      pthread_mutex_t m_tStartSenseControlPhaseMutex;
-      /** Mutex for the start of the act phase */
-      pthread_mutex_t m_tStartActPhaseMutex;
-      /** Mutex for the start of the physics phase */
-      pthread_mutex_t m_tStartPhysicsPhaseMutex;
-      /** Mutex for the start of the media phase */
-      pthread_mutex_t m_tStartMediaPhaseMutex;
       /** Mutex to fetch a task from the dispatcher */
       pthread_mutex_t m_tFetchTaskMutex;
 
-      /** Conditional for the start of the sense/control phase */
-      pthread_cond_t m_tStartSenseControlPhaseCond;
-      /** Conditional for the start of the act phase */
-      pthread_cond_t m_tStartActPhaseCond;
-      /** Conditional for the start of the physics phase */
-      pthread_cond_t m_tStartPhysicsPhaseCond;
-      /** Conditional for the start of the media phase */
-      pthread_cond_t m_tStartMediaPhaseCond;
-      /** Conditional controlling task fetching from the dispatcher */
-      pthread_cond_t m_tFetchTaskCond;
-
       /** How many threads are idle in the sense/control phase */
-      UInt32 m_unSenseControlPhaseIdleCounter;
+      CPhaseSyncCounter m_cSenseControlPhaseIdleCounter;
       /** How many threads are idle in the act phase */
-      UInt32 m_unActPhaseIdleCounter;
+      CPhaseSyncCounter m_cActPhaseIdleCounter;
       /** How many threads are idle in the physics phase */
-      UInt32 m_unPhysicsPhaseIdleCounter;
+      CPhaseSyncCounter m_cPhysicsPhaseIdleCounter;
       /** How many threads are idle in the media phase */
-      UInt32 m_unMediaPhaseIdleCounter;
+      CPhaseSyncCounter m_cMediaPhaseIdleCounter;
+      /** How many threads are idle in the per-thread part of the media phase */
+      CPhaseSyncCounter m_cMediaThreadsPhaseIdleCounter;
 
    };
 
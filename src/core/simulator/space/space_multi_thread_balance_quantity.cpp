@@ -15,24 +15,11 @@ namespace argos {
    /****************************************/
    /****************************************/
 
-   struct SCleanupUpdateThreadData {
-      pthread_mutex_t* SenseControlStepConditionalMutex;
-      pthread_mutex_t* ActConditionalMutex;
-      pthread_mutex_t* PhysicsConditionalMutex;
-      pthread_mutex_t* MediaConditionalMutex;
-   };
-
    static void CleanupUpdateThread(void* p_data) {
       CSimulator& cSimulator = CSimulator::GetInstance();
       if(cSimulator.IsProfiling()) {
          cSimulator.GetProfiler().CollectThreadResourceUsage();
       }
-      SCleanupUpdateThreadData& sData =
-         *reinterpret_cast<SCleanupUpdateThreadData*>(p_data);
-      pthread_mutex_unlock(sData.SenseControlStepConditionalMutex);
-      pthread_mutex_unlock(sData.ActConditionalMutex);
-      pthread_mutex_unlock(sData.PhysicsConditionalMutex);
-      pthread_mutex_unlock(sData.MediaConditionalMutex);
    }
 
    void* LaunchUpdateThreadBalanceQuantity(void* p_data) {
@@ -57,27 +44,23 @@ namespace argos {
    void CSpaceMultiThreadBalanceQuantity::Init(TConfigurationNode& t_tree) {
       /* Initialize the space */
       CSpace::Init(t_tree);
-      /* Initialize thread related structures */
-      int nErrors;
-      /* First the counters */
-      m_unSenseControlStepPhaseDoneCounter = CSimulator::GetInstance().GetNumThreads();
-      m_unActPhaseDoneCounter = CSimulator::GetInstance().GetNumThreads();
-      m_unPhysicsPhaseDoneCounter = CSimulator::GetInstance().GetNumThreads();
-      m_unMediaPhaseDoneCounter = CSimulator::GetInstance().GetNumThreads();
-      /* Then the mutexes */
-      if((nErrors = pthread_mutex_init(&m_tSenseControlStepConditionalMutex, NULL)) ||
-         (nErrors = pthread_mutex_init(&m_tActConditionalMutex, NULL)) ||
-         (nErrors = pthread_mutex_init(&m_tPhysicsConditionalMutex, NULL)) ||
-         (nErrors = pthread_mutex_init(&m_tMediaConditionalMutex, NULL))) {
-         THROW_ARGOSEXCEPTION("Error creating thread mutexes " << ::strerror(nErrors));
-      }
-      /* Finally the conditionals */
-      if((nErrors = pthread_cond_init(&m_tSenseControlStepConditional, NULL)) ||
-         (nErrors = pthread_cond_init(&m_tActConditional, NULL)) ||
-         (nErrors = pthread_cond_init(&m_tPhysicsConditional, NULL)) ||
-         (nErrors = pthread_cond_init(&m_tMediaConditional, NULL))) {
-         THROW_ARGOSEXCEPTION("Error creating thread conditionals " << ::strerror(nErrors));
-      }
+      /* Initialize the phase counters */
+      CSimulator& cSimulator = CSimulator::GetInstance();
+      m_cSenseControlStepPhaseDoneCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                               cSimulator.GetPhaseSyncSpinIterations(),
+                                               cSimulator.GetNumThreads());
+      m_cActPhaseDoneCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                  cSimulator.GetPhaseSyncSpinIterations(),
+                                  cSimulator.GetNumThreads());
+      m_cPhysicsPhaseDoneCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                      cSimulator.GetPhaseSyncSpinIterations(),
+                                      cSimulator.GetNumThreads());
+      m_cMediaPhaseDoneCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                    cSimulator.GetPhaseSyncSpinIterations(),
+                                    cSimulator.GetNumThreads());
+      m_cMediaThreadsPhaseDoneCounter.Init(cSimulator.GetPhaseSyncMethod(),
+                                           cSimulator.GetPhaseSyncSpinIterations(),
+                                           cSimulator.GetNumThreads());
       /* Start threads */
       StartThreads();
    }
@@ -134,14 +117,6 @@ namespace argos {
          }
       }
       delete[] m_psUpdateThreadData;
-      pthread_mutex_destroy(&m_tSenseControlStepConditionalMutex);
-      pthread_mutex_destroy(&m_tActConditionalMutex);
-      pthread_mutex_destroy(&m_tPhysicsConditionalMutex);
-      pthread_mutex_destroy(&m_tMediaConditionalMutex);
-      pthread_cond_destroy(&m_tSenseControlStepConditional);
-      pthread_cond_destroy(&m_tActConditional);
-      pthread_cond_destroy(&m_tPhysicsConditional);
-      pthread_cond_destroy(&m_tMediaConditional);
       /* Destroy the base space */
       CSpace::Destroy();
    }
@@ -165,20 +140,13 @@ namespace argos {
    /****************************************/
    /****************************************/
    
-#define MAIN_SEND_GO_FOR_PHASE(PHASE)                       \
-   LOG.Flush();                                             \
-   LOGERR.Flush();                                          \
-   pthread_mutex_lock(&m_t ## PHASE ## ConditionalMutex);   \
-   m_un ## PHASE ## PhaseDoneCounter = 0;                   \
-   pthread_cond_broadcast(&m_t ## PHASE ## Conditional);    \
-   pthread_mutex_unlock(&m_t ## PHASE ## ConditionalMutex);
+#define MAIN_SEND_GO_FOR_PHASE(PHASE)           \
+   LOG.Flush();                                 \
+   LOGERR.Flush();                              \
+   m_c ## PHASE ## PhaseDoneCounter.Set(0);
 
-#define MAIN_WAIT_FOR_PHASE_END(PHASE)                                  \
-   pthread_mutex_lock(&m_t ## PHASE ## ConditionalMutex);               \
-   while(m_un ## PHASE ## PhaseDoneCounter < CSimulator::GetInstance().GetNumThreads()) { \
-      pthread_cond_wait(&m_t ## PHASE ## Conditional, &m_t ## PHASE ## ConditionalMutex); \
-   }                                                                    \
-   pthread_mutex_unlock(&m_t ## PHASE ## ConditionalMutex);
+#define MAIN_WAIT_FOR_PHASE_END(PHASE)                                                        \
+   m_c ## PHASE ## PhaseDoneCounter.WaitUntilEqual(CSimulator::GetInstance().GetNumThreads());
    
    void CSpaceMultiThreadBalanceQuantity::UpdateControllableEntitiesAct() {
       MAIN_SEND_GO_FOR_PHASE(Act);
@@ -209,6 +177,10 @@ namespace argos {
       /* Update the media */
       MAIN_SEND_GO_FOR_PHASE(Media);
       MAIN_WAIT_FOR_PHASE_END(Media);
+      /* Let each thread do its share of the media update */
+      MAIN_SEND_GO_FOR_PHASE(MediaThreads);
+      MAIN_WAIT_FOR_PHASE_END(MediaThreads);
+      PostUpdateMedia();
    }
 
    /****************************************/
@@ -224,19 +196,12 @@ namespace argos {
    /****************************************/
    /****************************************/
 
-#define THREAD_WAIT_FOR_GO_SIGNAL(PHASE)                                                   \
-   pthread_mutex_lock(&m_t ## PHASE ## ConditionalMutex);                                  \
-   while(m_un ## PHASE ## PhaseDoneCounter == CSimulator::GetInstance().GetNumThreads()) { \
-      pthread_cond_wait(&m_t ## PHASE ## Conditional, &m_t ## PHASE ## ConditionalMutex);  \
-   }                                                                                       \
-   pthread_mutex_unlock(&m_t ## PHASE ## ConditionalMutex);                                \
+#define THREAD_WAIT_FOR_GO_SIGNAL(PHASE)                                                      \
+   m_c ## PHASE ## PhaseDoneCounter.WaitWhileEqual(CSimulator::GetInstance().GetNumThreads()); \
    pthread_testcancel();
    
-#define THREAD_SIGNAL_PHASE_DONE(PHASE)                     \
-   pthread_mutex_lock(&m_t ## PHASE ## ConditionalMutex);   \
-   ++m_un ## PHASE ## PhaseDoneCounter;                     \
-   pthread_cond_broadcast(&m_t ## PHASE ## Conditional);    \
-   pthread_mutex_unlock(&m_t ## PHASE ## ConditionalMutex); \
+#define THREAD_SIGNAL_PHASE_DONE(PHASE)         \
+   m_c ## PHASE ## PhaseDoneCounter.Increase(); \
    pthread_testcancel();
 
    CRange<size_t> CalculatePluginRangeForThread(size_t un_id,
@@ -275,13 +240,8 @@ namespace argos {
    void CSpaceMultiThreadBalanceQuantity::UpdateThread(UInt32 un_id) {
       /* Copy the id */
       UInt32 unId = un_id;
-      /* Create cancellation data */
-      SCleanupUpdateThreadData sCancelData;
-      sCancelData.SenseControlStepConditionalMutex = &m_tSenseControlStepConditionalMutex;
-      sCancelData.ActConditionalMutex = &m_tActConditionalMutex;
-      sCancelData.PhysicsConditionalMutex = &m_tPhysicsConditionalMutex;
-      sCancelData.MediaConditionalMutex = &m_tMediaConditionalMutex;
-      pthread_cleanup_push(CleanupUpdateThread, &sCancelData);
+      /* Set cancellation handler */
+      pthread_cleanup_push(CleanupUpdateThread, NULL);
       /* Id range for the physics engines assigned to this thread */
       CRange<size_t> cPhysicsRange = CalculatePluginRangeForThread(unId, m_ptPhysicsEngines->size());
       /* Id range for the physics engines assigned to this thread */
@@ -313,7 +273,7 @@ namespace argos {
          if(cPhysicsRange.GetSpan() > 0) {
             /* This thread has engines, update them */
             for(size_t i = cPhysicsRange.GetMin(); i < cPhysicsRange.GetMax(); ++i) {
-               (*m_ptPhysicsEngines)[i]->Update();
+               UpdatePhysicsEngine(i);
             }
             pthread_testcancel();
             THREAD_SIGNAL_PHASE_DONE(Physics);
@@ -327,7 +287,7 @@ namespace argos {
          if(cMediaRange.GetSpan() > 0) {
             /* This thread has media, update them */
             for(size_t i = cMediaRange.GetMin(); i < cMediaRange.GetMax(); ++i) {
-               (*m_ptMedia)[i]->Update();
+               UpdateMedium(i);
             }
             pthread_testcancel();
             THREAD_SIGNAL_PHASE_DONE(Media);
@@ -336,6 +296,11 @@ namespace argos {
             /* This thread has no media -> dummy computation */
             THREAD_SIGNAL_PHASE_DONE(Media);
          }
+         /* Do the share of the media update of this thread */
+         THREAD_WAIT_FOR_GO_SIGNAL(MediaThreads);
+         UpdateMediaThread(unId, CSimulator::GetInstance().GetNumThreads());
+         pthread_testcancel();
+         THREAD_SIGNAL_PHASE_DONE(MediaThreads);
          /* Update sensor readings and call controllers */
          THREAD_WAIT_FOR_GO_SIGNAL(SenseControlStep);
          /* Cope with the fact that there may be less entities than threads */
@@ -8,6 +8,7 @@
 #define SPACE_MULTI_THREAD_BALANCE_QUANTITY_H
 
 #include <argos3/core/simulator/space/space.h>
+#include <argos3/core/simulator/space/phase_sync_counter.h>
 #include <pthread.h>
 
 namespace argos {
@@ -40,23 +41,12 @@ namespace argos {
       /** The update threads */
       pthread_t* m_ptUpdateThreads;
 
-      /** Update thread related variables */
-      UInt32 m_unSenseControlStepPhaseDoneCounter;
-      UInt32 m_unActPhaseDoneCounter;
-      UInt32 m_unPhysicsPhaseDoneCounter;
-      UInt32 m_unMediaPhaseDoneCounter;
-
-      /** Update thread conditional mutexes */
-      pthread_mutex_t m_tSenseControlStepConditionalMutex;
-      pthread_mutex_t m_tActConditionalMutex;
-      pthread_mutex_t m_tPhysicsConditionalMutex;
-      pthread_mutex_t m_tMediaConditionalMutex;
-
-      /** Update thread conditionals */
-      pthread_cond_t m_tSenseControlStepConditional;
-      pthread_cond_t m_tActConditional;
-      pthread_cond_t m_tPhysicsConditional;
-      pthread_cond_t m_tMediaConditional;
+      /** Update thread phase counters */
+      CPhaseSyncCounter m_cSenseControlStepPhaseDoneCounter;
+      CPhaseSyncCounter m_cActPhaseDoneCounter;
+      CPhaseSyncCounter m_cPhysicsPhaseDoneCounter;
+      CPhaseSyncCounter m_cMediaPhaseDoneCounter;
+      CPhaseSyncCounter m_cMediaThreadsPhaseDoneCounter;
 
       /** Flag to know whether the assignment of controllable
           entities to threads must be recalculated */
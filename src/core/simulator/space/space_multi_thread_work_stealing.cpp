@@ -0,0 +1,326 @@
+/**
+ * @file <argos3/core/simulator/space/space_multi_thread_work_stealing.cpp>
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#include <cstring>
+#include "space_multi_thread_work_stealing.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/utility/profiler/profiler.h>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   static inline UInt64 PackTaskRange(UInt64 un_begin,
+                                      UInt64 un_end) {
+      return (un_begin << 32) | (un_end & 0xFFFFFFFFULL);
+   }
+
+   static inline UInt64 TaskRangeBegin(UInt64 un_range) {
+      return un_range >> 32;
+   }
+
+   static inline UInt64 TaskRangeEnd(UInt64 un_range) {
+      return un_range & 0xFFFFFFFFULL;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   static void CleanupThreadWorkStealing(void* p_data) {
+      CSimulator& cSimulator = CSimulator::GetInstance();
+      if(cSimulator.IsProfiling()) {
+         cSimulator.GetProfiler().CollectThreadResourceUsage();
+      }
+   }
+
+   void* LaunchThreadWorkStealing(void* p_data) {
+      /* Set up thread-safe buffers for this new thread */
+      LOG.AddThreadSafeBuffer();
+      LOGERR.AddThreadSafeBuffer();
+      /* Make this thread cancellable */
+      pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+      pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
+      /* Get a handle to the thread launch data */
+      CSpaceMultiThreadWorkStealing::SThreadLaunchData* psData = reinterpret_cast<CSpaceMultiThreadWorkStealing::SThreadLaunchData*>(p_data);
+      /* Set cancellation handler */
+      pthread_cleanup_push(CleanupThreadWorkStealing, NULL);
+      psData->Space->SlaveThread(psData->ThreadId);
+      /* Dispose of cancellation data */
+      pthread_cleanup_pop(1);
+      return NULL;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CSpaceMultiThreadWorkStealing::CSpaceMultiThreadWorkStealing() :
+      m_ptThreads(NULL),
+      m_psThreadData(NULL),
+      m_psTaskDeques(NULL),
+      m_eCurrentPhase(PHASE_ACT) {}
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::Init(TConfigurationNode& t_tree) {
+      /* Initialize the space */
+      CSpace::Init(t_tree);
+      /* Initialize the phase counters */
+      CSimulator& cSimulator = CSimulator::GetInstance();
+      m_cPhaseGeneration.Init(cSimulator.GetPhaseSyncMethod(),
+                              cSimulator.GetPhaseSyncSpinIterations(),
+                              0);
+      m_cBusyThreads.Init(cSimulator.GetPhaseSyncMethod(),
+                          cSimulator.GetPhaseSyncSpinIterations(),
+                          0);
+      /* Create the task deques */
+      m_psTaskDeques = new STaskDeque[CSimulator::GetInstance().GetNumThreads()];
+      /* Start threads */
+      StartThreads();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::StartThreads() {
+      int nErrors;
+      /* Create the threads */
+      m_ptThreads = new pthread_t[CSimulator::GetInstance().GetNumThreads()];
+      m_psThreadData = new SThreadLaunchData*[CSimulator::GetInstance().GetNumThreads()];
+      for(UInt32 i = 0; i < CSimulator::GetInstance().GetNumThreads(); ++i) {
+         /* Create the struct with the info to launch the thread */
+         m_psThreadData[i] = new SThreadLaunchData(i, this);
+         /* Create the thread */
+         if((nErrors = pthread_create(m_ptThreads + i,
+                                      NULL,
+                                      LaunchThreadWorkStealing,
+                                      reinterpret_cast<void*>(m_psThreadData[i])))) {
+            THROW_ARGOSEXCEPTION("Error creating thread: " << ::strerror(nErrors));
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::Destroy() {
+      /* Destroy the threads */
+      int nErrors;
+      if(m_ptThreads != NULL) {
+         for(UInt32 i = 0; i < CSimulator::GetInstance().GetNumThreads(); ++i) {
+            if((nErrors = pthread_cancel(m_ptThreads[i]))) {
+               THROW_ARGOSEXCEPTION("Error canceling threads " << ::strerror(nErrors));
+            }
+         }
+         void** ppJoinResult = new void*[CSimulator::GetInstance().GetNumThreads()];
+         for(UInt32 i = 0; i < CSimulator::GetInstance().GetNumThreads(); ++i) {
+            if((nErrors = pthread_join(m_ptThreads[i], ppJoinResult + i))) {
+               THROW_ARGOSEXCEPTION("Error joining threads " << ::strerror(nErrors));
+            }
+            if(ppJoinResult[i] != PTHREAD_CANCELED) {
+               LOGERR << "[WARNING] Thread #" << i<< " not canceled" << std::endl;
+            }
+         }
+         delete[] ppJoinResult;
+      }
+      delete[] m_ptThreads;
+      /* Destroy the thread launch info */
+      if(m_psThreadData != NULL) {
+         for(UInt32 i = 0; i < CSimulator::GetInstance().GetNumThreads(); ++i) {
+            delete m_psThreadData[i];
+         }
+      }
+      delete[] m_psThreadData;
+      /* Destroy the task deques */
+      delete[] m_psTaskDeques;
+      /* Destroy the base space */
+      CSpace::Destroy();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::UpdateControllableEntitiesAct() {
+      RunPhase(PHASE_ACT, m_vecControllableEntities.size());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::UpdatePhysics() {
+      /* Update the physics engines */
+      RunPhase(PHASE_PHYSICS, m_ptPhysicsEngines->size());
+      /* Perform entity transfer from engine to engine, if needed */
+      for(size_t i = 0; i < m_ptPhysicsEngines->size(); ++i) {
+         if((*m_ptPhysicsEngines)[i]->IsEntityTransferNeeded()) {
+            (*m_ptPhysicsEngines)[i]->TransferEntities();
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::UpdateMedia() {
+      RunPhase(PHASE_MEDIA, m_ptMedia->size());
+      /* Let each thread index do its share of the media update */
+      RunPhase(PHASE_MEDIA_THREADS, CSimulator::GetInstance().GetNumThreads());
+      PostUpdateMedia();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::UpdateControllableEntitiesSenseStep() {
+      RunPhase(PHASE_SENSECONTROL, m_vecControllableEntities.size());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::RunPhase(EPhase e_phase,
+                                                size_t un_num_tasks) {
+      /* Nothing to do? Don't wake up the threads */
+      if(un_num_tasks == 0) return;
+      LOG.Flush();
+      LOGERR.Flush();
+      /* Split the tasks evenly among the thread deques.
+         The threads are sleeping, so no synchronization is needed here */
+      UInt64 unThreads = CSimulator::GetInstance().GetNumThreads();
+      for(UInt64 i = 0; i < unThreads; ++i) {
+         m_psTaskDeques[i].Range =
+            PackTaskRange( i      * un_num_tasks / unThreads,
+                          (i + 1) * un_num_tasks / unThreads);
+      }
+      /* Start the phase and wait for its end */
+      m_eCurrentPhase = e_phase;
+      m_cBusyThreads.Set(unThreads);
+      m_cPhaseGeneration.Increase();
+      m_cBusyThreads.WaitUntilEqual(0);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CSpaceMultiThreadWorkStealing::PopTask(UInt32 un_id,
+                                               size_t& un_task) {
+      STaskDeque& sDeque = m_psTaskDeques[un_id];
+      while(1) {
+         UInt64 unOld = sDeque.Range;
+         UInt64 unBegin = TaskRangeBegin(unOld);
+         UInt64 unEnd = TaskRangeEnd(unOld);
+         if(unBegin >= unEnd) {
+            /* Make sure the read was not torn on platforms without atomic 64-bit loads */
+            if(__sync_bool_compare_and_swap(&sDeque.Range, unOld, unOld)) {
+               return false;
+            }
+            continue;
+         }
+         /* Take the task in front */
+         if(__sync_bool_compare_and_swap(&sDeque.Range,
+                                         unOld,
+                                         PackTaskRange(unBegin + 1, unEnd))) {
+            un_task = unBegin;
+            return true;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CSpaceMultiThreadWorkStealing::StealTasks(UInt32 un_thief) {
+      UInt32 unThreads = CSimulator::GetInstance().GetNumThreads();
+      STaskDeque& sThiefDeque = m_psTaskDeques[un_thief];
+      /* Go through the other threads, starting from the next one */
+      for(UInt32 i = 1; i < unThreads; ++i) {
+         STaskDeque& sVictimDeque = m_psTaskDeques[(un_thief + i) % unThreads];
+         while(1) {
+            UInt64 unOld = sVictimDeque.Range;
+            UInt64 unBegin = TaskRangeBegin(unOld);
+            UInt64 unEnd = TaskRangeEnd(unOld);
+            /* Nothing to steal here, try the next thread */
+            if(unBegin >= unEnd) break;
+            /* Steal the back half of the remaining tasks */
+            UInt64 unSplit = unEnd - (unEnd - unBegin + 1) / 2;
+            if(__sync_bool_compare_and_swap(&sVictimDeque.Range,
+                                            unOld,
+                                            PackTaskRange(unBegin, unSplit))) {
+               /* The thief deque is empty, so nobody else can modify it */
+               UInt64 unThiefOld = sThiefDeque.Range;
+               while(!__sync_bool_compare_and_swap(&sThiefDeque.Range,
+                                                   unThiefOld,
+                                                   PackTaskRange(unSplit, unEnd))) {
+                  unThiefOld = sThiefDeque.Range;
+               }
+               return true;
+            }
+         }
+      }
+      /* No work left anywhere */
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::ExecuteTask(EPhase e_phase,
+                                                   size_t un_task) {
+      switch(e_phase) {
+         case PHASE_ACT:
+            m_vecControllableEntities[un_task]->Act();
+            break;
+         case PHASE_PHYSICS:
+            UpdatePhysicsEngine(un_task);
+            break;
+         case PHASE_MEDIA:
+            UpdateMedium(un_task);
+            break;
+         case PHASE_MEDIA_THREADS:
+            /* A stolen task keeps its index, so each index runs once */
+            UpdateMediaThread(un_task, CSimulator::GetInstance().GetNumThreads());
+            break;
+         case PHASE_SENSECONTROL:
+            m_vecControllableEntities[un_task]->Sense();
+            m_vecControllableEntities[un_task]->ControlStep();
+            break;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::SlaveThread(UInt32 un_id) {
+      /* The last phase generation executed by this thread */
+      UInt32 unLastGeneration = 0;
+      /* The phase to execute */
+      EPhase ePhase;
+      /* Task index */
+      size_t unTask;
+      while(1) {
+         /* Wait for the start of a phase */
+         m_cPhaseGeneration.WaitWhileEqual(unLastGeneration);
+         unLastGeneration = m_cPhaseGeneration.Get();
+         ePhase = m_eCurrentPhase;
+         pthread_testcancel();
+         /* Consume the own tasks, then steal from the other threads */
+         do {
+            while(PopTask(un_id, unTask)) {
+               ExecuteTask(ePhase, unTask);
+            }
+         } while(StealTasks(un_id));
+         pthread_testcancel();
+         /* Signal the end of the work for this thread */
+         m_cBusyThreads.Decrease();
+         pthread_testcancel();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
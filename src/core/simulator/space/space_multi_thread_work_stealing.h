@@ -0,0 +1,119 @@
+/**
+ * @file <argos3/core/simulator/space/space_multi_thread_work_stealing.h>
+ *
+ * @brief This file provides the definition of the work-stealing space.
+ *
+ * At the beginning of each phase, the tasks (controllable entities,
+ * physics engines or media) are split evenly among the threads. Each
+ * thread consumes its own share from the front, and when it runs out
+ * of work, it steals half of the remaining tasks of another thread
+ * from the back. Task fetching is lock-free.
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#ifndef SPACE_MULTI_THREAD_WORK_STEALING_H
+#define SPACE_MULTI_THREAD_WORK_STEALING_H
+
+namespace argos {
+   class CSpace;
+}
+
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/simulator/space/phase_sync_counter.h>
+
+namespace argos {
+
+   class CSpaceMultiThreadWorkStealing : public CSpace {
+
+      /****************************************/
+      /****************************************/
+
+   private:
+
+      /** The phases of a simulation step */
+      enum EPhase {
+         PHASE_ACT = 0,
+         PHASE_PHYSICS,
+         PHASE_MEDIA,
+         PHASE_MEDIA_THREADS,
+         PHASE_SENSECONTROL
+      };
+
+      /**
+       * The task deque of a thread.
+       * The deque contains a contiguous range of task indices
+       * <tt>[begin,end)</tt>, packed into a single 64-bit word so that it
+       * can be modified with one compare-and-swap. The owner pops tasks
+       * from the front, thieves steal from the back. The structure is
+       * padded to a cache line to avoid false sharing.
+       */
+      struct STaskDeque {
+         volatile UInt64 Range;
+         UInt8 Padding[64 - sizeof(UInt64)];
+
+         STaskDeque() : Range(0) {}
+      };
+
+      /** Thread launch data */
+      struct SThreadLaunchData {
+         UInt32 ThreadId;
+         CSpaceMultiThreadWorkStealing* Space;
+
+         SThreadLaunchData(UInt32 un_thread_id,
+                           CSpaceMultiThreadWorkStealing* pc_space) :
+            ThreadId(un_thread_id),
+            Space(pc_space) {}
+      };
+
+      /****************************************/
+      /****************************************/
+
+   public:
+
+      CSpaceMultiThreadWorkStealing();
+      virtual ~CSpaceMultiThreadWorkStealing() {}
+
+      virtual void Init(TConfigurationNode& t_tree);
+      virtual void Destroy();
+
+      virtual void UpdateControllableEntitiesAct();
+      virtual void UpdatePhysics();
+      virtual void UpdateMedia();
+      virtual void UpdateControllableEntitiesSenseStep();
+
+   private:
+
+      void StartThreads();
+      void RunPhase(EPhase e_phase, size_t un_num_tasks);
+      void SlaveThread(UInt32 un_id);
+      bool PopTask(UInt32 un_id, size_t& un_task);
+      bool StealTasks(UInt32 un_thief);
+      void ExecuteTask(EPhase e_phase, size_t un_task);
+      friend void* LaunchThreadWorkStealing(void* p_data);
+
+   private:
+
+      /** The slave thread array */
+      pthread_t* m_ptThreads;
+
+      /** Data structure needed to launch the threads */
+      SThreadLaunchData** m_psThreadData;
+
+      /** The task deques, one per thread */
+      STaskDeque* m_psTaskDeques;
+
+      /** The phase currently being executed */
+      EPhase m_eCurrentPhase;
+
+      /** Incremented every time a phase starts */
+      CPhaseSyncCounter m_cPhaseGeneration;
+
+      /** How many threads are still working in the current phase */
+      CPhaseSyncCounter m_cBusyThreads;
+
+   };
+
+}
+
+#endif
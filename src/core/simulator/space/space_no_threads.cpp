@@ -28,7 +28,7 @@ namespace argos {
    void CSpaceNoThreads::UpdatePhysics() {
       /* Update the physics engines */
       for(size_t i = 0; i < m_ptPhysicsEngines->size(); ++i) {
-         (*m_ptPhysicsEngines)[i]->Update();
+         UpdatePhysicsEngine(i);
       }
       /* Perform entity transfer from engine to engine, if needed */
       for(size_t i = 0; i < m_ptPhysicsEngines->size(); ++i) {
@@ -43,8 +43,10 @@ namespace argos {
 
    void CSpaceNoThreads::UpdateMedia() {
       for(size_t i = 0; i < m_ptMedia->size(); ++i) {
-         (*m_ptMedia)[i]->Update();
+         UpdateMedium(i);
       }
+      UpdateMediaThread(0, 1);
+      PostUpdateMedia();
    }
 
    /****************************************/
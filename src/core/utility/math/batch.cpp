@@ -0,0 +1,261 @@
+/**
+ * @file <argos3/core/utility/math/batch.cpp>
+ *
+ * @author Carlo Pinciroli <ilpincy@gmail.com>
+ */
+#include "batch.h"
+#include "quaternion.h"
+#include "ray3.h"
+#include "vector3.h"
+#include <pthread.h>
+
+/* The scalar kernels, used when the processor has no vector extensions */
+#define BATCH_KERNELS_NAMESPACE batch_scalar
+#include "batch_kernels.h"
+
+namespace argos {
+
+#ifdef ARGOS_WITH_X86_SIMD
+   namespace batch_sse2 { extern const SBatchKernels KERNELS; }
+   namespace batch_avx2 { extern const SBatchKernels KERNELS; }
+#endif
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Returns true if the processor supports the given instruction set
+    */
+   static bool IsBatchInstructionSetSupported(EBatchInstructionSet e_set) {
+#ifdef ARGOS_WITH_X86_SIMD
+      __builtin_cpu_init();
+#endif
+      switch(e_set) {
+#ifdef ARGOS_WITH_X86_SIMD
+         case BATCH_AVX2: return __builtin_cpu_supports("avx2");
+         case BATCH_SSE2: return __builtin_cpu_supports("sse2");
+#endif
+         case BATCH_SCALAR: return true;
+         default: return false;
+      }
+   }
+
+   /*
+    * Returns the kernels for the given instruction set
+    */
+   static const SBatchKernels& GetBatchKernels(EBatchInstructionSet e_set) {
+      switch(e_set) {
+#ifdef ARGOS_WITH_X86_SIMD
+         case BATCH_AVX2: return batch_avx2::KERNELS;
+         case BATCH_SSE2: return batch_sse2::KERNELS;
+#endif
+         default: return batch_scalar::KERNELS;
+      }
+   }
+
+   /*
+    * The currently selected instruction set and kernels
+    */
+   static EBatchInstructionSet g_eBatchInstructionSet = BATCH_SCALAR;
+   static const SBatchKernels* g_psBatchKernels = NULL;
+
+   /*
+    * Guards the selection of the default kernels, which happens on the
+    * first call and possibly from several threads at once
+    */
+   static pthread_once_t g_tBatchKernelsOnce = PTHREAD_ONCE_INIT;
+
+   static EBatchInstructionSet SelectBatchInstructionSet(EBatchInstructionSet e_set) {
+      while(!IsBatchInstructionSetSupported(e_set)) {
+         e_set = static_cast<EBatchInstructionSet>(e_set - 1);
+      }
+      g_eBatchInstructionSet = e_set;
+      g_psBatchKernels = &GetBatchKernels(e_set);
+      return e_set;
+   }
+
+   static void InitBatchKernels() {
+      SelectBatchInstructionSet(BATCH_AVX2);
+   }
+
+   static inline const SBatchKernels& BatchKernels() {
+      pthread_once(&g_tBatchKernelsOnce, InitBatchKernels);
+      return *g_psBatchKernels;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   EBatchInstructionSet GetBatchInstructionSet() {
+      BatchKernels();
+      return g_eBatchInstructionSet;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   EBatchInstructionSet SetBatchInstructionSet(EBatchInstructionSet e_set) {
+      /* Make sure the default selection cannot override this one later */
+      pthread_once(&g_tBatchKernelsOnce, InitBatchKernels);
+      return SelectBatchInstructionSet(e_set);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   const char* GetBatchInstructionSetName(EBatchInstructionSet e_set) {
+      switch(e_set) {
+         case BATCH_AVX2: return "AVX2";
+         case BATCH_SSE2: return "SSE2";
+         default: return "scalar";
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void BatchRotateTranslate(Real* pf_out_x,
+                             Real* pf_out_y,
+                             Real* pf_out_z,
+                             const Real* pf_in_x,
+                             const Real* pf_in_y,
+                             const Real* pf_in_z,
+                             size_t un_num,
+                             const CQuaternion& c_rotation,
+                             const CVector3& c_translation) {
+      /*
+       * Calculate the matrix equivalent to v' = q v q*
+       * This form does not assume q to be normalized, like CVector3::Rotate()
+       */
+      Real fW = c_rotation.GetW();
+      Real fX = c_rotation.GetX();
+      Real fY = c_rotation.GetY();
+      Real fZ = c_rotation.GetZ();
+      Real fWW = fW * fW, fXX = fX * fX, fYY = fY * fY, fZZ = fZ * fZ;
+      Real fXY = fX * fY, fXZ = fX * fZ, fYZ = fY * fZ;
+      Real fWX = fW * fX, fWY = fW * fY, fWZ = fW * fZ;
+      Real fM[9] = {
+         fWW + fXX - fYY - fZZ, 2.0f * (fXY - fWZ),    2.0f * (fXZ + fWY),
+         2.0f * (fXY + fWZ),    fWW - fXX + fYY - fZZ, 2.0f * (fYZ - fWX),
+         2.0f * (fXZ - fWY),    2.0f * (fYZ + fWX),    fWW - fXX - fYY + fZZ
+      };
+      BatchKernels().RotateTranslate(pf_out_x, pf_out_y, pf_out_z,
+                                     pf_in_x, pf_in_y, pf_in_z,
+                                     un_num,
+                                     fM,
+                                     c_translation.GetX(),
+                                     c_translation.GetY(),
+                                     c_translation.GetZ());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void BatchDotProduct(Real* pf_out,
+                        const Real* pf_a_x,
+                        const Real* pf_a_y,
+                        const Real* pf_a_z,
+                        const Real* pf_b_x,
+                        const Real* pf_b_y,
+                        const Real* pf_b_z,
+                        size_t un_num) {
+      BatchKernels().DotProduct(pf_out,
+                                pf_a_x, pf_a_y, pf_a_z,
+                                pf_b_x, pf_b_y, pf_b_z,
+                                un_num);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void BatchCrossProduct(Real* pf_out_x,
+                          Real* pf_out_y,
+                          Real* pf_out_z,
+                          const Real* pf_a_x,
+                          const Real* pf_a_y,
+                          const Real* pf_a_z,
+                          const Real* pf_b_x,
+                          const Real* pf_b_y,
+                          const Real* pf_b_z,
+                          size_t un_num) {
+      BatchKernels().CrossProduct(pf_out_x, pf_out_y, pf_out_z,
+                                  pf_a_x, pf_a_y, pf_a_z,
+                                  pf_b_x, pf_b_y, pf_b_z,
+                                  un_num);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void BatchSquareDistance(Real* pf_out,
+                            const Real* pf_x,
+                            const Real* pf_y,
+                            const Real* pf_z,
+                            size_t un_num,
+                            const CVector3& c_point) {
+      BatchKernels().SquareDistance(pf_out,
+                                    pf_x, pf_y, pf_z,
+                                    un_num,
+                                    c_point.GetX(), c_point.GetY(), c_point.GetZ());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void BatchDistance(Real* pf_out,
+                      const Real* pf_x,
+                      const Real* pf_y,
+                      const Real* pf_z,
+                      size_t un_num,
+                      const CVector3& c_point) {
+      BatchKernels().Distance(pf_out,
+                              pf_x, pf_y, pf_z,
+                              un_num,
+                              c_point.GetX(), c_point.GetY(), c_point.GetZ());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void BatchIntersectRayBoxes(Real* pf_t_on_ray,
+                               const Real* pf_min_x,
+                               const Real* pf_min_y,
+                               const Real* pf_min_z,
+                               const Real* pf_max_x,
+                               const Real* pf_max_y,
+                               const Real* pf_max_z,
+                               size_t un_num,
+                               const CRay3& c_ray) {
+      Real pfStart[3] = { c_ray.GetStart().GetX(), c_ray.GetStart().GetY(), c_ray.GetStart().GetZ() };
+      Real pfEnd[3]   = { c_ray.GetEnd().GetX(),   c_ray.GetEnd().GetY(),   c_ray.GetEnd().GetZ()   };
+      BatchKernels().IntersectRayBoxes(pf_t_on_ray,
+                                       pf_min_x, pf_min_y, pf_min_z,
+                                       pf_max_x, pf_max_y, pf_max_z,
+                                       un_num,
+                                       pfStart, pfEnd);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void BatchIntersectRayCylinders(Real* pf_t_on_ray,
+                                   const Real* pf_base_x,
+                                   const Real* pf_base_y,
+                                   const Real* pf_base_z,
+                                   const Real* pf_radius,
+                                   const Real* pf_height,
+                                   size_t un_num,
+                                   const CRay3& c_ray) {
+      Real pfStart[3] = { c_ray.GetStart().GetX(), c_ray.GetStart().GetY(), c_ray.GetStart().GetZ() };
+      Real pfEnd[3]   = { c_ray.GetEnd().GetX(),   c_ray.GetEnd().GetY(),   c_ray.GetEnd().GetZ()   };
+      BatchKernels().IntersectRayCylinders(pf_t_on_ray,
+                                           pf_base_x, pf_base_y, pf_base_z,
+                                           pf_radius, pf_height,
+                                           un_num,
+                                           pfStart, pfEnd);
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
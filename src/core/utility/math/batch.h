@@ -0,0 +1,229 @@
+/**
+ * @file <argos3/core/utility/math/batch.h>
+ *
+ * @brief Kernels that operate on arrays of vectors stored in structure-of-arrays layout.
+ *
+ * The kernels are compiled for SSE2 and AVX2 on x86 processors, and the best
+ * version supported by the processor is chosen at run time. On the other
+ * processors, the kernels process one value at a time.
+ *
+ * @author Carlo Pinciroli <ilpincy@gmail.com>
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+namespace argos {
+   class CQuaternion;
+   class CRay3;
+   class CVector3;
+}
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <cstddef>
+
+namespace argos {
+
+   /**
+    * The instruction sets the batch kernels can run with.
+    * The kernels are compiled for each instruction set, and the best one
+    * supported by the processor is chosen at run time.
+    */
+   enum EBatchInstructionSet {
+      BATCH_SCALAR = 0,
+      BATCH_SSE2,
+      BATCH_AVX2
+   };
+
+   /**
+    * Returns the instruction set the batch kernels currently run with.
+    * @return The instruction set the batch kernels currently run with.
+    */
+   EBatchInstructionSet GetBatchInstructionSet();
+
+   /**
+    * Selects the instruction set the batch kernels run with.
+    * If the processor does not support the wanted instruction set, the best
+    * supported one below it is selected. This method is not thread-safe, and
+    * it is meant to be used for testing and benchmarking.
+    * @param e_set The wanted instruction set.
+    * @return The instruction set actually selected.
+    */
+   EBatchInstructionSet SetBatchInstructionSet(EBatchInstructionSet e_set);
+
+   /**
+    * Returns the name of the given instruction set.
+    * @param e_set The instruction set.
+    * @return The name of the given instruction set.
+    */
+   const char* GetBatchInstructionSetName(EBatchInstructionSet e_set);
+
+   /**
+    * Rotates and translates an array of points.
+    * <p>
+    * The coordinates of the points are stored in three separate arrays, one per
+    * axis. Each point is rotated by the given quaternion and then translated by
+    * the given vector, as in:
+    * </p>
+    * <pre>
+    * CVector3 cPoint(pf_in_x[i], pf_in_y[i], pf_in_z[i]);
+    * cPoint.Rotate(c_rotation);
+    * cPoint += c_translation;
+    * </pre>
+    * <p>
+    * The rotation is converted to a matrix once, and the points are processed
+    * several at a time. The input and output arrays may coincide.
+    * </p>
+    * @param pf_out_x The x coordinates of the result.
+    * @param pf_out_y The y coordinates of the result.
+    * @param pf_out_z The z coordinates of the result.
+    * @param pf_in_x The x coordinates of the points.
+    * @param pf_in_y The y coordinates of the points.
+    * @param pf_in_z The z coordinates of the points.
+    * @param un_num The number of points.
+    * @param c_rotation The rotation.
+    * @param c_translation The translation.
+    */
+   void BatchRotateTranslate(Real* pf_out_x,
+                             Real* pf_out_y,
+                             Real* pf_out_z,
+                             const Real* pf_in_x,
+                             const Real* pf_in_y,
+                             const Real* pf_in_z,
+                             size_t un_num,
+                             const CQuaternion& c_rotation,
+                             const CVector3& c_translation);
+
+   /**
+    * Calculates the dot products of two arrays of vectors.
+    * @param pf_out The dot products.
+    * @param pf_a_x The x coordinates of the first vectors.
+    * @param pf_a_y The y coordinates of the first vectors.
+    * @param pf_a_z The z coordinates of the first vectors.
+    * @param pf_b_x The x coordinates of the second vectors.
+    * @param pf_b_y The y coordinates of the second vectors.
+    * @param pf_b_z The z coordinates of the second vectors.
+    * @param un_num The number of vectors.
+    */
+   void BatchDotProduct(Real* pf_out,
+                        const Real* pf_a_x,
+                        const Real* pf_a_y,
+                        const Real* pf_a_z,
+                        const Real* pf_b_x,
+                        const Real* pf_b_y,
+                        const Real* pf_b_z,
+                        size_t un_num);
+
+   /**
+    * Calculates the cross products of two arrays of vectors.
+    * The output arrays may coincide with the input arrays.
+    * @param pf_out_x The x coordinates of the cross products.
+    * @param pf_out_y The y coordinates of the cross products.
+    * @param pf_out_z The z coordinates of the cross products.
+    * @param pf_a_x The x coordinates of the first vectors.
+    * @param pf_a_y The y coordinates of the first vectors.
+    * @param pf_a_z The z coordinates of the first vectors.
+    * @param pf_b_x The x coordinates of the second vectors.
+    * @param pf_b_y The y coordinates of the second vectors.
+    * @param pf_b_z The z coordinates of the second vectors.
+    * @param un_num The number of vectors.
+    */
+   void BatchCrossProduct(Real* pf_out_x,
+                          Real* pf_out_y,
+                          Real* pf_out_z,
+                          const Real* pf_a_x,
+                          const Real* pf_a_y,
+                          const Real* pf_a_z,
+                          const Real* pf_b_x,
+                          const Real* pf_b_y,
+                          const Real* pf_b_z,
+                          size_t un_num);
+
+   /**
+    * Calculates the square distances between an array of points and a point.
+    * @param pf_out The square distances.
+    * @param pf_x The x coordinates of the points.
+    * @param pf_y The y coordinates of the points.
+    * @param pf_z The z coordinates of the points.
+    * @param un_num The number of points.
+    * @param c_point The point to calculate the distances from.
+    */
+   void BatchSquareDistance(Real* pf_out,
+                            const Real* pf_x,
+                            const Real* pf_y,
+                            const Real* pf_z,
+                            size_t un_num,
+                            const CVector3& c_point);
+
+   /**
+    * Calculates the distances between an array of points and a point.
+    * @param pf_out The distances.
+    * @param pf_x The x coordinates of the points.
+    * @param pf_y The y coordinates of the points.
+    * @param pf_z The z coordinates of the points.
+    * @param un_num The number of points.
+    * @param c_point The point to calculate the distances from.
+    */
+   void BatchDistance(Real* pf_out,
+                      const Real* pf_x,
+                      const Real* pf_y,
+                      const Real* pf_z,
+                      size_t un_num,
+                      const CVector3& c_point);
+
+   /**
+    * Intersects a segment with an array of axis-aligned boxes.
+    * <p>
+    * For each box, the result is the smallest t in [0,1] such that
+    * <tt>c_ray.GetPoint(t)</tt> is inside the box, or a negative value if the
+    * segment does not intersect the box. This is the same test as
+    * SBoundingBox::Intersects().
+    * </p>
+    * @param pf_t_on_ray The results.
+    * @param pf_min_x The minimum x coordinates of the boxes.
+    * @param pf_min_y The minimum y coordinates of the boxes.
+    * @param pf_min_z The minimum z coordinates of the boxes.
+    * @param pf_max_x The maximum x coordinates of the boxes.
+    * @param pf_max_y The maximum y coordinates of the boxes.
+    * @param pf_max_z The maximum z coordinates of the boxes.
+    * @param un_num The number of boxes.
+    * @param c_ray The segment.
+    */
+   void BatchIntersectRayBoxes(Real* pf_t_on_ray,
+                               const Real* pf_min_x,
+                               const Real* pf_min_y,
+                               const Real* pf_min_z,
+                               const Real* pf_max_x,
+                               const Real* pf_max_y,
+                               const Real* pf_max_z,
+                               size_t un_num,
+                               const CRay3& c_ray);
+
+   /**
+    * Intersects a segment with an array of solid cylinders whose axis is parallel to Z.
+    * <p>
+    * For each cylinder, the result is the smallest t in [0,1] such that
+    * <tt>c_ray.GetPoint(t)</tt> is inside the cylinder, or a negative value if the
+    * segment does not intersect the cylinder.
+    * </p>
+    * @param pf_t_on_ray The results.
+    * @param pf_base_x The x coordinates of the centers of the bottom caps.
+    * @param pf_base_y The y coordinates of the centers of the bottom caps.
+    * @param pf_base_z The z coordinates of the centers of the bottom caps.
+    * @param pf_radius The radii of the cylinders.
+    * @param pf_height The heights of the cylinders.
+    * @param un_num The number of cylinders.
+    * @param c_ray The segment.
+    */
+   void BatchIntersectRayCylinders(Real* pf_t_on_ray,
+                                   const Real* pf_base_x,
+                                   const Real* pf_base_y,
+                                   const Real* pf_base_z,
+                                   const Real* pf_radius,
+                                   const Real* pf_height,
+                                   size_t un_num,
+                                   const CRay3& c_ray);
+
+}
+
+#endif
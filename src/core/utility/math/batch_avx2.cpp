@@ -0,0 +1,46 @@
+/**
+ * @file <argos3/core/utility/math/batch_avx2.cpp>
+ *
+ * @brief Kernels of batch.h compiled for AVX2.
+ *
+ * @author Carlo Pinciroli <ilpincy@gmail.com>
+ */
+#include <argos3/core/config.h>
+#include <immintrin.h>
+
+#ifdef ARGOS_USE_DOUBLE
+#  define PACKED_WIDTH 4
+#  define TPacked __m256d
+#  define PACKED_LOAD(PTR)        _mm256_loadu_pd(PTR)
+#  define PACKED_STORE(PTR, V)    _mm256_storeu_pd(PTR, V)
+#  define PACKED_SET1(F)          _mm256_set1_pd(F)
+#  define PACKED_ADD(A, B)        _mm256_add_pd(A, B)
+#  define PACKED_SUB(A, B)        _mm256_sub_pd(A, B)
+#  define PACKED_MUL(A, B)        _mm256_mul_pd(A, B)
+#  define PACKED_DIV(A, B)        _mm256_div_pd(A, B)
+#  define PACKED_MIN(A, B)        _mm256_min_pd(A, B)
+#  define PACKED_MAX(A, B)        _mm256_max_pd(A, B)
+#  define PACKED_SQRT(A)          _mm256_sqrt_pd(A)
+#  define PACKED_CMPLE(A, B)      _mm256_cmp_pd(A, B, _CMP_LE_OQ)
+#  define PACKED_AND(A, B)        _mm256_and_pd(A, B)
+#  define PACKED_BLEND(F, T, M)   _mm256_blendv_pd(F, T, M)
+#else
+#  define PACKED_WIDTH 8
+#  define TPacked __m256
+#  define PACKED_LOAD(PTR)        _mm256_loadu_ps(PTR)
+#  define PACKED_STORE(PTR, V)    _mm256_storeu_ps(PTR, V)
+#  define PACKED_SET1(F)          _mm256_set1_ps(F)
+#  define PACKED_ADD(A, B)        _mm256_add_ps(A, B)
+#  define PACKED_SUB(A, B)        _mm256_sub_ps(A, B)
+#  define PACKED_MUL(A, B)        _mm256_mul_ps(A, B)
+#  define PACKED_DIV(A, B)        _mm256_div_ps(A, B)
+#  define PACKED_MIN(A, B)        _mm256_min_ps(A, B)
+#  define PACKED_MAX(A, B)        _mm256_max_ps(A, B)
+#  define PACKED_SQRT(A)          _mm256_sqrt_ps(A)
+#  define PACKED_CMPLE(A, B)      _mm256_cmp_ps(A, B, _CMP_LE_OQ)
+#  define PACKED_AND(A, B)        _mm256_and_ps(A, B)
+#  define PACKED_BLEND(F, T, M)   _mm256_blendv_ps(F, T, M)
+#endif
+
+#define BATCH_KERNELS_NAMESPACE batch_avx2
+#include "batch_kernels.h"
@@ -0,0 +1,394 @@
+/**
+ * @file <argos3/core/utility/math/batch_kernels.h>
+ *
+ * @brief Implementation of the kernels declared in batch.h.
+ *
+ * This file is not meant to be included by user code. Each translation
+ * unit that includes it compiles the kernels for a specific instruction
+ * set. Before including it, the translation unit must define
+ * BATCH_KERNELS_NAMESPACE, the namespace where the kernels are placed,
+ * and optionally the PACKED_* macros for the vector instructions. If
+ * PACKED_WIDTH is not defined, the kernels process one value at a time.
+ *
+ * @author Carlo Pinciroli <ilpincy@gmail.com>
+ */
+
+#ifndef BATCH_KERNELS_H
+#define BATCH_KERNELS_H
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <argos3/core/utility/math/general.h>
+#include <cmath>
+#include <cstddef>
+
+namespace argos {
+
+   /**
+    * The kernels compiled for an instruction set.
+    * The arguments are the same as those of the functions in batch.h,
+    * with the vectors passed as separate coordinates.
+    */
+   struct SBatchKernels {
+      void (*RotateTranslate)(Real* pf_out_x, Real* pf_out_y, Real* pf_out_z,
+                              const Real* pf_in_x, const Real* pf_in_y, const Real* pf_in_z,
+                              size_t un_num,
+                              const Real* pf_matrix,
+                              Real f_t_x, Real f_t_y, Real f_t_z);
+      void (*DotProduct)(Real* pf_out,
+                         const Real* pf_a_x, const Real* pf_a_y, const Real* pf_a_z,
+                         const Real* pf_b_x, const Real* pf_b_y, const Real* pf_b_z,
+                         size_t un_num);
+      void (*CrossProduct)(Real* pf_out_x, Real* pf_out_y, Real* pf_out_z,
+                           const Real* pf_a_x, const Real* pf_a_y, const Real* pf_a_z,
+                           const Real* pf_b_x, const Real* pf_b_y, const Real* pf_b_z,
+                           size_t un_num);
+      void (*SquareDistance)(Real* pf_out,
+                             const Real* pf_x, const Real* pf_y, const Real* pf_z,
+                             size_t un_num,
+                             Real f_p_x, Real f_p_y, Real f_p_z);
+      void (*Distance)(Real* pf_out,
+                       const Real* pf_x, const Real* pf_y, const Real* pf_z,
+                       size_t un_num,
+                       Real f_p_x, Real f_p_y, Real f_p_z);
+      void (*IntersectRayBoxes)(Real* pf_t_on_ray,
+                                const Real* pf_min_x, const Real* pf_min_y, const Real* pf_min_z,
+                                const Real* pf_max_x, const Real* pf_max_y, const Real* pf_max_z,
+                                size_t un_num,
+                                const Real* pf_start, const Real* pf_end);
+      void (*IntersectRayCylinders)(Real* pf_t_on_ray,
+                                    const Real* pf_base_x, const Real* pf_base_y, const Real* pf_base_z,
+                                    const Real* pf_radius, const Real* pf_height,
+                                    size_t un_num,
+                                    const Real* pf_start, const Real* pf_end);
+   };
+
+}
+
+#endif
+
+#ifndef BATCH_KERNELS_NAMESPACE
+#  error "BATCH_KERNELS_NAMESPACE must be defined before including batch_kernels.h"
+#endif
+
+namespace argos {
+
+   namespace BATCH_KERNELS_NAMESPACE {
+
+      /****************************************/
+      /****************************************/
+
+      static void RotateTranslate(Real* pf_out_x, Real* pf_out_y, Real* pf_out_z,
+                                  const Real* pf_in_x, const Real* pf_in_y, const Real* pf_in_z,
+                                  size_t un_num,
+                                  const Real* pf_matrix,
+                                  Real f_t_x, Real f_t_y, Real f_t_z) {
+         const Real* fM = pf_matrix;
+         size_t i = 0;
+#ifdef PACKED_WIDTH
+         TPacked tM0 = PACKED_SET1(fM[0]), tM1 = PACKED_SET1(fM[1]), tM2 = PACKED_SET1(fM[2]);
+         TPacked tM3 = PACKED_SET1(fM[3]), tM4 = PACKED_SET1(fM[4]), tM5 = PACKED_SET1(fM[5]);
+         TPacked tM6 = PACKED_SET1(fM[6]), tM7 = PACKED_SET1(fM[7]), tM8 = PACKED_SET1(fM[8]);
+         TPacked tTX = PACKED_SET1(f_t_x), tTY = PACKED_SET1(f_t_y), tTZ = PACKED_SET1(f_t_z);
+         for(; i + PACKED_WIDTH <= un_num; i += PACKED_WIDTH) {
+            TPacked tX = PACKED_LOAD(pf_in_x + i);
+            TPacked tY = PACKED_LOAD(pf_in_y + i);
+            TPacked tZ = PACKED_LOAD(pf_in_z + i);
+            PACKED_STORE(pf_out_x + i,
+                         PACKED_ADD(PACKED_ADD(PACKED_ADD(PACKED_MUL(tM0, tX),
+                                                          PACKED_MUL(tM1, tY)),
+                                               PACKED_MUL(tM2, tZ)),
+                                    tTX));
+            PACKED_STORE(pf_out_y + i,
+                         PACKED_ADD(PACKED_ADD(PACKED_ADD(PACKED_MUL(tM3, tX),
+                                                          PACKED_MUL(tM4, tY)),
+                                               PACKED_MUL(tM5, tZ)),
+                                    tTY));
+            PACKED_STORE(pf_out_z + i,
+                         PACKED_ADD(PACKED_ADD(PACKED_ADD(PACKED_MUL(tM6, tX),
+                                                          PACKED_MUL(tM7, tY)),
+                                               PACKED_MUL(tM8, tZ)),
+                                    tTZ));
+         }
+#endif
+         for(; i < un_num; ++i) {
+            Real fInX = pf_in_x[i], fInY = pf_in_y[i], fInZ = pf_in_z[i];
+            pf_out_x[i] = fM[0] * fInX + fM[1] * fInY + fM[2] * fInZ + f_t_x;
+            pf_out_y[i] = fM[3] * fInX + fM[4] * fInY + fM[5] * fInZ + f_t_y;
+            pf_out_z[i] = fM[6] * fInX + fM[7] * fInY + fM[8] * fInZ + f_t_z;
+         }
+      }
+
+      /****************************************/
+      /****************************************/
+
+      static void DotProduct(Real* pf_out,
+                             const Real* pf_a_x, const Real* pf_a_y, const Real* pf_a_z,
+                             const Real* pf_b_x, const Real* pf_b_y, const Real* pf_b_z,
+                             size_t un_num) {
+         size_t i = 0;
+#ifdef PACKED_WIDTH
+         for(; i + PACKED_WIDTH <= un_num; i += PACKED_WIDTH) {
+            PACKED_STORE(pf_out + i,
+                         PACKED_ADD(PACKED_ADD(PACKED_MUL(PACKED_LOAD(pf_a_x + i), PACKED_LOAD(pf_b_x + i)),
+                                               PACKED_MUL(PACKED_LOAD(pf_a_y + i), PACKED_LOAD(pf_b_y + i))),
+                                    PACKED_MUL(PACKED_LOAD(pf_a_z + i), PACKED_LOAD(pf_b_z + i))));
+         }
+#endif
+         for(; i < un_num; ++i) {
+            pf_out[i] = pf_a_x[i] * pf_b_x[i] + pf_a_y[i] * pf_b_y[i] + pf_a_z[i] * pf_b_z[i];
+         }
+      }
+
+      /****************************************/
+      /****************************************/
+
+      static void CrossProduct(Real* pf_out_x, Real* pf_out_y, Real* pf_out_z,
+                               const Real* pf_a_x, const Real* pf_a_y, const Real* pf_a_z,
+                               const Real* pf_b_x, const Real* pf_b_y, const Real* pf_b_z,
+                               size_t un_num) {
+         size_t i = 0;
+#ifdef PACKED_WIDTH
+         for(; i + PACKED_WIDTH <= un_num; i += PACKED_WIDTH) {
+            TPacked tAX = PACKED_LOAD(pf_a_x + i), tAY = PACKED_LOAD(pf_a_y + i), tAZ = PACKED_LOAD(pf_a_z + i);
+            TPacked tBX = PACKED_LOAD(pf_b_x + i), tBY = PACKED_LOAD(pf_b_y + i), tBZ = PACKED_LOAD(pf_b_z + i);
+            /* Compute all the results before storing, as the output may coincide with the input */
+            TPacked tX = PACKED_SUB(PACKED_MUL(tAY, tBZ), PACKED_MUL(tAZ, tBY));
+            TPacked tY = PACKED_SUB(PACKED_MUL(tAZ, tBX), PACKED_MUL(tAX, tBZ));
+            TPacked tZ = PACKED_SUB(PACKED_MUL(tAX, tBY), PACKED_MUL(tAY, tBX));
+            PACKED_STORE(pf_out_x + i, tX);
+            PACKED_STORE(pf_out_y + i, tY);
+            PACKED_STORE(pf_out_z + i, tZ);
+         }
+#endif
+         for(; i < un_num; ++i) {
+            Real fAX = pf_a_x[i], fAY = pf_a_y[i], fAZ = pf_a_z[i];
+            Real fBX = pf_b_x[i], fBY = pf_b_y[i], fBZ = pf_b_z[i];
+            pf_out_x[i] = fAY * fBZ - fAZ * fBY;
+            pf_out_y[i] = fAZ * fBX - fAX * fBZ;
+            pf_out_z[i] = fAX * fBY - fAY * fBX;
+         }
+      }
+
+      /****************************************/
+      /****************************************/
+
+      static void SquareDistance(Real* pf_out,
+                                 const Real* pf_x, const Real* pf_y, const Real* pf_z,
+                                 size_t un_num,
+                                 Real f_p_x, Real f_p_y, Real f_p_z) {
+         size_t i = 0;
+#ifdef PACKED_WIDTH
+         TPacked tPX = PACKED_SET1(f_p_x), tPY = PACKED_SET1(f_p_y), tPZ = PACKED_SET1(f_p_z);
+         for(; i + PACKED_WIDTH <= un_num; i += PACKED_WIDTH) {
+            TPacked tDX = PACKED_SUB(PACKED_LOAD(pf_x + i), tPX);
+            TPacked tDY = PACKED_SUB(PACKED_LOAD(pf_y + i), tPY);
+            TPacked tDZ = PACKED_SUB(PACKED_LOAD(pf_z + i), tPZ);
+            PACKED_STORE(pf_out + i,
+                         PACKED_ADD(PACKED_ADD(PACKED_MUL(tDX, tDX),
+                                               PACKED_MUL(tDY, tDY)),
+                                    PACKED_MUL(tDZ, tDZ)));
+         }
+#endif
+         for(; i < un_num; ++i) {
+            Real fDX = pf_x[i] - f_p_x, fDY = pf_y[i] - f_p_y, fDZ = pf_z[i] - f_p_z;
+            pf_out[i] = fDX * fDX + fDY * fDY + fDZ * fDZ;
+         }
+      }
+
+      /****************************************/
+      /****************************************/
+
+      static void Distance(Real* pf_out,
+                           const Real* pf_x, const Real* pf_y, const Real* pf_z,
+                           size_t un_num,
+                           Real f_p_x, Real f_p_y, Real f_p_z) {
+         SquareDistance(pf_out, pf_x, pf_y, pf_z, un_num, f_p_x, f_p_y, f_p_z);
+         size_t i = 0;
+#ifdef PACKED_WIDTH
+         for(; i + PACKED_WIDTH <= un_num; i += PACKED_WIDTH) {
+            PACKED_STORE(pf_out + i, PACKED_SQRT(PACKED_LOAD(pf_out + i)));
+         }
+#endif
+         for(; i < un_num; ++i) {
+            pf_out[i] = ::sqrt(pf_out[i]);
+         }
+      }
+
+      /****************************************/
+      /****************************************/
+
+      static void IntersectRayBoxes(Real* pf_t_on_ray,
+                                    const Real* pf_min_x, const Real* pf_min_y, const Real* pf_min_z,
+                                    const Real* pf_max_x, const Real* pf_max_y, const Real* pf_max_z,
+                                    size_t un_num,
+                                    const Real* pf_start, const Real* pf_end) {
+         const Real* ppfMin[3] = { pf_min_x, pf_min_y, pf_min_z };
+         const Real* ppfMax[3] = { pf_max_x, pf_max_y, pf_max_z };
+         Real pfDelta[3] = {
+            pf_end[0] - pf_start[0],
+            pf_end[1] - pf_start[1],
+            pf_end[2] - pf_start[2]
+         };
+         size_t i = 0;
+#ifdef PACKED_WIDTH
+         TPacked tZero = PACKED_SET1(0.0f), tOne = PACKED_SET1(1.0f), tMiss = PACKED_SET1(-1.0f);
+         TPacked ptStart[3] = {
+            PACKED_SET1(pf_start[0]), PACKED_SET1(pf_start[1]), PACKED_SET1(pf_start[2])
+         };
+         TPacked ptDelta[3] = {
+            PACKED_SET1(pfDelta[0]), PACKED_SET1(pfDelta[1]), PACKED_SET1(pfDelta[2])
+         };
+         for(; i + PACKED_WIDTH <= un_num; i += PACKED_WIDTH) {
+            TPacked tTMin = tZero, tTMax = tOne;
+            TPacked tHit = PACKED_CMPLE(tZero, tOne);
+            for(UInt32 a = 0; a < 3; ++a) {
+               TPacked tMin = PACKED_LOAD(ppfMin[a] + i);
+               TPacked tMax = PACKED_LOAD(ppfMax[a] + i);
+               if(pfDelta[a] == 0.0f) {
+                  /* The ray is parallel to the slab */
+                  tHit = PACKED_AND(tHit, PACKED_AND(PACKED_CMPLE(tMin, ptStart[a]),
+                                                     PACKED_CMPLE(ptStart[a], tMax)));
+               }
+               else {
+                  TPacked tT1 = PACKED_DIV(PACKED_SUB(tMin, ptStart[a]), ptDelta[a]);
+                  TPacked tT2 = PACKED_DIV(PACKED_SUB(tMax, ptStart[a]), ptDelta[a]);
+                  tTMin = PACKED_MAX(tTMin, PACKED_MIN(tT1, tT2));
+                  tTMax = PACKED_MIN(tTMax, PACKED_MAX(tT1, tT2));
+               }
+            }
+            tHit = PACKED_AND(tHit, PACKED_CMPLE(tTMin, tTMax));
+            PACKED_STORE(pf_t_on_ray + i, PACKED_BLEND(tMiss, tTMin, tHit));
+         }
+#endif
+         for(; i < un_num; ++i) {
+            Real fTMin = 0.0f, fTMax = 1.0f;
+            bool bHit = true;
+            for(UInt32 a = 0; a < 3; ++a) {
+               Real fMin = ppfMin[a][i], fMax = ppfMax[a][i];
+               if(pfDelta[a] == 0.0f) {
+                  bHit = bHit && fMin <= pf_start[a] && pf_start[a] <= fMax;
+               }
+               else {
+                  Real fT1 = (fMin - pf_start[a]) / pfDelta[a];
+                  Real fT2 = (fMax - pf_start[a]) / pfDelta[a];
+                  fTMin = Max(fTMin, Min(fT1, fT2));
+                  fTMax = Min(fTMax, Max(fT1, fT2));
+               }
+            }
+            pf_t_on_ray[i] = (bHit && fTMin <= fTMax) ? fTMin : -1.0f;
+         }
+      }
+
+      /****************************************/
+      /****************************************/
+
+      static void IntersectRayCylinders(Real* pf_t_on_ray,
+                                        const Real* pf_base_x, const Real* pf_base_y, const Real* pf_base_z,
+                                        const Real* pf_radius, const Real* pf_height,
+                                        size_t un_num,
+                                        const Real* pf_start, const Real* pf_end) {
+         Real fDX = pf_end[0] - pf_start[0];
+         Real fDY = pf_end[1] - pf_start[1];
+         Real fDZ = pf_end[2] - pf_start[2];
+         /* Coefficient of t^2 in the equation of the lateral surface */
+         Real fA = fDX * fDX + fDY * fDY;
+         size_t i = 0;
+#ifdef PACKED_WIDTH
+         TPacked tZero = PACKED_SET1(0.0f), tOne = PACKED_SET1(1.0f), tMiss = PACKED_SET1(-1.0f);
+         TPacked tSX = PACKED_SET1(pf_start[0]), tSY = PACKED_SET1(pf_start[1]), tSZ = PACKED_SET1(pf_start[2]);
+         TPacked tDX = PACKED_SET1(fDX), tDY = PACKED_SET1(fDY), tDZ = PACKED_SET1(fDZ);
+         TPacked tA = PACKED_SET1(fA);
+         for(; i + PACKED_WIDTH <= un_num; i += PACKED_WIDTH) {
+            TPacked tTMin = tZero, tTMax = tOne;
+            TPacked tHit = PACKED_CMPLE(tZero, tOne);
+            /* Lateral surface */
+            TPacked tOX = PACKED_SUB(tSX, PACKED_LOAD(pf_base_x + i));
+            TPacked tOY = PACKED_SUB(tSY, PACKED_LOAD(pf_base_y + i));
+            TPacked tR = PACKED_LOAD(pf_radius + i);
+            TPacked tC = PACKED_SUB(PACKED_ADD(PACKED_MUL(tOX, tOX), PACKED_MUL(tOY, tOY)),
+                                    PACKED_MUL(tR, tR));
+            if(fA == 0.0f) {
+               /* The ray is parallel to the axis */
+               tHit = PACKED_AND(tHit, PACKED_CMPLE(tC, tZero));
+            }
+            else {
+               TPacked tB = PACKED_ADD(PACKED_MUL(tOX, tDX), PACKED_MUL(tOY, tDY));
+               TPacked tDelta = PACKED_SUB(PACKED_MUL(tB, tB), PACKED_MUL(tA, tC));
+               tHit = PACKED_AND(tHit, PACKED_CMPLE(tZero, tDelta));
+               TPacked tSqrt = PACKED_SQRT(PACKED_MAX(tDelta, tZero));
+               TPacked tMinusB = PACKED_SUB(tZero, tB);
+               tTMin = PACKED_MAX(tTMin, PACKED_DIV(PACKED_SUB(tMinusB, tSqrt), tA));
+               tTMax = PACKED_MIN(tTMax, PACKED_DIV(PACKED_ADD(tMinusB, tSqrt), tA));
+            }
+            /* Caps */
+            TPacked tBottom = PACKED_LOAD(pf_base_z + i);
+            TPacked tTop = PACKED_ADD(tBottom, PACKED_LOAD(pf_height + i));
+            if(fDZ == 0.0f) {
+               /* The ray is parallel to the caps */
+               tHit = PACKED_AND(tHit, PACKED_AND(PACKED_CMPLE(tBottom, tSZ),
+                                                  PACKED_CMPLE(tSZ, tTop)));
+            }
+            else {
+               TPacked tT1 = PACKED_DIV(PACKED_SUB(tBottom, tSZ), tDZ);
+               TPacked tT2 = PACKED_DIV(PACKED_SUB(tTop, tSZ), tDZ);
+               tTMin = PACKED_MAX(tTMin, PACKED_MIN(tT1, tT2));
+               tTMax = PACKED_MIN(tTMax, PACKED_MAX(tT1, tT2));
+            }
+            tHit = PACKED_AND(tHit, PACKED_CMPLE(tTMin, tTMax));
+            PACKED_STORE(pf_t_on_ray + i, PACKED_BLEND(tMiss, tTMin, tHit));
+         }
+#endif
+         for(; i < un_num; ++i) {
+            Real fTMin = 0.0f, fTMax = 1.0f;
+            bool bHit = true;
+            /* Lateral surface */
+            Real fOX = pf_start[0] - pf_base_x[i];
+            Real fOY = pf_start[1] - pf_base_y[i];
+            Real fC = (fOX * fOX + fOY * fOY) - pf_radius[i] * pf_radius[i];
+            if(fA == 0.0f) {
+               bHit = fC <= 0.0f;
+            }
+            else {
+               Real fB = fOX * fDX + fOY * fDY;
+               Real fDelta = fB * fB - fA * fC;
+               bHit = 0.0f <= fDelta;
+               Real fSqrt = ::sqrt(Max<Real>(fDelta, 0.0f));
+               fTMin = Max(fTMin, (-fB - fSqrt) / fA);
+               fTMax = Min(fTMax, (-fB + fSqrt) / fA);
+            }
+            /* Caps */
+            Real fBottom = pf_base_z[i];
+            Real fTop = fBottom + pf_height[i];
+            if(fDZ == 0.0f) {
+               bHit = bHit && fBottom <= pf_start[2] && pf_start[2] <= fTop;
+            }
+            else {
+               Real fT1 = (fBottom - pf_start[2]) / fDZ;
+               Real fT2 = (fTop - pf_start[2]) / fDZ;
+               fTMin = Max(fTMin, Min(fT1, fT2));
+               fTMax = Min(fTMax, Max(fT1, fT2));
+            }
+            pf_t_on_ray[i] = (bHit && fTMin <= fTMax) ? fTMin : -1.0f;
+         }
+      }
+
+      /****************************************/
+      /****************************************/
+
+      extern const SBatchKernels KERNELS;
+      const SBatchKernels KERNELS = {
+         RotateTranslate,
+         DotProduct,
+         CrossProduct,
+         SquareDistance,
+         Distance,
+         IntersectRayBoxes,
+         IntersectRayCylinders
+      };
+
+      /****************************************/
+      /****************************************/
+
+   }
+
+}
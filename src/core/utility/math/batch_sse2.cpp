@@ -0,0 +1,46 @@
+/**
+ * @file <argos3/core/utility/math/batch_sse2.cpp>
+ *
+ * @brief Kernels of batch.h compiled for SSE2.
+ *
+ * @author Carlo Pinciroli <ilpincy@gmail.com>
+ */
+#include <argos3/core/config.h>
+#include <emmintrin.h>
+
+#ifdef ARGOS_USE_DOUBLE
+#  define PACKED_WIDTH 2
+#  define TPacked __m128d
+#  define PACKED_LOAD(PTR)        _mm_loadu_pd(PTR)
+#  define PACKED_STORE(PTR, V)    _mm_storeu_pd(PTR, V)
+#  define PACKED_SET1(F)          _mm_set1_pd(F)
+#  define PACKED_ADD(A, B)        _mm_add_pd(A, B)
+#  define PACKED_SUB(A, B)        _mm_sub_pd(A, B)
+#  define PACKED_MUL(A, B)        _mm_mul_pd(A, B)
+#  define PACKED_DIV(A, B)        _mm_div_pd(A, B)
+#  define PACKED_MIN(A, B)        _mm_min_pd(A, B)
+#  define PACKED_MAX(A, B)        _mm_max_pd(A, B)
+#  define PACKED_SQRT(A)          _mm_sqrt_pd(A)
+#  define PACKED_CMPLE(A, B)      _mm_cmple_pd(A, B)
+#  define PACKED_AND(A, B)        _mm_and_pd(A, B)
+#  define PACKED_BLEND(F, T, M)   _mm_or_pd(_mm_and_pd(M, T), _mm_andnot_pd(M, F))
+#else
+#  define PACKED_WIDTH 4
+#  define TPacked __m128
+#  define PACKED_LOAD(PTR)        _mm_loadu_ps(PTR)
+#  define PACKED_STORE(PTR, V)    _mm_storeu_ps(PTR, V)
+#  define PACKED_SET1(F)          _mm_set1_ps(F)
+#  define PACKED_ADD(A, B)        _mm_add_ps(A, B)
+#  define PACKED_SUB(A, B)        _mm_sub_ps(A, B)
+#  define PACKED_MUL(A, B)        _mm_mul_ps(A, B)
+#  define PACKED_DIV(A, B)        _mm_div_ps(A, B)
+#  define PACKED_MIN(A, B)        _mm_min_ps(A, B)
+#  define PACKED_MAX(A, B)        _mm_max_ps(A, B)
+#  define PACKED_SQRT(A)          _mm_sqrt_ps(A)
+#  define PACKED_CMPLE(A, B)      _mm_cmple_ps(A, B)
+#  define PACKED_AND(A, B)        _mm_and_ps(A, B)
+#  define PACKED_BLEND(F, T, M)   _mm_or_ps(_mm_and_ps(M, T), _mm_andnot_ps(M, F))
+#endif
+
+#define BATCH_KERNELS_NAMESPACE batch_sse2
+#include "batch_kernels.h"
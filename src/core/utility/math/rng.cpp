@@ -26,6 +26,17 @@ namespace argos {
    static const UInt32 LOWER_MASK = 0x7fffffffUL; /* least significant r bits */
    static const CRange<UInt32> INT_RANGE = CRange<UInt32>(0, 0xFFFFFFFFUL);
 
+   /* Philox4x32-10 parameters */
+   static const UInt32 PHILOX_M0 = 0xD2511F53UL;
+   static const UInt32 PHILOX_M1 = 0xCD9E8D57UL;
+   static const UInt32 PHILOX_W0 = 0x9E3779B9UL;
+   static const UInt32 PHILOX_W1 = 0xBB67AE85UL;
+   static const UInt32 PHILOX_ROUNDS = 10;
+   static const SInt32 PHILOX_BLOCK = 4;
+
+   /* Size of the buffer of the bulk methods */
+   static const size_t BULK_BUFFER = 256;
+
    std::map<std::string, CRandom::CCategory*> CRandom::m_mapCategories;
 
    /* Checks that a category exists. It internally creates an iterator that points to the category, if found.  */
@@ -38,10 +49,47 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * Hashes a stream id into 64 bits (FNV-1a).
+    */
+   static UInt64 HashStream(const std::string& str_stream) {
+      UInt64 unHash = 0xcbf29ce484222325ULL;
+      for(size_t i = 0; i < str_stream.size(); ++i) {
+         unHash ^= static_cast<UInt8>(str_stream[i]);
+         unHash *= 0x100000001b3ULL;
+      }
+      return unHash;
+   }
+
+   /****************************************/
+   /****************************************/
+
    CRandom::CRNG::CRNG(UInt32 un_seed) :
+      m_eType(RNG_MERSENNE_TWISTER),
       m_unSeed(un_seed),
       m_punState(new UInt32[N]),
-      m_nIndex(N+1) {
+      m_nIndex(N+1),
+      m_unStream(0),
+      m_punStep(NULL),
+      m_unStep(0),
+      m_unCounter(0) {
+      Reset();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CRandom::CRNG::CRNG(UInt32 un_seed,
+                       UInt64 un_stream,
+                       const UInt32* pun_step) :
+      m_eType(RNG_COUNTER_BASED),
+      m_unSeed(un_seed),
+      m_punState(NULL),
+      m_nIndex(PHILOX_BLOCK),
+      m_unStream(un_stream),
+      m_punStep(pun_step),
+      m_unStep(0),
+      m_unCounter(0) {
       Reset();
    }
    
@@ -49,10 +97,19 @@ namespace argos {
    /****************************************/
    
    CRandom::CRNG::CRNG(const CRNG& c_rng) :
+      m_eType(c_rng.m_eType),
       m_unSeed(c_rng.m_unSeed),
-      m_punState(new UInt32[N]),
-      m_nIndex(c_rng.m_nIndex) {
-      ::memcpy(m_punState, c_rng.m_punState, N * sizeof(UInt32));
+      m_punState(NULL),
+      m_nIndex(c_rng.m_nIndex),
+      m_unStream(c_rng.m_unStream),
+      m_punStep(c_rng.m_punStep),
+      m_unStep(c_rng.m_unStep),
+      m_unCounter(c_rng.m_unCounter) {
+      if(m_eType == RNG_MERSENNE_TWISTER) {
+         m_punState = new UInt32[N];
+         ::memcpy(m_punState, c_rng.m_punState, N * sizeof(UInt32));
+      }
+      ::memcpy(m_punBlock, c_rng.m_punBlock, sizeof(m_punBlock));
    }
 
    /****************************************/
@@ -66,6 +123,13 @@ namespace argos {
    /****************************************/
 
    void CRandom::CRNG::Reset() {
+      if(m_eType == RNG_COUNTER_BASED) {
+         /* Restart the sequence of the current step */
+         m_unStep = (m_punStep != NULL) ? *m_punStep : 0;
+         m_unCounter = 0;
+         m_nIndex = PHILOX_BLOCK;
+         return;
+      }
       m_punState[0]= m_unSeed & 0xffffffffUL;
       for (m_nIndex = 1; m_nIndex < N; ++m_nIndex) {
          m_punState[m_nIndex] = 
@@ -73,6 +137,54 @@ namespace argos {
          m_punState[m_nIndex] &= 0xffffffffUL;
       }
    }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CRNG::SaveState(CByteArray& c_buffer) {
+      c_buffer << static_cast<UInt8>(m_eType)
+               << m_unSeed
+               << m_nIndex;
+      if(m_eType == RNG_COUNTER_BASED) {
+         c_buffer << m_unStream
+                  << m_unStep
+                  << m_unCounter;
+         for(SInt32 i = 0; i < PHILOX_BLOCK; ++i) {
+            c_buffer << m_punBlock[i];
+         }
+      }
+      else {
+         for(SInt32 i = 0; i < N; ++i) {
+            c_buffer << m_punState[i];
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CRNG::LoadState(CByteArray& c_buffer) {
+      UInt8 unType;
+      c_buffer >> unType;
+      if(unType != m_eType) {
+         THROW_ARGOSEXCEPTION("Cannot load the state of a RNG of type " << static_cast<UInt32>(unType) << " into a RNG of type " << static_cast<UInt32>(m_eType));
+      }
+      c_buffer >> m_unSeed
+               >> m_nIndex;
+      if(m_eType == RNG_COUNTER_BASED) {
+         c_buffer >> m_unStream
+                  >> m_unStep
+                  >> m_unCounter;
+         for(SInt32 i = 0; i < PHILOX_BLOCK; ++i) {
+            c_buffer >> m_punBlock[i];
+         }
+      }
+      else {
+         for(SInt32 i = 0; i < N; ++i) {
+            c_buffer >> m_punState[i];
+         }
+      }
+   }
    
    /****************************************/
    /****************************************/
@@ -120,6 +232,49 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CRandom::CRNG::Uniform(Real* pf_out,
+                               size_t un_count,
+                               const CRange<Real>& c_range) {
+      UInt32 punBuffer[BULK_BUFFER];
+      /* Same mapping as INT_RANGE.MapValueIntoRange() */
+      Real fMax = static_cast<Real>(INT_RANGE.GetMax());
+      Real fMin = c_range.GetMin();
+      Real fSpan = c_range.GetSpan();
+      while(un_count > 0) {
+         size_t unChunk = Min(BULK_BUFFER, un_count);
+         Uniform32bit(punBuffer, unChunk);
+         for(size_t i = 0; i < unChunk; ++i) {
+            pf_out[i] = (static_cast<Real>(punBuffer[i]) / fMax) * fSpan + fMin;
+         }
+         pf_out += unChunk;
+         un_count -= unChunk;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CRNG::Uniform(CRadians* pc_out,
+                               size_t un_count,
+                               const CRange<CRadians>& c_range) {
+      UInt32 punBuffer[BULK_BUFFER];
+      Real fMax = static_cast<Real>(INT_RANGE.GetMax());
+      Real fMin = c_range.GetMin().GetValue();
+      Real fSpan = c_range.GetSpan().GetValue();
+      while(un_count > 0) {
+         size_t unChunk = Min(BULK_BUFFER, un_count);
+         Uniform32bit(punBuffer, unChunk);
+         for(size_t i = 0; i < unChunk; ++i) {
+            pc_out[i].SetValue((static_cast<Real>(punBuffer[i]) / fMax) * fSpan + fMin);
+         }
+         pc_out += unChunk;
+         un_count -= unChunk;
+      }
+   }
+   
+   /****************************************/
+   /****************************************/
+
    Real CRandom::CRNG::Exponential(Real f_mean) {
       static CRange<Real> fRange(0.0f, 1.0f);
       return -Log(Uniform(fRange)) * f_mean;
@@ -147,6 +302,38 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CRandom::CRNG::Gaussian(Real* pf_out,
+                                size_t un_count,
+                                Real f_std_dev,
+                                Real f_mean) {
+      /* Box-Muller, cartesian variant as above, but both numbers of
+         each accepted pair are used */
+      UInt32 punBuffer[BULK_BUFFER];
+      Real fMax = static_cast<Real>(INT_RANGE.GetMax());
+      Real fNum1, fNum2, fSquare, fFactor;
+      while(un_count > 0) {
+         /* Draw a pair per missing number, about a fifth of the pairs is rejected */
+         size_t unChunk = Min(BULK_BUFFER, (un_count + 1) & ~static_cast<size_t>(1));
+         Uniform32bit(punBuffer, unChunk);
+         for(size_t i = 0; i < unChunk && un_count > 0; i += 2) {
+            fNum1 = (static_cast<Real>(punBuffer[i])   / fMax) * 2.0f - 1.0f;
+            fNum2 = (static_cast<Real>(punBuffer[i+1]) / fMax) * 2.0f - 1.0f;
+            fSquare = fNum1 * fNum1 + fNum2 * fNum2;
+            if(fSquare >= 1 || fSquare == 0) continue;
+            fFactor = f_std_dev * Sqrt(-2.0f * Log(fSquare) / fSquare);
+            *(pf_out++) = f_mean + fNum1 * fFactor;
+            --un_count;
+            if(un_count > 0) {
+               *(pf_out++) = f_mean + fNum2 * fFactor;
+               --un_count;
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    Real CRandom::CRNG::Rayleigh(Real f_sigma) {
       /* Draw a number uniformly from (0,1) --- bounds excluded */
       static CRange<Real> cUnitRange(0.0f, 1.0f);
@@ -178,24 +365,22 @@ namespace argos {
    /****************************************/
 
    UInt32 CRandom::CRNG::Uniform32bit() {
-      UInt32 y;
-      static UInt32 mag01[2] = { 0x0UL, MATRIX_A };
-      /* mag01[x] = x * MATRIX_A  for x=0,1 */
-      
-      if (m_nIndex >= N) { /* generate N words at one time */
-         SInt32 kk;
-         for (kk = 0; kk < N - M; ++kk) {
-            y = (m_punState[kk] & UPPER_MASK) | (m_punState[kk+1] & LOWER_MASK);
-            m_punState[kk] = m_punState[kk+M] ^ (y >> 1) ^ mag01[y & 0x1UL];
+      if(m_eType == RNG_COUNTER_BASED) {
+         /* A new step starts a new sequence */
+         if(m_punStep != NULL && *m_punStep != m_unStep) {
+            m_unStep = *m_punStep;
+            m_unCounter = 0;
+            m_nIndex = PHILOX_BLOCK;
          }
-         for (; kk < N - 1; ++kk) {
-            y = (m_punState[kk] & UPPER_MASK) | (m_punState[kk+1] & LOWER_MASK);
-            m_punState[kk] = m_punState[kk+(M-N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
+         if(m_nIndex >= PHILOX_BLOCK) {
+            CounterBasedBlock();
+            m_nIndex = 0;
          }
-         y = (m_punState[N-1] & UPPER_MASK) | (m_punState[0] & LOWER_MASK);
-         m_punState[N-1] = m_punState[M-1] ^ (y >> 1) ^ mag01[y & 0x1UL];
-         
-         m_nIndex = 0;
+         return m_punBlock[m_nIndex++];
+      }
+      UInt32 y;
+      if (m_nIndex >= N) { /* generate N words at one time */
+         MersenneTwisterBlock();
       }
       
       y = m_punState[m_nIndex++];
@@ -208,6 +393,106 @@ namespace argos {
       
       return y;
    }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CRNG::Uniform32bit(UInt32* pun_out,
+                                    size_t un_count) {
+      if(m_eType == RNG_COUNTER_BASED) {
+         /* A new step starts a new sequence */
+         if(m_punStep != NULL && *m_punStep != m_unStep) {
+            m_unStep = *m_punStep;
+            m_unCounter = 0;
+            m_nIndex = PHILOX_BLOCK;
+         }
+         while(un_count > 0) {
+            if(m_nIndex >= PHILOX_BLOCK) {
+               CounterBasedBlock();
+               m_nIndex = 0;
+            }
+            size_t unChunk = Min<size_t>(PHILOX_BLOCK - m_nIndex, un_count);
+            ::memcpy(pun_out, m_punBlock + m_nIndex, unChunk * sizeof(UInt32));
+            m_nIndex += unChunk;
+            pun_out += unChunk;
+            un_count -= unChunk;
+         }
+         return;
+      }
+      while(un_count > 0) {
+         if(m_nIndex >= N) {
+            MersenneTwisterBlock();
+         }
+         /* Temper as many words of the state as possible in one go */
+         size_t unChunk = Min<size_t>(N - m_nIndex, un_count);
+         const UInt32* punState = m_punState + m_nIndex;
+         for(size_t i = 0; i < unChunk; ++i) {
+            UInt32 y = punState[i];
+            y ^= (y >> 11);
+            y ^= (y << 7) & 0x9d2c5680UL;
+            y ^= (y << 15) & 0xefc60000UL;
+            y ^= (y >> 18);
+            pun_out[i] = y;
+         }
+         m_nIndex += unChunk;
+         pun_out += unChunk;
+         un_count -= unChunk;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CRNG::MersenneTwisterBlock() {
+      UInt32 y;
+      static UInt32 mag01[2] = { 0x0UL, MATRIX_A };
+      /* mag01[x] = x * MATRIX_A  for x=0,1 */
+      SInt32 kk;
+      for (kk = 0; kk < N - M; ++kk) {
+         y = (m_punState[kk] & UPPER_MASK) | (m_punState[kk+1] & LOWER_MASK);
+         m_punState[kk] = m_punState[kk+M] ^ (y >> 1) ^ mag01[y & 0x1UL];
+      }
+      for (; kk < N - 1; ++kk) {
+         y = (m_punState[kk] & UPPER_MASK) | (m_punState[kk+1] & LOWER_MASK);
+         m_punState[kk] = m_punState[kk+(M-N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
+      }
+      y = (m_punState[N-1] & UPPER_MASK) | (m_punState[0] & LOWER_MASK);
+      m_punState[N-1] = m_punState[M-1] ^ (y >> 1) ^ mag01[y & 0x1UL];
+      m_nIndex = 0;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CRNG::CounterBasedBlock() {
+      /* Philox4x32-10: the counter is (block, step, stream), the key is the seed */
+      m_punBlock[0] = m_unCounter++;
+      m_punBlock[1] = m_unStep;
+      m_punBlock[2] = static_cast<UInt32>(m_unStream);
+      m_punBlock[3] = static_cast<UInt32>(m_unStream >> 32);
+      UInt32 punKey[2] = { m_unSeed, 0 };
+      Philox4x32(m_punBlock, punKey);
+   }
+   
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CRNG::Philox4x32(UInt32* pun_ctr,
+                                  const UInt32* pun_key) {
+      UInt32 punKey[2] = { pun_key[0], pun_key[1] };
+      for(UInt32 r = 0; r < PHILOX_ROUNDS; ++r) {
+         UInt64 unProd0 = static_cast<UInt64>(PHILOX_M0) * pun_ctr[0];
+         UInt64 unProd1 = static_cast<UInt64>(PHILOX_M1) * pun_ctr[2];
+         UInt32 unHi0 = static_cast<UInt32>(unProd0 >> 32);
+         UInt32 unHi1 = static_cast<UInt32>(unProd1 >> 32);
+         pun_ctr[0] = unHi1 ^ pun_ctr[1] ^ punKey[0];
+         pun_ctr[1] = static_cast<UInt32>(unProd1);
+         pun_ctr[2] = unHi0 ^ pun_ctr[3] ^ punKey[1];
+         pun_ctr[3] = static_cast<UInt32>(unProd0);
+         punKey[0] += PHILOX_W0;
+         punKey[1] += PHILOX_W1;
+      }
+   }
    
    /****************************************/
    /****************************************/
@@ -215,6 +500,8 @@ namespace argos {
    CRandom::CCategory::CCategory(const std::string& str_id,
                                  UInt32 un_seed) :
       m_strId(str_id),
+      m_eType(RNG_MERSENNE_TWISTER),
+      m_unStep(0),
       m_unSeed(un_seed),
       m_cSeeder(un_seed),
       m_cSeedRange(1, std::numeric_limits<UInt32>::max()) {}
@@ -241,6 +528,11 @@ namespace argos {
    /****************************************/
 
    CRandom::CRNG* CRandom::CCategory::CreateRNG() {
+      if(m_eType == RNG_COUNTER_BASED) {
+         /* Use the creation order as stream id */
+         m_vecRNGList.push_back(new CRNG(m_unSeed, m_vecRNGList.size(), &m_unStep));
+         return m_vecRNGList.back();
+      }
       /* Get seed from internal RNG */
       UInt32 unSeed = m_cSeeder.Uniform(m_cSeedRange);
       /* Create new RNG */
@@ -251,6 +543,17 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CRandom::CRNG* CRandom::CCategory::CreateRNG(const std::string& str_stream) {
+      if(m_eType == RNG_COUNTER_BASED) {
+         m_vecRNGList.push_back(new CRNG(m_unSeed, HashStream(str_stream), &m_unStep));
+         return m_vecRNGList.back();
+      }
+      return CreateRNG();
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CRandom::CCategory::ResetRNGs() {
       /* Reset internal RNG */
       m_cSeeder.Reset();
@@ -266,8 +569,44 @@ namespace argos {
 
    void CRandom::CCategory::ReseedRNGs() {
       for(size_t i = 0; i < m_vecRNGList.size(); ++i) {
-         /* Get seed from internal RNG */
-         m_vecRNGList[i]->SetSeed(m_cSeeder.Uniform(m_cSeedRange));
+         if(m_vecRNGList[i]->GetType() == RNG_COUNTER_BASED) {
+            /* Counter-based RNGs use the category seed directly */
+            m_vecRNGList[i]->SetSeed(m_unSeed);
+         }
+         else {
+            /* Get seed from internal RNG */
+            m_vecRNGList[i]->SetSeed(m_cSeeder.Uniform(m_cSeedRange));
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CCategory::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_unSeed
+               << m_unStep;
+      m_cSeeder.SaveState(c_buffer);
+      c_buffer << static_cast<UInt32>(m_vecRNGList.size());
+      for(size_t i = 0; i < m_vecRNGList.size(); ++i) {
+         m_vecRNGList[i]->SaveState(c_buffer);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CCategory::LoadState(CByteArray& c_buffer) {
+      c_buffer >> m_unSeed
+               >> m_unStep;
+      m_cSeeder.LoadState(c_buffer);
+      UInt32 unNumRNGs;
+      c_buffer >> unNumRNGs;
+      if(unNumRNGs != m_vecRNGList.size()) {
+         THROW_ARGOSEXCEPTION("Saved state of RNG category \"" << m_strId << "\" has " << unNumRNGs << " RNGs, but the category has " << m_vecRNGList.size());
+      }
+      for(size_t i = 0; i < m_vecRNGList.size(); ++i) {
+         m_vecRNGList[i]->LoadState(c_buffer);
       }
    }
 
@@ -327,6 +666,15 @@ namespace argos {
       CHECK_CATEGORY(str_category);
       return itCategory->second->CreateRNG();
    }
+
+   /****************************************/
+   /****************************************/
+
+   CRandom::CRNG* CRandom::CreateRNG(const std::string& str_category,
+                                     const std::string& str_stream) {
+      CHECK_CATEGORY(str_category);
+      return itCategory->second->CreateRNG(str_stream);
+   }
    
    /****************************************/
    /****************************************/
@@ -359,4 +707,30 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CRandom::SaveState(CByteArray& c_buffer) {
+      c_buffer << static_cast<UInt32>(m_mapCategories.size());
+      for(std::map<std::string, CCategory*>::iterator itCategory = m_mapCategories.begin();
+          itCategory != m_mapCategories.end();
+          ++itCategory) {
+         c_buffer << itCategory->first;
+         itCategory->second->SaveState(c_buffer);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::LoadState(CByteArray& c_buffer) {
+      UInt32 unNumCategories;
+      std::string strCategory;
+      c_buffer >> unNumCategories;
+      for(UInt32 i = 0; i < unNumCategories; ++i) {
+         c_buffer >> strCategory;
+         GetCategory(strCategory).LoadState(c_buffer);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
@@ -15,6 +15,7 @@ namespace argos {
 
 #include <argos3/core/utility/math/angles.h>
 #include <argos3/core/utility/math/range.h>
+#include <argos3/core/utility/configuration/memento.h>
 #include <map>
 
 namespace argos {
@@ -77,17 +78,43 @@ namespace argos {
  * <pre>
  * argos::CRandom::CRNG* m_pcRNG = argos::CRandom::CreateRNG("my_category");
  * </pre>
+ * <p>
+ * By default, the RNGs are Mersenne Twisters, each with its own seed drawn from the
+ * category. The seed of an RNG thus depends on the order in which the RNGs are created.
+ * A category can instead use counter-based RNGs (Philox4x32-10). A counter-based RNG
+ * has no state to speak of: each number is a function of the category seed, the id
+ * of the stream, the simulation step, and the position of the number within the step.
+ * Streams are identified by a string, typically the id of the robot followed by the
+ * name of the device:
+ * </p>
+ * <pre>
+ * argos::CRandom::GetCategory("my_category").SetType(argos::CRandom::RNG_COUNTER_BASED);
+ * argos::CRandom::CRNG* m_pcRNG = argos::CRandom::CreateRNG("my_category", "fb0.proximity");
+ * </pre>
+ * <p>
+ * The numbers drawn by a counter-based RNG do not depend on the creation order of the
+ * RNGs, nor on the number of numbers drawn in the previous steps. The simulator sets
+ * the step of the <tt>argos</tt> category at the beginning of each step.
+ * </p>
 */
    class CRandom {
 
    public:
 
+      /**
+       * The types of RNG.
+       */
+      enum EType {
+         RNG_MERSENNE_TWISTER = 0,
+         RNG_COUNTER_BASED
+      };
+
       /**
        * The RNG.
        * This class is the real random number generator. You need an instance of this class
        * to be able to generate random numbers.
        */
-      class CRNG {
+      class CRNG : public CMemento {
 
       public:
 
@@ -99,6 +126,17 @@ namespace argos {
           */
          CRNG(UInt32 un_seed);
 
+         /**
+          * Class constructor for a counter-based RNG.
+          * To create a new RNG from user code, never use this method. Use CreateRNG() instead.
+          * @param un_seed the seed of the RNG.
+          * @param un_stream the id of the stream.
+          * @param pun_step a pointer to the current step, or <tt>NULL</tt> to stay at step 0.
+          */
+         CRNG(UInt32 un_seed,
+              UInt64 un_stream,
+              const UInt32* pun_step);
+
          /**
           * Class copy constructor.
           * To create a new RNG from user code, never use this method. Use CreateRNG() instead.
@@ -128,12 +166,35 @@ namespace argos {
             m_unSeed = un_seed;
          }
 
+         /**
+          * Returns the type of this RNG.
+          * @return the type of this RNG.
+          */
+         inline EType GetType() const throw() {
+            return m_eType;
+         }
+
          /**
           * Reset the RNG.
           * Reset the RNG to the current seed value.
           */
          void Reset();
 
+         /**
+          * Saves the state of this RNG to the given buffer.
+          * The state includes the seed, so that the RNG can continue
+          * its sequence exactly where it was.
+          * @param c_buffer the target buffer.
+          */
+         virtual void SaveState(CByteArray& c_buffer);
+
+         /**
+          * Restores the state of this RNG from the given buffer.
+          * @param c_buffer the source buffer.
+          * @throws CARGoSException if the saved RNG is of a different type
+          */
+         virtual void LoadState(CByteArray& c_buffer);
+
          /**
           * Returns a random value from a Bernoulli distribution.
           * @param f_true the probability to return a 1.
@@ -168,6 +229,28 @@ namespace argos {
           * @return a random value from the range [min,max).
           */
          UInt32 Uniform(const CRange<UInt32>& c_range);
+
+         /**
+          * Fills a buffer with random values from a uniform distribution.
+          * The values are the same that as many calls to Uniform(const CRange<Real>&) would return.
+          * @param pf_out the buffer to fill.
+          * @param un_count the number of values to draw.
+          * @param c_range the range of values to draw from.
+          */
+         void Uniform(Real* pf_out,
+                      size_t un_count,
+                      const CRange<Real>& c_range);
+
+         /**
+          * Fills a buffer with random values from a uniform distribution.
+          * The values are the same that as many calls to Uniform(const CRange<CRadians>&) would return.
+          * @param pc_out the buffer to fill.
+          * @param un_count the number of values to draw.
+          * @param c_range the range of values to draw from.
+          */
+         void Uniform(CRadians* pc_out,
+                      size_t un_count,
+                      const CRange<CRadians>& c_range);
          
          /**
           * Returns a random value from an exponential distribution.
@@ -183,6 +266,20 @@ namespace argos {
           * @return a random value from the Gaussian distribution.
           */
          Real Gaussian(Real f_std_dev, Real f_mean = 0.0f);
+
+         /**
+          * Fills a buffer with random values from a Gaussian distribution.
+          * Both numbers of each pair generated by the Box-Muller method are used, so the values
+          * differ from those that as many calls to Gaussian(Real,Real) would return.
+          * @param pf_out the buffer to fill.
+          * @param un_count the number of values to draw.
+          * @param f_std_dev the standard deviation of the Gaussian distribution.
+          * @param f_mean the mean of the Gaussian distribution.
+          */
+         void Gaussian(Real* pf_out,
+                       size_t un_count,
+                       Real f_std_dev,
+                       Real f_mean = 0.0f);
          
          /**
           * Returns a random value from a Rayleigh distribution.
@@ -199,6 +296,16 @@ namespace argos {
           */
          Real Lognormal(Real f_sigma, Real f_mu);
 
+         /**
+          * Applies the Philox4x32-10 function to the given counter.
+          * This is the block function of the counter-based RNG. It is
+          * exposed to check it against the published known-answer vectors.
+          * @param pun_ctr the counter, which is overwritten with the output.
+          * @param pun_key the key.
+          */
+         static void Philox4x32(UInt32* pun_ctr,
+                                const UInt32* pun_key);
+
       private:
 
          /*
@@ -207,19 +314,44 @@ namespace argos {
           */
          UInt32 Uniform32bit();
 
+         /*
+          * Fills a buffer with random 32bit unsigned integers.
+          * Used internally by the bulk functions.
+          */
+         void Uniform32bit(UInt32* pun_out,
+                           size_t un_count);
+
+         /*
+          * Regenerates the state of a Mersenne Twister.
+          */
+         void MersenneTwisterBlock();
+
+         /*
+          * Fills the output block of a counter-based RNG.
+          */
+         void CounterBasedBlock();
+
       private:
 
+         EType m_eType;
          UInt32 m_unSeed;
          UInt32* m_punState;
          SInt32 m_nIndex;
 
+         /* Counter-based RNG: stream id, current step and counter within the step */
+         UInt64 m_unStream;
+         const UInt32* m_punStep;
+         UInt32 m_unStep;
+         UInt32 m_unCounter;
+         UInt32 m_punBlock[4];
+
       };
 
       /**
        * The RNG category.
        * This class stores a specific category of RNGs.
        */
-      class CCategory {
+      class CCategory : public CMemento {
 
       public:
 
@@ -266,12 +398,58 @@ namespace argos {
           */
          void SetSeed(UInt32 un_seed);
 
+         /**
+          * Returns the type of the RNGs created in this category.
+          * @return the type of the RNGs created in this category.
+          */
+         inline EType GetType() const {
+            return m_eType;
+         }
+
+         /**
+          * Sets the type of the RNGs created in this category.
+          * The RNGs created before the call keep their type.
+          * @param e_type the type of the RNGs created in this category.
+          */
+         inline void SetType(EType e_type) {
+            m_eType = e_type;
+         }
+
+         /**
+          * Returns the current step of this category.
+          * @return the current step of this category.
+          */
+         inline UInt32 GetStep() const {
+            return m_unStep;
+         }
+
+         /**
+          * Sets the current step of this category.
+          * The counter-based RNGs of this category start a new sequence of numbers
+          * when the step changes.
+          * @param un_step the current step of this category.
+          */
+         inline void SetStep(UInt32 un_step) {
+            m_unStep = un_step;
+         }
+
          /**
           * Creates a new RNG inside this category.
+          * A counter-based RNG is identified by its creation order.
           * @return the pointer to a new RNG inside this category.
           */
          CRNG* CreateRNG();
 
+         /**
+          * Creates a new RNG inside this category.
+          * A counter-based RNG is identified by the given stream id, and the
+          * numbers it draws do not depend on the creation order.
+          * A Mersenne Twister ignores the stream id.
+          * @param str_stream the id of the stream.
+          * @return the pointer to a new RNG inside this category.
+          */
+         CRNG* CreateRNG(const std::string& str_stream);
+
          /**
           * Resets the RNGs in this category.
           */
@@ -284,10 +462,26 @@ namespace argos {
           */
          void ReseedRNGs();
 
+         /**
+          * Saves the state of this category and of all its RNGs.
+          * @param c_buffer the target buffer.
+          */
+         virtual void SaveState(CByteArray& c_buffer);
+
+         /**
+          * Restores the state of this category and of all its RNGs.
+          * The RNGs are matched by creation order.
+          * @param c_buffer the source buffer.
+          * @throws CARGoSException if the number of RNGs does not match
+          */
+         virtual void LoadState(CByteArray& c_buffer);
+
       private:
 
          std::string m_strId;
          std::vector<CRNG*> m_vecRNGList;
+         EType m_eType;
+         UInt32 m_unStep;
          UInt32 m_unSeed;
          CRNG m_cSeeder;
          CRange<UInt32> m_cSeedRange;
@@ -330,6 +524,16 @@ namespace argos {
        */
       static CRNG* CreateRNG(const std::string& str_category);
 
+      /**
+       * Creates a new RNG inside the given category, with the given stream id.
+       * @param str_category the id of the category.
+       * @param str_stream the id of the stream.
+       * @return the pointer to a new RNG inside this category.
+       * @see CCategory::CreateRNG(const std::string&)
+       */
+      static CRNG* CreateRNG(const std::string& str_category,
+                             const std::string& str_stream);
+
       /**
        * Returns the seed of the wanted category.
        * @param str_category the id of the category.
@@ -352,6 +556,20 @@ namespace argos {
        */
       static void Reset();
 
+      /**
+       * Saves the state of all the RNG categories.
+       * @param c_buffer the target buffer.
+       */
+      static void SaveState(CByteArray& c_buffer);
+
+      /**
+       * Restores the state of the RNG categories.
+       * Each saved category must exist already.
+       * @param c_buffer the source buffer.
+       * @throws CARGoSException if a saved category does not exist or does not match
+       */
+      static void LoadState(CByteArray& c_buffer);
+
    private:
 
       static std::map<std::string, CCategory*> m_mapCategories;
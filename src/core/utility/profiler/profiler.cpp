@@ -7,6 +7,9 @@
 #include "profiler.h"
 #include <argos3/core/utility/logging/argos_log.h>
 #include <argos3/core/utility/configuration/argos_configuration.h>
+#include <algorithm>
+#include <cmath>
+#include <time.h>
 
 namespace argos {
 
@@ -113,8 +116,74 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * Range and resolution of the phase histograms: bin i covers part of
+    * [2^(e-1),2^e) seconds, for e between PHASE_MIN_EXP and PHASE_MAX_EXP,
+    * that is from about 1 ns to 256 s. Samples out of range are counted in
+    * the first or last bin.
+    */
+   static const int PHASE_MIN_EXP = -29;
+   static const int PHASE_MAX_EXP = 8;
+   static const size_t PHASE_SUB_BINS = 64;
+   static const size_t PHASE_BINS = (PHASE_MAX_EXP - PHASE_MIN_EXP + 1) * PHASE_SUB_BINS;
+
+   CProfiler::SPhase::SPhase(const std::string& str_name) :
+      Name(str_name),
+      Samples(0),
+      Min(0.0),
+      Max(0.0),
+      Sum(0.0),
+      Bins(PHASE_BINS, 0) {}
+
+   /****************************************/
+   /****************************************/
+
+   void CProfiler::SPhase::AddSample(double f_duration) {
+      if(Samples == 0 || f_duration < Min) Min = f_duration;
+      if(Samples == 0 || f_duration > Max) Max = f_duration;
+      ++Samples;
+      Sum += f_duration;
+      /* f_duration = fMantissa * 2^nExp, with fMantissa in [0.5,1) */
+      int nExp;
+      double fMantissa = std::frexp(f_duration, &nExp);
+      size_t unBin;
+      if(f_duration <= 0.0 || nExp < PHASE_MIN_EXP) {
+         unBin = 0;
+      }
+      else if(nExp > PHASE_MAX_EXP) {
+         unBin = PHASE_BINS - 1;
+      }
+      else {
+         unBin = (nExp - PHASE_MIN_EXP) * PHASE_SUB_BINS +
+            static_cast<size_t>((fMantissa - 0.5) * 2.0 * PHASE_SUB_BINS);
+      }
+      ++Bins[unBin];
+   }
+
+   /****************************************/
+   /****************************************/
+
+   double CProfiler::SPhase::Percentile(double f_fraction) const {
+      if(Samples == 0) return 0.0;
+      size_t unRank = static_cast<size_t>(std::ceil(f_fraction * Samples));
+      if(unRank == 0) unRank = 1;
+      size_t unBin = 0, unCount = Bins[0];
+      while(unCount < unRank) {
+         unCount += Bins[++unBin];
+      }
+      /* Take the middle of the bin, within the observed range */
+      int nExp = static_cast<int>(unBin / PHASE_SUB_BINS) + PHASE_MIN_EXP;
+      double fSub = static_cast<double>(unBin % PHASE_SUB_BINS) + 0.5;
+      double fValue = std::ldexp(0.5 + fSub / (2.0 * PHASE_SUB_BINS), nExp);
+      return std::max(std::min(fValue, Max), Min);
+   }
+
+   /****************************************/
+   /****************************************/
+
    CProfiler::CProfiler(const std::string& str_file_name,
-                        bool b_trunc) {
+                        bool b_trunc) :
+      m_bDeviceTiming(false) {
       if(b_trunc) {
          m_cOutFile.open(str_file_name.c_str(),
                          std::ios::trunc | std::ios::out);
@@ -186,6 +255,53 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   size_t CProfiler::AddPhase(const std::string& str_name) {
+      m_vecPhases.push_back(SPhase(str_name));
+      return m_vecPhases.size() - 1;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CProfiler::AddSensorTime(const std::string& str_type,
+                                 double f_time,
+                                 size_t un_calls) {
+      SDeviceTime& sTime = m_mapSensorTimes[str_type];
+      sTime.Time += f_time;
+      sTime.Calls += un_calls;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CProfiler::AddActuatorTime(const std::string& str_type,
+                                   double f_time,
+                                   size_t un_calls) {
+      SDeviceTime& sTime = m_mapActuatorTimes[str_type];
+      sTime.Time += f_time;
+      sTime.Calls += un_calls;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   double CProfiler::GetTimeStamp() {
+#ifdef __APPLE__
+      ::timeval tTime;
+      ::gettimeofday(&tTime, NULL);
+      return TV2Sec(tTime);
+#else
+      ::timespec tTime;
+      ::clock_gettime(CLOCK_MONOTONIC, &tTime);
+      return
+         static_cast<double>(tTime.tv_sec) +
+         static_cast<double>(tTime.tv_nsec) * 1e-9;
+#endif
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CProfiler::FlushHumanReadable() {
       m_cOutFile << "[profiled portion overall]" << std::endl << std::endl;
       double fStartTime = TV2Sec(m_tWallClockStart);
@@ -214,6 +330,17 @@ namespace argos {
             DumpResourceUsageHumanReadable(m_cOutFile, m_vecThreadResourceUsage[i]);
          }
       }
+      for(size_t i = 0; i < m_vecPhases.size(); ++i) {
+         const SPhase& sPhase = m_vecPhases[i];
+         m_cOutFile << std::endl << "[step phase " << sPhase.Name << "]" << std::endl << std::endl;
+         m_cOutFile << "Samples: " << sPhase.Samples << std::endl;
+         m_cOutFile << "Min time (s): " << sPhase.Min << std::endl;
+         m_cOutFile << "Mean time (s): " << (sPhase.Samples > 0 ? sPhase.Sum / sPhase.Samples : 0.0) << std::endl;
+         m_cOutFile << "Median time (s): " << sPhase.Percentile(0.50) << std::endl;
+         m_cOutFile << "99th percentile time (s): " << sPhase.Percentile(0.99) << std::endl;
+      }
+      FlushDeviceTimesHumanReadable("sensor", m_mapSensorTimes);
+      FlushDeviceTimesHumanReadable("actuator", m_mapActuatorTimes);
    }
 
    /****************************************/
@@ -246,12 +373,59 @@ namespace argos {
             DumpResourceUsageAsTableRow(m_cOutFile, m_vecThreadResourceUsage[i]);
          }
       }
+      if(! m_vecPhases.empty()) {
+         m_cOutFile << std::endl << "# phase_NAME samples min_s mean_s p50_s p99_s";
+      }
+      for(size_t i = 0; i < m_vecPhases.size(); ++i) {
+         const SPhase& sPhase = m_vecPhases[i];
+         m_cOutFile << std::endl << "phase_" << sPhase.Name << " "
+                    << sPhase.Samples << " "
+                    << sPhase.Min << " "
+                    << (sPhase.Samples > 0 ? sPhase.Sum / sPhase.Samples : 0.0) << " "
+                    << sPhase.Percentile(0.50) << " "
+                    << sPhase.Percentile(0.99);
+      }
+      if(! m_mapSensorTimes.empty() || ! m_mapActuatorTimes.empty()) {
+         m_cOutFile << std::endl << "# KIND_TYPE calls total_s mean_s";
+      }
+      FlushDeviceTimesAsTable("sensor", m_mapSensorTimes);
+      FlushDeviceTimesAsTable("actuator", m_mapActuatorTimes);
       m_cOutFile << std::endl;
    }
 
    /****************************************/
    /****************************************/
 
+   void CProfiler::FlushDeviceTimesHumanReadable(const std::string& str_kind,
+                                                 const TDeviceTimeMap& t_times) {
+      for(TDeviceTimeMap::const_iterator it = t_times.begin();
+          it != t_times.end(); ++it) {
+         m_cOutFile << std::endl << "[" << str_kind << " " << it->first << "]" << std::endl << std::endl;
+         m_cOutFile << "Calls: " << it->second.Calls << std::endl;
+         m_cOutFile << "Total time (s): " << it->second.Time << std::endl;
+         m_cOutFile << "Mean time (s): "
+                    << (it->second.Calls > 0 ? it->second.Time / it->second.Calls : 0.0)
+                    << std::endl;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CProfiler::FlushDeviceTimesAsTable(const std::string& str_kind,
+                                           const TDeviceTimeMap& t_times) {
+      for(TDeviceTimeMap::const_iterator it = t_times.begin();
+          it != t_times.end(); ++it) {
+         m_cOutFile << std::endl << str_kind << "_" << it->first << " "
+                    << it->second.Calls << " "
+                    << it->second.Time << " "
+                    << (it->second.Calls > 0 ? it->second.Time / it->second.Calls : 0.0);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CProfiler::StartWallClock() {
       ::gettimeofday(&m_tWallClockStart, NULL);
    }
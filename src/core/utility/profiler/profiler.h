@@ -14,6 +14,7 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <map>
 
 namespace argos {
 
@@ -30,6 +31,67 @@ namespace argos {
       void Flush(bool b_human_readable);
       void CollectThreadResourceUsage();
 
+      /**
+       * Adds a phase to the per-step timing.
+       * Phases must be added before the first sample is recorded.
+       * @param str_name The name of the phase, as it appears in the profile.
+       * @return The index of the phase, to pass to AddPhaseSample().
+       */
+      size_t AddPhase(const std::string& str_name);
+
+      /**
+       * Records how long a phase took in the current step.
+       * Different threads may record samples concurrently, as long as
+       * they record them for different phases.
+       * @param un_phase The index of the phase, as returned by AddPhase().
+       * @param f_duration The duration of the phase, in seconds.
+       */
+      inline void AddPhaseSample(size_t un_phase,
+                                 double f_duration) {
+         m_vecPhases[un_phase].AddSample(f_duration);
+      }
+
+      /**
+       * Returns <tt>true</tt> if sensors and actuators are timed.
+       */
+      inline bool IsDeviceTiming() const {
+         return m_bDeviceTiming;
+      }
+
+      /**
+       * Sets whether sensors and actuators are timed.
+       * @param b_device_timing <tt>true</tt> to time sensors and actuators.
+       */
+      inline void SetDeviceTiming(bool b_device_timing) {
+         m_bDeviceTiming = b_device_timing;
+      }
+
+      /**
+       * Adds the time spent updating a sensor implementation.
+       * @param str_type The sensor type, such as <tt>proximity/default</tt>.
+       * @param f_time The time spent in the sensor updates, in seconds.
+       * @param un_calls The number of sensor updates.
+       */
+      void AddSensorTime(const std::string& str_type,
+                         double f_time,
+                         size_t un_calls);
+
+      /**
+       * Adds the time spent updating an actuator implementation.
+       * @param str_type The actuator type, such as <tt>differential_steering/default</tt>.
+       * @param f_time The time spent in the actuator updates, in seconds.
+       * @param un_calls The number of actuator updates.
+       */
+      void AddActuatorTime(const std::string& str_type,
+                           double f_time,
+                           size_t un_calls);
+
+      /**
+       * Returns a monotonic time stamp, in seconds.
+       * Use the difference between two time stamps as phase sample.
+       */
+      static double GetTimeStamp();
+
    private:
 
       void StartWallClock();
@@ -41,6 +103,46 @@ namespace argos {
       void FlushHumanReadable();
       void FlushAsTable();
 
+   private:
+
+      /*
+       * The samples of a phase are counted in a histogram with logarithmic
+       * bins, so that the memory does not grow with the experiment length.
+       * Each power of two is split into PHASE_SUB_BINS bins, which bounds
+       * the relative error of the percentiles to 1/PHASE_SUB_BINS.
+       */
+      struct SPhase {
+         std::string Name;
+         size_t Samples;
+         double Min;
+         double Max;
+         double Sum;
+         std::vector<size_t> Bins;
+
+         SPhase(const std::string& str_name);
+
+         void AddSample(double f_duration);
+
+         /* Nearest-rank percentile, in seconds */
+         double Percentile(double f_fraction) const;
+      };
+
+      struct SDeviceTime {
+         double Time;
+         size_t Calls;
+
+         SDeviceTime() :
+            Time(0.0),
+            Calls(0) {}
+      };
+
+      typedef std::map<std::string, SDeviceTime> TDeviceTimeMap;
+
+      void FlushDeviceTimesHumanReadable(const std::string& str_kind,
+                                         const TDeviceTimeMap& t_times);
+      void FlushDeviceTimesAsTable(const std::string& str_kind,
+                                   const TDeviceTimeMap& t_times);
+
    private:
 
       std::ofstream m_cOutFile;
@@ -50,6 +152,10 @@ namespace argos {
       ::rusage m_tResourceUsageEnd;
       std::vector< ::rusage > m_vecThreadResourceUsage;
       pthread_mutex_t m_tThreadResourceUsageMutex;
+      std::vector<SPhase> m_vecPhases;
+      bool m_bDeviceTiming;
+      TDeviceTimeMap m_mapSensorTimes;
+      TDeviceTimeMap m_mapActuatorTimes;
 
    };
 
@@ -33,7 +33,7 @@ namespace argos {
    void CLuaController::Init(TConfigurationNode& t_tree) {
       try {
          /* Create RNG */
-         m_pcRNG = CRandom::CreateRNG("argos");
+         m_pcRNG = CRandom::CreateRNG("argos", GetId() + ".lua");
          /* Load script */
          std::string strScriptFileName;
          GetNodeAttributeOrDefault(t_tree, "script", strScriptFileName, strScriptFileName);
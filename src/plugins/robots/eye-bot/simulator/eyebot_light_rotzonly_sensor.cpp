@@ -89,9 +89,12 @@ namespace argos {
          else if(fNoiseLevel > 0.0f) {
             m_bAddNoise = true;
             m_cNoiseRange.Set(-fNoiseLevel, fNoiseLevel);
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcEmbodiedEntity->GetRootEntity().GetId() + ".eyebot_light");
          }
          m_tReadings.resize(m_pcLightEntity->GetNumSensors());
+         if(m_bAddNoise) {
+            m_vecNoise.resize(m_tReadings.size());
+         }
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Initialization error in rot_z_only light sensor", ex);
@@ -136,9 +139,8 @@ namespace argos {
             /* Set the ray end */
             cOcclusionCheckRay.SetEnd(cLight.GetPosition());
             /* Check occlusion between the eye-bot and the light */
-            if(! GetClosestEmbodiedEntityIntersectedByRay(sIntersection,
-                                                          cOcclusionCheckRay,
-                                                          *m_pcEmbodiedEntity)) {
+            if(! IsSegmentOccluded(cOcclusionCheckRay,
+                                   m_pcEmbodiedEntity)) {
                /* The light is not occluded */
                if(m_bShowRays) {
                   m_pcControllableEntity->AddCheckedRay(false, cOcclusionCheckRay);
@@ -182,6 +184,10 @@ namespace argos {
             else {
                /* The ray is occluded */
                if(m_bShowRays) {
+                  /* The intersection point is needed only to draw it */
+                  GetClosestEmbodiedEntityIntersectedByRay(sIntersection,
+                                                           cOcclusionCheckRay,
+                                                           *m_pcEmbodiedEntity);
                   m_pcControllableEntity->AddCheckedRay(true, cOcclusionCheckRay);
                   m_pcControllableEntity->AddIntersectionPoint(cOcclusionCheckRay, sIntersection.TOnRay);
                }
@@ -190,8 +196,9 @@ namespace argos {
       }
       /* Apply noise to the sensors */
       if(m_bAddNoise) {
+         m_pcRNG->Uniform(&m_vecNoise[0], m_vecNoise.size(), m_cNoiseRange);
          for(size_t i = 0; i < 24; ++i) {
-            m_tReadings[i].Value += m_pcRNG->Uniform(m_cNoiseRange);
+            m_tReadings[i].Value += m_vecNoise[i];
          }
       }
       /* Trunc the reading between 0 and 1 */
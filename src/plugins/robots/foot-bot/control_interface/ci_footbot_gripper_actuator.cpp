@@ -119,4 +119,20 @@ namespace argos {
   /****************************************/
   /****************************************/
 
+   void CCI_FootBotGripperActuator::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_cAperture.GetValue();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CCI_FootBotGripperActuator::LoadState(CByteArray& c_buffer) {
+      Real fAperture;
+      c_buffer >> fAperture;
+      m_cAperture.SetValue(fAperture);
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
@@ -199,11 +199,16 @@ namespace argos {
    /****************************************/
 
    void CDynamics2DFootBotModel::CalculateBoundingBox() {
-      GetBoundingBox().MinCorner.SetX(m_ptBaseShape->bb.l);
-      GetBoundingBox().MinCorner.SetY(m_ptBaseShape->bb.b);
+      /* The tip of the gripper sticks out of the base */
+      cpBB tBoundingBox = m_ptBaseShape->bb;
+      if(m_pcGripper != NULL) {
+         tBoundingBox = cpBBMerge(tBoundingBox, m_pcGripper->GripperShape()->bb);
+      }
+      GetBoundingBox().MinCorner.SetX(tBoundingBox.l);
+      GetBoundingBox().MinCorner.SetY(tBoundingBox.b);
       GetBoundingBox().MinCorner.SetZ(GetDynamics2DEngine().GetElevation());
-      GetBoundingBox().MaxCorner.SetX(m_ptBaseShape->bb.r);
-      GetBoundingBox().MaxCorner.SetY(m_ptBaseShape->bb.t);
+      GetBoundingBox().MaxCorner.SetX(tBoundingBox.r);
+      GetBoundingBox().MaxCorner.SetY(tBoundingBox.t);
       GetBoundingBox().MaxCorner.SetZ(GetDynamics2DEngine().GetElevation() + FOOTBOT_HEIGHT);
    }
 
@@ -297,6 +302,47 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CDynamics2DFootBotModel::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_unLastTurretMode
+               << m_fPreviousTurretAngleError;
+      CDynamics2DMultiBodyObjectModel::SaveState(c_buffer);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DFootBotModel::LoadState(CByteArray& c_buffer) {
+      /* Grips are re-established at the next contact */
+      m_pcGripper->Release();
+      m_pcGrippable->ReleaseAll();
+      /* Switch the turret constraints to the saved mode */
+      UInt8 unTurretMode;
+      c_buffer >> unTurretMode
+               >> m_fPreviousTurretAngleError;
+      bool bWasActive =
+         m_unLastTurretMode == MODE_SPEED_CONTROL ||
+         m_unLastTurretMode == MODE_POSITION_CONTROL;
+      bool bIsActive =
+         unTurretMode == MODE_SPEED_CONTROL ||
+         unTurretMode == MODE_POSITION_CONTROL;
+      if(!bWasActive && bIsActive) TurretPassiveToActive();
+      if(bWasActive && !bIsActive) TurretActiveToPassive();
+      if(unTurretMode != m_unLastTurretMode) {
+         if(unTurretMode != MODE_OFF) {
+            GetEmbodiedEntity().EnableAnchor("turret");
+         }
+         else {
+            GetEmbodiedEntity().DisableAnchor("turret");
+         }
+         m_unLastTurretMode = unTurretMode;
+      }
+      /* Restore the bodies */
+      CDynamics2DMultiBodyObjectModel::LoadState(c_buffer);
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CDynamics2DFootBotModel::TurretPassiveToActive() {
       /* Delete constraints to actual base body */
       cpSpaceRemoveConstraint(GetDynamics2DEngine().GetPhysicsSpace(), m_ptBaseGripperAngularMotion);
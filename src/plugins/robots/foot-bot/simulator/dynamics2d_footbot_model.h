@@ -36,6 +36,10 @@ namespace argos {
 
       virtual void UpdateFromEntityStatus();
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
       void UpdateOriginAnchor(SAnchor& s_anchor);
 
       void UpdateTurretAnchor(SAnchor& s_anchor);
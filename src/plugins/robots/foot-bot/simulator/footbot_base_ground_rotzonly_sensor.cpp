@@ -55,9 +55,12 @@ namespace argos {
          else if(fNoiseLevel > 0.0f) {
             m_bAddNoise = true;
             m_cNoiseRange.Set(-fNoiseLevel, fNoiseLevel);
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcEmbodiedEntity->GetRootEntity().GetId() + ".footbot_base_ground");
          }
          m_tReadings.resize(8);
+         if(m_bAddNoise) {
+            m_vecNoise.resize(m_tReadings.size());
+         }
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Initialization error in foot-bot rotzonly ground sensor", ex);
@@ -80,6 +83,10 @@ namespace argos {
       CVector2 cCenterPos(cEntityPos.GetX(), cEntityPos.GetY());
       /* Position of sensor on the ground after rototranslation */
       CVector2 cSensorPos;
+      /* Draw the noise of all the sensors at once */
+      if(m_bAddNoise && !m_vecNoise.empty()) {
+         m_pcRNG->Uniform(&m_vecNoise[0], m_vecNoise.size(), m_cNoiseRange);
+      }
       /* Go through the sensors */
       for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
          /* Calculate sensor position on the ground */
@@ -93,7 +100,7 @@ namespace argos {
          m_tReadings[i].Value = cColor.ToGrayScale() / 255.0f;
          /* Apply noise to the sensor */
          if(m_bAddNoise) {
-            m_tReadings[i].Value += m_pcRNG->Uniform(m_cNoiseRange);
+            m_tReadings[i].Value += m_vecNoise[i];
          }
          /* Set the final reading */
          m_tReadings[i].Value = m_tReadings[i].Value < 0.5f ? 0.0f : 1.0f;
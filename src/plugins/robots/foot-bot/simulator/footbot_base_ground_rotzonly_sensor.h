@@ -9,6 +9,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace argos {
    class CFootBotBaseGroundRotZOnlySensor;
@@ -61,6 +62,9 @@ namespace argos {
       /** Noise range */
       CRange<Real> m_cNoiseRange;
 
+      /** The noise of the current step, one per sensor */
+      std::vector<Real> m_vecNoise;
+
       /** Reference to the space */
       CSpace& m_cSpace;
    };
@@ -80,6 +80,24 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CFootBotDistanceScannerDefaultActuator::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_cDesiredRotation.GetValue()
+               << m_fDesiredRotationSpeed
+               << m_unDesiredMode;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFootBotDistanceScannerDefaultActuator::LoadState(CByteArray& c_buffer) {
+      Real fRotation;
+      c_buffer >> fRotation >> m_fDesiredRotationSpeed >> m_unDesiredMode;
+      m_cDesiredRotation.SetValue(fRotation);
+   }
+
+   /****************************************/
+   /****************************************/
+
    REGISTER_ACTUATOR(CFootBotDistanceScannerDefaultActuator,
                      "footbot_distance_scanner", "default",
                      "Carlo Pinciroli [ilpincy@gmail.com]",
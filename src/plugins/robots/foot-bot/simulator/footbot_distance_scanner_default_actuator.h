@@ -42,6 +42,10 @@ namespace argos {
       virtual void Update();
       virtual void Reset();
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
    private:
 
       CFootBotDistanceScannerEquippedEntity* m_pcDistanceScannerEquippedEntity;
@@ -43,6 +43,26 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CFootBotDistanceScannerEquippedEntity::SaveState(CByteArray& c_buffer) {
+      CEntity::SaveState(c_buffer);
+      c_buffer << m_unMode
+               << m_cRotation.GetValue()
+               << m_fRotationSpeed;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFootBotDistanceScannerEquippedEntity::LoadState(CByteArray& c_buffer) {
+      CEntity::LoadState(c_buffer);
+      Real fRotation;
+      c_buffer >> m_unMode >> fRotation >> m_fRotationSpeed;
+      m_cRotation.SetValue(fRotation);
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CFootBotDistanceScannerEquippedEntity::Update() {
       if(m_unMode == MODE_SPEED_CONTROL &&
          m_fRotationSpeed != 0.0f) {
@@ -48,7 +48,7 @@ namespace argos {
          GetNodeAttributeOrDefault(t_tree, "noise_range", m_cNoiseRange, m_cNoiseRange);
          if(m_cNoiseRange.GetSpan() > 0.0f) {
             m_bAddNoise = true;
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcEmbodiedEntity->GetRootEntity().GetId() + ".footbot_distance_scanner");
          }
       }
       catch(CARGoSException& ex) {
@@ -113,6 +113,22 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CFootBotDistanceScannerRotZOnlySensor::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_cLastDistScanRotation.GetValue();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFootBotDistanceScannerRotZOnlySensor::LoadState(CByteArray& c_buffer) {
+      Real fRotation;
+      c_buffer >> fRotation;
+      m_cLastDistScanRotation.SetValue(fRotation);
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CFootBotDistanceScannerRotZOnlySensor::UpdateNotRotating() {
       /* Short range [0] */
       CRadians cAngle = m_cLastDistScanRotation;
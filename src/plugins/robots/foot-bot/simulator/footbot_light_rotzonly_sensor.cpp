@@ -9,6 +9,7 @@
 #include <argos3/core/simulator/entity/composable_entity.h>
 #include <argos3/plugins/simulator/entities/light_entity.h>
 #include <argos3/plugins/simulator/entities/light_sensor_equipped_entity.h>
+#include <argos3/plugins/simulator/media/light_medium.h>
 
 #include "footbot_light_rotzonly_sensor.h"
 
@@ -20,6 +21,7 @@ namespace argos {
    static CRange<Real> SENSOR_RANGE(0.0f, 1.0f);
    static CRadians SENSOR_SPACING      = CRadians(ARGOS_PI / 12.0f);
    static CRadians SENSOR_HALF_SPACING = SENSOR_SPACING * 0.5;
+   static Real     SENSOR_MAX_DISTANCE = 2.5f;
 
    /****************************************/
    /****************************************/
@@ -31,7 +33,7 @@ namespace argos {
    }
 
    static Real ComputeReading(Real f_distance) {
-      if(f_distance > 2.5f) {
+      if(f_distance > SENSOR_MAX_DISTANCE) {
          return 0.0f;
       }
       else {
@@ -56,7 +58,8 @@ namespace argos {
       m_bShowRays(false),
       m_pcRNG(NULL),
       m_bAddNoise(false),
-      m_cSpace(CSimulator::GetInstance().GetSpace()) {}
+      m_cSpace(CSimulator::GetInstance().GetSpace()),
+      m_pcLightMedium(NULL) {}
 
    /****************************************/
    /****************************************/
@@ -89,9 +92,18 @@ namespace argos {
          else if(fNoiseLevel > 0.0f) {
             m_bAddNoise = true;
             m_cNoiseRange.Set(-fNoiseLevel, fNoiseLevel);
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcEmbodiedEntity->GetRootEntity().GetId() + ".footbot_light");
+         }
+         /* Get light medium from id specified in the XML, if any */
+         if(NodeAttributeExists(t_tree, "medium")) {
+            std::string strMedium;
+            GetNodeAttribute(t_tree, "medium", strMedium);
+            m_pcLightMedium = &(CSimulator::GetInstance().GetMedium<CLightMedium>(strMedium));
          }
          m_tReadings.resize(m_pcLightEntity->GetNumSensors());
+         if(m_bAddNoise) {
+            m_vecNoise.resize(m_tReadings.size());
+         }
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Initialization error in rot_z_only light sensor", ex);
@@ -118,7 +130,20 @@ namespace argos {
       /* Buffers to contain data about the intersection */
       SEmbodiedEntityIntersectionItem sIntersection;
       /* List of light entities */
-      CSpace::TMapPerType& mapLights = m_cSpace.GetEntitiesByType("light");
+      const std::vector<CLightEntity*>* pvecLights;
+      if(m_pcLightMedium != NULL) {
+         pvecLights = &m_pcLightMedium->GetLights();
+      }
+      else {
+         m_vecLights.clear();
+         CSpace::TMapPerType& mapLights = m_cSpace.GetEntitiesByType("light");
+         for(CSpace::TMapPerType::iterator it = mapLights.begin();
+             it != mapLights.end();
+             ++it) {
+            m_vecLights.push_back(any_cast<CLightEntity*>(it->second));
+         }
+         pvecLights = &m_vecLights;
+      }
       /*
        * 1. go through the list of light entities in the scene
        * 2. check if a light is occluded
@@ -126,19 +151,21 @@ namespace argos {
        *    NOTE: the readings are additive
        * 4. go through the sensors and clamp their values
        */
-      for(CSpace::TMapPerType::iterator it = mapLights.begin();
-          it != mapLights.end();
-          ++it) {
+      for(size_t j = 0; j < pvecLights->size(); ++j) {
          /* Get a reference to the light */
-         CLightEntity& cLight = *(any_cast<CLightEntity*>(it->second));
+         CLightEntity& cLight = *(*pvecLights)[j];
          /* Consider the light only if it has non zero intensity */
          if(cLight.GetIntensity() > 0.0f) {
+            /* Skip the light if it is too far to be perceived */
+            if(SquareDistance(cOcclusionCheckRay.GetStart(), cLight.GetPosition()) >
+               Square(SENSOR_MAX_DISTANCE * cLight.GetIntensity())) {
+               continue;
+            }
             /* Set the ray end */
             cOcclusionCheckRay.SetEnd(cLight.GetPosition());
             /* Check occlusion between the foot-bot and the light */
-            if(! GetClosestEmbodiedEntityIntersectedByRay(sIntersection,
-                                                          cOcclusionCheckRay,
-                                                          *m_pcEmbodiedEntity)) {
+            if(! IsSegmentOccluded(cOcclusionCheckRay,
+                                   m_pcEmbodiedEntity)) {
                /* The light is not occluded */
                if(m_bShowRays) {
                   m_pcControllableEntity->AddCheckedRay(false, cOcclusionCheckRay);
@@ -182,6 +209,10 @@ namespace argos {
             else {
                /* The ray is occluded */
                if(m_bShowRays) {
+                  /* The intersection point is needed only to draw it */
+                  GetClosestEmbodiedEntityIntersectedByRay(sIntersection,
+                                                           cOcclusionCheckRay,
+                                                           *m_pcEmbodiedEntity);
                   m_pcControllableEntity->AddCheckedRay(true, cOcclusionCheckRay);
                   m_pcControllableEntity->AddIntersectionPoint(cOcclusionCheckRay, sIntersection.TOnRay);
                }
@@ -190,8 +221,9 @@ namespace argos {
       }
       /* Apply noise to the sensors */
       if(m_bAddNoise) {
+         m_pcRNG->Uniform(&m_vecNoise[0], m_vecNoise.size(), m_cNoiseRange);
          for(size_t i = 0; i < 24; ++i) {
-            m_tReadings[i].Value += m_pcRNG->Uniform(m_cNoiseRange);
+            m_tReadings[i].Value += m_vecNoise[i];
          }
       }
       /* Trunc the reading between 0 and 1 */
@@ -283,8 +315,24 @@ namespace argos {
                    "    </my_controller>\n"
                    "    ...\n"
                    "  </controllers>\n\n"
-                   "OPTIONAL XML CONFIGURATION\n\n"
-                   "None.\n",
+                   "By default, the sensor looks for the lights among all the entities in the\n"
+                   "space at every step. When the arena contains many lights or many robots, it\n"
+                   "is faster to declare a light medium in the <media> section and set its id in\n"
+                   "the \"medium\" attribute.\n\n"
+                   "  <controllers>\n"
+                   "    ...\n"
+                   "    <my_controller ...>\n"
+                   "      ...\n"
+                   "      <sensors>\n"
+                   "        ...\n"
+                   "        <footbot_light implementation=\"rot_z_only\"\n"
+                   "                       medium=\"lights\" />\n"
+                   "        ...\n"
+                   "      </sensors>\n"
+                   "      ...\n"
+                   "    </my_controller>\n"
+                   "    ...\n"
+                   "  </controllers>\n",
                    "Usable"
       );
 
@@ -9,10 +9,13 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace argos {
    class CFootBotLightRotZOnlySensor;
    class CLightSensorEquippedEntity;
+   class CLightEntity;
+   class CLightMedium;
 }
 
 #include <argos3/plugins/robots/foot-bot/control_interface/ci_footbot_light_sensor.h>
@@ -63,8 +66,17 @@ namespace argos {
       /** Noise range */
       CRange<Real> m_cNoiseRange;
 
+      /** The noise of the current step, one per sensor */
+      std::vector<Real> m_vecNoise;
+
       /** Reference to the space */
       CSpace& m_cSpace;
+
+      /** The light medium, or <tt>NULL</tt> to look for the lights in the space */
+      CLightMedium* m_pcLightMedium;
+
+      /** The lights found in the space, when no light medium is used */
+      std::vector<CLightEntity*> m_vecLights;
    };
 
 }
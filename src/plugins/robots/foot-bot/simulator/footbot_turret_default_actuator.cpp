@@ -63,6 +63,20 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CFootBotTurretDefaultActuator::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_unDesiredMode;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFootBotTurretDefaultActuator::LoadState(CByteArray& c_buffer) {
+      c_buffer >> m_unDesiredMode;
+   }
+
+   /****************************************/
+   /****************************************/
+
    REGISTER_ACTUATOR(CFootBotTurretDefaultActuator,
                      "footbot_turret", "default",
                      "Carlo Pinciroli [ilpincy@gmail.com]",
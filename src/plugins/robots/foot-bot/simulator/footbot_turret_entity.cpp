@@ -56,6 +56,43 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CFootBotTurretEntity::SaveState(CByteArray& c_buffer) {
+      CEntity::SaveState(c_buffer);
+      c_buffer << m_unMode
+               << m_cDesRot.GetValue()
+               << m_fDesRotSpeed
+               << m_fCurRotSpeed
+               << m_cOldRot.GetValue();
+      if(m_psAnchor) {
+         c_buffer << m_psAnchor->OffsetOrientation.GetW()
+                  << m_psAnchor->OffsetOrientation.GetX()
+                  << m_psAnchor->OffsetOrientation.GetY()
+                  << m_psAnchor->OffsetOrientation.GetZ();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CFootBotTurretEntity::LoadState(CByteArray& c_buffer) {
+      CEntity::LoadState(c_buffer);
+      Real fValue;
+      c_buffer >> m_unMode;
+      c_buffer >> fValue;
+      m_cDesRot.SetValue(fValue);
+      c_buffer >> m_fDesRotSpeed >> m_fCurRotSpeed;
+      c_buffer >> fValue;
+      m_cOldRot.SetValue(fValue);
+      if(m_psAnchor) {
+         Real fW, fX, fY, fZ;
+         c_buffer >> fW >> fX >> fY >> fZ;
+         m_psAnchor->OffsetOrientation.Set(fW, fX, fY, fZ);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CFootBotTurretEntity::Update() {
       /* Calculate rotation speed */
       CRadians cZAngle, cYAngle, cXAngle;
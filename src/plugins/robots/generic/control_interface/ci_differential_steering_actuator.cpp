@@ -51,4 +51,18 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CCI_DifferentialSteeringActuator::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_fCurrentVelocity[0] << m_fCurrentVelocity[1];
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CCI_DifferentialSteeringActuator::LoadState(CByteArray& c_buffer) {
+      c_buffer >> m_fCurrentVelocity[0] >> m_fCurrentVelocity[1];
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
@@ -25,6 +25,10 @@ namespace argos {
       virtual void SetLinearVelocity(Real f_left_velocity,
                                      Real f_right_velocity) = 0;
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
 #ifdef ARGOS_WITH_LUA
       virtual void CreateLuaState(lua_State* pt_lua_state);
 #endif
@@ -93,4 +93,18 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CCI_GripperActuator::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_fLockState;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CCI_GripperActuator::LoadState(CByteArray& c_buffer) {
+      c_buffer >> m_fLockState;
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
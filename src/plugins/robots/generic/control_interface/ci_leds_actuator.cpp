@@ -159,4 +159,27 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CCI_LEDsActuator::SaveState(CByteArray& c_buffer) {
+      for(size_t i = 0; i < m_tSettings.size(); ++i) {
+         c_buffer << m_tSettings[i].GetRed()
+                  << m_tSettings[i].GetGreen()
+                  << m_tSettings[i].GetBlue()
+                  << m_tSettings[i].GetAlpha();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CCI_LEDsActuator::LoadState(CByteArray& c_buffer) {
+      UInt8 unRed, unGreen, unBlue, unAlpha;
+      for(size_t i = 0; i < m_tSettings.size(); ++i) {
+         c_buffer >> unRed >> unGreen >> unBlue >> unAlpha;
+         m_tSettings[i].Set(unRed, unGreen, unBlue, unAlpha);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
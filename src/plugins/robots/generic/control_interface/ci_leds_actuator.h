@@ -84,6 +84,10 @@ namespace argos {
        */
       virtual void SetAllIntensities(UInt8 un_intensity);
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
 #ifdef ARGOS_WITH_LUA
       virtual void CreateLuaState(lua_State* pt_lua_state);
 #endif
@@ -137,4 +137,18 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CCI_RangeAndBearingActuator::SaveState(CByteArray& c_buffer) {
+      c_buffer.AddBuffer(m_cData.ToCArray(), m_cData.Size());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CCI_RangeAndBearingActuator::LoadState(CByteArray& c_buffer) {
+      c_buffer.FetchBuffer(m_cData.ToCArray(), m_cData.Size());
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
@@ -3,6 +3,7 @@
 #include <argos3/core/simulator/space/positional_indices/positional_index.h>
 #include <argos3/core/simulator/entity/composable_entity.h>
 #include <argos3/core/simulator/entity/embodied_entity.h>
+#include <argos3/core/simulator/physics_engine/occlusion_cache.h>
 #include <argos3/plugins/simulator/entities/led_entity.h>
 #include <argos3/plugins/simulator/entities/omnidirectional_camera_equipped_entity.h>
 #include <argos3/plugins/simulator/media/led_medium.h>
@@ -29,10 +30,11 @@ namespace argos {
          m_cControllableEntity(c_controllable_entity),
          m_bShowRays(b_show_rays),
          m_fDistanceNoiseStdDev(f_noise_std_dev),
-         m_pcRNG(NULL) {
+         m_pcRNG(NULL),
+         m_bCacheOcclusions(false) {
          m_pcRootSensingEntity = &m_cEmbodiedEntity.GetParent();
          if(m_fDistanceNoiseStdDev > 0.0f) {
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_cEmbodiedEntity.GetRootEntity().GetId() + ".colored_blob_omnidirectional_camera");
          }
       }
       virtual ~COmnidirectionalCameraLEDCheckOperation() {
@@ -62,15 +64,7 @@ namespace argos {
             if(Abs(m_cLEDRelativePos.GetX()) < m_fGroundHalfRange &&
                Abs(m_cLEDRelativePos.GetY()) < m_fGroundHalfRange &&
                m_cLEDRelativePos.GetZ() < m_cCameraPos.GetZ() &&
-               !GetClosestEmbodiedEntityIntersectedByRay(m_sIntersectionItem,
-                                                         m_cOcclusionCheckRay,
-                                                         m_cEmbodiedEntity)) {
-               /* If noise was setup, add it */
-               if(m_fDistanceNoiseStdDev > 0.0f) {
-                  m_cLEDRelativePosXY += CVector2(
-                     m_cLEDRelativePosXY.Length() * m_pcRNG->Gaussian(m_fDistanceNoiseStdDev),
-                     m_pcRNG->Uniform(CRadians::UNSIGNED_RANGE));
-               }
+               !IsOccluded(c_led)) {
                m_tBlobs.push_back(new CCI_ColoredBlobOmnidirectionalCameraSensor::SBlob(
                                      c_led.GetColor(),
                                      NormalizedDifference(m_cLEDRelativePosXY.Angle(), m_cCameraOrient),
@@ -94,6 +88,47 @@ namespace argos {
          m_cCameraPos += m_cOmnicamEntity.GetOffset();
          m_cOcclusionCheckRay.SetStart(m_cCameraPos);
       }
+
+      void ApplyNoise() {
+         if(m_fDistanceNoiseStdDev > 0.0f && !m_tBlobs.empty()) {
+            /* Draw the noise of all the blobs at once */
+            size_t unBlobs = m_tBlobs.size();
+            m_vecDistanceNoise.resize(unBlobs);
+            m_vecAngleNoise.resize(unBlobs);
+            m_pcRNG->Gaussian(&m_vecDistanceNoise[0], unBlobs, m_fDistanceNoiseStdDev);
+            m_pcRNG->Uniform(&m_vecAngleNoise[0], unBlobs, CRadians::UNSIGNED_RANGE);
+            /* The noise has a uniform direction, so adding it in the
+               camera frame is the same as adding it in the global frame */
+            for(size_t i = 0; i < unBlobs; ++i) {
+               m_cBlobPos.FromPolarCoordinates(m_tBlobs[i]->Distance, m_tBlobs[i]->Angle);
+               m_cBlobPos += CVector2(m_tBlobs[i]->Distance * m_vecDistanceNoise[i],
+                                      m_vecAngleNoise[i]);
+               m_tBlobs[i]->Angle = m_cBlobPos.Angle();
+               m_tBlobs[i]->Distance = m_cBlobPos.Length();
+            }
+         }
+      }
+
+      void EnableOcclusionCache(Real f_tolerance) {
+         m_bCacheOcclusions = true;
+         m_cOcclusionCache.Init(f_tolerance);
+      }
+
+      void ClearOcclusionCache() {
+         m_cOcclusionCache.Clear();
+      }
+
+   private:
+
+      bool IsOccluded(CLEDEntity& c_led) {
+         if(m_bCacheOcclusions) {
+            return m_cOcclusionCache.IsSegmentOccluded(&c_led,
+                                                       m_cOcclusionCheckRay,
+                                                       &m_cEmbodiedEntity);
+         }
+         return IsSegmentOccluded(m_cOcclusionCheckRay,
+                                  &m_cEmbodiedEntity);
+      }
       
    private:
       
@@ -110,10 +145,14 @@ namespace argos {
       CRadians m_cTmp1, m_cTmp2;
       CVector3 m_cLEDRelativePos;
       CVector2 m_cLEDRelativePosXY;
-      SEmbodiedEntityIntersectionItem m_sIntersectionItem;
       CRay3 m_cOcclusionCheckRay;
       Real m_fDistanceNoiseStdDev;
       CRandom::CRNG* m_pcRNG;
+      std::vector<Real> m_vecDistanceNoise;
+      std::vector<CRadians> m_vecAngleNoise;
+      CVector2 m_cBlobPos;
+      bool m_bCacheOcclusions;
+      COcclusionCache m_cOcclusionCache;
    };
 
    /****************************************/
@@ -171,6 +210,14 @@ namespace argos {
             *m_pcControllableEntity,
             m_bShowRays,
             fDistanceNoiseStdDev);
+         /* Cache the occlusion checks? */
+         bool bCacheOcclusions = false;
+         GetNodeAttributeOrDefault(t_tree, "cache_occlusions", bCacheOcclusions, bCacheOcclusions);
+         if(bCacheOcclusions) {
+            Real fCacheTolerance = 0.001f;
+            GetNodeAttributeOrDefault(t_tree, "cache_tolerance", fCacheTolerance, fCacheTolerance);
+            m_pcOperation->EnableOcclusionCache(fCacheTolerance);
+         }
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Error initializing the colored blob omnidirectional camera rotzonly sensor", ex);
@@ -197,6 +244,8 @@ namespace argos {
                      cCameraPos.GetZ() * 0.5f),
             CVector3(fGroundHalfRange, fGroundHalfRange, cCameraPos.GetZ() * 0.5f),
             *m_pcOperation);
+         /* Add the noise, if any */
+         m_pcOperation->ApplyNoise();
       }
    }
 
@@ -206,6 +255,15 @@ namespace argos {
    void CColoredBlobOmnidirectionalCameraRotZOnlySensor::Reset() {
       m_sReadings.Counter = 0;
       m_sReadings.BlobList.clear();
+      m_pcOperation->ClearOcclusionCache();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CColoredBlobOmnidirectionalCameraRotZOnlySensor::LoadState(CByteArray& c_buffer) {
+      /* The cached occlusion checks refer to the old positions */
+      m_pcOperation->ClearOcclusionCache();
    }
 
    /****************************************/
@@ -300,6 +358,27 @@ namespace argos {
                    "      ...\n"
                    "    </my_controller>\n"
                    "    ...\n"
+                   "  </controllers>\n\n"
+                   "When the robots and the LEDs move little, the results of the occlusion checks\n"
+                   "can be cached and reused as long as nothing moves along the ray. This is done\n"
+                   "with the attribute \"cache_occlusions\". The attribute \"cache_tolerance\"\n"
+                   "sets how much (in meters) the camera or an LED can move before the cached\n"
+                   "check is discarded; it defaults to 0.001.\n\n"
+                   "  <controllers>\n"
+                   "    ...\n"
+                   "    <my_controller ...>\n"
+                   "      ...\n"
+                   "      <sensors>\n"
+                   "        ...\n"
+                   "        <colored_blob_omnidirectional_camera implementation=\"rot_z_only\"\n"
+                   "                                             medium=\"leds\"\n"
+                   "                                             cache_occlusions=\"true\"\n"
+                   "                                             cache_tolerance=\"0.001\" />\n"
+                   "        ...\n"
+                   "      </sensors>\n"
+                   "      ...\n"
+                   "    </my_controller>\n"
+                   "    ...\n"
                    "  </controllers>\n",
                    "Usable"
 		  );
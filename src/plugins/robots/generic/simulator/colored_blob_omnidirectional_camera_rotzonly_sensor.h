@@ -33,6 +33,8 @@ namespace argos {
 
       virtual void Reset();
 
+      virtual void LoadState(CByteArray& c_buffer);
+
       virtual void Destroy();
 
       virtual void Enable();
@@ -3,6 +3,7 @@
 #include <argos3/core/simulator/space/positional_indices/positional_index.h>
 #include <argos3/core/simulator/entity/composable_entity.h>
 #include <argos3/core/simulator/entity/embodied_entity.h>
+#include <argos3/core/simulator/physics_engine/occlusion_cache.h>
 #include <argos3/plugins/simulator/entities/led_entity.h>
 #include <argos3/plugins/simulator/entities/perspective_camera_equipped_entity.h>
 #include <argos3/plugins/simulator/media/led_medium.h>
@@ -29,10 +30,11 @@ namespace argos {
          m_cControllableEntity(c_controllable_entity),
          m_bShowRays(b_show_rays),
          m_fNoiseStdDev(f_noise_std_dev),
-         m_pcRNG(NULL) {
+         m_pcRNG(NULL),
+         m_bCacheOcclusions(false) {
          m_pcRootSensingEntity = &m_cEmbodiedEntity.GetRootEntity();
          if(m_fNoiseStdDev > 0.0f) {
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_cEmbodiedEntity.GetRootEntity().GetId() + ".colored_blob_perspective_camera");
          }
       }
       virtual ~CPerspectiveCameraLEDCheckOperation() {
@@ -63,9 +65,7 @@ namespace argos {
              */
             if(fDotProd < m_cCamEntity.GetRange() &&
                ACos(fDotProd / m_cLEDRelative.Length()) < m_cCamEntity.GetAperture() &&
-               !GetClosestEmbodiedEntityIntersectedByRay(m_sIntersectionItem,
-                                                         m_cOcclusionCheckRay,
-                                                         m_cEmbodiedEntity)) {
+               !IsOccluded(c_led)) {
                /* The LED is visibile */
                /* Calculate the intersection point between the LED ray and the image plane */
                m_cLEDRelative.Normalize();
@@ -117,6 +117,27 @@ namespace argos {
          /* Calculate inverse of camera orientation */
          m_cInvCameraOrient = m_cCamEntity.GetAnchor().Orientation.Inverse();
       }
+
+      void EnableOcclusionCache(Real f_tolerance) {
+         m_bCacheOcclusions = true;
+         m_cOcclusionCache.Init(f_tolerance);
+      }
+
+      void ClearOcclusionCache() {
+         m_cOcclusionCache.Clear();
+      }
+
+   private:
+
+      bool IsOccluded(CLEDEntity& c_led) {
+         if(m_bCacheOcclusions) {
+            return m_cOcclusionCache.IsSegmentOccluded(&c_led,
+                                                       m_cOcclusionCheckRay,
+                                                       &m_cEmbodiedEntity);
+         }
+         return IsSegmentOccluded(m_cOcclusionCheckRay,
+                                  &m_cEmbodiedEntity);
+      }
       
    private:
       
@@ -129,10 +150,11 @@ namespace argos {
       CEntity* m_pcRootSensingEntity;
       CRadians m_cTmp1, m_cTmp2;
       CVector3 m_cLEDRelative;
-      SEmbodiedEntityIntersectionItem m_sIntersectionItem;
       CRay3 m_cOcclusionCheckRay;
       Real m_fNoiseStdDev;
       CRandom::CRNG* m_pcRNG;
+      bool m_bCacheOcclusions;
+      COcclusionCache m_cOcclusionCache;
    };
 
    /****************************************/
@@ -190,6 +212,14 @@ namespace argos {
             *m_pcControllableEntity,
             m_bShowRays,
             fNoiseStdDev);
+         /* Cache the occlusion checks? */
+         bool bCacheOcclusions = false;
+         GetNodeAttributeOrDefault(t_tree, "cache_occlusions", bCacheOcclusions, bCacheOcclusions);
+         if(bCacheOcclusions) {
+            Real fCacheTolerance = 0.001f;
+            GetNodeAttributeOrDefault(t_tree, "cache_tolerance", fCacheTolerance, fCacheTolerance);
+            m_pcOperation->EnableOcclusionCache(fCacheTolerance);
+         }
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Error initializing the colored blob perspective camera default sensor", ex);
@@ -231,6 +261,15 @@ namespace argos {
    void CColoredBlobPerspectiveCameraDefaultSensor::Reset() {
       m_sReadings.Counter = 0;
       m_sReadings.BlobList.clear();
+      m_pcOperation->ClearOcclusionCache();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CColoredBlobPerspectiveCameraDefaultSensor::LoadState(CByteArray& c_buffer) {
+      /* The cached occlusion checks refer to the old positions */
+      m_pcOperation->ClearOcclusionCache();
    }
 
    /****************************************/
@@ -325,6 +364,27 @@ namespace argos {
                    "      ...\n"
                    "    </my_controller>\n"
                    "    ...\n"
+                   "  </controllers>\n\n"
+                   "When the robots and the LEDs move little, the results of the occlusion checks\n"
+                   "can be cached and reused as long as nothing moves along the ray. This is done\n"
+                   "with the attribute \"cache_occlusions\". The attribute \"cache_tolerance\"\n"
+                   "sets how much (in meters) the camera or an LED can move before the cached\n"
+                   "check is discarded; it defaults to 0.001.\n\n"
+                   "  <controllers>\n"
+                   "    ...\n"
+                   "    <my_controller ...>\n"
+                   "      ...\n"
+                   "      <sensors>\n"
+                   "        ...\n"
+                   "        <colored_blob_perspective_camera implementation=\"default\"\n"
+                   "                                         medium=\"leds\"\n"
+                   "                                         cache_occlusions=\"true\"\n"
+                   "                                         cache_tolerance=\"0.001\" />\n"
+                   "        ...\n"
+                   "      </sensors>\n"
+                   "      ...\n"
+                   "    </my_controller>\n"
+                   "    ...\n"
                    "  </controllers>\n",
                    "Usable"
       );
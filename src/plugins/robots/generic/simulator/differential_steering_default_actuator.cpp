@@ -45,7 +45,7 @@ namespace argos {
          CCI_DifferentialSteeringActuator::Init(t_tree);
          GetNodeAttributeOrDefault<Real>(t_tree, "noise_std_dev", m_fNoiseStdDeviation, 0.0f);
          if(m_fNoiseStdDeviation > 0.0f) {
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcWheeledEntity->GetRootEntity().GetId() + ".differential_steering_actuator");
          }
       }
       catch(CARGoSException& ex) {
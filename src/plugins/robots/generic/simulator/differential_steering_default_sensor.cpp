@@ -51,7 +51,7 @@ namespace argos {
          if(m_cVelNoiseRange.GetSpan() != 0 ||
             m_cDistNoiseRange.GetSpan() != 0) {
             m_bAddNoise = true;
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcWheeledEntity->GetRootEntity().GetId() + ".differential_steering_sensor");
          }
       }
       catch(CARGoSException& ex) {
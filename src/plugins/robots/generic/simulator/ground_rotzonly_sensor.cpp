@@ -55,9 +55,12 @@ namespace argos {
          else if(fNoiseLevel > 0.0f) {
             m_bAddNoise = true;
             m_cNoiseRange.Set(-fNoiseLevel, fNoiseLevel);
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcEmbodiedEntity->GetRootEntity().GetId() + ".ground");
          }
          m_tReadings.resize(m_pcGroundSensorEntity->GetNumSensors());
+         if(m_bAddNoise) {
+            m_vecNoise.resize(m_tReadings.size());
+         }
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Initialization error in rotzonly ground sensor", ex);
@@ -76,6 +79,10 @@ namespace argos {
       CVector2 cCenterPos;
       /* Position of sensor on the ground after rototranslation */
       CVector2 cSensorPos;
+      /* Draw the noise of all the sensors at once */
+      if(m_bAddNoise && !m_vecNoise.empty()) {
+         m_pcRNG->Uniform(&m_vecNoise[0], m_vecNoise.size(), m_cNoiseRange);
+      }
       /* Go through the sensors */
       for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
          CGroundSensorEquippedEntity::SSensor& sSens = m_pcGroundSensorEntity->GetSensor(i);
@@ -94,7 +101,7 @@ namespace argos {
          m_tReadings[i] = cColor.ToGrayScale() / 255.0f;
          /* Apply noise to the sensor */
          if(m_bAddNoise) {
-            m_tReadings[i] += m_pcRNG->Uniform(m_cNoiseRange);
+            m_tReadings[i] += m_vecNoise[i];
          }
          /* Is it a BW sensor? */
          if(sSens.Type == CGroundSensorEquippedEntity::TYPE_BLACK_WHITE) {
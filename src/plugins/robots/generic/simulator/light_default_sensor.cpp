@@ -9,6 +9,7 @@
 #include <argos3/core/simulator/entity/composable_entity.h>
 #include <argos3/plugins/simulator/entities/light_entity.h>
 #include <argos3/plugins/simulator/entities/light_sensor_equipped_entity.h>
+#include <argos3/plugins/simulator/media/light_medium.h>
 
 #include "light_default_sensor.h"
 
@@ -26,7 +27,9 @@ namespace argos {
       m_bShowRays(false),
       m_pcRNG(NULL),
       m_bAddNoise(false),
-      m_cSpace(CSimulator::GetInstance().GetSpace()) {}
+      m_cSpace(CSimulator::GetInstance().GetSpace()),
+      m_pcLightMedium(NULL),
+      m_fCutoff(0.0f) {}
 
    /****************************************/
    /****************************************/
@@ -59,9 +62,24 @@ namespace argos {
          else if(fNoiseLevel > 0.0f) {
             m_bAddNoise = true;
             m_cNoiseRange.Set(-fNoiseLevel, fNoiseLevel);
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcLightEntity->GetRootEntity().GetId() + ".light");
+         }
+         /* Get light medium from id specified in the XML, if any */
+         if(NodeAttributeExists(t_tree, "medium")) {
+            std::string strMedium;
+            GetNodeAttribute(t_tree, "medium", strMedium);
+            m_pcLightMedium = &(CSimulator::GetInstance().GetMedium<CLightMedium>(strMedium));
+         }
+         /* Parse cutoff */
+         GetNodeAttributeOrDefault(t_tree, "cutoff", m_fCutoff, m_fCutoff);
+         if(m_fCutoff < 0.0f) {
+            THROW_ARGOSEXCEPTION("Can't specify a negative value for the cutoff of the light sensor");
          }
          m_tReadings.resize(m_pcLightEntity->GetNumSensors());
+         m_vecPositions.resize(m_pcLightEntity->GetNumSensors());
+         if(m_bAddNoise) {
+            m_vecNoise.resize(m_tReadings.size());
+         }
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Initialization error in default light sensor", ex);
@@ -76,71 +94,84 @@ namespace argos {
       for(size_t i = 0; i < m_tReadings.size(); ++i)  m_tReadings[i] = 0.0f;
       /* Ray used for scanning the environment for obstacles */
       CRay3 cScanningRay;
-      CVector3 cRayStart;
       CVector3 cSensorToLight;
       /* Buffers to contain data about the intersection */
       SEmbodiedEntityIntersectionItem sIntersection;
-      /* Get the map of light entities */
-      CSpace::TMapPerTypePerId::iterator itLights = m_cSpace.GetEntityMapPerTypePerId().find("light");
-      if (itLights != m_cSpace.GetEntityMapPerTypePerId().end()) {
-         CSpace::TMapPerType& mapLights = itLights->second;
-         /* Go through the sensors */
-         for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
-            /* Set ray start */
-            cRayStart = m_pcLightEntity->GetSensor(i).Position;
-            cRayStart.Rotate(m_pcLightEntity->GetSensor(i).Anchor.Orientation);
-            cRayStart += m_pcLightEntity->GetSensor(i).Anchor.Position;
-            /* Go through all the light entities */
-            for(CSpace::TMapPerType::iterator it = mapLights.begin();
-                it != mapLights.end();
+      /* Get the light entities */
+      const std::vector<CLightEntity*>* pvecLights;
+      if(m_pcLightMedium != NULL) {
+         pvecLights = &m_pcLightMedium->GetLights();
+      }
+      else {
+         m_vecLights.clear();
+         CSpace::TMapPerTypePerId::iterator itLights = m_cSpace.GetEntityMapPerTypePerId().find("light");
+         if(itLights != m_cSpace.GetEntityMapPerTypePerId().end()) {
+            for(CSpace::TMapPerType::iterator it = itLights->second.begin();
+                it != itLights->second.end();
                 ++it) {
-               /* Get a reference to the light */
-               CLightEntity& cLight = *any_cast<CLightEntity*>(it->second);
-               /* Consider the light only if it has non zero intensity */
-               if(cLight.GetIntensity() > 0.0f) {
-                  /* Set ray end to light position */
-                  cScanningRay.Set(cRayStart, cLight.GetPosition());
-                  /* Check occlusions */
-                  if(! GetClosestEmbodiedEntityIntersectedByRay(sIntersection,
-                                                                cScanningRay)) {
-                     /* No occlusion, the light is visibile */
-                     if(m_bShowRays) {
-                        m_pcControllableEntity->AddCheckedRay(false, cScanningRay);
-                     }
-                     /* Calculate reading */
-                     cScanningRay.ToVector(cSensorToLight);
-                     m_tReadings[i] += CalculateReading(cSensorToLight.Length(),
-                                                        cLight.GetIntensity());
+               m_vecLights.push_back(any_cast<CLightEntity*>(it->second));
+            }
+         }
+         pvecLights = &m_vecLights;
+      }
+      /* Compute the positions of all the sensors */
+      if(!m_tReadings.empty()) {
+         m_pcLightEntity->CalculatePositions(&m_vecPositions[0]);
+         /* Draw the noise of all the sensors at once */
+         if(m_bAddNoise) {
+            m_pcRNG->Uniform(&m_vecNoise[0], m_vecNoise.size(), m_cNoiseRange);
+         }
+      }
+      /* Go through the sensors */
+      for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
+         /* Set ray start */
+         const CVector3& cRayStart = m_vecPositions[i];
+         /* Go through all the light entities */
+         for(size_t j = 0; j < pvecLights->size(); ++j) {
+            /* Get a reference to the light */
+            CLightEntity& cLight = *(*pvecLights)[j];
+            /* Consider the light only if it has non zero intensity */
+            if(cLight.GetIntensity() > 0.0f) {
+               /*
+                * Skip the light if its reading would be below the cutoff, that is, if
+                * (I/x)^2 < cutoff; the comparison is done without divisions
+                */
+               if(m_fCutoff * SquareDistance(cRayStart, cLight.GetPosition()) >=
+                  cLight.GetIntensity() * cLight.GetIntensity()) {
+                  continue;
+               }
+               /* Set ray end to light position */
+               cScanningRay.Set(cRayStart, cLight.GetPosition());
+               /* Check occlusions */
+               if(! IsSegmentOccluded(cScanningRay)) {
+                  /* No occlusion, the light is visibile */
+                  if(m_bShowRays) {
+                     m_pcControllableEntity->AddCheckedRay(false, cScanningRay);
                   }
-                  else {
-                     /* There is an occlusion, the light is not visible */
-                     if(m_bShowRays) {
-                        m_pcControllableEntity->AddIntersectionPoint(cScanningRay,
-                                                                     sIntersection.TOnRay);
-                        m_pcControllableEntity->AddCheckedRay(true, cScanningRay);
-                     }
+                  /* Calculate reading */
+                  cScanningRay.ToVector(cSensorToLight);
+                  m_tReadings[i] += CalculateReading(cSensorToLight.Length(),
+                                                     cLight.GetIntensity());
+               }
+               else {
+                  /* There is an occlusion, the light is not visible */
+                  if(m_bShowRays) {
+                     /* The intersection point is needed only to draw it */
+                     GetClosestEmbodiedEntityIntersectedByRay(sIntersection,
+                                                              cScanningRay);
+                     m_pcControllableEntity->AddIntersectionPoint(cScanningRay,
+                                                                  sIntersection.TOnRay);
+                     m_pcControllableEntity->AddCheckedRay(true, cScanningRay);
                   }
                }
             }
-            /* Apply noise to the sensor */
-            if(m_bAddNoise) {
-               m_tReadings[i] += m_pcRNG->Uniform(m_cNoiseRange);
-            }
-            /* Trunc the reading between 0 and 1 */
-            UNIT.TruncValue(m_tReadings[i]);
          }
-      }
-      else {
-         /* There are no lights in the environment */
+         /* Apply noise to the sensor */
          if(m_bAddNoise) {
-            /* Go through the sensors */
-            for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
-               /* Apply noise to the sensor */
-               m_tReadings[i] += m_pcRNG->Uniform(m_cNoiseRange);
-               /* Trunc the reading between 0 and 1 */
-               UNIT.TruncValue(m_tReadings[i]);
-            }
+            m_tReadings[i] += m_vecNoise[i];
          }
+         /* Trunc the reading between 0 and 1 */
+         UNIT.TruncValue(m_tReadings[i]);
       }
    }
 
@@ -234,8 +265,28 @@ namespace argos {
                    "    </my_controller>\n"
                    "    ...\n"
                    "  </controllers>\n\n"
-                   "OPTIONAL XML CONFIGURATION\n\n"
-                   "None.\n",
+                   "By default, the sensor looks for the lights among all the entities in the\n"
+                   "space at every step. When the arena contains many lights or many robots, it\n"
+                   "is faster to declare a light medium in the <media> section and set its id in\n"
+                   "the \"medium\" attribute. In addition, the \"cutoff\" attribute makes the\n"
+                   "sensor ignore the lights whose reading would be below the given value. No\n"
+                   "occlusion ray is cast towards these lights. The default value is 0, which\n"
+                   "means that all the lights are considered.\n\n"
+                   "  <controllers>\n"
+                   "    ...\n"
+                   "    <my_controller ...>\n"
+                   "      ...\n"
+                   "      <sensors>\n"
+                   "        ...\n"
+                   "        <light implementation=\"default\"\n"
+                   "                   medium=\"lights\"\n"
+                   "                   cutoff=\"0.01\" />\n"
+                   "        ...\n"
+                   "      </sensors>\n"
+                   "      ...\n"
+                   "    </my_controller>\n"
+                   "    ...\n"
+                   "  </controllers>\n",
                    "Usable"
 		  );
 
@@ -9,10 +9,13 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace argos {
    class CLightDefaultSensor;
    class CLightSensorEquippedEntity;
+   class CLightEntity;
+   class CLightMedium;
 }
 
 #include <argos3/plugins/robots/generic/control_interface/ci_light_sensor.h>
@@ -71,8 +74,23 @@ namespace argos {
       /** Noise range */
       CRange<Real> m_cNoiseRange;
 
+      /** The noise of the current step, one per sensor */
+      std::vector<Real> m_vecNoise;
+
       /** Reference to the space */
       CSpace& m_cSpace;
+
+      /** The light medium, or <tt>NULL</tt> to look for the lights in the space */
+      CLightMedium* m_pcLightMedium;
+
+      /** The lights found in the space, when no light medium is used */
+      std::vector<CLightEntity*> m_vecLights;
+
+      /** Lights whose reading would be below this value are ignored */
+      Real m_fCutoff;
+
+      /** The positions of the sensors in the global reference frame */
+      std::vector<CVector3> m_vecPositions;
    };
 
 }
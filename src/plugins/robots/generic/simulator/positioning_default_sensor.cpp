@@ -43,7 +43,7 @@ namespace argos {
             m_cAngleNoiseRange.GetSpan() != CRadians::ZERO ||
             m_cAxisNoiseRange.GetSpan() != 0) {
             m_bAddNoise = true;
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcEmbodiedEntity->GetRootEntity().GetId() + ".positioning");
          }
       }
       catch(CARGoSException& ex) {
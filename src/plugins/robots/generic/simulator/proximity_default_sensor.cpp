@@ -60,9 +60,14 @@ namespace argos {
          else if(fNoiseLevel > 0.0f) {
             m_bAddNoise = true;
             m_cNoiseRange.Set(-fNoiseLevel, fNoiseLevel);
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcEmbodiedEntity->GetRootEntity().GetId() + ".proximity");
          }
          m_tReadings.resize(m_pcProximityEntity->GetNumSensors());
+         m_vecRays.resize(m_pcProximityEntity->GetNumSensors());
+         m_vecIntersections.resize(m_pcProximityEntity->GetNumSensors());
+         if(m_bAddNoise) {
+            m_vecNoise.resize(m_tReadings.size());
+         }
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Initialization error in default proximity sensor", ex);
@@ -73,45 +78,41 @@ namespace argos {
    /****************************************/
    
    void CProximityDefaultSensor::Update() {
-      /* Ray used for scanning the environment for obstacles */
-      CRay3 cScanningRay;
-      CVector3 cRayStart, cRayEnd;
-      /* Buffers to contain data about the intersection */
-      SEmbodiedEntityIntersectionItem sIntersection;
+      if(!m_tReadings.empty()) {
+         /* Compute the rays of all the sensors */
+         m_pcProximityEntity->CalculateRays(&m_vecRays[0]);
+         /* Get the closest intersection for all the rays at once */
+         GetClosestEmbodiedEntitiesIntersectedByRays(&m_vecIntersections[0],
+                                                     &m_vecRays[0],
+                                                     m_vecRays.size(),
+                                                     m_pcEmbodiedEntity);
+         /* Draw the noise of all the sensors at once */
+         if(m_bAddNoise) {
+            m_pcRNG->Uniform(&m_vecNoise[0], m_vecNoise.size(), m_cNoiseRange);
+         }
+      }
       /* Go through the sensors */
       for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
-         /* Compute ray for sensor i */
-         cRayStart = m_pcProximityEntity->GetSensor(i).Offset;
-         cRayStart.Rotate(m_pcProximityEntity->GetSensor(i).Anchor.Orientation);
-         cRayStart += m_pcProximityEntity->GetSensor(i).Anchor.Position;
-         cRayEnd = m_pcProximityEntity->GetSensor(i).Offset;
-         cRayEnd += m_pcProximityEntity->GetSensor(i).Direction;
-         cRayEnd.Rotate(m_pcProximityEntity->GetSensor(i).Anchor.Orientation);
-         cRayEnd += m_pcProximityEntity->GetSensor(i).Anchor.Position;
-         cScanningRay.Set(cRayStart,cRayEnd);
          /* Compute reading */
-         /* Get the closest intersection */
-         if(GetClosestEmbodiedEntityIntersectedByRay(sIntersection,
-                                                     cScanningRay,
-                                                     *m_pcEmbodiedEntity)) {
+         if(m_vecIntersections[i].IntersectedEntity != NULL) {
             /* There is an intersection */
             if(m_bShowRays) {
-               m_pcControllableEntity->AddIntersectionPoint(cScanningRay,
-                                                            sIntersection.TOnRay);
-               m_pcControllableEntity->AddCheckedRay(true, cScanningRay);
+               m_pcControllableEntity->AddIntersectionPoint(m_vecRays[i],
+                                                            m_vecIntersections[i].TOnRay);
+               m_pcControllableEntity->AddCheckedRay(true, m_vecRays[i]);
             }
-            m_tReadings[i] = CalculateReading(cScanningRay.GetDistance(sIntersection.TOnRay));
+            m_tReadings[i] = CalculateReading(m_vecRays[i].GetDistance(m_vecIntersections[i].TOnRay));
          }
          else {
             /* No intersection */
             m_tReadings[i] = 0.0f;
             if(m_bShowRays) {
-               m_pcControllableEntity->AddCheckedRay(false, cScanningRay);
+               m_pcControllableEntity->AddCheckedRay(false, m_vecRays[i]);
             }
          }
          /* Apply noise to the sensor */
          if(m_bAddNoise) {
-            m_tReadings[i] += m_pcRNG->Uniform(m_cNoiseRange);
+            m_tReadings[i] += m_vecNoise[i];
          }
          /* Trunc the reading between 0 and 1 */
          UNIT.TruncValue(m_tReadings[i]);
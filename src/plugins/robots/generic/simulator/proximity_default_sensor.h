@@ -9,6 +9,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace argos {
    class CProximityDefaultSensor;
@@ -70,8 +71,17 @@ namespace argos {
       /** Noise range */
       CRange<Real> m_cNoiseRange;
 
+      /** The noise of the current step, one per sensor */
+      std::vector<Real> m_vecNoise;
+
       /** Reference to the space */
       CSpace& m_cSpace;
+
+      /** The scanning rays, one per sensor */
+      std::vector<CRay3> m_vecRays;
+
+      /** The intersection data, one per sensor */
+      std::vector<SEmbodiedEntityIntersectionItem> m_vecIntersections;
    };
 
 }
@@ -104,6 +104,26 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CQuadRotorPositionDefaultActuator::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_sDesiredPosData.Position.GetX()
+               << m_sDesiredPosData.Position.GetY()
+               << m_sDesiredPosData.Position.GetZ()
+               << m_sDesiredPosData.Yaw.GetValue();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CQuadRotorPositionDefaultActuator::LoadState(CByteArray& c_buffer) {
+      Real fX, fY, fZ, fYaw;
+      c_buffer >> fX >> fY >> fZ >> fYaw;
+      m_sDesiredPosData.Position.Set(fX, fY, fZ);
+      m_sDesiredPosData.Yaw.SetValue(fYaw);
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
 
 REGISTER_ACTUATOR(CQuadRotorPositionDefaultActuator,
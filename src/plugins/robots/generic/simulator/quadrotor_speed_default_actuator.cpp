@@ -85,6 +85,26 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CQuadRotorSpeedDefaultActuator::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_sDesiredSpeedData.Velocity.GetX()
+               << m_sDesiredSpeedData.Velocity.GetY()
+               << m_sDesiredSpeedData.Velocity.GetZ()
+               << m_sDesiredSpeedData.RotSpeed.GetValue();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CQuadRotorSpeedDefaultActuator::LoadState(CByteArray& c_buffer) {
+      Real fX, fY, fZ, fRotSpeed;
+      c_buffer >> fX >> fY >> fZ >> fRotSpeed;
+      m_sDesiredSpeedData.Velocity.Set(fX, fY, fZ);
+      m_sDesiredSpeedData.RotSpeed.SetValue(fRotSpeed);
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
 
 REGISTER_ACTUATOR(CQuadRotorSpeedDefaultActuator,
@@ -17,6 +17,7 @@ namespace argos {
    /****************************************/
 
    CRange<CRadians> INCLINATION_RANGE(CRadians(0), CRadians(ARGOS_PI));
+   static CRange<Real> UNIT(0.0f, 1.0f);
 
    /****************************************/
    /****************************************/
@@ -55,7 +56,7 @@ namespace argos {
          GetNodeAttributeOrDefault(t_tree, "packet_drop_prob", m_fPacketDropProb, m_fPacketDropProb);
          if((m_fPacketDropProb > 0.0f) ||
             (m_fDistanceNoiseStdDev > 0.0f)) {
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcRangeAndBearingEquippedEntity->GetRootEntity().GetId() + ".range_and_bearing");
          }
          /* Get RAB medium from id specified in the XML */
          std::string strMedium;
@@ -82,13 +83,31 @@ namespace argos {
       CVector3 cVectorRobotToMessage;
       /* Buffer for the received packet */
       CCI_RangeAndBearingSensor::SPacket sPacket;
+      /* Draw the random numbers for all the packets at once */
+      bool bDropPackets = (m_pcRNG != NULL && m_fPacketDropProb > 0.0f);
+      bool bAddNoise = (m_pcRNG != NULL && m_fDistanceNoiseStdDev > 0.0f);
+      size_t unPackets = setRABs.size();
+      if(unPackets > 0) {
+         if(bDropPackets) {
+            m_vecDropDraws.resize(unPackets);
+            m_pcRNG->Uniform(&m_vecDropDraws[0], unPackets, UNIT);
+         }
+         if(bAddNoise) {
+            m_vecRangeNoise.resize(unPackets);
+            m_vecInclinationNoise.resize(unPackets);
+            m_vecAzimuthNoise.resize(unPackets);
+            m_pcRNG->Gaussian(&m_vecRangeNoise[0], unPackets, m_fDistanceNoiseStdDev);
+            m_pcRNG->Uniform(&m_vecInclinationNoise[0], unPackets, INCLINATION_RANGE);
+            m_pcRNG->Uniform(&m_vecAzimuthNoise[0], unPackets, CRadians::UNSIGNED_RANGE);
+         }
+      }
       /* Go through communicating RABs and create packets */
+      size_t i = 0;
       for(CSet<CRABEquippedEntity*>::iterator it = setRABs.begin();
-          it != setRABs.end(); ++it) {
+          it != setRABs.end(); ++it, ++i) {
          /* Should we drop this packet? */
-         if(m_pcRNG == NULL || /* No noise to apply */
-            !(m_fPacketDropProb > 0.0f &&
-              m_pcRNG->Bernoulli(m_fPacketDropProb)) /* Packet is not dropped */
+         if(!bDropPackets || /* No noise to apply */
+            m_vecDropDraws[i] >= m_fPacketDropProb /* Packet is not dropped */
             ) {
             /* Create a reference to the RAB entity to process */
             CRABEquippedEntity& cRABEntity = **it;
@@ -102,11 +121,11 @@ namespace argos {
             cVectorRobotToMessage = cRABEntity.GetPosition();
             cVectorRobotToMessage -= m_pcRangeAndBearingEquippedEntity->GetPosition();
             /* If noise was setup, add it */
-            if(m_pcRNG && m_fDistanceNoiseStdDev > 0.0f) {
+            if(bAddNoise) {
                cVectorRobotToMessage += CVector3(
-                  m_pcRNG->Gaussian(m_fDistanceNoiseStdDev),
-                  m_pcRNG->Uniform(INCLINATION_RANGE),
-                  m_pcRNG->Uniform(CRadians::UNSIGNED_RANGE));
+                  m_vecRangeNoise[i],
+                  m_vecInclinationNoise[i],
+                  m_vecAzimuthNoise[i]);
             }
             /*
              * Set range and bearing from cVectorRobotToMessage
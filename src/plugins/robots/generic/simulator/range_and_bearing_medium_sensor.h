@@ -9,6 +9,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace argos {
    class CRangeAndBearingMediumSensor;
@@ -47,6 +48,11 @@ namespace argos {
       CRandom::CRNG*       m_pcRNG;
       CSpace&              m_cSpace;
       bool                 m_bShowRays;
+      /* Random draws of the current step, one per packet */
+      std::vector<Real>     m_vecDropDraws;
+      std::vector<Real>     m_vecRangeNoise;
+      std::vector<CRadians> m_vecInclinationNoise;
+      std::vector<CRadians> m_vecAzimuthNoise;
    };
 }
 
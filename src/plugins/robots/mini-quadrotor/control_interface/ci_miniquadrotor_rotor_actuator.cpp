@@ -104,4 +104,22 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CCI_MiniQuadrotorRotorActuator::SaveState(CByteArray& c_buffer) {
+      for(size_t i = 0; i < 4; ++i) {
+         c_buffer << m_sCurrentVelocities.Velocities[i];
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CCI_MiniQuadrotorRotorActuator::LoadState(CByteArray& c_buffer) {
+      for(size_t i = 0; i < 4; ++i) {
+         c_buffer >> m_sCurrentVelocities.Velocities[i];
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
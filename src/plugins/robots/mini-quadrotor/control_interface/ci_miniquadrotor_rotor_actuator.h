@@ -37,6 +37,10 @@ namespace argos {
 
       virtual void SetRotorVelocities(const SVelocities& s_velocities) = 0;
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
 #ifdef ARGOS_WITH_LUA
       virtual void CreateLuaState(lua_State* pt_lua_state);
 #endif
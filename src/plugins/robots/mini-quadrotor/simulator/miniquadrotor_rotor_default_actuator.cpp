@@ -43,7 +43,7 @@ namespace argos {
          CCI_MiniQuadrotorRotorActuator::Init(t_tree);
          GetNodeAttributeOrDefault<Real>(t_tree, "noise_std_dev", m_fNoiseStdDeviation, 0.0f);
          if(m_fNoiseStdDeviation > 0.0f) {
-            m_pcRNG = CRandom::CreateRNG("argos");
+            m_pcRNG = CRandom::CreateRNG("argos", m_pcRotorEquippedEntity->GetRootEntity().GetId() + ".quadrotor_rotors");
          }
       }
       catch(CARGoSException& ex) {
@@ -74,6 +74,34 @@ namespace argos {
       ClearGrippedEntity();
    }
 
+   /****************************************/
+   /****************************************/
+
+   void CGripperEquippedEntity::SaveState(CByteArray& c_buffer) {
+      CEntity::SaveState(c_buffer);
+      c_buffer << m_fLockState
+               << m_cOffset.GetX()
+               << m_cOffset.GetY()
+               << m_cOffset.GetZ()
+               << m_cDirection.GetX()
+               << m_cDirection.GetY()
+               << m_cDirection.GetZ();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CGripperEquippedEntity::LoadState(CByteArray& c_buffer) {
+      CEntity::LoadState(c_buffer);
+      Real fX, fY, fZ;
+      c_buffer >> m_fLockState;
+      c_buffer >> fX >> fY >> fZ;
+      m_cOffset.Set(fX, fY, fZ);
+      c_buffer >> fX >> fY >> fZ;
+      m_cDirection.Set(fX, fY, fZ);
+      ClearGrippedEntity();
+   }
+
    /****************************************/
    /****************************************/
          
@@ -77,6 +77,20 @@ namespace argos {
        */
       virtual void Reset();
 
+      /**
+       * Saves the lock state, the offset and the direction of the gripper.
+       * The gripped entity is not saved: the physics engines grip it
+       * again at the first contact after the state is restored.
+       * @param c_buffer The target buffer.
+       */
+      virtual void SaveState(CByteArray& c_buffer);
+
+      /**
+       * Restores the lock state, the offset and the direction of the gripper.
+       * @param c_buffer The source buffer.
+       */
+      virtual void LoadState(CByteArray& c_buffer);
+
       /**
        * Returns the offset of the gripper with respect to the reference point.
        * @return The offset of the gripper with respect to the reference point.
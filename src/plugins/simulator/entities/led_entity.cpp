@@ -54,6 +54,29 @@ namespace argos {
 
    void CLEDEntity::Reset() {
       m_cColor = m_cInitColor;
+      MarkDirty();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLEDEntity::SaveState(CByteArray& c_buffer) {
+      CPositionalEntity::SaveState(c_buffer);
+      c_buffer << m_cColor.GetRed()
+               << m_cColor.GetGreen()
+               << m_cColor.GetBlue()
+               << m_cColor.GetAlpha();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLEDEntity::LoadState(CByteArray& c_buffer) {
+      CPositionalEntity::LoadState(c_buffer);
+      UInt8 unRed, unGreen, unBlue, unAlpha;
+      c_buffer >> unRed >> unGreen >> unBlue >> unAlpha;
+      m_cColor.Set(unRed, unGreen, unBlue, unAlpha);
+      MarkDirty();
    }
 
    /****************************************/
@@ -76,6 +99,10 @@ namespace argos {
    /****************************************/
 
    void CLEDEntity::SetColor(const CColor& c_color) {
+      /* The medium ignores the LEDs switched off */
+      if((m_cColor == CColor::BLACK) != (c_color == CColor::BLACK)) {
+         MarkDirty();
+      }
       m_cColor = c_color;
       SetEnabled(c_color != CColor::BLACK);
    }
@@ -83,6 +110,14 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CLEDEntity::SetPosition(const CVector3& c_position) {
+      CPositionalEntity::SetPosition(c_position);
+      MarkDirty();
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CLEDEntity::AddToMedium(CLEDMedium& c_medium) {
       if(HasMedium()) RemoveFromMedium();
       m_pcMedium = &c_medium;
@@ -117,6 +152,15 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CLEDEntity::MarkDirty() {
+      if(m_pcMedium != NULL) {
+         m_pcMedium->GetIndex().MarkDirty(*this);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CLEDEntitySpaceHashUpdater::operator()(CAbstractSpaceHash<CLEDEntity>& c_space_hash,
                                                CLEDEntity& c_element) {
       /* Discard LEDs switched off */
@@ -132,7 +176,8 @@ namespace argos {
    /****************************************/
 
    CLEDEntityGridUpdater::CLEDEntityGridUpdater(CGrid<CLEDEntity>& c_grid) :
-      m_cGrid(c_grid) {}
+      m_cGrid(c_grid),
+      m_bOutOfAreaWarned(false) {}
 
    /****************************************/
    /****************************************/
@@ -140,14 +185,20 @@ namespace argos {
    bool CLEDEntityGridUpdater::operator()(CLEDEntity& c_entity) {
       /* Discard LEDs switched off */
       if(c_entity.GetColor() != CColor::BLACK) {
-         try {
-            /* Calculate the position of the LED in the space hash */
-            m_cGrid.PositionToCell(m_nI, m_nJ, m_nK, c_entity.GetPosition());
+         /* Calculate the position of the LED in the grid */
+         if(m_cGrid.PositionToCellClamped(m_nI, m_nJ, m_nK, c_entity.GetPosition())) {
             /* Update the corresponding cell */
             m_cGrid.UpdateCell(m_nI, m_nJ, m_nK, c_entity);
          }
-         catch(CARGoSException& ex) {
-            THROW_ARGOSEXCEPTION_NESTED("While updating the LED grid for LED \"" << c_entity.GetContext() << c_entity.GetId() << "\"", ex);
+         else if(!m_bOutOfAreaWarned) {
+            /* LEDs out of the area are not indexed, thus they are not seen */
+            LOGERR << "[WARNING] LED \""
+                   << c_entity.GetContext() << c_entity.GetId()
+                   << "\" is out of the arena at "
+                   << c_entity.GetPosition()
+                   << "; LEDs out of the arena are ignored by the LED medium"
+                   << std::endl;
+            m_bOutOfAreaWarned = true;
          }
       }
       /* Continue with the other entities */
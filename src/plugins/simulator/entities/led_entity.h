@@ -45,10 +45,21 @@ namespace argos {
 
       virtual void Reset();
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
       virtual void Destroy();
 
       virtual void SetEnabled(bool b_enabled);
 
+      /**
+       * Moves the LED and tells its medium.
+       * MoveTo() goes through this method too.
+       * @param c_position The new position.
+       */
+      virtual void SetPosition(const CVector3& c_position);
+
       /**
        * Returns the current color of the LED.
        * @return the current color of the LED.
@@ -126,6 +137,13 @@ namespace argos {
        */
       CLEDMedium& GetMedium() const;
 
+   protected:
+
+      /**
+       * Tells the medium that this LED moved or changed color.
+       */
+      void MarkDirty();
+
    protected:
 
       CColor m_cColor;
@@ -164,6 +182,7 @@ namespace argos {
 
       CGrid<CLEDEntity>& m_cGrid;
       SInt32 m_nI, m_nJ, m_nK;
+      bool m_bOutOfAreaWarned;
 
    };
 
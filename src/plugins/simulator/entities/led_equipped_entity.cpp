@@ -245,7 +245,10 @@ namespace argos {
             cLEDPosition = m_tLEDs[i]->Offset;
             cLEDPosition.Rotate(m_tLEDs[i]->Anchor.Orientation);
             cLEDPosition += m_tLEDs[i]->Anchor.Position;
-            m_tLEDs[i]->LED.SetPosition(cLEDPosition);
+            /* Tell the medium only about the LEDs that moved */
+            if(cLEDPosition != m_tLEDs[i]->LED.GetPosition()) {
+               m_tLEDs[i]->LED.SetPosition(cLEDPosition);
+            }
          }
       }
    }
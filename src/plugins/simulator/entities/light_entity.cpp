@@ -8,6 +8,7 @@
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/space/space.h>
 #include <argos3/plugins/simulator/media/led_medium.h>
+#include <argos3/plugins/simulator/media/light_medium.h>
 
 namespace argos {
 
@@ -42,8 +43,16 @@ namespace argos {
          GetNodeAttribute(t_tree, "intensity", m_fIntensity);
          std::string strMedium;
          GetNodeAttribute(t_tree, "medium", strMedium);
-         CLEDMedium& cLEDMedium = CSimulator::GetInstance().GetMedium<CLEDMedium>(strMedium);
-         cLEDMedium.AddEntity(*this);
+         AddToMedium(CSimulator::GetInstance().GetMedium<CLEDMedium>(strMedium));
+         /* Add this light to all the light media */
+         CMedium::TVector& vecMedia = CSimulator::GetInstance().GetMedia();
+         for(size_t i = 0; i < vecMedia.size(); ++i) {
+            CLightMedium* pcLightMedium = dynamic_cast<CLightMedium*>(vecMedia[i]);
+            if(pcLightMedium != NULL) {
+               pcLightMedium->AddEntity(*this);
+               m_vecLightMedia.push_back(pcLightMedium);
+            }
+         }
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Error while initializing light entity", ex);
@@ -53,6 +62,33 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CLightEntity::Destroy() {
+      for(size_t i = 0; i < m_vecLightMedia.size(); ++i) {
+         m_vecLightMedia[i]->RemoveEntity(*this);
+      }
+      m_vecLightMedia.clear();
+      CLEDEntity::Destroy();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLightEntity::SaveState(CByteArray& c_buffer) {
+      CLEDEntity::SaveState(c_buffer);
+      c_buffer << m_fIntensity;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLightEntity::LoadState(CByteArray& c_buffer) {
+      CLEDEntity::LoadState(c_buffer);
+      c_buffer >> m_fIntensity;
+   }
+
+   /****************************************/
+   /****************************************/
+
    REGISTER_ENTITY(CLightEntity,
                    "light",
                    "Carlo Pinciroli [ilpincy@gmail.com]",
@@ -88,7 +124,9 @@ namespace argos {
                    "light is half, and when the value is 2.0 the emission is doubled. The\n"
                    "intensity of the light affects the readings of the light sensors but not\n"
                    "those of the cameras.\n"
-                   "The 'medium' attribute is used to add the light the corresponding LED medium.\n\n"
+                   "The 'medium' attribute is used to add the light the corresponding LED medium.\n"
+                   "The light is also added to all the light media, if any is declared in the\n"
+                   "<media> section.\n\n"
                    "OPTIONAL XML CONFIGURATION\n\n"
                    "None.\n",
                    "Usable"
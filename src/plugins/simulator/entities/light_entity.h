@@ -10,6 +10,7 @@
 namespace argos {
    class CLightEntity;
    class CLedEquippedEntity;
+   class CLightMedium;
 }
 
 #include <argos3/core/simulator/entity/positional_entity.h>
@@ -34,6 +35,12 @@ namespace argos {
 
       virtual void Init(TConfigurationNode& t_tree);
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
+      virtual void Destroy();
+
       inline Real GetIntensity() const {
          return m_fIntensity;
       }
@@ -49,6 +56,9 @@ namespace argos {
    protected:
 
       Real m_fIntensity;
+
+      /** The light media this entity has been added to */
+      std::vector<CLightMedium*> m_vecLightMedia;
    };
 
 }
@@ -7,6 +7,7 @@
 #include "light_sensor_equipped_entity.h"
 #include <argos3/core/simulator/space/space.h>
 #include <argos3/core/simulator/entity/composable_entity.h>
+#include <argos3/core/utility/math/batch.h>
 
 namespace argos {
 
@@ -146,6 +147,12 @@ namespace argos {
                                               Real f_range,
                                               SAnchor& s_anchor) {
       m_tSensors.push_back(new SSensor(c_position, c_direction, f_range, s_anchor));
+      m_vecPositionX.push_back(c_position.GetX());
+      m_vecPositionY.push_back(c_position.GetY());
+      m_vecPositionZ.push_back(c_position.GetZ());
+      m_vecBufferX.resize(m_tSensors.size());
+      m_vecBufferY.resize(m_tSensors.size());
+      m_vecBufferZ.resize(m_tSensors.size());
    }
 
    /****************************************/
@@ -175,6 +182,32 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CLightSensorEquippedEntity::CalculatePositions(CVector3* pc_positions) {
+      size_t unNum = m_tSensors.size();
+      /* Transform the runs of sensors attached to the same anchor */
+      size_t unFirst = 0, unLast;
+      while(unFirst < unNum) {
+         SAnchor& sAnchor = m_tSensors[unFirst]->Anchor;
+         unLast = unFirst + 1;
+         while(unLast < unNum && &m_tSensors[unLast]->Anchor == &sAnchor) {
+            ++unLast;
+         }
+         BatchRotateTranslate(&m_vecBufferX[unFirst], &m_vecBufferY[unFirst], &m_vecBufferZ[unFirst],
+                              &m_vecPositionX[unFirst], &m_vecPositionY[unFirst], &m_vecPositionZ[unFirst],
+                              unLast - unFirst,
+                              sAnchor.Orientation,
+                              sAnchor.Position);
+         unFirst = unLast;
+      }
+      /* Pack the results into vectors */
+      for(size_t i = 0; i < unNum; ++i) {
+         pc_positions[i].Set(m_vecBufferX[i], m_vecBufferY[i], m_vecBufferZ[i]);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    REGISTER_STANDARD_SPACE_OPERATIONS_ON_ENTITY(CLightSensorEquippedEntity);
    
    /****************************************/
@@ -80,11 +80,28 @@ namespace argos {
                          UInt32 un_num_sensors,
                          SAnchor& s_anchor);
 
+      /**
+       * Calculates the positions of all the sensors in the global reference frame.
+       * Sensors that share the same anchor are transformed in one batch.
+       * @param pc_positions The buffer to fill; it must hold GetNumSensors() positions.
+       */
+      void CalculatePositions(CVector3* pc_positions);
+
    protected:
 
       /** The list of sensors */
       SSensor::TList m_tSensors;
 
+      /** The sensor positions in the anchor reference frame, one array per axis */
+      std::vector<Real> m_vecPositionX;
+      std::vector<Real> m_vecPositionY;
+      std::vector<Real> m_vecPositionZ;
+
+      /** Scratch buffers for the transformed positions */
+      std::vector<Real> m_vecBufferX;
+      std::vector<Real> m_vecBufferY;
+      std::vector<Real> m_vecBufferZ;
+
    };
 
 }
@@ -7,6 +7,7 @@
 #include "proximity_sensor_equipped_entity.h"
 #include <argos3/core/simulator/space/space.h>
 #include <argos3/core/simulator/entity/composable_entity.h>
+#include <argos3/core/utility/math/batch.h>
 
 namespace argos {
 
@@ -145,7 +146,18 @@ namespace argos {
                                                   const CVector3& c_direction,
                                                   Real f_range,
                                                   SAnchor& s_anchor) {
-      m_tSensors.push_back(new SSensor(c_offset, c_direction, f_range, s_anchor));
+      SSensor* psSensor = new SSensor(c_offset, c_direction, f_range, s_anchor);
+      m_tSensors.push_back(psSensor);
+      CVector3 cEnd = psSensor->Offset + psSensor->Direction;
+      m_vecOffsetX.push_back(psSensor->Offset.GetX());
+      m_vecOffsetY.push_back(psSensor->Offset.GetY());
+      m_vecOffsetZ.push_back(psSensor->Offset.GetZ());
+      m_vecEndX.push_back(cEnd.GetX());
+      m_vecEndY.push_back(cEnd.GetY());
+      m_vecEndZ.push_back(cEnd.GetZ());
+      m_vecBufferX.resize(2 * m_tSensors.size());
+      m_vecBufferY.resize(2 * m_tSensors.size());
+      m_vecBufferZ.resize(2 * m_tSensors.size());
    }
 
    /****************************************/
@@ -175,6 +187,45 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CProximitySensorEquippedEntity::CalculateRays(CRay3* pc_rays) {
+      size_t unNum = m_tSensors.size();
+      /* The second half of the scratch buffers holds the end points */
+      Real* pfStartX = &m_vecBufferX[0];
+      Real* pfStartY = &m_vecBufferY[0];
+      Real* pfStartZ = &m_vecBufferZ[0];
+      Real* pfEndX = pfStartX + unNum;
+      Real* pfEndY = pfStartY + unNum;
+      Real* pfEndZ = pfStartZ + unNum;
+      /* Transform the runs of sensors attached to the same anchor */
+      size_t unFirst = 0, unLast;
+      while(unFirst < unNum) {
+         SAnchor& sAnchor = m_tSensors[unFirst]->Anchor;
+         unLast = unFirst + 1;
+         while(unLast < unNum && &m_tSensors[unLast]->Anchor == &sAnchor) {
+            ++unLast;
+         }
+         BatchRotateTranslate(pfStartX + unFirst, pfStartY + unFirst, pfStartZ + unFirst,
+                              &m_vecOffsetX[unFirst], &m_vecOffsetY[unFirst], &m_vecOffsetZ[unFirst],
+                              unLast - unFirst,
+                              sAnchor.Orientation,
+                              sAnchor.Position);
+         BatchRotateTranslate(pfEndX + unFirst, pfEndY + unFirst, pfEndZ + unFirst,
+                              &m_vecEndX[unFirst], &m_vecEndY[unFirst], &m_vecEndZ[unFirst],
+                              unLast - unFirst,
+                              sAnchor.Orientation,
+                              sAnchor.Position);
+         unFirst = unLast;
+      }
+      /* Pack the results into rays */
+      for(size_t i = 0; i < unNum; ++i) {
+         pc_rays[i].Set(CVector3(pfStartX[i], pfStartY[i], pfStartZ[i]),
+                        CVector3(pfEndX[i], pfEndY[i], pfEndZ[i]));
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    REGISTER_STANDARD_SPACE_OPERATIONS_ON_ENTITY(CProximitySensorEquippedEntity);
    
    /****************************************/
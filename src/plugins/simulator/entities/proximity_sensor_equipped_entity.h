@@ -12,6 +12,7 @@ namespace argos {
 }
 
 #include <argos3/core/utility/math/vector3.h>
+#include <argos3/core/utility/math/ray3.h>
 #include <argos3/core/simulator/entity/entity.h>
 #include <argos3/core/simulator/entity/embodied_entity.h>
 #include <map>
@@ -80,11 +81,34 @@ namespace argos {
                          UInt32 un_num_sensors,
                          SAnchor& s_anchor);
 
+      /**
+       * Calculates the rays of all the sensors in the global reference frame.
+       * The rays start at the sensor offset and end at the sensor range.
+       * Sensors that share the same anchor are transformed in one batch.
+       * @param pc_rays The buffer to fill; it must hold GetNumSensors() rays.
+       */
+      void CalculateRays(CRay3* pc_rays);
+
    protected:
 
       /** The list of sensors */
       SSensor::TList m_tSensors;
 
+      /** The sensor offsets in the anchor reference frame, one array per axis */
+      std::vector<Real> m_vecOffsetX;
+      std::vector<Real> m_vecOffsetY;
+      std::vector<Real> m_vecOffsetZ;
+
+      /** The sensor range end points in the anchor reference frame, one array per axis */
+      std::vector<Real> m_vecEndX;
+      std::vector<Real> m_vecEndY;
+      std::vector<Real> m_vecEndZ;
+
+      /** Scratch buffers for the transformed points */
+      std::vector<Real> m_vecBufferX;
+      std::vector<Real> m_vecBufferY;
+      std::vector<Real> m_vecBufferZ;
+
    };
 
 }
@@ -59,6 +59,39 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CQuadRotorEntity::SaveState(CByteArray& c_buffer) {
+      CEntity::SaveState(c_buffer);
+      c_buffer << static_cast<UInt8>(m_eControlMethod)
+               << m_sPositionControlData.Position.GetX()
+               << m_sPositionControlData.Position.GetY()
+               << m_sPositionControlData.Position.GetZ()
+               << m_sPositionControlData.Yaw.GetValue()
+               << m_sSpeedControlData.Velocity.GetX()
+               << m_sSpeedControlData.Velocity.GetY()
+               << m_sSpeedControlData.Velocity.GetZ()
+               << m_sSpeedControlData.RotSpeed.GetValue();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CQuadRotorEntity::LoadState(CByteArray& c_buffer) {
+      CEntity::LoadState(c_buffer);
+      UInt8 unControlMethod;
+      Real fX, fY, fZ, fAngle;
+      c_buffer >> unControlMethod;
+      m_eControlMethod = static_cast<EControlMethod>(unControlMethod);
+      c_buffer >> fX >> fY >> fZ >> fAngle;
+      m_sPositionControlData.Position.Set(fX, fY, fZ);
+      m_sPositionControlData.Yaw.SetValue(fAngle);
+      c_buffer >> fX >> fY >> fZ >> fAngle;
+      m_sSpeedControlData.Velocity.Set(fX, fY, fZ);
+      m_sSpeedControlData.RotSpeed.SetValue(fAngle);
+   }
+
+   /****************************************/
+   /****************************************/
+
    REGISTER_STANDARD_SPACE_OPERATIONS_ON_ENTITY(CQuadRotorEntity);
 
    /****************************************/
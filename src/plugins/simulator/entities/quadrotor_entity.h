@@ -55,6 +55,10 @@ namespace argos {
 
       virtual void Reset();
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
       EControlMethod GetControlMethod() const {
          return m_eControlMethod;
       }
@@ -126,6 +126,28 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CRABEquippedEntity::SaveState(CByteArray& c_buffer) {
+      CPositionalEntity::SaveState(c_buffer);
+      c_buffer << static_cast<UInt32>(m_cData.Size());
+      c_buffer.AddBuffer(m_cData.ToCArray(), m_cData.Size());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABEquippedEntity::LoadState(CByteArray& c_buffer) {
+      CPositionalEntity::LoadState(c_buffer);
+      UInt32 unSize;
+      c_buffer >> unSize;
+      if(unSize != m_cData.Size()) {
+         THROW_ARGOSEXCEPTION("Saved state of range and bearing entity \"" << GetContext() << GetId() << "\" has a " << unSize << "-byte payload, but the entity has " << m_cData.Size() << " bytes");
+      }
+      c_buffer.FetchBuffer(m_cData.ToCArray(), unSize);
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CRABEquippedEntity::Enable() {
       if(m_psAnchor) m_psAnchor->Enable();
    }
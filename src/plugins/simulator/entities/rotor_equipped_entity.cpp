@@ -52,6 +52,26 @@ namespace argos {
    void CRotorEquippedEntity::Reset() {
       ::memset(m_pfRotorVelocities, 0, m_unNumRotors * sizeof(Real));
    }
+
+   /****************************************/
+   /****************************************/
+
+   void CRotorEquippedEntity::SaveState(CByteArray& c_buffer) {
+      CEntity::SaveState(c_buffer);
+      for(size_t i = 0; i < m_unNumRotors; ++i) {
+         c_buffer << m_pfRotorVelocities[i];
+      }
+   }
+   
+   /****************************************/
+   /****************************************/
+
+   void CRotorEquippedEntity::LoadState(CByteArray& c_buffer) {
+      CEntity::LoadState(c_buffer);
+      for(size_t i = 0; i < m_unNumRotors; ++i) {
+         c_buffer >> m_pfRotorVelocities[i];
+      }
+   }
    
    /****************************************/
    /****************************************/
@@ -57,6 +57,26 @@ namespace argos {
    void CWheeledEntity::Reset() {
       ::memset(m_pfWheelVelocities, 0, m_unNumWheels * sizeof(Real));
    }
+
+   /****************************************/
+   /****************************************/
+
+   void CWheeledEntity::SaveState(CByteArray& c_buffer) {
+      CEntity::SaveState(c_buffer);
+      for(size_t i = 0; i < m_unNumWheels; ++i) {
+         c_buffer << m_pfWheelVelocities[i];
+      }
+   }
+   
+   /****************************************/
+   /****************************************/
+
+   void CWheeledEntity::LoadState(CByteArray& c_buffer) {
+      CEntity::LoadState(c_buffer);
+      for(size_t i = 0; i < m_unNumWheels; ++i) {
+         c_buffer >> m_pfWheelVelocities[i];
+      }
+   }
    
    /****************************************/
    /****************************************/
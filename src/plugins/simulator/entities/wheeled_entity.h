@@ -31,6 +31,10 @@ namespace argos {
 
       virtual void Reset();
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
       inline size_t GetNumWheels() const {
          return m_unNumWheels;
       }
@@ -35,7 +35,8 @@ namespace argos {
          GetNodeAttribute(tArena, "size", cArenaSize);
          GetNodeAttributeOrDefault(tArena, "center", cArenaCenter, cArenaCenter);
          /* Create the positional index for LED entities */
-         if(strPosIndexMethod == "grid") {
+         if(strPosIndexMethod == "grid" ||
+            strPosIndexMethod == "sparse_grid") {
             size_t punGridSize[3];
             if(!NodeAttributeExists(t_tree, "grid_size")) {
                punGridSize[0] = cArenaSize.GetX();
@@ -49,9 +50,12 @@ namespace argos {
             }
             CGrid<CLEDEntity>* pcGrid = new CGrid<CLEDEntity>(
                cArenaCenter - cArenaSize * 0.5f, cArenaCenter + cArenaSize * 0.5f,
-               punGridSize[0], punGridSize[1], punGridSize[2]);
+               punGridSize[0], punGridSize[1], punGridSize[2],
+               strPosIndexMethod == "sparse_grid");
             m_pcLEDEntityGridUpdateOperation = new CLEDEntityGridUpdater(*pcGrid);
             pcGrid->SetUpdateEntityOperation(m_pcLEDEntityGridUpdateOperation);
+            /* The LEDs tell the grid when they move or change color */
+            pcGrid->EnableDirtyTracking();
             m_pcLEDEntityIndex = pcGrid;
          }
          else {
@@ -68,6 +72,8 @@ namespace argos {
 
    void CLEDMedium::PostSpaceInit() {
       Update();
+      /* Reset() puts the LEDs back in the cells they occupy now */
+      m_pcLEDEntityIndex->TakeSnapshot();
    }
 
    /****************************************/
@@ -123,7 +129,18 @@ namespace argos {
                    "REQUIRED XML CONFIGURATION\n\n"
                    "<led id=\"led\" />\n\n"
                    "OPTIONAL XML CONFIGURATION\n\n"
-                   "None for the time being\n",
+                   "The LEDs are indexed in a grid that covers the arena. By default, the grid\n"
+                   "has one cell per cubic meter. You can change the number of cells along X, Y\n"
+                   "and Z with the 'grid_size' attribute:\n\n"
+                   "<led id=\"led\"\n"
+                   "     grid_size=\"20,20,1\" />\n\n"
+                   "For very large arenas with few LEDs, most of the cells of the grid are empty.\n"
+                   "In this case, setting the 'index' attribute to 'sparse_grid' stores only\n"
+                   "the occupied cells in a hash table, which saves memory:\n\n"
+                   "<led id=\"led\"\n"
+                   "     index=\"sparse_grid\"\n"
+                   "     grid_size=\"1000,1000,1\" />\n\n"
+                   "The 'index' attribute defaults to 'grid'.\n",
                    "Under development"
       );
 
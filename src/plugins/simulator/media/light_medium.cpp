@@ -0,0 +1,102 @@
+/**
+ * @file <argos3/plugins/simulator/media/light_medium.cpp>
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#include "light_medium.h"
+#include <argos3/core/utility/configuration/argos_exception.h>
+#include <algorithm>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   CLightMedium::CLightMedium() {
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CLightMedium::~CLightMedium() {
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLightMedium::Init(TConfigurationNode& t_tree) {
+      try {
+         CMedium::Init(t_tree);
+      }
+      catch(CARGoSException& ex) {
+         THROW_ARGOSEXCEPTION_NESTED("Error in initialization of the light medium", ex);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLightMedium::Reset() {
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLightMedium::Destroy() {
+      m_vecLights.clear();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLightMedium::Update() {
+      /* The sensors read the position and intensity of the lights directly */
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLightMedium::AddEntity(CLightEntity& c_entity) {
+      if(std::find(m_vecLights.begin(), m_vecLights.end(), &c_entity) == m_vecLights.end()) {
+         m_vecLights.push_back(&c_entity);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLightMedium::RemoveEntity(CLightEntity& c_entity) {
+      std::vector<CLightEntity*>::iterator it =
+         std::find(m_vecLights.begin(), m_vecLights.end(), &c_entity);
+      if(it != m_vecLights.end()) {
+         m_vecLights.erase(it);
+      }
+      else {
+         THROW_ARGOSEXCEPTION("Can't erase entity \"" << c_entity.GetId() << "\" from light medium \"" << GetId() << "\"");
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   REGISTER_MEDIUM(CLightMedium,
+                   "light",
+                   "Carlo Pinciroli [ilpincy@gmail.com]",
+                   "1.0",
+                   "Manages the lights.",
+                   "This medium keeps track of the light entities, so that the light sensors can\n"
+                   "access them quickly. It is optional: when a light sensor is not associated to\n"
+                   "a light medium, it looks for the lights among all the entities in the space.\n"
+                   "Every light entity is automatically added to all the light media.\n\n"
+                   "REQUIRED XML CONFIGURATION\n\n"
+                   "<light id=\"lights\" />\n\n"
+                   "OPTIONAL XML CONFIGURATION\n\n"
+                   "None for the time being\n",
+                   "Under development"
+      );
+
+   /****************************************/
+   /****************************************/
+
+}
@@ -0,0 +1,78 @@
+/**
+ * @file <argos3/plugins/simulator/media/light_medium.h>
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#ifndef LIGHT_MEDIUM_H
+#define LIGHT_MEDIUM_H
+
+namespace argos {
+   class CLightMedium;
+   class CLightEntity;
+}
+
+#include <argos3/core/simulator/medium/medium.h>
+#include <argos3/plugins/simulator/entities/light_entity.h>
+#include <vector>
+
+namespace argos {
+
+   /**
+    * The light medium.
+    * <p>
+    * It keeps the light entities in a dense array, so that the light sensors
+    * do not need to go through the entity maps of the space at every step.
+    * Light entities add themselves to every light medium when they are
+    * initialized.
+    * </p>
+    */
+   class CLightMedium : public CMedium {
+
+   public:
+
+      /**
+       * Class constructor.
+       */
+      CLightMedium();
+
+      /**
+       * Class destructor.
+       */
+      virtual ~CLightMedium();
+
+      virtual void Init(TConfigurationNode& t_tree);
+      virtual void Reset();
+      virtual void Destroy();
+      virtual void Update();
+
+     /**
+      * Adds the specified entity to the list of managed entities.
+      * @param c_entity The entity to add.
+      */
+      void AddEntity(CLightEntity& c_entity);
+
+     /**
+      * Removes the specified entity from the list of managed entities.
+      * @param c_entity The entity to remove.
+      */
+      void RemoveEntity(CLightEntity& c_entity);
+
+      /**
+       * Returns the light entities managed by this medium.
+       * @return The light entities managed by this medium.
+       */
+      inline const std::vector<CLightEntity*>& GetLights() const {
+         return m_vecLights;
+      }
+
+   private:
+
+      /** The light entities */
+      std::vector<CLightEntity*> m_vecLights;
+
+   };
+
+}
+
+#endif
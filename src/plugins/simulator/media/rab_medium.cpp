@@ -5,13 +5,27 @@
 #include <argos3/core/simulator/space/positional_indices/grid.h>
 #include <argos3/core/utility/configuration/argos_exception.h>
 #include <argos3/core/utility/logging/argos_log.h>
+#include <argos3/core/utility/math/batch.h>
+#include <algorithm>
+#include <cstring>
 
 namespace argos {
 
    /****************************************/
    /****************************************/
 
-   CRABMedium::CRABMedium() {
+   /* How many RAB entities a thread takes at a time */
+   static const size_t RAB_CHUNK_SIZE = 16;
+
+   /****************************************/
+   /****************************************/
+
+   CRABMedium::CRABMedium() :
+      m_pcRABEquippedEntityIndex(NULL),
+      m_pcRABEquippedEntityGridUpdateOperation(NULL),
+      m_bCacheOcclusions(false),
+      m_fCacheTolerance(0.001f),
+      m_unNextRAB(0) {
    }
 
    /****************************************/
@@ -36,7 +50,8 @@ namespace argos {
          GetNodeAttribute(tArena, "size", cArenaSize);
          GetNodeAttributeOrDefault(tArena, "center", cArenaCenter, cArenaCenter);
          /* Create the positional index for embodied entities */
-         if(strPosIndexMethod == "grid") {
+         if(strPosIndexMethod == "grid" ||
+            strPosIndexMethod == "sparse_grid") {
             size_t punGridSize[3];
             if(!NodeAttributeExists(t_tree, "grid_size")) {
                punGridSize[0] = cArenaSize.GetX();
@@ -50,7 +65,8 @@ namespace argos {
             }
             CGrid<CRABEquippedEntity>* pcGrid = new CGrid<CRABEquippedEntity>(
                cArenaCenter - cArenaSize * 0.5f, cArenaCenter + cArenaSize * 0.5f,
-               punGridSize[0], punGridSize[1], punGridSize[2]);
+               punGridSize[0], punGridSize[1], punGridSize[2],
+               strPosIndexMethod == "sparse_grid");
             m_pcRABEquippedEntityGridUpdateOperation = new CRABEquippedEntityGridEntityUpdater(*pcGrid);
             pcGrid->SetUpdateEntityOperation(m_pcRABEquippedEntityGridUpdateOperation);
             m_pcRABEquippedEntityIndex = pcGrid;
@@ -58,6 +74,15 @@ namespace argos {
          else {
             THROW_ARGOSEXCEPTION("Unknown method \"" << strPosIndexMethod << "\" for the positional index.");
          }
+         /* Get the occlusion cache settings */
+         GetNodeAttributeOrDefault(t_tree, "cache_occlusions", m_bCacheOcclusions, m_bCacheOcclusions);
+         GetNodeAttributeOrDefault(t_tree, "cache_tolerance", m_fCacheTolerance, m_fCacheTolerance);
+         if(m_bCacheOcclusions) {
+            CSimulator::GetInstance().GetSpace().GetMotionGrid().Enable(m_fCacheTolerance);
+         }
+         /* One set of links and buffers per thread of the space */
+         m_vecThreadLinks.resize(Max<UInt32>(CSimulator::GetInstance().GetNumThreads(), 1));
+         m_vecThreadBuffers.resize(m_vecThreadLinks.size());
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Error in initialization of the range-and-bearing medium", ex);
@@ -69,6 +94,10 @@ namespace argos {
 
    void CRABMedium::PostSpaceInit() {
       Update();
+      UpdateThread(0, 1);
+      PostUpdate();
+      /* Reset() puts the RAB entities back in the cells they occupy now */
+      m_pcRABEquippedEntityIndex->TakeSnapshot();
    }
 
    /****************************************/
@@ -83,6 +112,12 @@ namespace argos {
           ++it) {
          it->second.clear();
       }
+      /* Forget the cached occlusion checks */
+      for(std::map<CRABEquippedEntity*, COcclusionCache>::iterator it = m_mapOcclusionCaches.begin();
+          it != m_mapOcclusionCaches.end();
+          ++it) {
+         it->second.Clear();
+      }
    }
 
    /****************************************/
@@ -98,98 +133,153 @@ namespace argos {
    /****************************************/
    /****************************************/
 
-   static UInt64 HashRABPair(const std::pair<CRABEquippedEntity*, CRABEquippedEntity*>& c_pair) {
-      UInt64 unA = *reinterpret_cast<unsigned long long*>(c_pair.first) & 0xFFFFFFFF;
-      UInt64 unB = *reinterpret_cast<unsigned long long*>(c_pair.second) & 0xFFFFFFFF;
-      return (unA << 32) | unB;
-   }
-
    void CRABMedium::Update() {
       /* Update positional index of RAB entities */
       m_pcRABEquippedEntityIndex->Update();
-      /* Delete routing table */
+      /* Delete routing table and index the RAB entities */
+      m_vecRABs.clear();
+      m_vecRoutingSets.clear();
+      m_vecOcclusionCaches.clear();
       for(TRoutingTable::iterator it = m_tRoutingTable.begin();
           it != m_tRoutingTable.end();
           ++it) {
          it->second.clear();
+         m_vecRABs.push_back(it->first);
+         m_vecRoutingSets.push_back(&it->second);
+         if(m_bCacheOcclusions) {
+            std::pair<std::map<CRABEquippedEntity*, COcclusionCache>::iterator, bool> cIns =
+               m_mapOcclusionCaches.insert(std::make_pair(it->first, COcclusionCache()));
+            if(cIns.second) cIns.first->second.Init(m_fCacheTolerance);
+            m_vecOcclusionCaches.push_back(&cIns.first->second);
+         }
+      }
+      /* For each RAB entity, get the list of RAB entities in range */
+      m_vecCandidates.resize(m_vecRABs.size());
+      for(size_t i = 0; i < m_vecRABs.size(); ++i) {
+         m_vecCandidates[i].clear();
+         m_pcRABEquippedEntityIndex->GetEntitiesAt(m_vecCandidates[i], m_vecRABs[i]->GetPosition());
       }
-      /* This map contains the pairs that have already been checked */
-      std::map<UInt64, std::pair<CRABEquippedEntity*, CRABEquippedEntity*> > mapPairsAlreadyChecked;
-      /* Iterator for the above structure */
-      std::map<UInt64, std::pair<CRABEquippedEntity*, CRABEquippedEntity*> >::iterator itPair;
-      /* Used as test key */
-      std::pair<CRABEquippedEntity*, CRABEquippedEntity*> cTestKey;
-      /* Used as hash for the test key */
-      UInt64 unTestHash;
+      /* The threads of the space check the pairs in UpdateThread() */
+      m_unNextRAB = 0;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::UpdateThread(UInt32 un_thread,
+                                 UInt32 un_threads) {
+      CheckPairs(m_vecThreadLinks[un_thread], m_vecThreadBuffers[un_thread]);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::PostUpdate() {
+      /* Fill the routing table with the links found by the threads */
+      for(size_t i = 0; i < m_vecThreadLinks.size(); ++i) {
+         for(size_t j = 0; j < m_vecThreadLinks[i].size(); ++j) {
+            m_vecThreadLinks[i][j].first->insert(m_vecThreadLinks[i][j].second);
+         }
+         m_vecThreadLinks[i].clear();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::CheckPairs(std::vector<TLink>& vec_links,
+                               SDistanceBuffers& s_buffers) {
+      size_t unBegin, unEnd;
+      while(1) {
+         /* Take the next chunk of RAB entities */
+         unBegin = __sync_fetch_and_add(&m_unNextRAB, RAB_CHUNK_SIZE);
+         if(unBegin >= m_vecRABs.size()) return;
+         unEnd = Min(unBegin + RAB_CHUNK_SIZE, m_vecRABs.size());
+         for(size_t i = unBegin; i < unEnd; ++i) {
+            CheckPairsOf(i, vec_links, s_buffers);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::CheckPairsOf(size_t un_index,
+                                 std::vector<TLink>& vec_links,
+                                 SDistanceBuffers& s_buffers) {
+      /* Get a reference to the RAB entity */
+      CRABEquippedEntity& cRAB = *m_vecRABs[un_index];
       /* The ray to use for occlusion checking */
       CRay3 cOcclusionCheckRay;
-      /* Buffer for the communicating entities */
-      CSet<CRABEquippedEntity*> cOtherRABs;
-      /* Buffer to store the intersection data */
-      SEmbodiedEntityIntersectionItem sIntersectionItem;
+      cOcclusionCheckRay.SetStart(cRAB.GetPosition());
       /* The distance between two RABs in line of sight */
       Real fDistance;
-      /* Go through the RAB entities */
-      for(TRoutingTable::iterator it = m_tRoutingTable.begin();
-          it != m_tRoutingTable.end();
-          ++it) {
-         /* Get a reference to the current RAB entity */
-         CRABEquippedEntity& cRAB = *(it->first);
-         /* Initialize the occlusion check ray start to the position of the robot */
-         cOcclusionCheckRay.SetStart(cRAB.GetPosition());
-         /* For each RAB entity, get the list of RAB entities in range */
-         cOtherRABs.clear();
-         m_pcRABEquippedEntityIndex->GetEntitiesAt(cOtherRABs, cRAB.GetPosition());
-         /* Go through the RAB entities in range */
-         for(CSet<CRABEquippedEntity*>::iterator it2 = cOtherRABs.begin();
-             it2 != cOtherRABs.end();
-             ++it2) {
-            /* Get a reference to the RAB entity */
-            CRABEquippedEntity& cOtherRAB = **it2;
-            /* First, make sure the entities are not the same */
-            if(&cRAB != &cOtherRAB) {
-               /* Proceed if the pair has not been checked already */
-               if(&cRAB < &cOtherRAB) {
-                  cTestKey.first = &cRAB;
-                  cTestKey.second = &cOtherRAB;
-               }
-               else {
-                  cTestKey.first = &cOtherRAB;
-                  cTestKey.second = &cRAB;
-               }
-               unTestHash = HashRABPair(cTestKey);
-               itPair = mapPairsAlreadyChecked.find(unTestHash);
-               if(itPair == mapPairsAlreadyChecked.end() ||   /* Pair does not exist */
-                  itPair->second.first != cTestKey.first ||   /* Pair exists, but first RAB involved is different */
-                  itPair->second.second != cTestKey.second) { /* Pair exists, but second RAB involved is different */
-                  /* Mark this pair as already checked */
-                  mapPairsAlreadyChecked[unTestHash] = cTestKey;
-                  /* Proceed if the message size is compatible */
-                  if(cRAB.GetMsgSize() == cOtherRAB.GetMsgSize()) {
-                     /* Proceed if the two entities are not obstructed by another object */
-                     cOcclusionCheckRay.SetEnd(cOtherRAB.GetPosition());
-                     if((!GetClosestEmbodiedEntityIntersectedByRay(sIntersectionItem,
-                                                                   cOcclusionCheckRay,
-                                                                   cRAB.GetEntityBody())) ||
-                        (&cOtherRAB.GetEntityBody() == sIntersectionItem.IntersectedEntity)) {
-                        /* If we get here, the two RAB entities are in direct line of sight */
-                        /* cRAB can receive cOtherRAB's message if it is in range, and viceversa */
-                        /* Calculate square distance */
-                        fDistance = cOcclusionCheckRay.GetLength();
-                        if(fDistance < cOtherRAB.GetRange()) {
-                           /* cRAB receives cOtherRAB's message */
-                           it->second.insert(&cOtherRAB);
-                        }
-                        if(fDistance < cRAB.GetRange()) {
-                           /* cOtherRAB receives cRAB's message */
-                           m_tRoutingTable[&cOtherRAB].insert(&cRAB);
-                        }
-                     } // occlusion found?
-                  } // is msg size the same?
-               } // is check necessary?
-            } // are entities the same?
-         } // for entities in range
-      } // for routing table
+      /* Calculate the distances to all the candidates at once */
+      const CSet<CRABEquippedEntity*>& cOtherRABs = m_vecCandidates[un_index];
+      s_buffers.X.resize(cOtherRABs.size());
+      s_buffers.Y.resize(cOtherRABs.size());
+      s_buffers.Z.resize(cOtherRABs.size());
+      s_buffers.SquareDistances.resize(cOtherRABs.size());
+      size_t k = 0;
+      for(CSet<CRABEquippedEntity*>::iterator it = cOtherRABs.begin();
+          it != cOtherRABs.end();
+          ++it, ++k) {
+         s_buffers.X[k] = (*it)->GetPosition().GetX();
+         s_buffers.Y[k] = (*it)->GetPosition().GetY();
+         s_buffers.Z[k] = (*it)->GetPosition().GetZ();
+      }
+      if(k > 0) {
+         BatchSquareDistance(&s_buffers.SquareDistances[0],
+                             &s_buffers.X[0],
+                             &s_buffers.Y[0],
+                             &s_buffers.Z[0],
+                             k,
+                             cRAB.GetPosition());
+      }
+      /* Go through the RAB entities in range */
+      k = 0;
+      for(CSet<CRABEquippedEntity*>::iterator it = cOtherRABs.begin();
+          it != cOtherRABs.end();
+          ++it, ++k) {
+         /* Get a reference to the RAB entity */
+         CRABEquippedEntity& cOtherRAB = **it;
+         /* First, make sure the entities are not the same */
+         if(&cRAB == &cOtherRAB) continue;
+         /* Skip the pair if neither entity is in range of the other */
+         if(s_buffers.SquareDistances[k] > Square(Max(cRAB.GetRange(), cOtherRAB.GetRange()))) continue;
+         /*
+          * Each pair must be checked only once.
+          * The pair is checked here if cRAB comes first, or if cOtherRAB
+          * comes first but it does not have cRAB among its candidates.
+          */
+         size_t unOtherIndex = std::lower_bound(m_vecRABs.begin(), m_vecRABs.end(), &cOtherRAB) - m_vecRABs.begin();
+         if(unOtherIndex < un_index &&
+            m_vecCandidates[unOtherIndex].exists(&cRAB)) continue;
+         /* Proceed if the message size is compatible */
+         if(cRAB.GetMsgSize() != cOtherRAB.GetMsgSize()) continue;
+         /* Proceed if the two entities are not obstructed by another object */
+         cOcclusionCheckRay.SetEnd(cOtherRAB.GetPosition());
+         if(m_bCacheOcclusions) {
+            if(m_vecOcclusionCaches[un_index]->IsSegmentOccluded(&cOtherRAB,
+                                                                 cOcclusionCheckRay,
+                                                                 &cRAB.GetEntityBody(),
+                                                                 &cOtherRAB.GetEntityBody())) continue;
+         }
+         else if(IsSegmentOccluded(cOcclusionCheckRay,
+                                   &cRAB.GetEntityBody(),
+                                   &cOtherRAB.GetEntityBody())) continue;
+         /* If we get here, the two RAB entities are in direct line of sight */
+         /* cRAB can receive cOtherRAB's message if it is in range, and viceversa */
+         fDistance = cOcclusionCheckRay.GetLength();
+         if(fDistance < cOtherRAB.GetRange()) {
+            /* cRAB receives cOtherRAB's message */
+            vec_links.push_back(TLink(m_vecRoutingSets[un_index], &cOtherRAB));
+         }
+         if(fDistance < cRAB.GetRange()) {
+            /* cOtherRAB receives cRAB's message */
+            vec_links.push_back(TLink(m_vecRoutingSets[unOtherIndex], &cRAB));
+         }
+      }
    }
 
    /****************************************/
@@ -210,6 +300,7 @@ namespace argos {
       if(it != m_tRoutingTable.end()) {
          m_pcRABEquippedEntityIndex->RemoveEntity(c_entity);
          m_tRoutingTable.erase(it);
+         m_mapOcclusionCaches.erase(&c_entity);
       }
       else {
          THROW_ARGOSEXCEPTION("Can't erase entity \"" << c_entity.GetId() << "\" from RAB medium \"" << GetId() << "\"");
@@ -244,7 +335,27 @@ namespace argos {
                    "REQUIRED XML CONFIGURATION\n\n"
                    "<range_and_bearing id=\"rab\" />\n\n"
                    "OPTIONAL XML CONFIGURATION\n\n"
-                   "None for the time being\n",
+                   "By default, the occlusion check of each pair of entities is performed at\n"
+                   "every step. When many robots stand still, the result of these checks can\n"
+                   "be cached and reused as long as nothing moves along the ray:\n\n"
+                   "<range_and_bearing id=\"rab\"\n"
+                   "                   cache_occlusions=\"true\"\n"
+                   "                   cache_tolerance=\"0.001\" />\n\n"
+                   "The 'cache_tolerance' attribute sets how much (in meters) an entity can\n"
+                   "move before the cached checks that involve it are discarded. It defaults\n"
+                   "to 0.001. Entities moved by the loop functions are noticed at the next\n"
+                   "step.\n\n"
+                   "The entities are indexed in a grid that covers the arena. By default, the\n"
+                   "grid has one cell per cubic meter. You can change the number of cells along\n"
+                   "X, Y and Z with the 'grid_size' attribute. For very large arenas with few\n"
+                   "robots, setting the 'index' attribute to 'sparse_grid' stores only the\n"
+                   "occupied cells in a hash table, which saves memory:\n\n"
+                   "<range_and_bearing id=\"rab\"\n"
+                   "                   index=\"sparse_grid\"\n"
+                   "                   grid_size=\"1000,1000,1\" />\n\n"
+                   "The 'index' attribute defaults to 'grid'.\n\n"
+                   "When the simulation runs with multiple threads, the threads of the space\n"
+                   "share the calculation of which entities can communicate.\n",
                    "Under development"
       );
 
@@ -7,12 +7,28 @@ namespace argos {
 }
 
 #include <argos3/core/simulator/medium/medium.h>
+#include <argos3/core/simulator/physics_engine/occlusion_cache.h>
 #include <argos3/core/simulator/space/positional_indices/positional_index.h>
 #include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_sensor.h>
 #include <argos3/plugins/simulator/entities/rab_equipped_entity.h>
 
 namespace argos {
 
+   /**
+    * The range-and-bearing medium.
+    * <p>
+    * At each step, the medium calculates which RAB entities can communicate.
+    * Every pair of RAB entities in range is checked once, casting a single
+    * occlusion ray. When the simulation uses multiple threads, the pair
+    * checks are split among the threads of the space in UpdateThread().
+    * Each thread collects the links it finds, and the routing table is
+    * filled with these links in PostUpdate().
+    * </p>
+    * <p>
+    * Optionally, the medium can store the result of the occlusion check of
+    * each pair and reuse it while nothing moves along the ray.
+    * </p>
+    */
    class CRABMedium : public CMedium {
 
    public:
@@ -32,6 +48,9 @@ namespace argos {
       virtual void Reset();
       virtual void Destroy();
       virtual void Update();
+      virtual void UpdateThread(UInt32 un_thread,
+                                UInt32 un_threads);
+      virtual void PostUpdate();
 
       /**
        * Adds the specified entity to the list of managed entities.
@@ -53,6 +72,40 @@ namespace argos {
        */
       const CSet<CRABEquippedEntity*>& GetRABsCommunicatingWith(CRABEquippedEntity& c_entity) const;
 
+   private:
+
+      /** A link to add to the routing table: the set of the receiver and the sender */
+      typedef std::pair<CSet<CRABEquippedEntity*>*, CRABEquippedEntity*> TLink;
+
+      /** Scratch buffers used by a thread to calculate the distances to the candidates */
+      struct SDistanceBuffers {
+         std::vector<Real> X;
+         std::vector<Real> Y;
+         std::vector<Real> Z;
+         std::vector<Real> SquareDistances;
+      };
+
+   private:
+
+      /**
+       * Checks the pairs of RAB entities, taking the entities in chunks
+       * until none is left.
+       * @param vec_links The vector where the links found are appended.
+       * @param s_buffers The scratch buffers of the calling thread.
+       */
+      void CheckPairs(std::vector<TLink>& vec_links,
+                      SDistanceBuffers& s_buffers);
+
+      /**
+       * Checks the pairs formed by the given RAB entity and its candidates.
+       * @param un_index The index of the entity in m_vecRABs.
+       * @param vec_links The vector where the links found are appended.
+       * @param s_buffers The scratch buffers of the calling thread.
+       */
+      void CheckPairsOf(size_t un_index,
+                        std::vector<TLink>& vec_links,
+                        SDistanceBuffers& s_buffers);
+
    private:
 
       /** Defines the routing table */
@@ -67,6 +120,35 @@ namespace argos {
       /** The update operation for the grid positional index */
       CRABEquippedEntityGridEntityUpdater* m_pcRABEquippedEntityGridUpdateOperation;
 
+      /** The RAB entities, ordered by pointer like the routing table */
+      std::vector<CRABEquippedEntity*> m_vecRABs;
+
+      /** The routing table entries of the RAB entities in m_vecRABs */
+      std::vector<CSet<CRABEquippedEntity*>*> m_vecRoutingSets;
+
+      /** For each RAB entity in m_vecRABs, the RAB entities that might be in range */
+      std::vector<CSet<CRABEquippedEntity*> > m_vecCandidates;
+
+      /** True if the results of the occlusion checks must be cached */
+      bool m_bCacheOcclusions;
+
+      /** How much a RAB entity can move before its cached occlusion checks are discarded */
+      Real m_fCacheTolerance;
+
+      /** The occlusion caches of the RAB entities */
+      std::map<CRABEquippedEntity*, COcclusionCache> m_mapOcclusionCaches;
+
+      /** The occlusion caches of the RAB entities in m_vecRABs */
+      std::vector<COcclusionCache*> m_vecOcclusionCaches;
+
+      /** The links found by each thread */
+      std::vector<std::vector<TLink> > m_vecThreadLinks;
+
+      /** The scratch buffers of each thread */
+      std::vector<SDistanceBuffers> m_vecThreadBuffers;
+
+      /** The index of the next RAB entity whose pairs must be checked */
+      volatile size_t m_unNextRAB;
    };
 
 }
@@ -52,27 +52,7 @@ namespace argos {
          /* Used to attach static geometries so that they won't move and to simulate friction */
          m_ptGroundBody = cpBodyNew(INFINITY, INFINITY);
          /* Create the space to contain the movable objects */
-         m_ptSpace = cpSpaceNew();
-         /* Subiterations to solve constraints.
-            The more, the better for precision but the worse for speed
-         */
-         m_ptSpace->iterations = GetIterations();
-         /* Resize the space hash.
-            This has dramatic effects on performance.
-            TODO: - find optimal parameters automatically (average entity size)
-            cpSpaceReindexStaticHash(m_ptSpace, m_fStaticHashCellSize, m_nStaticHashCells);
-            cpSpaceResizeActiveHash(m_ptSpace, m_fActiveHashCellSize, m_nActiveHashCells);
-         */
-         /* Gripper-Gripped callback functions */
-         cpSpaceAddCollisionHandler(
-            m_ptSpace,
-            SHAPE_GRIPPER,
-            SHAPE_GRIPPABLE,
-            BeginCollisionBetweenGripperAndGrippable,
-            ManageCollisionBetweenGripperAndGrippable,
-            NULL,
-            NULL,
-            NULL);
+         CreatePhysicsSpace();
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Error initializing the dynamics 2D engine \"" << GetId() << "\"", ex);
@@ -82,12 +62,39 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CDynamics2DEngine::CreatePhysicsSpace() {
+      m_ptSpace = cpSpaceNew();
+      /* Subiterations to solve constraints.
+         The more, the better for precision but the worse for speed
+      */
+      m_ptSpace->iterations = GetIterations();
+      /* Resize the space hash.
+         This has dramatic effects on performance.
+         TODO: - find optimal parameters automatically (average entity size)
+         cpSpaceReindexStaticHash(m_ptSpace, m_fStaticHashCellSize, m_nStaticHashCells);
+         cpSpaceResizeActiveHash(m_ptSpace, m_fActiveHashCellSize, m_nActiveHashCells);
+      */
+      /* Gripper-Gripped callback functions */
+      cpSpaceAddCollisionHandler(
+         m_ptSpace,
+         SHAPE_GRIPPER,
+         SHAPE_GRIPPABLE,
+         BeginCollisionBetweenGripperAndGrippable,
+         ManageCollisionBetweenGripperAndGrippable,
+         NULL,
+         NULL,
+         NULL);
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CDynamics2DEngine::Reset() {
       for(CDynamics2DModel::TMap::iterator it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
          it->second->Reset();
       }
-      cpSpaceReindexStatic(m_ptSpace);
+      /* Static bodies are not moved by Reset(), so their index is still valid */
    }
 
    /****************************************/
@@ -113,6 +120,55 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CDynamics2DEngine::SaveState(CByteArray& c_buffer) {
+      RebuildPhysicsSpace();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DEngine::LoadState(CByteArray& c_buffer) {
+      /* The models have just loaded their state */
+      RebuildPhysicsSpace();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DEngine::RebuildPhysicsSpace() {
+      /*
+       * Keep the state of the models aside, then rebuild the models and the
+       * space from the entities, so that no contact or joint impulse survives
+       */
+      CByteArray cModelStates;
+      std::vector<CEntity*> vecEntities;
+      for(CDynamics2DModel::TMap::iterator it = m_tPhysicsModels.begin();
+          it != m_tPhysicsModels.end(); ++it) {
+         it->second->SaveState(cModelStates);
+         vecEntities.push_back(&it->second->GetEmbodiedEntity().GetRootEntity());
+      }
+      for(size_t i = 0; i < vecEntities.size(); ++i) {
+         RemoveEntity(*vecEntities[i]);
+      }
+      cpFloat fDamping = cpSpaceGetDamping(m_ptSpace);
+      cpVect tGravity = cpSpaceGetGravity(m_ptSpace);
+      cpSpaceFree(m_ptSpace);
+      CreatePhysicsSpace();
+      cpSpaceSetDamping(m_ptSpace, fDamping);
+      cpSpaceSetGravity(m_ptSpace, tGravity);
+      for(size_t i = 0; i < vecEntities.size(); ++i) {
+         AddEntity(*vecEntities[i]);
+      }
+      /* The map is sorted by id, so the models come back in the same order */
+      for(CDynamics2DModel::TMap::iterator it = m_tPhysicsModels.begin();
+          it != m_tPhysicsModels.end(); ++it) {
+         it->second->LoadState(cModelStates);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CDynamics2DEngine::Destroy() {
       /* Empty the physics model map */
       for(CDynamics2DModel::TMap::iterator it = m_tPhysicsModels.begin();
@@ -200,6 +256,163 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   struct SDynamics2DClosestSegmentHitData {
+      SEmbodiedEntityIntersectionItem& Closest;
+      const CRay3& Ray;
+      const CEmbodiedEntity* IgnoredEntity;
+      cpVect Start;
+      cpVect End;
+      cpFloat Clip;
+      bool Found;
+
+      SDynamics2DClosestSegmentHitData(SEmbodiedEntityIntersectionItem& s_closest,
+                                       const CRay3& c_ray,
+                                       const CEmbodiedEntity* pc_ignored_entity) :
+         Closest(s_closest),
+         Ray(c_ray),
+         IgnoredEntity(pc_ignored_entity),
+         Start(cpv(c_ray.GetStart().GetX(), c_ray.GetStart().GetY())),
+         End(cpv(c_ray.GetEnd().GetX(), c_ray.GetEnd().GetY())),
+         Clip(1.0f),
+         Found(false) {}
+   };
+
+   /*
+    * Called by the spatial index for each shape whose bounding box is
+    * crossed by the query segment. The hit is computed on the full ray,
+    * so that t has the same meaning as in CheckIntersectionWithRay().
+    * The returned value is the new exit t on the clipped query segment;
+    * the BB tree used by the chipmunk space ignores it, but the spatial
+    * hash honors it.
+    */
+   static cpFloat Dynamics2DClosestSegmentQueryFunc(void* pt_data, void* pt_shape, void*) {
+      /* Get the data associated to this query */
+      SDynamics2DClosestSegmentHitData& sData = *reinterpret_cast<SDynamics2DClosestSegmentHitData*>(pt_data);
+      cpShape* ptShape = reinterpret_cast<cpShape*>(pt_shape);
+      /* Is there a hit closer than the current one? */
+      cpSegmentQueryInfo tInfo;
+      if(cpShapeSegmentQuery(ptShape, sData.Start, sData.End, &tInfo) &&
+         tInfo.t < sData.Closest.TOnRay) {
+         /* Is it within the limits? */
+         CDynamics2DModel& cModel = *reinterpret_cast<CDynamics2DModel*>(ptShape->body->data);
+         if(&cModel.GetEmbodiedEntity() != sData.IgnoredEntity) {
+            CVector3 cIntersectionPoint;
+            sData.Ray.GetPoint(cIntersectionPoint, tInfo.t);
+            if((cIntersectionPoint.GetZ() >= cModel.GetBoundingBox().MinCorner.GetZ()) &&
+               (cIntersectionPoint.GetZ() <= cModel.GetBoundingBox().MaxCorner.GetZ()) ) {
+               /* Yes, a real hit */
+               sData.Closest.IntersectedEntity = &cModel.GetEmbodiedEntity();
+               sData.Closest.TOnRay = tInfo.t;
+               sData.Found = true;
+            }
+         }
+      }
+      return sData.Closest.TOnRay / sData.Clip;
+   }
+
+   bool CDynamics2DEngine::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                           const CRay3& c_ray,
+                                                           const CEmbodiedEntity* pc_entity) const {
+      SDynamics2DClosestSegmentHitData sHitData(s_item, c_ray, pc_entity);
+      /* Query the static shapes, clipping the segment at the closest hit found so far */
+      if(s_item.TOnRay <= 0.0f) return false;
+      sHitData.Clip = s_item.TOnRay;
+      cpSpatialIndexSegmentQuery(m_ptSpace->staticShapes,
+                                 &sHitData,
+                                 sHitData.Start,
+                                 cpvlerp(sHitData.Start, sHitData.End, sHitData.Clip),
+                                 1.0f,
+                                 Dynamics2DClosestSegmentQueryFunc,
+                                 NULL);
+      /* Query the active shapes, clipping the segment again */
+      if(s_item.TOnRay <= 0.0f) return sHitData.Found;
+      sHitData.Clip = s_item.TOnRay;
+      cpSpatialIndexSegmentQuery(m_ptSpace->activeShapes,
+                                 &sHitData,
+                                 sHitData.Start,
+                                 cpvlerp(sHitData.Start, sHitData.End, sHitData.Clip),
+                                 1.0f,
+                                 Dynamics2DClosestSegmentQueryFunc,
+                                 NULL);
+      return sHitData.Found;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   struct SDynamics2DOcclusionData {
+      const CRay3& Ray;
+      const CEmbodiedEntity* IgnoredEntity1;
+      const CEmbodiedEntity* IgnoredEntity2;
+      cpVect Start;
+      cpVect End;
+      bool Occluded;
+
+      SDynamics2DOcclusionData(const CRay3& c_ray,
+                               const CEmbodiedEntity* pc_ignored_entity_1,
+                               const CEmbodiedEntity* pc_ignored_entity_2) :
+         Ray(c_ray),
+         IgnoredEntity1(pc_ignored_entity_1),
+         IgnoredEntity2(pc_ignored_entity_2),
+         Start(cpv(c_ray.GetStart().GetX(), c_ray.GetStart().GetY())),
+         End(cpv(c_ray.GetEnd().GetX(), c_ray.GetEnd().GetY())),
+         Occluded(false) {}
+   };
+
+   /*
+    * Called by the spatial index for each shape whose bounding box is
+    * crossed by the segment. Once an occlusion is found, the remaining
+    * shapes are skipped.
+    */
+   static cpFloat Dynamics2DOcclusionQueryFunc(void* pt_data, void* pt_shape, void*) {
+      /* Get the data associated to this query */
+      SDynamics2DOcclusionData& sData = *reinterpret_cast<SDynamics2DOcclusionData*>(pt_data);
+      if(sData.Occluded) return 0.0f;
+      cpShape* ptShape = reinterpret_cast<cpShape*>(pt_shape);
+      /* Is the shape to be ignored? */
+      CDynamics2DModel& cModel = *reinterpret_cast<CDynamics2DModel*>(ptShape->body->data);
+      if(&cModel.GetEmbodiedEntity() == sData.IgnoredEntity1 ||
+         &cModel.GetEmbodiedEntity() == sData.IgnoredEntity2) return 1.0f;
+      /* Is there a hit within the limits? */
+      cpSegmentQueryInfo tInfo;
+      if(cpShapeSegmentQuery(ptShape, sData.Start, sData.End, &tInfo) &&
+         tInfo.t < 1.0f) {
+         CVector3 cIntersectionPoint;
+         sData.Ray.GetPoint(cIntersectionPoint, tInfo.t);
+         if((cIntersectionPoint.GetZ() >= cModel.GetBoundingBox().MinCorner.GetZ()) &&
+            (cIntersectionPoint.GetZ() <= cModel.GetBoundingBox().MaxCorner.GetZ()) ) {
+            sData.Occluded = true;
+            return 0.0f;
+         }
+      }
+      return 1.0f;
+   }
+
+   bool CDynamics2DEngine::IsSegmentOccluded(const CRay3& c_ray,
+                                             const CEmbodiedEntity* pc_entity_1,
+                                             const CEmbodiedEntity* pc_entity_2) const {
+      SDynamics2DOcclusionData sData(c_ray, pc_entity_1, pc_entity_2);
+      cpSpatialIndexSegmentQuery(m_ptSpace->staticShapes,
+                                 &sData,
+                                 sData.Start,
+                                 sData.End,
+                                 1.0f,
+                                 Dynamics2DOcclusionQueryFunc,
+                                 NULL);
+      if(sData.Occluded) return true;
+      cpSpatialIndexSegmentQuery(m_ptSpace->activeShapes,
+                                 &sData,
+                                 sData.Start,
+                                 sData.End,
+                                 1.0f,
+                                 Dynamics2DOcclusionQueryFunc,
+                                 NULL);
+      return sData.Occluded;
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CDynamics2DEngine::PositionPhysicsToSpace(CVector3& c_new_pos,
                                                   const CVector3& c_original_pos,
                                                   const cpBody* pt_body) {
@@ -63,6 +63,23 @@ namespace argos {
       virtual void Update();
       virtual void Destroy();
 
+      /**
+       * Rebuilds the physics models and the space from the current entities.
+       * The contact and joint impulses that Chipmunk caches for warm
+       * starting are not part of the checkpoint. Dropping them here too
+       * makes the run that saved the checkpoint continue exactly like the
+       * runs restored from it.
+       * @param c_buffer The target buffer.
+       */
+      virtual void SaveState(CByteArray& c_buffer);
+
+      /**
+       * Rebuilds the physics models and the space from the restored entities.
+       * As in SaveState(), the space starts with no cached impulses.
+       * @param c_buffer The source buffer.
+       */
+      virtual void LoadState(CByteArray& c_buffer);
+
       virtual size_t GetNumPhysicsModels();
       virtual bool AddEntity(CEntity& c_entity);
       virtual bool RemoveEntity(CEntity& c_entity);
@@ -70,6 +87,14 @@ namespace argos {
       virtual void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
                                             const CRay3& c_ray) const;
 
+      virtual bool CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                   const CRay3& c_ray,
+                                                   const CEmbodiedEntity* pc_entity) const;
+
+      virtual bool IsSegmentOccluded(const CRay3& c_ray,
+                                     const CEmbodiedEntity* pc_entity_1,
+                                     const CEmbodiedEntity* pc_entity_2) const;
+
       inline cpSpace* GetPhysicsSpace() {
          return m_ptSpace;
       }
@@ -113,6 +138,16 @@ namespace argos {
                             CDynamics2DModel& c_model);
       void RemovePhysicsModel(const std::string& str_id);
 
+   private:
+
+      void CreatePhysicsSpace();
+
+      /**
+       * Rebuilds the models and the space from the state of the models,
+       * dropping every cached contact and joint impulse.
+       */
+      void RebuildPhysicsSpace();
+
    private:
 
       cpFloat m_fStaticHashCellSize;
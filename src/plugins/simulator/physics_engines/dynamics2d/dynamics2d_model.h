@@ -13,6 +13,7 @@ namespace argos {
 
 #include <argos3/core/simulator/physics_engine/physics_model.h>
 #include <argos3/plugins/simulator/physics_engines/dynamics2d/dynamics2d_engine.h>
+#include <argos3/core/utility/math/ray3.h>
 
 namespace argos {
 
@@ -57,6 +58,77 @@ namespace argos {
          return m_cDyn2DEngine;
       }
 
+   protected:
+
+      /**
+       * Checks whether the given ray intersects the shapes of the given body.
+       * As in CDynamics2DEngine::CheckIntersectionWithRay(), a hit counts
+       * only if it falls within the height of the model.
+       * @param f_t_on_ray Set to the t on the ray of the closest intersection.
+       * @param c_ray The ray to test.
+       * @param pt_body The body whose shapes must be tested.
+       * @return <tt>true</tt> if the ray intersects the body.
+       */
+      inline bool CheckBodyIntersectionWithRay(Real& f_t_on_ray,
+                                               const CRay3& c_ray,
+                                               const cpBody* pt_body) const {
+         cpVect tStart = cpv(c_ray.GetStart().GetX(), c_ray.GetStart().GetY());
+         cpVect tEnd   = cpv(c_ray.GetEnd().GetX(),   c_ray.GetEnd().GetY());
+         bool bFound = false;
+         cpSegmentQueryInfo tInfo;
+         CVector3 cIntersectionPoint;
+         for(cpShape* ptShape = pt_body->shapeList;
+             ptShape != NULL;
+             ptShape = ptShape->next) {
+            if(cpShapeSegmentQuery(ptShape, tStart, tEnd, &tInfo) &&
+               (!bFound || tInfo.t < f_t_on_ray)) {
+               c_ray.GetPoint(cIntersectionPoint, tInfo.t);
+               if((cIntersectionPoint.GetZ() >= GetBoundingBox().MinCorner.GetZ()) &&
+                  (cIntersectionPoint.GetZ() <= GetBoundingBox().MaxCorner.GetZ()) ) {
+                  f_t_on_ray = tInfo.t;
+                  bFound = true;
+               }
+            }
+         }
+         return bFound;
+      }
+
+      /**
+       * Saves the state of the given body.
+       * Static bodies never move, so nothing is saved for them.
+       * @param c_buffer The target buffer.
+       * @param pt_body The body to save.
+       */
+      inline void SaveBodyState(CByteArray& c_buffer,
+                                const cpBody* pt_body) const {
+         if(cpBodyIsStatic(pt_body)) return;
+         c_buffer << pt_body->p.x << pt_body->p.y
+                  << pt_body->v.x << pt_body->v.y
+                  << pt_body->f.x << pt_body->f.y
+                  << pt_body->a
+                  << pt_body->w
+                  << pt_body->t;
+      }
+
+      /**
+       * Restores the state of the given body and reindexes its shapes.
+       * @param c_buffer The source buffer.
+       * @param pt_body The body to restore.
+       */
+      inline void LoadBodyState(CByteArray& c_buffer,
+                                cpBody* pt_body) {
+         if(cpBodyIsStatic(pt_body)) return;
+         cpFloat fA;
+         c_buffer >> pt_body->p.x >> pt_body->p.y
+                  >> pt_body->v.x >> pt_body->v.y
+                  >> pt_body->f.x >> pt_body->f.y
+                  >> fA
+                  >> pt_body->w
+                  >> pt_body->t;
+         cpBodySetAngle(pt_body, fA);
+         cpSpaceReindexShapesForBody(m_cDyn2DEngine.GetPhysicsSpace(), pt_body);
+      }
+
    private:
 
       CDynamics2DEngine& m_cDyn2DEngine;
@@ -47,7 +47,11 @@ namespace argos {
       c_orientation.ToEulerAngles(cZAngle, cYAngle, cXAngle);
       cpFloat tBodyOrient = cZAngle.GetValue();
       /* For each body: */
+      cpVect tOldPos;
+      cpFloat fOldOrient;
       for(size_t i = 0; i < m_vecBodies.size(); ++i) {
+         tOldPos = m_vecBodies[i].Body->p;
+         fOldOrient = m_vecBodies[i].Body->a;
          /* Set body orientation at anchor */
          cpBodySetAngle(m_vecBodies[i].Body,
                         tBodyOrient + m_vecBodies[i].OffsetOrient);
@@ -56,10 +60,12 @@ namespace argos {
                       cpvadd(tBodyPos,
                              cpvrotate(m_vecBodies[i].OffsetPos,
                                        m_vecBodies[i].Body->rot)));
-         
-         /* Update shape index */
-         cpSpaceReindexShapesForBody(GetDynamics2DEngine().GetPhysicsSpace(),
-                                     m_vecBodies[i].Body);
+         /* Update shape index, unless the body is where it was */
+         if(!cpveql(tOldPos, m_vecBodies[i].Body->p) ||
+            fOldOrient != m_vecBodies[i].Body->a) {
+            cpSpaceReindexShapesForBody(GetDynamics2DEngine().GetPhysicsSpace(),
+                                        m_vecBodies[i].Body);
+         }
       }
       /* Update ARGoS entity state */
       UpdateEntityStatus();
@@ -85,6 +91,25 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CDynamics2DMultiBodyObjectModel::SaveState(CByteArray& c_buffer) {
+      for(size_t i = 0; i < m_vecBodies.size(); ++i) {
+         SaveBodyState(c_buffer, m_vecBodies[i].Body);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DMultiBodyObjectModel::LoadState(CByteArray& c_buffer) {
+      for(size_t i = 0; i < m_vecBodies.size(); ++i) {
+         LoadBodyState(c_buffer, m_vecBodies[i].Body);
+      }
+      CalculateBoundingBox();
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CDynamics2DMultiBodyObjectModel::CalculateBoundingBox() {
       if(m_vecBodies.empty()) return;
       cpBB tBoundingBox;
@@ -133,6 +158,23 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   bool CDynamics2DMultiBodyObjectModel::CheckIntersectionWithRay(Real& f_t_on_ray,
+                                                                  const CRay3& c_ray) const {
+      bool bFound = false;
+      Real fTOnRay = 1.0f;
+      for(size_t i = 0; i < m_vecBodies.size(); ++i) {
+         if(CheckBodyIntersectionWithRay(fTOnRay, c_ray, m_vecBodies[i].Body) &&
+            (!bFound || fTOnRay < f_t_on_ray)) {
+            f_t_on_ray = fTOnRay;
+            bFound = true;
+         }
+      }
+      return bFound;
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CDynamics2DMultiBodyObjectModel::AddBody(cpBody* pt_body,
                                                  const cpVect& t_offset_pos,
                                                  cpFloat t_offset_orient,
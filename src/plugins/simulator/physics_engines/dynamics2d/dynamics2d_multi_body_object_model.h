@@ -112,10 +112,17 @@ namespace argos {
 
       virtual void CalculateBoundingBox();
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
       virtual void UpdateFromEntityStatus()  = 0;
 
       virtual bool IsCollidingWithSomething() const;
 
+      virtual bool CheckIntersectionWithRay(Real& f_t_on_ray,
+                                            const CRay3& c_ray) const;
+
       /**
        * Adds a body.
        * <p>
@@ -63,6 +63,8 @@ namespace argos {
    void CDynamics2DSingleBodyObjectModel::Reset() {
       /* Nothing to do for a static body */
       if(cpBodyIsStatic(m_ptBody)) return;
+      cpVect tOldPos = m_ptBody->p;
+      cpFloat fOldOrient = m_ptBody->a;
       /* Reset body position */
       const CVector3& cPosition = GetEmbodiedEntity().GetOriginAnchor().Position;
       m_ptBody->p = cpv(cPosition.GetX(), cPosition.GetY());
@@ -74,8 +76,26 @@ namespace argos {
       m_ptBody->v = cpvzero;
       m_ptBody->w = 0.0f;
       cpBodyResetForces(m_ptBody);
-      /* Update bounding box */
-      cpSpaceReindexShapesForBody(GetDynamics2DEngine().GetPhysicsSpace(), m_ptBody);
+      /* Update bounding box, unless the body is where it was */
+      if(!cpveql(tOldPos, m_ptBody->p) ||
+         fOldOrient != m_ptBody->a) {
+         cpSpaceReindexShapesForBody(GetDynamics2DEngine().GetPhysicsSpace(), m_ptBody);
+         CalculateBoundingBox();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DSingleBodyObjectModel::SaveState(CByteArray& c_buffer) {
+      SaveBodyState(c_buffer, m_ptBody);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DSingleBodyObjectModel::LoadState(CByteArray& c_buffer) {
+      LoadBodyState(c_buffer, m_ptBody);
       CalculateBoundingBox();
    }
 
@@ -129,6 +149,14 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   bool CDynamics2DSingleBodyObjectModel::CheckIntersectionWithRay(Real& f_t_on_ray,
+                                                                   const CRay3& c_ray) const {
+      return CheckBodyIntersectionWithRay(f_t_on_ray, c_ray, m_ptBody);
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CDynamics2DSingleBodyObjectModel::SetBody(cpBody* pt_body,
                                                   Real f_height) {
       /* Set the body and its data field for ray queries */
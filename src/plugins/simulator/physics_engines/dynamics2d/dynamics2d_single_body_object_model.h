@@ -102,12 +102,19 @@ namespace argos {
 
       virtual void CalculateBoundingBox();
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
       virtual void UpdateEntityStatus();
 
       virtual void UpdateFromEntityStatus()  = 0;
 
       virtual bool IsCollidingWithSomething() const;
 
+      virtual bool CheckIntersectionWithRay(Real& f_t_on_ray,
+                                            const CRay3& c_ray) const;
+
       /**
        * Sets the body and registers the default origin anchor method.
        * <p>
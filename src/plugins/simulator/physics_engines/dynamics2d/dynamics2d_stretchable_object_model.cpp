@@ -51,6 +51,17 @@ namespace argos {
       }
       CDynamics2DSingleBodyObjectModel::Reset();
    }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DStretchableObjectModel::LoadState(CByteArray& c_buffer) {
+      if(m_pcGrippable != NULL) {
+         /* Grippers attach again at the next contact */
+         m_pcGrippable->ReleaseAll();
+      }
+      CDynamics2DSingleBodyObjectModel::LoadState(c_buffer);
+   }
    
    /****************************************/
    /****************************************/
@@ -43,6 +43,8 @@ namespace argos {
 
       virtual void Reset();
 
+      virtual void LoadState(CByteArray& c_buffer);
+
       virtual void UpdateFromEntityStatus() {}
 
       inline Real GetMass() const {
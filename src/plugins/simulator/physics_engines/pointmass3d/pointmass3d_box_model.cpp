@@ -22,15 +22,29 @@ namespace argos {
    /****************************************/
 
    void CPointMass3DBoxModel::CalculateBoundingBox() {
-      CVector3 cHalfSize = 0.5f * m_cBoxEntity.GetSize();
-      GetBoundingBox().MinCorner.Set(
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetX() - cHalfSize.GetX(),
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetY() - cHalfSize.GetY(),
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetZ());
-      GetBoundingBox().MaxCorner.Set(
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetX() + cHalfSize.GetX(),
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetY() + cHalfSize.GetY(),
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetZ() + m_cBoxEntity.GetSize().GetZ());
+      /* Take the rotated corners of the box, with the origin at the center of the base */
+      const CVector3& cSize = m_cBoxEntity.GetSize();
+      const SAnchor& sOrigin = GetEmbodiedEntity().GetOriginAnchor();
+      CVector3 cCorner;
+      for(UInt32 i = 0; i < 8; ++i) {
+         cCorner.Set(((i & 1) ? 0.5f : -0.5f) * cSize.GetX(),
+                     ((i & 2) ? 0.5f : -0.5f) * cSize.GetY(),
+                     ((i & 4) ? cSize.GetZ() : 0.0f));
+         cCorner.Rotate(sOrigin.Orientation);
+         cCorner += sOrigin.Position;
+         if(i == 0) {
+            GetBoundingBox().MinCorner = cCorner;
+            GetBoundingBox().MaxCorner = cCorner;
+         }
+         else {
+            GetBoundingBox().MinCorner.Set(Min(GetBoundingBox().MinCorner.GetX(), cCorner.GetX()),
+                                           Min(GetBoundingBox().MinCorner.GetY(), cCorner.GetY()),
+                                           Min(GetBoundingBox().MinCorner.GetZ(), cCorner.GetZ()));
+            GetBoundingBox().MaxCorner.Set(Max(GetBoundingBox().MaxCorner.GetX(), cCorner.GetX()),
+                                           Max(GetBoundingBox().MaxCorner.GetY(), cCorner.GetY()),
+                                           Max(GetBoundingBox().MaxCorner.GetZ(), cCorner.GetZ()));
+         }
+      }
    }
 
    /****************************************/
@@ -0,0 +1,357 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/pointmass3d/pointmass3d_bvh.cpp>
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#include "pointmass3d_bvh.h"
+#include "pointmass3d_model.h"
+#include <argos3/core/utility/math/batch.h>
+#include <algorithm>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /* Maximum number of models in a leaf */
+   static const UInt32 MAX_MODELS_PER_LEAF = 4;
+
+   /* Maximum depth of the traversal stack. Since the tree is built
+      splitting at the median, its depth is log2 of the number of leaves */
+   static const UInt32 MAX_STACK_DEPTH = 64;
+
+   /* The tree is degraded when the refitted nodes are this much larger than after the build */
+   static const Real DEGRADATION_FACTOR = 2.0f;
+
+   /****************************************/
+   /****************************************/
+
+   static inline void MergeBoundingBox(SBoundingBox& s_bb,
+                                       const SBoundingBox& s_other) {
+      s_bb.MinCorner.Set(Min(s_bb.MinCorner.GetX(), s_other.MinCorner.GetX()),
+                         Min(s_bb.MinCorner.GetY(), s_other.MinCorner.GetY()),
+                         Min(s_bb.MinCorner.GetZ(), s_other.MinCorner.GetZ()));
+      s_bb.MaxCorner.Set(Max(s_bb.MaxCorner.GetX(), s_other.MaxCorner.GetX()),
+                         Max(s_bb.MaxCorner.GetY(), s_other.MaxCorner.GetY()),
+                         Max(s_bb.MaxCorner.GetZ(), s_other.MaxCorner.GetZ()));
+   }
+
+   static inline Real SurfaceArea(const SBoundingBox& s_bb) {
+      CVector3 cSize = s_bb.MaxCorner - s_bb.MinCorner;
+      return 2.0f * (cSize.GetX() * cSize.GetY() +
+                     cSize.GetX() * cSize.GetZ() +
+                     cSize.GetY() * cSize.GetZ());
+   }
+
+   /*
+    * Orders the models by the center of their bounding box along an axis
+    */
+   struct SModelCenterLess {
+      UInt32 Axis;
+
+      SModelCenterLess(UInt32 un_axis) : Axis(un_axis) {}
+
+      inline Real Center(const CPointMass3DModel* pc_model) const {
+         const SBoundingBox& sBB = pc_model->GetBoundingBox();
+         switch(Axis) {
+            case 0:  return sBB.MinCorner.GetX() + sBB.MaxCorner.GetX();
+            case 1:  return sBB.MinCorner.GetY() + sBB.MaxCorner.GetY();
+            default: return sBB.MinCorner.GetZ() + sBB.MaxCorner.GetZ();
+         }
+      }
+
+      inline bool operator()(const CPointMass3DModel* pc_a,
+                             const CPointMass3DModel* pc_b) const {
+         return Center(pc_a) < Center(pc_b);
+      }
+   };
+
+   /****************************************/
+   /****************************************/
+
+   CPointMass3DBVH::CPointMass3DBVH() :
+      m_fBuildCost(0.0f),
+      m_fCurrentCost(0.0f) {}
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::Build(const std::map<std::string, CPointMass3DModel*>& t_models) {
+      Clear();
+      if(t_models.empty()) return;
+      /* Collect the models */
+      m_vecModels.reserve(t_models.size());
+      for(std::map<std::string, CPointMass3DModel*>::const_iterator it = t_models.begin();
+          it != t_models.end();
+          ++it) {
+         m_vecModels.push_back(it->second);
+      }
+      m_vecMinX.resize(m_vecModels.size());
+      m_vecMinY.resize(m_vecModels.size());
+      m_vecMinZ.resize(m_vecModels.size());
+      m_vecMaxX.resize(m_vecModels.size());
+      m_vecMaxY.resize(m_vecModels.size());
+      m_vecMaxZ.resize(m_vecModels.size());
+      /* A binary tree with L leaves has 2L-1 nodes */
+      m_vecNodes.reserve(2 * (m_vecModels.size() / MAX_MODELS_PER_LEAF + 1));
+      /* Build the tree starting from the root */
+      m_vecNodes.push_back(SNode());
+      BuildNode(0, 0, m_vecModels.size());
+      m_fBuildCost = CalculateCost();
+      m_fCurrentCost = m_fBuildCost;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::BuildNode(UInt32 un_node,
+                                   UInt32 un_begin,
+                                   UInt32 un_end) {
+      /* Calculate the bounding box of the models in this node */
+      m_vecNodes[un_node].First = un_begin;
+      m_vecNodes[un_node].NumModels = un_end - un_begin;
+      FitLeaf(m_vecNodes[un_node]);
+      /* Few models? This is a leaf */
+      if(un_end - un_begin <= MAX_MODELS_PER_LEAF) return;
+      /* Split along the longest axis */
+      CVector3 cSize = m_vecNodes[un_node].BoundingBox.MaxCorner - m_vecNodes[un_node].BoundingBox.MinCorner;
+      UInt32 unAxis = 0;
+      if(cSize.GetY() > cSize.GetX()) unAxis = 1;
+      if(cSize.GetZ() > cSize[unAxis]) unAxis = 2;
+      UInt32 unMiddle = (un_begin + un_end) / 2;
+      std::nth_element(m_vecModels.begin() + un_begin,
+                       m_vecModels.begin() + unMiddle,
+                       m_vecModels.begin() + un_end,
+                       SModelCenterLess(unAxis));
+      /* Create the children. Note that push_back() may invalidate references to the nodes */
+      UInt32 unLeft = m_vecNodes.size();
+      m_vecNodes.push_back(SNode());
+      m_vecNodes.push_back(SNode());
+      m_vecNodes[un_node].First = unLeft;
+      m_vecNodes[un_node].NumModels = 0;
+      BuildNode(unLeft,     un_begin,  unMiddle);
+      BuildNode(unLeft + 1, unMiddle, un_end);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::FitLeaf(SNode& s_node) {
+      s_node.BoundingBox = m_vecModels[s_node.First]->GetBoundingBox();
+      for(UInt32 i = 1; i < s_node.NumModels; ++i) {
+         MergeBoundingBox(s_node.BoundingBox,
+                          m_vecModels[s_node.First + i]->GetBoundingBox());
+      }
+      for(UInt32 i = s_node.First; i < s_node.First + s_node.NumModels; ++i) {
+         const SBoundingBox& sBB = m_vecModels[i]->GetBoundingBox();
+         m_vecMinX[i] = sBB.MinCorner.GetX();
+         m_vecMinY[i] = sBB.MinCorner.GetY();
+         m_vecMinZ[i] = sBB.MinCorner.GetZ();
+         m_vecMaxX[i] = sBB.MaxCorner.GetX();
+         m_vecMaxY[i] = sBB.MaxCorner.GetY();
+         m_vecMaxZ[i] = sBB.MaxCorner.GetZ();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::IntersectLeafBoxes(Real* pf_t_on_ray,
+                                            const SNode& s_node,
+                                            const CRay3& c_ray) const {
+      BatchIntersectRayBoxes(pf_t_on_ray,
+                             &m_vecMinX[s_node.First],
+                             &m_vecMinY[s_node.First],
+                             &m_vecMinZ[s_node.First],
+                             &m_vecMaxX[s_node.First],
+                             &m_vecMaxY[s_node.First],
+                             &m_vecMaxZ[s_node.First],
+                             s_node.NumModels,
+                             c_ray);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::Refit() {
+      /* The children always come after their parent, so go backwards */
+      for(size_t i = m_vecNodes.size(); i > 0; --i) {
+         SNode& sNode = m_vecNodes[i-1];
+         if(sNode.NumModels > 0) {
+            FitLeaf(sNode);
+         }
+         else {
+            sNode.BoundingBox = m_vecNodes[sNode.First].BoundingBox;
+            MergeBoundingBox(sNode.BoundingBox,
+                             m_vecNodes[sNode.First + 1].BoundingBox);
+         }
+      }
+      m_fCurrentCost = CalculateCost();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CPointMass3DBVH::IsDegraded() const {
+      return m_fCurrentCost > DEGRADATION_FACTOR * m_fBuildCost;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::Clear() {
+      m_vecNodes.clear();
+      m_vecModels.clear();
+      m_vecMinX.clear();
+      m_vecMinY.clear();
+      m_vecMinZ.clear();
+      m_vecMaxX.clear();
+      m_vecMaxY.clear();
+      m_vecMaxZ.clear();
+      m_fBuildCost = 0.0f;
+      m_fCurrentCost = 0.0f;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   Real CPointMass3DBVH::CalculateCost() const {
+      Real fCost = 0.0f;
+      for(size_t i = 0; i < m_vecNodes.size(); ++i) {
+         fCost += SurfaceArea(m_vecNodes[i].BoundingBox);
+      }
+      return fCost;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
+                                                  const CRay3& c_ray) const {
+      if(m_vecNodes.empty()) return;
+      UInt32 punStack[MAX_STACK_DEPTH];
+      UInt32 unStackSize = 0;
+      Real fTOnRay;
+      punStack[unStackSize++] = 0;
+      while(unStackSize > 0) {
+         const SNode& sNode = m_vecNodes[punStack[--unStackSize]];
+         if(!sNode.BoundingBox.Intersects(fTOnRay, c_ray)) continue;
+         if(sNode.NumModels > 0) {
+            for(UInt32 i = sNode.First; i < sNode.First + sNode.NumModels; ++i) {
+               if(m_vecModels[i]->CheckIntersectionWithRay(fTOnRay, c_ray)) {
+                  t_data.push_back(
+                     SEmbodiedEntityIntersectionItem(
+                        &m_vecModels[i]->GetEmbodiedEntity(),
+                        fTOnRay));
+               }
+            }
+         }
+         else {
+            punStack[unStackSize++] = sNode.First;
+            punStack[unStackSize++] = sNode.First + 1;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CPointMass3DBVH::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                         const CRay3& c_ray,
+                                                         const CEmbodiedEntity* pc_entity) const {
+      if(m_vecNodes.empty()) return false;
+      bool bFound = false;
+      UInt32 punStack[MAX_STACK_DEPTH];
+      UInt32 unStackSize = 0;
+      Real fTOnRay, fTLeft, fTRight;
+      Real pfTOnBoxes[MAX_MODELS_PER_LEAF];
+      bool bLeft, bRight;
+      /* Check the root */
+      if(!m_vecNodes[0].BoundingBox.Intersects(fTOnRay, c_ray) ||
+         fTOnRay >= s_item.TOnRay) return false;
+      punStack[unStackSize++] = 0;
+      /* The nodes in the stack have already been checked against the ray */
+      while(unStackSize > 0) {
+         const SNode& sNode = m_vecNodes[punStack[--unStackSize]];
+         if(sNode.NumModels > 0) {
+            IntersectLeafBoxes(pfTOnBoxes, sNode, c_ray);
+            for(UInt32 i = sNode.First; i < sNode.First + sNode.NumModels; ++i) {
+               if(&m_vecModels[i]->GetEmbodiedEntity() == pc_entity) continue;
+               if(pfTOnBoxes[i - sNode.First] >= 0.0f &&
+                  pfTOnBoxes[i - sNode.First] < s_item.TOnRay &&
+                  m_vecModels[i]->CheckIntersectionWithRay(fTOnRay, c_ray) &&
+                  fTOnRay < s_item.TOnRay) {
+                  s_item.IntersectedEntity = &m_vecModels[i]->GetEmbodiedEntity();
+                  s_item.TOnRay = fTOnRay;
+                  bFound = true;
+               }
+            }
+         }
+         else {
+            /* Skip the children that the ray enters beyond the closest hit so far */
+            bLeft = m_vecNodes[sNode.First].BoundingBox.Intersects(fTLeft, c_ray) &&
+               fTLeft < s_item.TOnRay;
+            bRight = m_vecNodes[sNode.First + 1].BoundingBox.Intersects(fTRight, c_ray) &&
+               fTRight < s_item.TOnRay;
+            /* Visit the closest child first, so it's pushed last */
+            if(bLeft && bRight) {
+               if(fTLeft <= fTRight) {
+                  punStack[unStackSize++] = sNode.First + 1;
+                  punStack[unStackSize++] = sNode.First;
+               }
+               else {
+                  punStack[unStackSize++] = sNode.First;
+                  punStack[unStackSize++] = sNode.First + 1;
+               }
+            }
+            else if(bLeft) {
+               punStack[unStackSize++] = sNode.First;
+            }
+            else if(bRight) {
+               punStack[unStackSize++] = sNode.First + 1;
+            }
+         }
+      }
+      return bFound;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CPointMass3DBVH::IsSegmentOccluded(const CRay3& c_ray,
+                                           const CEmbodiedEntity* pc_entity_1,
+                                           const CEmbodiedEntity* pc_entity_2) const {
+      if(m_vecNodes.empty()) return false;
+      UInt32 punStack[MAX_STACK_DEPTH];
+      UInt32 unStackSize = 0;
+      Real fTOnRay;
+      Real pfTOnBoxes[MAX_MODELS_PER_LEAF];
+      punStack[unStackSize++] = 0;
+      while(unStackSize > 0) {
+         const SNode& sNode = m_vecNodes[punStack[--unStackSize]];
+         if(!sNode.BoundingBox.Intersects(fTOnRay, c_ray)) continue;
+         if(sNode.NumModels > 0) {
+            IntersectLeafBoxes(pfTOnBoxes, sNode, c_ray);
+            for(UInt32 i = sNode.First; i < sNode.First + sNode.NumModels; ++i) {
+               if(&m_vecModels[i]->GetEmbodiedEntity() == pc_entity_1 ||
+                  &m_vecModels[i]->GetEmbodiedEntity() == pc_entity_2) continue;
+               if(pfTOnBoxes[i - sNode.First] >= 0.0f &&
+                  m_vecModels[i]->CheckIntersectionWithRay(fTOnRay, c_ray) &&
+                  fTOnRay < 1.0f) {
+                  return true;
+               }
+            }
+         }
+         else {
+            punStack[unStackSize++] = sNode.First;
+            punStack[unStackSize++] = sNode.First + 1;
+         }
+      }
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
@@ -0,0 +1,161 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/pointmass3d/pointmass3d_bvh.h>
+ *
+ * @brief This file provides the definition of the bounding volume
+ * hierarchy used by the point-mass 3D engine for ray queries.
+ *
+ * @author Carlo Pinciroli - <ilpincy@gmail.com>
+ */
+
+#ifndef POINTMASS3D_BVH_H
+#define POINTMASS3D_BVH_H
+
+namespace argos {
+   class CPointMass3DBVH;
+   class CPointMass3DModel;
+}
+
+#include <argos3/core/simulator/physics_engine/physics_engine.h>
+#include <argos3/core/simulator/physics_engine/physics_model.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace argos {
+
+   /**
+    * A bounding volume hierarchy over the bounding boxes of the point-mass 3D models.
+    * <p>
+    * The hierarchy is a binary tree whose leaves contain a few models each. It is
+    * built top-down, splitting the models at the median of the longest axis. Since
+    * the models move a little at each step, the tree is not rebuilt every time:
+    * Refit() recalculates the bounding boxes of the nodes, keeping the structure
+    * of the tree. When the refitted tree becomes too loose, IsDegraded() returns
+    * <tt>true</tt> and the tree should be rebuilt.
+    * </p>
+    */
+   class CPointMass3DBVH {
+
+   public:
+
+      CPointMass3DBVH();
+
+      /**
+       * Builds the hierarchy from scratch.
+       * @param t_models The models to insert.
+       */
+      void Build(const std::map<std::string, CPointMass3DModel*>& t_models);
+
+      /**
+       * Recalculates the bounding boxes of the nodes, keeping the tree structure.
+       * Call this method after the bounding boxes of the models have changed.
+       */
+      void Refit();
+
+      /**
+       * Returns <tt>true</tt> if the tree has become too loose after refitting.
+       * @return <tt>true</tt> if the tree has become too loose after refitting.
+       */
+      bool IsDegraded() const;
+
+      /**
+       * Empties the hierarchy.
+       */
+      void Clear();
+
+      /**
+       * Appends all the intersections between the models and the given ray.
+       * @param t_data The list of intersections.
+       * @param c_ray The test ray.
+       * @see CPhysicsEngine::CheckIntersectionWithRay
+       */
+      void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
+                                    const CRay3& c_ray) const;
+
+      /**
+       * Looks for an intersection closer than <tt>s_item.TOnRay</tt>.
+       * @param s_item The closest intersection found so far.
+       * @param c_ray The test ray.
+       * @param pc_entity The entity to ignore, or <tt>NULL</tt>.
+       * @return <tt>true</tt> if <tt>s_item</tt> was updated.
+       * @see CPhysicsEngine::CheckClosestIntersectionWithRay
+       */
+      bool CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                           const CRay3& c_ray,
+                                           const CEmbodiedEntity* pc_entity) const;
+
+      /**
+       * Returns <tt>true</tt> if any model intersects the given segment.
+       * @param c_ray The test segment.
+       * @param pc_entity_1 An entity to ignore, or <tt>NULL</tt>.
+       * @param pc_entity_2 Another entity to ignore, or <tt>NULL</tt>.
+       * @see CPhysicsEngine::IsSegmentOccluded
+       */
+      bool IsSegmentOccluded(const CRay3& c_ray,
+                             const CEmbodiedEntity* pc_entity_1,
+                             const CEmbodiedEntity* pc_entity_2) const;
+
+   private:
+
+      /**
+       * A node of the tree.
+       * For internal nodes, NumModels is zero and the children are at
+       * indices First and First+1. For leaves, the models are at indices
+       * [First,First+NumModels) in m_vecModels.
+       */
+      struct SNode {
+         SBoundingBox BoundingBox;
+         UInt32 First;
+         UInt32 NumModels;
+      };
+
+   private:
+
+      void BuildNode(UInt32 un_node,
+                     UInt32 un_begin,
+                     UInt32 un_end);
+
+      void FitLeaf(SNode& s_node);
+
+      /**
+       * Intersects the ray with the bounding boxes of the models of a leaf.
+       * @param pf_t_on_ray The results, as in BatchIntersectRayBoxes().
+       * @param s_node The leaf.
+       * @param c_ray The test ray.
+       */
+      void IntersectLeafBoxes(Real* pf_t_on_ray,
+                              const SNode& s_node,
+                              const CRay3& c_ray) const;
+
+      Real CalculateCost() const;
+
+   private:
+
+      /** The nodes, with the root at index 0 and the children always after their parent */
+      std::vector<SNode> m_vecNodes;
+
+      /** The models, sorted so that the models of a leaf are contiguous */
+      std::vector<CPointMass3DModel*> m_vecModels;
+
+      /**
+       * The bounding boxes of the models in m_vecModels, one array per coordinate.
+       * They are updated with the leaves, and let the leaves be checked in one batch.
+       */
+      std::vector<Real> m_vecMinX;
+      std::vector<Real> m_vecMinY;
+      std::vector<Real> m_vecMinZ;
+      std::vector<Real> m_vecMaxX;
+      std::vector<Real> m_vecMaxY;
+      std::vector<Real> m_vecMaxZ;
+
+      /** The sum of the surface areas of the nodes right after the last build */
+      Real m_fBuildCost;
+
+      /** The sum of the surface areas of the nodes after the last refit */
+      Real m_fCurrentCost;
+
+   };
+
+}
+
+#endif
@@ -15,7 +15,8 @@ namespace argos {
    /****************************************/
 
    CPointMass3DEngine::CPointMass3DEngine() :
-      m_fGravity(-9.81f) {
+      m_fGravity(-9.81f),
+      m_bBVHValid(false) {
    }
 
    /****************************************/
@@ -42,6 +43,7 @@ namespace argos {
           it != m_tPhysicsModels.end(); ++it) {
          it->second->Reset();
       }
+      m_bBVHValid = false;
    }
 
    /****************************************/
@@ -54,6 +56,8 @@ namespace argos {
          delete it->second;
       }
       m_tPhysicsModels.clear();
+      m_cBVH.Clear();
+      m_bBVHValid = false;
    }
 
    /****************************************/
@@ -77,6 +81,17 @@ namespace argos {
           it != m_tPhysicsModels.end(); ++it) {
          it->second->UpdateEntityStatus();
       }
+      /* Update the bounding volume hierarchy for the ray queries */
+      if(m_bBVHValid) {
+         m_cBVH.Refit();
+         if(m_cBVH.IsDegraded()) {
+            m_cBVH.Build(m_tPhysicsModels);
+         }
+      }
+      else {
+         m_cBVH.Build(m_tPhysicsModels);
+         m_bBVHValid = true;
+      }
    }
 
    /****************************************/
@@ -131,6 +146,10 @@ namespace argos {
 
    void CPointMass3DEngine::CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
                                                      const CRay3& c_ray) const {
+      if(m_bBVHValid) {
+         m_cBVH.CheckIntersectionWithRay(t_data, c_ray);
+         return;
+      }
       Real fTOnRay;
       for(CPointMass3DModel::TMap::const_iterator it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end();
@@ -147,9 +166,65 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   bool CPointMass3DEngine::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                            const CRay3& c_ray,
+                                                            const CEmbodiedEntity* pc_entity) const {
+      if(m_bBVHValid) {
+         return m_cBVH.CheckClosestIntersectionWithRay(s_item, c_ray, pc_entity);
+      }
+      bool bFound = false;
+      Real fTOnRay;
+      for(CPointMass3DModel::TMap::const_iterator it = m_tPhysicsModels.begin();
+          it != m_tPhysicsModels.end();
+          ++it) {
+         if(&it->second->GetEmbodiedEntity() == pc_entity) continue;
+         /* Skip the models whose bounding box is beyond the closest hit found so far */
+         if(!it->second->GetBoundingBox().Intersects(fTOnRay, c_ray) ||
+            fTOnRay >= s_item.TOnRay) continue;
+         /* Check the actual shape */
+         if(it->second->CheckIntersectionWithRay(fTOnRay, c_ray) &&
+            fTOnRay < s_item.TOnRay) {
+            s_item.IntersectedEntity = &it->second->GetEmbodiedEntity();
+            s_item.TOnRay = fTOnRay;
+            bFound = true;
+         }
+      }
+      return bFound;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CPointMass3DEngine::IsSegmentOccluded(const CRay3& c_ray,
+                                              const CEmbodiedEntity* pc_entity_1,
+                                              const CEmbodiedEntity* pc_entity_2) const {
+      if(m_bBVHValid) {
+         return m_cBVH.IsSegmentOccluded(c_ray, pc_entity_1, pc_entity_2);
+      }
+      Real fTOnRay;
+      for(CPointMass3DModel::TMap::const_iterator it = m_tPhysicsModels.begin();
+          it != m_tPhysicsModels.end();
+          ++it) {
+         if(&it->second->GetEmbodiedEntity() == pc_entity_1 ||
+            &it->second->GetEmbodiedEntity() == pc_entity_2) continue;
+         if(it->second->GetBoundingBox().Intersects(fTOnRay, c_ray) &&
+            it->second->CheckIntersectionWithRay(fTOnRay, c_ray) &&
+            fTOnRay < 1.0f) {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CPointMass3DEngine::AddPhysicsModel(const std::string& str_id,
                                             CPointMass3DModel& c_model) {
       m_tPhysicsModels[str_id] = &c_model;
+      m_bBVHValid = false;
+      /* The bounding box is used by ray queries before the first step */
+      c_model.CalculateBoundingBox();
    }
 
    /****************************************/
@@ -160,6 +235,7 @@ namespace argos {
       if(it != m_tPhysicsModels.end()) {
          delete it->second;
          m_tPhysicsModels.erase(it);
+         m_bBVHValid = false;
       }
       else {
          THROW_ARGOSEXCEPTION("PointMass3D model id \"" << str_id << "\" not found in point-mass 3D engine \"" << GetId() << "\"");
@@ -16,6 +16,7 @@ namespace argos {
 #include <argos3/core/utility/math/ray2.h>
 #include <argos3/core/simulator/entity/controllable_entity.h>
 #include <argos3/core/simulator/physics_engine/physics_engine.h>
+#include <argos3/plugins/simulator/physics_engines/pointmass3d/pointmass3d_bvh.h>
 
 namespace argos {
 
@@ -45,6 +46,14 @@ namespace argos {
       virtual void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
                                             const CRay3& c_ray) const;
 
+      virtual bool CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                   const CRay3& c_ray,
+                                                   const CEmbodiedEntity* pc_entity) const;
+
+      virtual bool IsSegmentOccluded(const CRay3& c_ray,
+                                     const CEmbodiedEntity* pc_entity_1,
+                                     const CEmbodiedEntity* pc_entity_2) const;
+
       void AddPhysicsModel(const std::string& str_id,
                            CPointMass3DModel& c_model);
       void RemovePhysicsModel(const std::string& str_id);
@@ -61,12 +70,27 @@ namespace argos {
          return m_fGravity;
       }
 
+      /**
+       * Marks the bounding volume hierarchy as out of date.
+       * Until the next Update(), the ray queries check every model.
+       * Call this method when a model is moved outside of Update().
+       */
+      inline void InvalidateBVH() {
+         m_bBVHValid = false;
+      }
+
    private:
 
       CControllableEntity::TMap m_tControllableEntities;
       std::map<std::string, CPointMass3DModel*> m_tPhysicsModels;
       Real m_fGravity;
 
+      /** The bounding volume hierarchy used for ray queries */
+      CPointMass3DBVH m_cBVH;
+
+      /** True when m_cBVH matches the current model bounding boxes */
+      bool m_bBVHValid;
+
    };
 
    /****************************************/
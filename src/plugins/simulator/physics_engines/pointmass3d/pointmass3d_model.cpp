@@ -34,6 +34,39 @@ namespace argos {
                                   const CQuaternion& c_orientation) {
       m_cPosition = c_position;
       UpdateEntityStatus();
+      /* The hierarchy does not know about the new bounding box yet */
+      m_cPM3DEngine.InvalidateBVH();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DModel::SaveState(CByteArray& c_buffer) {
+      c_buffer << m_cPosition.GetX()
+               << m_cPosition.GetY()
+               << m_cPosition.GetZ()
+               << m_cVelocity.GetX()
+               << m_cVelocity.GetY()
+               << m_cVelocity.GetZ()
+               << m_cAcceleration.GetX()
+               << m_cAcceleration.GetY()
+               << m_cAcceleration.GetZ();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DModel::LoadState(CByteArray& c_buffer) {
+      Real fX, fY, fZ;
+      c_buffer >> fX >> fY >> fZ;
+      m_cPosition.Set(fX, fY, fZ);
+      c_buffer >> fX >> fY >> fZ;
+      m_cVelocity.Set(fX, fY, fZ);
+      c_buffer >> fX >> fY >> fZ;
+      m_cAcceleration.Set(fX, fY, fZ);
+      CalculateBoundingBox();
+      /* The hierarchy does not know about the new bounding box yet */
+      m_cPM3DEngine.InvalidateBVH();
    }
 
    /****************************************/
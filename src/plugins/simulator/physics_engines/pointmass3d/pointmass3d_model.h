@@ -36,6 +36,10 @@ namespace argos {
 
       virtual void Reset();
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
       virtual void Step() = 0;
       virtual void UpdateFromEntityStatus() = 0;
 
@@ -79,6 +79,38 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CPointMass3DQuadRotorModel::SaveState(CByteArray& c_buffer) {
+      CPointMass3DModel::SaveState(c_buffer);
+      c_buffer << m_cYaw.GetValue()
+               << m_cRotSpeed.GetValue()
+               << m_cTorque.GetValue()
+               << m_pfLinearError[0]
+               << m_pfLinearError[1]
+               << m_pfLinearError[2]
+               << m_fRotError;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DQuadRotorModel::LoadState(CByteArray& c_buffer) {
+      CPointMass3DModel::LoadState(c_buffer);
+      Real fValue;
+      c_buffer >> fValue;
+      m_cYaw.SetValue(fValue);
+      c_buffer >> fValue;
+      m_cRotSpeed.SetValue(fValue);
+      c_buffer >> fValue;
+      m_cTorque.SetValue(fValue);
+      c_buffer >> m_pfLinearError[0]
+               >> m_pfLinearError[1]
+               >> m_pfLinearError[2]
+               >> m_fRotError;
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CPointMass3DQuadRotorModel::UpdateFromEntityStatus() {
       m_sDesiredPositionData = m_cQuadRotorEntity.GetPositionControlData();
    }
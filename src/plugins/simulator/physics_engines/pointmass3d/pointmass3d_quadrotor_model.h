@@ -45,6 +45,10 @@ namespace argos {
       
       virtual void Reset();
 
+      virtual void SaveState(CByteArray& c_buffer);
+
+      virtual void LoadState(CByteArray& c_buffer);
+
       virtual void UpdateFromEntityStatus();
       virtual void Step();
 
@@ -8,7 +8,7 @@ _argos3() {
     # previous token
     prev="${COMP_WORDS[COMP_CWORD-1]}"
     # option list
-    opts="-h --help -v --version -c --config-file -q --query -n --no-color -l --log-file -e --logerr-file"
+    opts="-h --help -v --version -c --config-file -f --fork -b --batch -q --query -n --no-color -l --log-file -e --logerr-file"
     # Complete option arguments
     case "${prev}" in
         -h|--help|-v|--version|-n|--no-color)
@@ -24,7 +24,10 @@ _argos3() {
             COMPREPLY=( $(compgen -W "${plugintypes} ${plugins}" -- ${cur}) )
             return 0
             ;;
-        -l|--log-file|-e|--logerr-file)
+        -f|--fork)
+            return 0
+            ;;
+        -b|--batch|-l|--log-file|-e|--logerr-file)
             COMPREPLY=( $(compgen -f ${cur}) )
             return 0
             ;;
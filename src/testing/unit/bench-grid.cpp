@@ -0,0 +1,113 @@
+#include <argos3/core/simulator/space/positional_indices/grid.h>
+#include <argos3/plugins/simulator/entities/led_entity.h>
+#include <argos3/core/utility/math/rng.h>
+#include <ctime>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+/* Settings of the dense/sparse benchmark */
+const size_t BENCH_NUM_LEDS  = 5000;
+const size_t BENCH_NUM_STEPS = 100;
+const Real   BENCH_ARENA     = 500.0;
+const SInt32 BENCH_CELLS     = 5000;
+
+/****************************************/
+/****************************************/
+
+class CLEDEntityGridCount : public CGrid<CLEDEntity>::COperation {
+
+public:
+
+   CLEDEntityGridCount() : Count(0) {}
+
+   virtual bool operator()(CLEDEntity& c_entity) {
+      ++Count;
+      return true;
+   }
+
+   size_t Count;
+
+};
+
+/****************************************/
+/****************************************/
+
+static Real Now() {
+   ::timespec tTime;
+   ::clock_gettime(CLOCK_MONOTONIC, &tTime);
+   return tTime.tv_sec + tTime.tv_nsec * 1e-9;
+}
+
+/*
+ * Moves the LEDs around a large arena and queries their neighbors.
+ * Returns the number of neighbors found, to compare dense and sparse grids.
+ */
+size_t BenchmarkGrid(CRandom::CRNG* pc_rng,
+                    bool b_sparse) {
+   Real fStart = Now();
+   CGrid<CLEDEntity> g(
+      CVector3(0.0, 0.0, 0.0),
+      CVector3(BENCH_ARENA, BENCH_ARENA, 1.0),
+      BENCH_CELLS, BENCH_CELLS, 1,
+      b_sparse);
+   CLEDEntityGridUpdater u(g);
+   g.SetUpdateEntityOperation(&u);
+   pc_rng->Reset();
+   CRange<Real> cPosition(0.0, BENCH_ARENA);
+   CRange<Real> cStep(-0.2, 0.2);
+   std::vector<CLEDEntity*> vecLEDs;
+   for(size_t i = 0; i < BENCH_NUM_LEDS; ++i) {
+      vecLEDs.push_back(new CLEDEntity(NULL,
+                                       "LED" + ToString(i),
+                                       CVector3(pc_rng->Uniform(cPosition),
+                                                pc_rng->Uniform(cPosition),
+                                                0.5),
+                                       CColor::RED));
+      g.AddEntity(*vecLEDs.back());
+   }
+   g.Update();
+   Real fSetup = Now() - fStart;
+   CLEDEntityGridCount cCount;
+   fStart = Now();
+   for(size_t t = 0; t < BENCH_NUM_STEPS; ++t) {
+      for(size_t i = 0; i < vecLEDs.size(); ++i) {
+         Real fX = vecLEDs[i]->GetPosition().GetX() + pc_rng->Uniform(cStep);
+         Real fY = vecLEDs[i]->GetPosition().GetY() + pc_rng->Uniform(cStep);
+         cPosition.TruncValue(fX);
+         cPosition.TruncValue(fY);
+         vecLEDs[i]->SetPosition(CVector3(fX, fY, 0.5));
+      }
+      g.Update();
+      for(size_t i = 0; i < vecLEDs.size(); i += 10) {
+         g.ForEntitiesInCircleRange(vecLEDs[i]->GetPosition(), 1.0, cCount);
+      }
+   }
+   fprintf(stdout, "%s grid: %zu stored cells, setup %.3fs, %zu steps %.3fs, %zu neighbors\n",
+           b_sparse ? "sparse" : "dense ",
+           g.GetNumStoredCells(),
+           fSetup,
+           BENCH_NUM_STEPS,
+           Now() - fStart,
+           cCount.Count);
+   for(size_t i = 0; i < vecLEDs.size(); ++i) {
+      delete vecLEDs[i];
+   }
+   return cCount.Count;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   /* Compare a dense and a sparse grid on a large arena */
+   CRandom::CreateCategory("argos", 12345);
+   CRandom::CRNG* pcRNG = CRandom::CreateRNG("argos");
+   if(BenchmarkGrid(pcRNG, false) != BenchmarkGrid(pcRNG, true)) {
+      fprintf(stderr, "ERROR: the dense and sparse grids found different neighbors\n");
+      return 1;
+   }
+   return 0;
+}
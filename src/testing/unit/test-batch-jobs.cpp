@@ -0,0 +1,221 @@
+/**
+ * @file <argos3/testing/unit/test-batch-jobs.cpp>
+ *
+ * Runs an experiment with randomly distributed entities once per seed, and
+ * then again as a batch, and checks that each batch job gives the same
+ * result as the single run with its seed.
+ *
+ * The ARGoS plugins must be in ARGOS_PLUGIN_PATH.
+ *
+ * @author Carlo Pinciroli <ilpincy@gmail.com>
+ */
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/loop_functions.h>
+#include <argos3/core/simulator/entity/composable_entity.h>
+#include <argos3/core/simulator/entity/embodied_entity.h>
+#include <argos3/core/utility/plugins/dynamic_loading.h>
+#include <fstream>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+static const UInt32 SEEDS[] = { 11, 22, 33 };
+static const UInt32 NUM_SEEDS = 3;
+
+/* Prefix of the result files, set before forking the runs */
+static std::string g_strPrefix;
+
+/****************************************/
+/****************************************/
+
+/*
+ * Writes the position of every entity after the experiment, and the numbers
+ * drawn from the simulator RNG along the way, to <prefix>_<seed>.dat
+ */
+class CBatchJobsLoopFunctions : public CLoopFunctions {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_fDrawn = 0.0;
+   }
+
+   virtual void PreStep() {
+      m_fDrawn += GetSimulator().GetRNG()->Uniform(CRange<Real>(0.0, 1.0));
+   }
+
+   virtual void PostExperiment() {
+      std::ostringstream ossFName;
+      ossFName << g_strPrefix << "_" << GetSimulator().GetRandomSeed() << ".dat";
+      std::ofstream cOut(ossFName.str().c_str(), std::ofstream::out | std::ofstream::trunc);
+      cOut.precision(12);
+      CEntity::TVector& vecEntities = GetSpace().GetRootEntityVector();
+      for(size_t i = 0; i < vecEntities.size(); ++i) {
+         CComposableEntity* pcEntity = dynamic_cast<CComposableEntity*>(vecEntities[i]);
+         if(pcEntity != NULL && pcEntity->HasComponent("body")) {
+            cOut << pcEntity->GetId() << " "
+                 << pcEntity->GetComponent<CEmbodiedEntity>("body").GetOriginAnchor().Position
+                 << std::endl;
+         }
+      }
+      cOut << "drawn " << m_fDrawn << std::endl;
+   }
+
+private:
+
+   Real m_fDrawn;
+
+};
+
+REGISTER_LOOP_FUNCTIONS(CBatchJobsLoopFunctions, "test_batch_jobs_loop_functions");
+
+/****************************************/
+/****************************************/
+
+static void WriteExperiment(const std::string& str_fname,
+                            const std::string& str_rng_type) {
+   std::ofstream cOut(str_fname.c_str(), std::ofstream::out | std::ofstream::trunc);
+   cOut << "<?xml version=\"1.0\" ?>" << std::endl
+        << "<argos-configuration>" << std::endl
+        << "  <framework>" << std::endl
+        << "    <system threads=\"0\" />" << std::endl
+        << "    <experiment length=\"5\" ticks_per_second=\"10\" random_seed=\"1\" rng_type=\"" << str_rng_type << "\" />" << std::endl
+        << "  </framework>" << std::endl
+        << "  <loop_functions label=\"test_batch_jobs_loop_functions\" />" << std::endl
+        << "  <controllers />" << std::endl
+        << "  <arena size=\"10, 10, 1\">" << std::endl
+        << "    <distribute>" << std::endl
+        << "      <position method=\"uniform\" min=\"-4,-4,0\" max=\"4,4,0\" />" << std::endl
+        << "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />" << std::endl
+        << "      <entity quantity=\"10\" max_trials=\"100\">" << std::endl
+        << "        <box id=\"b\" size=\"0.2,0.2,0.2\" movable=\"false\" />" << std::endl
+        << "      </entity>" << std::endl
+        << "    </distribute>" << std::endl
+        << "  </arena>" << std::endl
+        << "  <physics_engines>" << std::endl
+        << "    <dynamics2d id=\"dyn2d\" />" << std::endl
+        << "  </physics_engines>" << std::endl
+        << "  <media />" << std::endl
+        << "</argos-configuration>" << std::endl;
+}
+
+/****************************************/
+/****************************************/
+
+static std::string ReadFile(const std::string& str_fname) {
+   std::ifstream cIn(str_fname.c_str());
+   if(!cIn) {
+      THROW_ARGOSEXCEPTION("Cannot open \"" << str_fname << "\"");
+   }
+   std::ostringstream ossContent;
+   ossContent << cIn.rdbuf();
+   return ossContent.str();
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs the experiment once per seed, each time in a new process, as a
+ * separate invocation of argos3 would
+ */
+static void RunSingle(CSimulator& c_simulator) {
+   for(UInt32 i = 0; i < NUM_SEEDS; ++i) {
+      LOG.Flush();
+      LOGERR.Flush();
+      pid_t tPid = ::fork();
+      if(tPid < 0) {
+         THROW_ARGOSEXCEPTION("Error forking a single run");
+      }
+      if(tPid == 0) {
+         int nStatus = 0;
+         try {
+            c_simulator.SetRandomSeed(SEEDS[i]);
+            c_simulator.LoadExperiment();
+            c_simulator.Execute();
+            c_simulator.Destroy();
+         }
+         catch(std::exception& ex) {
+            LOGERR << ex.what() << std::endl;
+            nStatus = 1;
+         }
+         LOG.Flush();
+         LOGERR.Flush();
+         ::_exit(nStatus);
+      }
+      int nStatus;
+      if(::waitpid(tPid, &nStatus, 0) < 0 ||
+         !WIFEXITED(nStatus) ||
+         WEXITSTATUS(nStatus) != 0) {
+         THROW_ARGOSEXCEPTION("Single run with seed " << SEEDS[i] << " failed");
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the number of batch jobs whose result differs from the single run
+ */
+static UInt32 Compare(const std::string& str_rng_type) {
+   UInt32 unErrors = 0;
+   for(UInt32 i = 0; i < NUM_SEEDS; ++i) {
+      std::ostringstream ossSingle, ossBatch;
+      ossSingle << "single_" << SEEDS[i] << ".dat";
+      ossBatch << "batch_" << SEEDS[i] << ".dat";
+      if(ReadFile(ossSingle.str()) != ReadFile(ossBatch.str())) {
+         LOGERR << "[" << str_rng_type << "] batch job with seed " << SEEDS[i]
+                << " differs from the single run" << std::endl;
+         ++unErrors;
+      }
+   }
+   /* The seed must matter, or the comparison proves nothing */
+   if(ReadFile("single_11.dat") == ReadFile("single_22.dat")) {
+      LOGERR << "[" << str_rng_type << "] seeds 11 and 22 gave the same result" << std::endl;
+      ++unErrors;
+   }
+   return unErrors;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   UInt32 unErrors = 0;
+   try {
+      CDynamicLoading::LoadAllLibraries();
+      const char* ppchRNGTypes[] = { "mersenne_twister", "counter_based" };
+      for(UInt32 t = 0; t < 2; ++t) {
+         WriteExperiment("test-batch-jobs.argos", ppchRNGTypes[t]);
+         cSimulator.SetExperimentFileName("test-batch-jobs.argos");
+         std::ofstream cBatch("test-batch-jobs.txt", std::ofstream::out | std::ofstream::trunc);
+         for(UInt32 i = 0; i < NUM_SEEDS; ++i) {
+            cBatch << SEEDS[i] << std::endl;
+         }
+         cBatch.close();
+         g_strPrefix = "single";
+         RunSingle(cSimulator);
+         g_strPrefix = "batch";
+         cSimulator.ExecuteBatch("test-batch-jobs.txt", 2);
+         unErrors += Compare(ppchRNGTypes[t]);
+      }
+   }
+   catch(std::exception& ex) {
+      LOGERR << ex.what() << std::endl;
+      ++unErrors;
+   }
+   if(unErrors == 0) {
+      LOG << "[INFO] Batch jobs match the single runs" << std::endl;
+   }
+   LOG.Flush();
+   LOGERR.Flush();
+   return (unErrors == 0) ? 0 : 1;
+}
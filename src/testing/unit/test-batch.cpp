@@ -0,0 +1,174 @@
+#include <argos3/core/utility/math/batch.h>
+#include <argos3/core/utility/math/quaternion.h>
+#include <argos3/core/utility/math/ray3.h>
+#include <argos3/core/utility/math/rng.h>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+/* Number of elements in the arrays */
+const size_t NUM_ELEMENTS = 1000;
+
+/* Number of times each kernel is run */
+const size_t NUM_RUNS = 20000;
+
+/****************************************/
+/****************************************/
+
+struct SArrays {
+   std::vector<Real> AX, AY, AZ;
+   std::vector<Real> BX, BY, BZ;
+   std::vector<Real> Radius, Height;
+   std::vector<Real> OutX, OutY, OutZ;
+
+   SArrays(size_t un_num) :
+      AX(un_num), AY(un_num), AZ(un_num),
+      BX(un_num), BY(un_num), BZ(un_num),
+      Radius(un_num), Height(un_num),
+      OutX(un_num), OutY(un_num), OutZ(un_num) {
+      CRandom::CRNG* pcRNG = CRandom::CreateRNG("argos");
+      CRange<Real> cPosition(-5.0f, 5.0f);
+      CRange<Real> cSize(0.1f, 1.0f);
+      for(size_t i = 0; i < un_num; ++i) {
+         AX[i] = pcRNG->Uniform(cPosition);
+         AY[i] = pcRNG->Uniform(cPosition);
+         AZ[i] = pcRNG->Uniform(cPosition);
+         /* The B arrays double as the max corners of the boxes */
+         BX[i] = AX[i] + pcRNG->Uniform(cSize);
+         BY[i] = AY[i] + pcRNG->Uniform(cSize);
+         BZ[i] = AZ[i] + pcRNG->Uniform(cSize);
+         Radius[i] = pcRNG->Uniform(cSize);
+         Height[i] = pcRNG->Uniform(cSize);
+      }
+   }
+};
+
+/****************************************/
+/****************************************/
+
+static Real Now() {
+   ::timespec tTime;
+   ::clock_gettime(CLOCK_MONOTONIC, &tTime);
+   return tTime.tv_sec + tTime.tv_nsec * 1e-9;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs all the kernels with the current instruction set.
+ * Stores the results of the last runs in vec_results and the times in pf_times.
+ */
+static void RunKernels(SArrays& s_arrays,
+                       std::vector<Real>& vec_results,
+                       Real* pf_times) {
+   size_t unNum = s_arrays.AX.size();
+   CQuaternion cRotation(CRadians(0.7), CVector3(1.0, 2.0, 3.0).Normalize());
+   CVector3 cTranslation(1.0, -2.0, 0.5);
+   CRay3 cRay(CVector3(-6.0, -5.0, -4.0), CVector3(6.0, 5.5, 4.0));
+   vec_results.clear();
+   Real fStart;
+   /* Rotate and translate */
+   fStart = Now();
+   for(size_t r = 0; r < NUM_RUNS; ++r) {
+      BatchRotateTranslate(&s_arrays.OutX[0], &s_arrays.OutY[0], &s_arrays.OutZ[0],
+                           &s_arrays.AX[0], &s_arrays.AY[0], &s_arrays.AZ[0],
+                           unNum, cRotation, cTranslation);
+   }
+   pf_times[0] = Now() - fStart;
+   vec_results.insert(vec_results.end(), s_arrays.OutX.begin(), s_arrays.OutX.end());
+   vec_results.insert(vec_results.end(), s_arrays.OutZ.begin(), s_arrays.OutZ.end());
+   /* Dot product */
+   fStart = Now();
+   for(size_t r = 0; r < NUM_RUNS; ++r) {
+      BatchDotProduct(&s_arrays.OutX[0],
+                      &s_arrays.AX[0], &s_arrays.AY[0], &s_arrays.AZ[0],
+                      &s_arrays.BX[0], &s_arrays.BY[0], &s_arrays.BZ[0],
+                      unNum);
+   }
+   pf_times[1] = Now() - fStart;
+   vec_results.insert(vec_results.end(), s_arrays.OutX.begin(), s_arrays.OutX.end());
+   /* Cross product */
+   fStart = Now();
+   for(size_t r = 0; r < NUM_RUNS; ++r) {
+      BatchCrossProduct(&s_arrays.OutX[0], &s_arrays.OutY[0], &s_arrays.OutZ[0],
+                        &s_arrays.AX[0], &s_arrays.AY[0], &s_arrays.AZ[0],
+                        &s_arrays.BX[0], &s_arrays.BY[0], &s_arrays.BZ[0],
+                        unNum);
+   }
+   pf_times[2] = Now() - fStart;
+   vec_results.insert(vec_results.end(), s_arrays.OutY.begin(), s_arrays.OutY.end());
+   /* Distance */
+   fStart = Now();
+   for(size_t r = 0; r < NUM_RUNS; ++r) {
+      BatchDistance(&s_arrays.OutX[0],
+                    &s_arrays.AX[0], &s_arrays.AY[0], &s_arrays.AZ[0],
+                    unNum, cTranslation);
+   }
+   pf_times[3] = Now() - fStart;
+   vec_results.insert(vec_results.end(), s_arrays.OutX.begin(), s_arrays.OutX.end());
+   /* Ray-box */
+   fStart = Now();
+   for(size_t r = 0; r < NUM_RUNS; ++r) {
+      BatchIntersectRayBoxes(&s_arrays.OutX[0],
+                             &s_arrays.AX[0], &s_arrays.AY[0], &s_arrays.AZ[0],
+                             &s_arrays.BX[0], &s_arrays.BY[0], &s_arrays.BZ[0],
+                             unNum, cRay);
+   }
+   pf_times[4] = Now() - fStart;
+   vec_results.insert(vec_results.end(), s_arrays.OutX.begin(), s_arrays.OutX.end());
+   /* Ray-cylinder */
+   fStart = Now();
+   for(size_t r = 0; r < NUM_RUNS; ++r) {
+      BatchIntersectRayCylinders(&s_arrays.OutX[0],
+                                 &s_arrays.AX[0], &s_arrays.AY[0], &s_arrays.AZ[0],
+                                 &s_arrays.Radius[0], &s_arrays.Height[0],
+                                 unNum, cRay);
+   }
+   pf_times[5] = Now() - fStart;
+   vec_results.insert(vec_results.end(), s_arrays.OutX.begin(), s_arrays.OutX.end());
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   const char* ppchKernels[] = {
+      "rotate", "dot", "cross", "distance", "ray-box", "ray-cylinder"
+   };
+   CRandom::CreateCategory("argos", 12345);
+   SArrays sArrays(NUM_ELEMENTS);
+   /* Run the scalar kernels as a reference */
+   std::vector<Real> vecReference, vecResults;
+   Real pfScalarTimes[6], pfTimes[6];
+   SetBatchInstructionSet(BATCH_SCALAR);
+   RunKernels(sArrays, vecReference, pfScalarTimes);
+   /* Run the vector kernels */
+   EBatchInstructionSet peSets[] = { BATCH_SSE2, BATCH_AVX2 };
+   for(size_t s = 0; s < 2; ++s) {
+      if(SetBatchInstructionSet(peSets[s]) != peSets[s]) {
+         fprintf(stdout, "%s is not supported\n", GetBatchInstructionSetName(peSets[s]));
+         continue;
+      }
+      RunKernels(sArrays, vecResults, pfTimes);
+      /* The results must match the scalar ones */
+      for(size_t i = 0; i < vecResults.size(); ++i) {
+         if(Abs(vecResults[i] - vecReference[i]) > 1e-6 * (1.0 + Abs(vecReference[i]))) {
+            fprintf(stderr, "ERROR: %s result #%zu is %f, expected %f\n",
+                    GetBatchInstructionSetName(peSets[s]), i, vecResults[i], vecReference[i]);
+            return 1;
+         }
+      }
+      fprintf(stdout, "%s\n", GetBatchInstructionSetName(peSets[s]));
+      for(size_t k = 0; k < 6; ++k) {
+         fprintf(stdout, "   %-12s scalar %.3fs, vector %.3fs, speedup %.2fx\n",
+                 ppchKernels[k], pfScalarTimes[k], pfTimes[k], pfScalarTimes[k] / pfTimes[k]);
+      }
+   }
+   return 0;
+}
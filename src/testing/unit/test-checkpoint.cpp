@@ -0,0 +1,188 @@
+/**
+ * @file <argos3/testing/unit/test-checkpoint.cpp>
+ *
+ * Saves a checkpoint of a crowded foot-bot experiment, keeps running it, and
+ * then loads the checkpoint twice and runs again from it. Checks that the
+ * two runs after the loads follow exactly the trajectory of the run that
+ * saved the checkpoint.
+ *
+ * The ARGoS plugins must be in ARGOS_PLUGIN_PATH.
+ *
+ * @author Carlo Pinciroli <ilpincy@gmail.com>
+ */
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/simulator/entity/composable_entity.h>
+#include <argos3/core/simulator/entity/embodied_entity.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/plugins/dynamic_loading.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_differential_steering_actuator.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_proximity_sensor.h>
+#include <fstream>
+#include <vector>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+/* Steps before the checkpoint */
+static const UInt32 WARMUP_STEPS = 50;
+
+/*
+ * Steps compared after the checkpoint. The robots keep colliding, so any
+ * difference in the restored state grows over this many steps.
+ */
+static const UInt32 COMPARED_STEPS = 500;
+
+/****************************************/
+/****************************************/
+
+/*
+ * Drives forward and turns away from obstacles, so that the robots keep
+ * bumping into each other and into the walls
+ */
+class CCheckpointController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_pcWheels = GetActuator<CCI_DifferentialSteeringActuator>("differential_steering");
+      m_pcProximity = GetSensor<CCI_ProximitySensor>("proximity");
+   }
+
+   virtual void ControlStep() {
+      const std::vector<Real>& vecReadings = m_pcProximity->GetReadings();
+      Real fTurn = 0.0;
+      for(size_t i = 0; i < vecReadings.size(); ++i) {
+         fTurn += vecReadings[i] * (static_cast<Real>(i) - 12.0);
+      }
+      m_pcWheels->SetLinearVelocity(8.0 + fTurn, 8.0 - fTurn);
+   }
+
+private:
+
+   CCI_DifferentialSteeringActuator* m_pcWheels;
+   CCI_ProximitySensor* m_pcProximity;
+
+};
+
+REGISTER_CONTROLLER(CCheckpointController, "test_checkpoint_controller");
+
+/****************************************/
+/****************************************/
+
+static void WriteExperiment(const std::string& str_fname) {
+   std::ofstream cOut(str_fname.c_str(), std::ofstream::out | std::ofstream::trunc);
+   cOut << "<?xml version=\"1.0\" ?>" << std::endl
+        << "<argos-configuration>" << std::endl
+        << "  <framework>" << std::endl
+        << "    <system threads=\"0\" />" << std::endl
+        << "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"7\" />" << std::endl
+        << "  </framework>" << std::endl
+        << "  <controllers>" << std::endl
+        << "    <test_checkpoint_controller id=\"c\">" << std::endl
+        << "      <actuators>" << std::endl
+        << "        <differential_steering implementation=\"default\" />" << std::endl
+        << "      </actuators>" << std::endl
+        << "      <sensors>" << std::endl
+        << "        <proximity implementation=\"default\" show_rays=\"false\" />" << std::endl
+        << "      </sensors>" << std::endl
+        << "      <params />" << std::endl
+        << "    </test_checkpoint_controller>" << std::endl
+        << "  </controllers>" << std::endl
+        << "  <arena size=\"2, 2, 1\">" << std::endl
+        << "    <box id=\"wn\" size=\"0.1,2,0.2\" movable=\"false\"><body position=\"0.95,0,0\" orientation=\"0,0,0\" /></box>" << std::endl
+        << "    <box id=\"ws\" size=\"0.1,2,0.2\" movable=\"false\"><body position=\"-0.95,0,0\" orientation=\"0,0,0\" /></box>" << std::endl
+        << "    <box id=\"we\" size=\"2,0.1,0.2\" movable=\"false\"><body position=\"0,0.95,0\" orientation=\"0,0,0\" /></box>" << std::endl
+        << "    <box id=\"ww\" size=\"2,0.1,0.2\" movable=\"false\"><body position=\"0,-0.95,0\" orientation=\"0,0,0\" /></box>" << std::endl
+        << "    <distribute>" << std::endl
+        << "      <position method=\"uniform\" min=\"-0.8,-0.8,0\" max=\"0.8,0.8,0\" />" << std::endl
+        << "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />" << std::endl
+        << "      <entity quantity=\"12\" max_trials=\"100\">" << std::endl
+        << "        <foot-bot id=\"fb\"><controller config=\"c\" /></foot-bot>" << std::endl
+        << "      </entity>" << std::endl
+        << "    </distribute>" << std::endl
+        << "    <box id=\"b\" size=\"0.1,0.1,0.1\" movable=\"true\" mass=\"0.1\"><body position=\"0,0,0\" orientation=\"0,0,0\" /></box>" << std::endl
+        << "  </arena>" << std::endl
+        << "  <physics_engines>" << std::endl
+        << "    <dynamics2d id=\"dyn2d\" />" << std::endl
+        << "  </physics_engines>" << std::endl
+        << "  <media />" << std::endl
+        << "</argos-configuration>" << std::endl;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs COMPARED_STEPS steps, appending the position of every entity after
+ * each step to vec_trajectory. Returns the number of positions per step.
+ */
+static size_t Run(CSimulator& c_simulator,
+                  std::vector<CVector3>& vec_trajectory) {
+   vec_trajectory.clear();
+   CEntity::TVector& vecEntities = c_simulator.GetSpace().GetRootEntityVector();
+   for(UInt32 s = 0; s < COMPARED_STEPS; ++s) {
+      c_simulator.UpdateSpace();
+      for(size_t i = 0; i < vecEntities.size(); ++i) {
+         CComposableEntity* pcEntity = dynamic_cast<CComposableEntity*>(vecEntities[i]);
+         if(pcEntity != NULL && pcEntity->HasComponent("body")) {
+            vec_trajectory.push_back(
+               pcEntity->GetComponent<CEmbodiedEntity>("body").GetOriginAnchor().Position);
+         }
+      }
+   }
+   return vec_trajectory.size() / COMPARED_STEPS;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   UInt32 unErrors = 0;
+   try {
+      CDynamicLoading::LoadAllLibraries();
+      WriteExperiment("test-checkpoint.argos");
+      cSimulator.SetExperimentFileName("test-checkpoint.argos");
+      cSimulator.LoadExperiment();
+      for(UInt32 s = 0; s < WARMUP_STEPS; ++s) {
+         cSimulator.UpdateSpace();
+      }
+      cSimulator.SaveCheckpoint("test-checkpoint.dat");
+      /* The run that saved the checkpoint, then two runs from it */
+      std::vector<CVector3> vecSaved, vecLoaded1, vecLoaded2;
+      size_t unPerStep = Run(cSimulator, vecSaved);
+      cSimulator.LoadCheckpoint("test-checkpoint.dat");
+      Run(cSimulator, vecLoaded1);
+      cSimulator.LoadCheckpoint("test-checkpoint.dat");
+      Run(cSimulator, vecLoaded2);
+      /* The runs from the checkpoint must be identical */
+      if(vecLoaded1 != vecLoaded2) {
+         LOGERR << "The two runs from the checkpoint differ" << std::endl;
+         ++unErrors;
+      }
+      /* They must also be identical to the run that saved the checkpoint */
+      for(size_t i = 0; i < vecSaved.size(); ++i) {
+         if(vecSaved[i] != vecLoaded1[i]) {
+            LOGERR << "The run from the checkpoint leaves the run that saved it at step "
+                   << (i / unPerStep + 1) << " of " << COMPARED_STEPS
+                   << ", by " << Distance(vecSaved[i], vecLoaded1[i]) << " m" << std::endl;
+            ++unErrors;
+            break;
+         }
+      }
+      cSimulator.Destroy();
+   }
+   catch(std::exception& ex) {
+      LOGERR << ex.what() << std::endl;
+      ++unErrors;
+   }
+   if(unErrors == 0) {
+      LOG << "[INFO] Checkpoint trajectories match" << std::endl;
+   }
+   LOG.Flush();
+   LOGERR.Flush();
+   return (unErrors == 0) ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 #include <argos3/core/utility/logging/argos_log.h>
 #include <argos3/core/simulator/space/positional_indices/grid.h>
 #include <argos3/plugins/simulator/entities/led_entity.h>
+#include <argos3/core/utility/math/rng.h>
 
 using namespace argos;
 
@@ -9,6 +10,12 @@ using namespace argos;
 
 const size_t NUM_LEDS = 10;
 
+/* Settings of the dense/sparse comparison */
+const size_t CHECK_NUM_LEDS  = 500;
+const size_t CHECK_NUM_STEPS = 20;
+const Real   CHECK_ARENA     = 50.0;
+const SInt32 CHECK_CELLS     = 200;
+
 /****************************************/
 /****************************************/
 
@@ -40,7 +47,7 @@ void PrintGridCells(CGrid<CLEDEntity>& g) {
    for(SInt32 k = g.GetSizeK()-1; k >= 0; --k) {
       for(SInt32 j = g.GetSizeJ()-1; j >= 0; --j) {
          for(SInt32 i = 0; i < g.GetSizeI(); ++i) {
-            CGrid<CLEDEntity>::SCell& c = g.GetCellAt(i, j, k);
+            const CGrid<CLEDEntity>::SCell& c = g.GetCellAt(i, j, k);
             fprintf(stdout, "[ %d, %d, %d ] %zu entities, timestamp = %zu\n", i, j, k, c.Entities.size(), c.Timestamp);
             if(!c.Entities.empty()) {
                for(CSet<CLEDEntity*>::iterator it = c.Entities.begin();
@@ -84,7 +91,233 @@ void PrintGridCells(CGrid<CLEDEntity>& g) {
 /****************************************/
 /****************************************/
 
+class CLEDEntityGridCount : public CGrid<CLEDEntity>::COperation {
+
+public:
+
+   CLEDEntityGridCount() : Count(0) {}
+
+   virtual bool operator()(CLEDEntity& c_entity) {
+      ++Count;
+      return true;
+   }
+
+   size_t Count;
+
+};
+
+/*
+ * Moves the LEDs around an arena and queries their neighbors.
+ * Returns the number of neighbors found, to compare dense and sparse grids.
+ */
+size_t CountNeighbors(CRandom::CRNG* pc_rng,
+                      bool b_sparse,
+                      bool b_dirty_tracking) {
+   CGrid<CLEDEntity> g(
+      CVector3(0.0, 0.0, 0.0),
+      CVector3(CHECK_ARENA, CHECK_ARENA, 1.0),
+      CHECK_CELLS, CHECK_CELLS, 1,
+      b_sparse);
+   CLEDEntityGridUpdater u(g);
+   g.SetUpdateEntityOperation(&u);
+   if(b_dirty_tracking) g.EnableDirtyTracking();
+   pc_rng->Reset();
+   CRange<Real> cPosition(0.0, CHECK_ARENA);
+   CRange<Real> cStep(-0.2, 0.2);
+   std::vector<CLEDEntity*> vecLEDs;
+   for(size_t i = 0; i < CHECK_NUM_LEDS; ++i) {
+      vecLEDs.push_back(new CLEDEntity(NULL,
+                                       "LED" + ToString(i),
+                                       CVector3(pc_rng->Uniform(cPosition),
+                                                pc_rng->Uniform(cPosition),
+                                                0.5),
+                                       CColor::RED));
+      g.AddEntity(*vecLEDs.back());
+   }
+   g.Update();
+   CLEDEntityGridCount cCount;
+   for(size_t t = 0; t < CHECK_NUM_STEPS; ++t) {
+      /* Only half of the LEDs move at each step */
+      for(size_t i = t % 2; i < vecLEDs.size(); i += 2) {
+         Real fX = vecLEDs[i]->GetPosition().GetX() + pc_rng->Uniform(cStep);
+         Real fY = vecLEDs[i]->GetPosition().GetY() + pc_rng->Uniform(cStep);
+         cPosition.TruncValue(fX);
+         cPosition.TruncValue(fY);
+         vecLEDs[i]->SetPosition(CVector3(fX, fY, 0.5));
+         g.MarkDirty(*vecLEDs[i]);
+      }
+      g.Update();
+      for(size_t i = 0; i < vecLEDs.size(); ++i) {
+         g.ForEntitiesInCircleRange(vecLEDs[i]->GetPosition(), 1.0, cCount);
+      }
+   }
+   for(size_t i = 0; i < vecLEDs.size(); ++i) {
+      delete vecLEDs[i];
+   }
+   return cCount.Count;
+}
+
+/*
+ * A cell operation that scribbles into the cells it visits.
+ */
+class CLEDEntityGridScribble : public CGrid<CLEDEntity>::CCellOperation {
+
+public:
+
+   CLEDEntityGridScribble(CLEDEntity& c_entity) : m_cEntity(c_entity) {}
+
+   virtual bool operator()(SInt32 n_i,
+                           SInt32 n_j,
+                           SInt32 n_k,
+                           CGrid<CLEDEntity>::SCell& s_cell) {
+      s_cell.Entities.insert(&m_cEntity);
+      return true;
+   }
+
+private:
+
+   CLEDEntity& m_cEntity;
+
+};
+
+/*
+ * Checks that a cell operation on an empty region of a sparse grid does not
+ * change what the grid reports for the cells that are not stored.
+ */
+bool CheckSparseEmptyCell() {
+   CGrid<CLEDEntity> g(
+      CVector3(0.0, 0.0, 0.0),
+      CVector3(CHECK_ARENA, CHECK_ARENA, 1.0),
+      CHECK_CELLS, CHECK_CELLS, 1,
+      true);
+   CLEDEntity cLED(NULL, "LED", CVector3(1.0, 1.0, 0.5), CColor::RED);
+   CLEDEntityGridScribble cScribble(cLED);
+   g.ForCellsInBoxRange(CVector3(10.0, 10.0, 0.5), CVector3(1.0, 1.0, 0.5), cScribble);
+   return g.GetCellAt(0, 0, 0).Entities.empty() &&
+      g.GetNumStoredCells() == 0;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns how many LEDs each LED finds around itself.
+ */
+std::vector<size_t> CountNeighborsOf(CGrid<CLEDEntity>& g,
+                                     const std::vector<CLEDEntity*>& vec_leds) {
+   std::vector<size_t> vecCounts;
+   for(size_t i = 0; i < vec_leds.size(); ++i) {
+      CLEDEntityGridCount cCount;
+      g.ForEntitiesInCircleRange(vec_leds[i]->GetPosition(), 1.0, cCount);
+      vecCounts.push_back(cCount.Count);
+   }
+   return vecCounts;
+}
+
+/*
+ * Takes a snapshot, moves the given number of LEDs, removes one and adds one,
+ * puts the initial LEDs back and resets the grid. Checks that the grid then
+ * finds the same neighbors as a grid built from scratch.
+ */
+bool CheckSnapshotReset(CRandom::CRNG* pc_rng,
+                        bool b_sparse,
+                        size_t un_moved) {
+   CGrid<CLEDEntity> g(
+      CVector3(0.0, 0.0, 0.0),
+      CVector3(CHECK_ARENA, CHECK_ARENA, 1.0),
+      CHECK_CELLS, CHECK_CELLS, 1,
+      b_sparse);
+   CLEDEntityGridUpdater u(g);
+   g.SetUpdateEntityOperation(&u);
+   pc_rng->Reset();
+   CRange<Real> cPosition(0.0, CHECK_ARENA);
+   std::vector<CLEDEntity*> vecLEDs;
+   std::vector<CVector3> vecInitPositions;
+   for(size_t i = 0; i < CHECK_NUM_LEDS; ++i) {
+      vecInitPositions.push_back(CVector3(pc_rng->Uniform(cPosition),
+                                          pc_rng->Uniform(cPosition),
+                                          0.5));
+      vecLEDs.push_back(new CLEDEntity(NULL,
+                                       "LED" + ToString(i),
+                                       vecInitPositions.back(),
+                                       CColor::RED));
+      g.AddEntity(*vecLEDs.back());
+   }
+   g.Update();
+   g.TakeSnapshot();
+   /* Move some LEDs, remove the last one and add a new one */
+   for(size_t i = 0; i < un_moved; ++i) {
+      vecLEDs[i]->SetPosition(CVector3(pc_rng->Uniform(cPosition),
+                                       pc_rng->Uniform(cPosition),
+                                       0.5));
+   }
+   g.RemoveEntity(*vecLEDs.back());
+   delete vecLEDs.back();
+   vecLEDs.pop_back();
+   vecInitPositions.pop_back();
+   vecLEDs.push_back(new CLEDEntity(NULL,
+                                    "LEDnew",
+                                    CVector3(1.0, 1.0, 0.5),
+                                    CColor::RED));
+   g.AddEntity(*vecLEDs.back());
+   g.Update();
+   /* Put the initial LEDs back and reset */
+   for(size_t i = 0; i < vecInitPositions.size(); ++i) {
+      vecLEDs[i]->SetPosition(vecInitPositions[i]);
+   }
+   g.Reset();
+   /* Compare with a grid built from scratch */
+   CGrid<CLEDEntity> cFresh(
+      CVector3(0.0, 0.0, 0.0),
+      CVector3(CHECK_ARENA, CHECK_ARENA, 1.0),
+      CHECK_CELLS, CHECK_CELLS, 1,
+      b_sparse);
+   CLEDEntityGridUpdater cFreshUpdater(cFresh);
+   cFresh.SetUpdateEntityOperation(&cFreshUpdater);
+   for(size_t i = 0; i < vecLEDs.size(); ++i) {
+      cFresh.AddEntity(*vecLEDs[i]);
+   }
+   cFresh.Update();
+   bool bOK = (CountNeighborsOf(g, vecLEDs) == CountNeighborsOf(cFresh, vecLEDs));
+   for(size_t i = 0; i < vecLEDs.size(); ++i) {
+      delete vecLEDs[i];
+   }
+   return bOK;
+}
+
+/****************************************/
+/****************************************/
+
 int main() {
+   /* Compare a dense and a sparse grid */
+   CRandom::CreateCategory("argos", 12345);
+   CRandom::CRNG* pcRNG = CRandom::CreateRNG("argos");
+   size_t unNeighbors = CountNeighbors(pcRNG, false, false);
+   if(unNeighbors != CountNeighbors(pcRNG, true, false)) {
+      fprintf(stderr, "ERROR: the dense and sparse grids found different neighbors\n");
+      return 1;
+   }
+   /* Re-binning only the marked LEDs must give the same result */
+   if(unNeighbors != CountNeighbors(pcRNG, false, true) ||
+      unNeighbors != CountNeighbors(pcRNG, true, true)) {
+      fprintf(stderr, "ERROR: the grids with dirty tracking found different neighbors\n");
+      return 1;
+   }
+   if(!CheckSparseEmptyCell()) {
+      fprintf(stderr, "ERROR: a cell operation modified the empty cell of a sparse grid\n");
+      return 1;
+   }
+   /* Reset from a snapshot, moving back a few LEDs or refilling the cells */
+   for(UInt32 i = 0; i < 2; ++i) {
+      bool bSparse = (i == 1);
+      if(!CheckSnapshotReset(pcRNG, bSparse, 10) ||
+         !CheckSnapshotReset(pcRNG, bSparse, CHECK_NUM_LEDS - 1)) {
+         fprintf(stderr, "ERROR: the %s grid reset from the snapshot differs from a new grid\n",
+                 bSparse ? "sparse" : "dense");
+         return 1;
+      }
+   }
+
    // Create stuff
    // CGrid<CLEDEntity> g(
    //    CVector3(0.0, 0.0, 0.0),
@@ -0,0 +1,136 @@
+/**
+ * @file <argos3/testing/unit/test-led-medium.cpp>
+ *
+ * Moves a light with SetPosition() and checks that the LED medium finds it
+ * at its new position, and no longer at its old one.
+ *
+ * The ARGoS plugins must be in ARGOS_PLUGIN_PATH.
+ *
+ * @author Carlo Pinciroli <ilpincy@gmail.com>
+ */
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/utility/plugins/dynamic_loading.h>
+#include <argos3/plugins/simulator/entities/light_entity.h>
+#include <argos3/plugins/simulator/media/led_medium.h>
+#include <fstream>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+/*
+ * Counts the LEDs with the given id
+ */
+class CCountLEDs : public CPositionalIndex<CLEDEntity>::COperation {
+
+public:
+
+   CCountLEDs(const std::string& str_id) :
+      m_strId(str_id),
+      m_unCount(0) {}
+
+   virtual bool operator()(CLEDEntity& c_led) {
+      if(c_led.GetId() == m_strId) ++m_unCount;
+      return true;
+   }
+
+   UInt32 GetCount() const {
+      return m_unCount;
+   }
+
+private:
+
+   std::string m_strId;
+   UInt32 m_unCount;
+
+};
+
+/****************************************/
+/****************************************/
+
+static void WriteExperiment(const std::string& str_fname) {
+   std::ofstream cOut(str_fname.c_str(), std::ofstream::out | std::ofstream::trunc);
+   cOut << "<?xml version=\"1.0\" ?>" << std::endl
+        << "<argos-configuration>" << std::endl
+        << "  <framework>" << std::endl
+        << "    <system threads=\"0\" />" << std::endl
+        << "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"1\" />" << std::endl
+        << "  </framework>" << std::endl
+        << "  <controllers />" << std::endl
+        << "  <arena size=\"4, 4, 1\">" << std::endl
+        << "    <light id=\"l0\" position=\"-1.5,-1.5,0.5\" orientation=\"0,0,0\" color=\"yellow\" intensity=\"1\" medium=\"leds\" />" << std::endl
+        << "    <light id=\"l1\" position=\"1.5,1.5,0.5\" orientation=\"0,0,0\" color=\"yellow\" intensity=\"1\" medium=\"leds\" />" << std::endl
+        << "  </arena>" << std::endl
+        << "  <physics_engines>" << std::endl
+        << "    <dynamics2d id=\"dyn2d\" />" << std::endl
+        << "  </physics_engines>" << std::endl
+        << "  <media>" << std::endl
+        << "    <led id=\"leds\" />" << std::endl
+        << "  </media>" << std::endl
+        << "</argos-configuration>" << std::endl;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns how many times the medium finds the LED with the given id in a
+ * 0.5 m box around the given point
+ */
+static UInt32 CountAt(CLEDMedium& c_medium,
+                      const std::string& str_id,
+                      const CVector3& c_point) {
+   CCountLEDs cCount(str_id);
+   c_medium.GetIndex().ForEntitiesInBoxRange(c_point,
+                                             CVector3(0.25, 0.25, 0.25),
+                                             cCount);
+   return cCount.GetCount();
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   UInt32 unErrors = 0;
+   try {
+      CDynamicLoading::LoadAllLibraries();
+      WriteExperiment("test-led-medium.argos");
+      cSimulator.SetExperimentFileName("test-led-medium.argos");
+      cSimulator.LoadExperiment();
+      CLEDMedium& cMedium = cSimulator.GetMedium<CLEDMedium>("leds");
+      CLightEntity& cLight =
+         dynamic_cast<CLightEntity&>(cSimulator.GetSpace().GetEntity("l0"));
+      /* Move the light through the base class, as a loop function would */
+      CPositionalEntity& cPositional = cLight;
+      CVector3 cOld = cPositional.GetPosition();
+      CVector3 cNew(1.5, -1.5, 0.5);
+      cPositional.SetPosition(cNew);
+      cSimulator.UpdateSpace();
+      if(CountAt(cMedium, "l0", cNew) != 1) {
+         LOGERR << "The LED medium does not find the light at its new position" << std::endl;
+         ++unErrors;
+      }
+      if(CountAt(cMedium, "l0", cOld) != 0) {
+         LOGERR << "The LED medium still finds the light at its old position" << std::endl;
+         ++unErrors;
+      }
+      if(CountAt(cMedium, "l1", CVector3(1.5, 1.5, 0.5)) != 1) {
+         LOGERR << "The LED medium lost the light that did not move" << std::endl;
+         ++unErrors;
+      }
+      cSimulator.Destroy();
+   }
+   catch(std::exception& ex) {
+      LOGERR << ex.what() << std::endl;
+      ++unErrors;
+   }
+   if(unErrors == 0) {
+      LOG << "[INFO] The LED medium follows the moved light" << std::endl;
+   }
+   LOG.Flush();
+   LOGERR.Flush();
+   return (unErrors == 0) ? 0 : 1;
+}
@@ -1,15 +1,32 @@
-
 /**
  * @file <argos3/testing/unit/test-reset.cpp>
  *
+ * Runs an experiment several times, resetting it in between, and reports
+ * how long each reset takes.
+ *
  * @author Carlo Pinciroli <ilpincy@gmail.com>
  */
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/utility/plugins/dynamic_loading.h>
 #include <argos3/core/utility/string_utilities.h>
+#include <algorithm>
+#include <vector>
+#include <sys/time.h>
 
 using namespace argos;
 
+/****************************************/
+/****************************************/
+
+static Real Now() {
+   ::timeval tTime;
+   ::gettimeofday(&tTime, NULL);
+   return tTime.tv_sec + tTime.tv_usec * 1e-6;
+}
+
+/****************************************/
+/****************************************/
+
 int main(int n_argc, char** ppch_argv) {
    if(n_argc != 3) {
       LOGERR << "Usage:" << std::endl;
@@ -24,13 +41,31 @@ int main(int n_argc, char** ppch_argv) {
       CDynamicLoading::LoadAllLibraries();
       cSimulator.SetExperimentFileName(ppch_argv[2]);
       cSimulator.LoadExperiment();
+      std::vector<Real> vecLatencies;
+      Real fStart;
       for(UInt32 i = 0; i < unRepeats; ++i) {
          LOG << "[INFO] === Repetition #" << i+1 << " START" << std::endl;
          cSimulator.Execute();
          LOG << "[INFO] === Repetition #" << i+1 << " END" << std::endl;
+         fStart = Now();
          cSimulator.Reset();
+         vecLatencies.push_back(Now() - fStart);
          LOG << "[INFO] === Reset" << std::endl;
       }
+      /* Report the reset latency */
+      if(!vecLatencies.empty()) {
+         std::sort(vecLatencies.begin(), vecLatencies.end());
+         Real fTotal = 0.0;
+         for(size_t i = 0; i < vecLatencies.size(); ++i) {
+            fTotal += vecLatencies[i];
+         }
+         LOG << "[INFO] Reset latency over " << vecLatencies.size() << " resets:"
+             << " min " << vecLatencies.front() * 1e6 << " us,"
+             << " mean " << fTotal / vecLatencies.size() * 1e6 << " us,"
+             << " median " << vecLatencies[vecLatencies.size() / 2] * 1e6 << " us,"
+             << " max " << vecLatencies.back() * 1e6 << " us"
+             << std::endl;
+      }
       cSimulator.Destroy();
    }
    catch(std::exception& ex) {
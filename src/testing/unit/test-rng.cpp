@@ -50,7 +50,40 @@ void GenerateG(Real f_std_dev, Real f_mean) {
    cFile.close();
 }
 
+/*
+ * Checks the Philox4x32-10 block function against the known-answer
+ * vectors published with Random123.
+ * Returns the number of mismatching vectors.
+ */
+UInt32 CheckPhilox() {
+   static const UInt32 KAT[3][10] = {
+      /* counter, key, expected output */
+      { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+        0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+      { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+        0xffffffff, 0xffffffff,
+        0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+      { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344,
+        0xa4093822, 0x299f31d0,
+        0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }
+   };
+   UInt32 unErrors = 0;
+   for(UInt32 v = 0; v < 3; ++v) {
+      UInt32 punCtr[4] = { KAT[v][0], KAT[v][1], KAT[v][2], KAT[v][3] };
+      CRandom::CRNG::Philox4x32(punCtr, KAT[v] + 4);
+      if(::memcmp(punCtr, KAT[v] + 6, sizeof(punCtr)) != 0) {
+         std::cerr << "Philox4x32-10 vector " << v << " mismatch" << std::endl;
+         ++unErrors;
+      }
+   }
+   return unErrors;
+}
+
 int main() {
+   if(CheckPhilox() > 0) {
+      return 1;
+   }
    CRandom::CreateCategory("testing", 12345);
    GenerateU("ufile.dat", URANGE);
    GenerateU("sfile.dat", SRANGE);